@@ -0,0 +1,486 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EABitStream.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements reading and writing of bit-granular data over an IStream.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EABitStream.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAStreamFixedMemory.h>
+#include <eaio/EAMappedFileStream.h>
+#include <string.h> // memcpy, etc.
+#include EA_ASSERT_HEADER
+
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+namespace BitStreamLocal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // GetStreamMemory
+    //
+    // Returns a pointer to the beginning of the stream's data if the stream is one 
+    // whose contents are directly addressable in memory, else NULL.
+    //
+    const uint8_t* GetStreamMemory(IStream* pStream)
+    {
+        switch(pStream->GetType())
+        {
+            case MemoryStream::kTypeMemoryStream:
+                return (const uint8_t*)static_cast<MemoryStream*>(pStream)->GetData();
+
+            case FixedMemoryStream::kTypeFixedMemoryStream:
+                return (const uint8_t*)static_cast<FixedMemoryStream*>(pStream)->GetData();
+
+            #if EAIO_MAPPED_FILE_STREAM_ENABLED
+                case MappedFileStream::kTypeMappedFileStream:
+                    return (const uint8_t*)static_cast<MappedFileStream*>(pStream)->GetData();
+            #endif
+        }
+
+        return NULL;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // LoadUint64Little / StoreUint32Little
+    //
+    inline uint64_t LoadUint64Little(const uint8_t* p)
+    {
+        uint64_t n;
+        memcpy(&n, p, sizeof(n));
+
+        if(kEndianLocal != kEndianLittle)
+        {
+            n = ((n & UINT64_C(0x00000000ffffffff)) << 32) | (n >> 32);
+            n = ((n & UINT64_C(0x0000ffff0000ffff)) << 16) | ((n >> 16) & UINT64_C(0x0000ffff0000ffff));
+            n = ((n & UINT64_C(0x00ff00ff00ff00ff)) <<  8) | ((n >>  8) & UINT64_C(0x00ff00ff00ff00ff));
+        }
+
+        return n;
+    }
+
+    inline void StoreUint32Little(uint8_t* p, uint32_t n)
+    {
+        p[0] = (uint8_t)(n);
+        p[1] = (uint8_t)(n >>  8);
+        p[2] = (uint8_t)(n >> 16);
+        p[3] = (uint8_t)(n >> 24);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BitStreamReader
+///////////////////////////////////////////////////////////////////////////////
+
+BitStreamReader::BitStreamReader(IStream* pStream)
+  : mpStream(NULL),
+    mAccumulator(0),
+    mnAccumulatorBitCount(0),
+    mbValid(true),
+    mbStreamMemory(false),
+    mpBufferBegin(mBuffer),
+    mpBufferCurrent(mBuffer),
+    mpBufferEnd(mBuffer),
+    mnBufferPosition(0),
+    mnStartPosition(0)
+{
+    setStream(pStream);
+}
+
+
+BitStreamReader::~BitStreamReader()
+{
+    setStream(NULL);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setStream
+//
+bool BitStreamReader::setStream(IStream* pStream)
+{
+    bool bResult = true;
+
+    if(pStream != mpStream)
+    {
+        if(mpStream)
+        {
+            bResult = Sync();
+            mpStream->Release();
+        }
+
+        mpStream = pStream;
+
+        if(pStream)
+            pStream->AddRef();
+
+        ResetBuffer();
+        mnStartPosition = mnBufferPosition;
+        mbValid         = true;
+    }
+
+    return bResult;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResetBuffer
+//
+// This is an internal function.
+//
+// Discards the accumulator and buffer and starts buffering at the current 
+// stream position.
+//
+void BitStreamReader::ResetBuffer()
+{
+    const uint8_t* const pStreamData = mpStream ? BitStreamLocal::GetStreamMemory(mpStream) : NULL;
+
+    mAccumulator          = 0;
+    mnAccumulatorBitCount = 0;
+    mnBufferPosition      = mpStream ? (size_type)mpStream->GetPosition() : 0;
+    mbStreamMemory        = (pStreamData != NULL);
+
+    if(mbStreamMemory) // If we can read the stream's memory directly, we treat it as an already full buffer.
+    {
+        const size_type nSize = mpStream->getSize();
+
+        if(mnBufferPosition > nSize)
+            mnBufferPosition = nSize;
+
+        mpBufferBegin   = pStreamData + mnBufferPosition;
+        mpBufferCurrent = mpBufferBegin;
+        mpBufferEnd     = pStreamData + nSize;
+    }
+    else
+    {
+        mpBufferBegin   = mBuffer;
+        mpBufferCurrent = mBuffer;
+        mpBufferEnd     = mBuffer;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FillBuffer
+//
+// This is an internal function.
+//
+// Reads the next part of the stream into the buffer, which must be empty.
+// Returns false if nothing could be read.
+//
+bool BitStreamReader::FillBuffer()
+{
+    EA_ASSERT(mpBufferCurrent == mpBufferEnd);
+
+    if(mbStreamMemory || !mpStream) // If there is nothing beyond the buffer...
+        return false;
+
+    mnBufferPosition += (size_type)(mpBufferEnd - mpBufferBegin);
+
+    const size_type nReadSize = mpStream->Read(mBuffer, kBufferSize);
+
+    mpBufferBegin   = mBuffer;
+    mpBufferCurrent = mBuffer;
+    mpBufferEnd     = mBuffer + (((nReadSize != kSizeTypeError)) ? nReadSize : 0);
+
+    return (mpBufferEnd != mBuffer);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Refill
+//
+// This is an internal function.
+//
+// Moves as many whole bytes from the buffer into the accumulator as fit, which 
+// is at least 57 bits' worth unless the stream ends first. mnAccumulatorBitCount 
+// must be less than 32.
+//
+// The fast path loads a 64 bit word and keeps only the whole bytes which fit.
+// The accumulator bits above mnAccumulatorBitCount are then left holding part 
+// of the next byte, but since they are the same bits which the next refill will
+// OR into the same place, they do no harm. Reads mask them off.
+//
+void BitStreamReader::Refill()
+{
+    using namespace BitStreamLocal;
+
+    if((mpBufferEnd - mpBufferCurrent) >= 8)
+    {
+        const int nByteCount = ((63 - mnAccumulatorBitCount) >> 3);
+
+        mAccumulator          |= (LoadUint64Little(mpBufferCurrent) << mnAccumulatorBitCount);
+        mpBufferCurrent       += nByteCount;
+        mnAccumulatorBitCount += (nByteCount * 8);
+    }
+    else
+    {
+        while(mnAccumulatorBitCount <= 56)
+        {
+            if((mpBufferCurrent == mpBufferEnd) && !FillBuffer())
+                break;
+
+            mAccumulator          |= ((uint64_t)*mpBufferCurrent++ << mnAccumulatorBitCount);
+            mnAccumulatorBitCount += 8;
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ReadBits64
+//
+uint64_t BitStreamReader::ReadBits64(int nBitCount)
+{
+    EA_ASSERT((nBitCount >= 0) && (nBitCount <= 64));
+
+    if(nBitCount <= 32)
+        return ReadBits(nBitCount);
+
+    const uint64_t nLow = ReadBits(32);
+    return nLow | ((uint64_t)ReadBits(nBitCount - 32) << 32);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlignToByte
+//
+void BitStreamReader::AlignToByte()
+{
+    // Bits are moved into the accumulator a whole byte at a time, so the partial
+    // byte's remaining bits are the low (mnAccumulatorBitCount % 8) bits.
+    const int nBitCount = (mnAccumulatorBitCount & 7);
+
+    mAccumulator         >>= nBitCount;
+    mnAccumulatorBitCount -= nBitCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetBitPosition
+//
+size_type BitStreamReader::GetBitPosition() const
+{
+    const size_type nBytePosition = mnBufferPosition + (size_type)(mpBufferCurrent - mpBufferBegin);
+
+    return ((nBytePosition - mnStartPosition) * 8) - (size_type)mnAccumulatorBitCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Sync
+//
+bool BitStreamReader::Sync()
+{
+    if(mpStream)
+    {
+        AlignToByte();
+
+        // Whole bytes still in the accumulator haven't been consumed.
+        const size_type nPosition = mnBufferPosition + (size_type)(mpBufferCurrent - mpBufferBegin) - (size_type)(mnAccumulatorBitCount / 8);
+        const bool      bResult   = mpStream->SetPosition((off_type)nPosition);
+
+        ResetBuffer();
+        return bResult;
+    }
+
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BitStreamWriter
+///////////////////////////////////////////////////////////////////////////////
+
+BitStreamWriter::BitStreamWriter(IStream* pStream)
+  : mpStream(NULL),
+    mAccumulator(0),
+    mnAccumulatorBitCount(0),
+    mbValid(true),
+    mnBufferUsed(0),
+    mnWrittenSize(0)
+{
+    setStream(pStream);
+}
+
+
+BitStreamWriter::~BitStreamWriter()
+{
+    setStream(NULL);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setStream
+//
+bool BitStreamWriter::setStream(IStream* pStream)
+{
+    bool bResult = true;
+
+    if(pStream != mpStream)
+    {
+        if(mpStream)
+        {
+            bResult = Flush();
+            mpStream->Release();
+        }
+
+        mpStream = pStream;
+
+        if(pStream)
+            pStream->AddRef();
+
+        mAccumulator          = 0;
+        mnAccumulatorBitCount = 0;
+        mnBufferUsed          = 0;
+        mnWrittenSize         = 0;
+        mbValid               = true;
+    }
+
+    return bResult;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FlushAccumulator
+//
+// This is an internal function.
+//
+// Moves the low 32 bits of the accumulator to the buffer.
+//
+void BitStreamWriter::FlushAccumulator()
+{
+    EA_ASSERT(mnAccumulatorBitCount >= 32);
+
+    if((mnBufferUsed + 4) > kBufferSize)
+        FlushBuffer();
+
+    BitStreamLocal::StoreUint32Little(mBuffer + mnBufferUsed, (uint32_t)mAccumulator);
+    mnBufferUsed          += 4;
+    mAccumulator         >>= 32;
+    mnAccumulatorBitCount -= 32;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FlushBuffer
+//
+// This is an internal function.
+//
+bool BitStreamWriter::FlushBuffer()
+{
+    if(mnBufferUsed)
+    {
+        if(!mpStream || !mpStream->Write(mBuffer, mnBufferUsed))
+            mbValid = false;
+
+        mnWrittenSize += mnBufferUsed;
+        mnBufferUsed   = 0;
+    }
+
+    return mbValid;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WriteBits64
+//
+void BitStreamWriter::WriteBits64(uint64_t value, int nBitCount)
+{
+    EA_ASSERT((nBitCount >= 0) && (nBitCount <= 64));
+
+    if(nBitCount <= 32)
+        WriteBits((uint32_t)value, nBitCount);
+    else
+    {
+        WriteBits((uint32_t)value, 32);
+        WriteBits((uint32_t)(value >> 32), nBitCount - 32);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AlignToByte
+//
+void BitStreamWriter::AlignToByte()
+{
+    // The accumulator bits above mnAccumulatorBitCount are always zero, so this pads with zeros.
+    mnAccumulatorBitCount = ((mnAccumulatorBitCount + 7) & ~7);
+
+    if(mnAccumulatorBitCount >= 32)
+        FlushAccumulator();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetBitPosition
+//
+size_type BitStreamWriter::GetBitPosition() const
+{
+    return ((mnWrittenSize + mnBufferUsed) * 8) + (size_type)mnAccumulatorBitCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Flush
+//
+bool BitStreamWriter::Flush()
+{
+    AlignToByte();
+
+    // Move the remaining whole bytes, of which there are fewer than 4, to the buffer.
+    for(; mnAccumulatorBitCount; mnAccumulatorBitCount -= 8, mAccumulator >>= 8)
+    {
+        if(mnBufferUsed == kBufferSize)
+            FlushBuffer();
+        mBuffer[mnBufferUsed++] = (uint8_t)mAccumulator;
+    }
+
+    return FlushBuffer();
+}
+
+
+} // namespace IO
+
+} // namespace EA
@@ -0,0 +1,319 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EABitStream.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements reading and writing of bit-granular data over an IStream.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EABITSTREAM_H
+#define EAIO_EABITSTREAM_H
+
+
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// class BitStreamReader
+        ///
+        /// Reads values of 0 to 64 bits from a stream, in the order in which 
+        /// BitStreamWriter writes them. Bits are packed least significant first: the 
+        /// first bit read is bit 0 of the first byte, and a value's low bits come 
+        /// before its high bits.
+        ///
+        /// Bits are consumed from a 64 bit accumulator which is refilled a word at a
+        /// time from an internal buffer, which in turn is filled with large reads 
+        /// from the stream. If the stream is a MemoryStream, FixedMemoryStream or 
+        /// MappedFileStream, its memory is read directly instead.
+        ///
+        /// Since the reader reads ahead, the stream's position is beyond the consumed
+        /// bits until Sync is called, which the destructor does. A failed read, such 
+        /// as beyond the end of the stream, makes the reader invalid, and reads after
+        /// that return 0, so that a sequence of reads can be checked once at its end.
+        ///
+        /// Example usage:
+        ///     BitStreamReader reader(pStream);
+        ///
+        ///     const uint32_t nType  = reader.ReadBits(3);
+        ///     const bool     bMoved = reader.ReadBit();
+        ///     const uint32_t nIndex = reader.ReadBits(nIndexBitCount);
+        ///
+        ///     if(!reader.IsValid())
+        ///         HandleError();
+        ///
+        class EAIO_API BitStreamReader
+        {
+        public:
+            static const size_type kBufferSize = 512; /// The size of the internal buffer, which is the size of each read from the stream.
+
+        public:
+            BitStreamReader(IStream* pStream = NULL);
+           ~BitStreamReader();
+
+            IStream*  getStream() const;
+            bool      setStream(IStream* pStream);      /// Syncs any previous stream. The new stream is read from its current position.
+
+            bool      IsValid() const;
+            void      SetValid(bool bValid);
+
+            /// ReadBits
+            /// Reads an nBitCount bit value, where nBitCount is in the range of [0, 32].
+            uint32_t  ReadBits(int nBitCount);
+
+            /// ReadBits64
+            /// Reads an nBitCount bit value, where nBitCount is in the range of [0, 64].
+            uint64_t  ReadBits64(int nBitCount);
+
+            bool      ReadBit();
+
+            /// AlignToByte
+            /// Skips the remaining bits of a partially read byte, if any.
+            void      AlignToByte();
+
+            /// GetBitPosition
+            /// Returns the number of bits read since the stream was set.
+            size_type GetBitPosition() const;
+
+            /// Sync
+            /// Aligns to the next byte and sets the stream position to that byte, 
+            /// discarding any data which was read ahead. Returns false if the stream 
+            /// position couldn't be set.
+            bool      Sync();
+
+        protected:
+            BitStreamReader(const BitStreamReader&);              // Not implemented.
+            BitStreamReader& operator=(const BitStreamReader&);   // Not implemented.
+
+            void      Refill();
+            void      ResetBuffer();
+            bool      FillBuffer();
+
+        protected:
+            IStream*       mpStream;                /// The stream that we are reading.
+            uint64_t       mAccumulator;            /// Bits which have been read from the buffer but not consumed, least significant first.
+            int            mnAccumulatorBitCount;   /// Number of valid bits in mAccumulator.
+            bool           mbValid;                 /// False if any read has failed.
+            bool           mbStreamMemory;          /// True if mpBufferBegin refers to the stream's own memory rather than mBuffer.
+            const uint8_t* mpBufferBegin;           /// The beginning of the buffered data.
+            const uint8_t* mpBufferCurrent;         /// The next byte to move into mAccumulator.
+            const uint8_t* mpBufferEnd;             /// The end of the buffered data.
+            size_type      mnBufferPosition;        /// The stream position of mpBufferBegin.
+            size_type      mnStartPosition;         /// The stream position at the time the stream was set.
+            uint8_t        mBuffer[kBufferSize];    /// Data read from the stream, unless mbStreamMemory.
+        };
+
+
+
+        /// class BitStreamWriter
+        ///
+        /// Writes values of 0 to 64 bits to a stream, least significant bit first.
+        /// See BitStreamReader.
+        ///
+        /// Bits are collected in a 64 bit accumulator, which is moved a 32 bit word 
+        /// at a time to an internal buffer, which in turn is written to the stream 
+        /// when it is full. Flush writes any pending bits, padding the last byte with
+        /// zero bits; the destructor does this as well.
+        ///
+        /// Example usage:
+        ///     BitStreamWriter writer(pStream);
+        ///
+        ///     writer.WriteBits(nType, 3);
+        ///     writer.WriteBit(bMoved);
+        ///     writer.WriteBits(nIndex, nIndexBitCount);
+        ///     writer.Flush();
+        ///
+        class EAIO_API BitStreamWriter
+        {
+        public:
+            static const size_type kBufferSize = 512; /// The size of the internal buffer, which is the size of each write to the stream.
+
+        public:
+            BitStreamWriter(IStream* pStream = NULL);
+           ~BitStreamWriter();
+
+            IStream*  getStream() const;
+            bool      setStream(IStream* pStream);      /// Flushes to any previous stream. The new stream is written at its current position.
+
+            bool      IsValid() const;
+            void      SetValid(bool bValid);
+
+            /// WriteBits
+            /// Writes the low nBitCount bits of value, where nBitCount is in the range of [0, 32].
+            /// Bits of value above nBitCount are ignored.
+            void      WriteBits(uint32_t value, int nBitCount);
+
+            /// WriteBits64
+            /// Writes the low nBitCount bits of value, where nBitCount is in the range of [0, 64].
+            void      WriteBits64(uint64_t value, int nBitCount);
+
+            void      WriteBit(bool value);
+
+            /// AlignToByte
+            /// Pads a partially written byte, if any, with zero bits.
+            void      AlignToByte();
+
+            /// GetBitPosition
+            /// Returns the number of bits written since the stream was set.
+            size_type GetBitPosition() const;
+
+            /// Flush
+            /// Aligns to the next byte and writes all pending data to the stream. 
+            /// Returns false if this or any previous write to the stream failed.
+            bool      Flush();
+
+        protected:
+            BitStreamWriter(const BitStreamWriter&);              // Not implemented.
+            BitStreamWriter& operator=(const BitStreamWriter&);   // Not implemented.
+
+            void      FlushAccumulator();
+            bool      FlushBuffer();
+
+        protected:
+            IStream*  mpStream;                 /// The stream that we are writing.
+            uint64_t  mAccumulator;             /// Bits which haven't yet been moved to the buffer, least significant first.
+            int       mnAccumulatorBitCount;    /// Number of valid bits in mAccumulator. This is less than 32 between calls.
+            bool      mbValid;                  /// False if any write has failed.
+            size_type mnBufferUsed;             /// Number of bytes of mBuffer in use.
+            size_type mnWrittenSize;            /// Number of bytes written to the stream since it was set.
+            uint8_t   mBuffer[kBufferSize];     /// Data to be written to the stream.
+        };
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+    namespace IO
+    {
+        inline
+        IStream* BitStreamReader::getStream() const
+        {
+            // We do not AddRef the returned stream.
+            return mpStream;
+        }
+
+        inline
+        bool BitStreamReader::IsValid() const
+        {
+            return mbValid;
+        }
+
+        inline
+        void BitStreamReader::SetValid(bool bValid)
+        {
+            mbValid = bValid;
+        }
+
+        inline
+        uint32_t BitStreamReader::ReadBits(int nBitCount)
+        {
+            if(mnAccumulatorBitCount < nBitCount)
+            {
+                Refill();
+
+                if(mnAccumulatorBitCount < nBitCount) // If we are at the end of the stream...
+                {
+                    mbValid = false;
+                    return 0;
+                }
+            }
+
+            const uint32_t value = (uint32_t)(mAccumulator & ((UINT64_C(1) << nBitCount) - 1));
+
+            mAccumulator         >>= nBitCount;
+            mnAccumulatorBitCount -= nBitCount;
+
+            return mbValid ? value : 0;
+        }
+
+        inline
+        bool BitStreamReader::ReadBit()
+        {
+            return ReadBits(1) != 0;
+        }
+
+        inline
+        IStream* BitStreamWriter::getStream() const
+        {
+            // We do not AddRef the returned stream.
+            return mpStream;
+        }
+
+        inline
+        bool BitStreamWriter::IsValid() const
+        {
+            return mbValid;
+        }
+
+        inline
+        void BitStreamWriter::SetValid(bool bValid)
+        {
+            mbValid = bValid;
+        }
+
+        inline
+        void BitStreamWriter::WriteBits(uint32_t value, int nBitCount)
+        {
+            mAccumulator          |= ((uint64_t)value & ((UINT64_C(1) << nBitCount) - 1)) << mnAccumulatorBitCount;
+            mnAccumulatorBitCount += nBitCount;
+
+            if(mnAccumulatorBitCount >= 32)
+                FlushAccumulator();
+        }
+
+        inline
+        void BitStreamWriter::WriteBit(bool value)
+        {
+            WriteBits(value ? 1u : 0u, 1);
+        }
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif // Header include guard
@@ -0,0 +1,709 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EABufferAdapter.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements non-virtual adapters for reading and writing basic types in an 
+// endian-proper way directly from and to contiguous memory.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EABUFFERADAPTER_H
+#define EAIO_EABUFFERADAPTER_H
+
+
+#ifndef INCLUDED_eabase_H
+    #include <eastl/EABase/eabase.h>
+#endif
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+#include <string.h>
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// BufferReader
+        ///
+        /// Reads basic types from a contiguous span of memory, converting them from 
+        /// endianType. This is a lightweight alternative to StreamAdapter for data which
+        /// is already in memory, such as the data of a MemoryStream, FixedMemoryStream 
+        /// or MappedFileStream, or the window returned by StreamBuffer::Peek. Everything 
+        /// is inline and non-virtual, and the endian conversion is resolved at compile time.
+        ///
+        /// As with StreamAdapter, a failed read makes the reader invalid, and reads 
+        /// after that do nothing, so that a sequence of reads can be checked once at 
+        /// its end. The ReadXXX functions check the bounds for each call. For the 
+        /// lowest overhead, Require can instead check the bounds for a batch of values,
+        /// after which the GetXXX functions read them without checks.
+        ///
+        /// Example usage:
+        ///     BufferReader<kEndianBig> reader(memoryStream.GetData(), memoryStream.getSize());
+        ///     reader.SetPosition((size_type)memoryStream.GetPosition());
+        ///
+        ///     if(reader.Require(sizeof(uint32_t) + sizeof(uint16_t) + sizeof(float)))
+        ///     {
+        ///         packet.mId     = reader.GetUint32();
+        ///         packet.mFlags  = reader.GetUint16();
+        ///         packet.mWeight = reader.GetFloat();
+        ///     }
+        ///
+        ///     memoryStream.SetPosition((off_type)reader.GetPosition());
+        ///
+        template <Endian endianType = kEndianBig>
+        class BufferReader
+        {
+        public:
+            BufferReader();
+            BufferReader(const void* pData, size_type nSize);
+
+            /// SetBuffer
+            /// Sets the memory to read from, sets the position to zero and makes the reader valid.
+            void        SetBuffer(const void* pData, size_type nSize);
+
+            void        SetValid(bool success);
+            bool        IsValid() const;
+            operator    bool() const;
+            bool        operator !() const;
+
+            const void* GetData() const;                    /// Returns the beginning of the buffer.
+            const void* GetCurrent() const;                 /// Returns the current position within the buffer.
+            size_type   getSize() const;
+            size_type   GetPosition() const;
+            bool        SetPosition(size_type nPosition);   /// Returns false, without invalidating the reader, if nPosition is beyond the end.
+            size_type   GetAvailable() const;
+
+            /// Require
+            /// Returns true if there are at least nSize bytes available, else makes the 
+            /// reader invalid and returns false. Also returns false if the reader is invalid.
+            bool        Require(size_type nSize);
+
+            /// Skip
+            /// Advances the position by nSize bytes, as with a read.
+            void        Skip(size_type nSize);
+
+            // Unchecked reads. The caller must first have called Require for the data.
+            uint8_t     GetUint8();
+            uint16_t    GetUint16();
+            uint32_t    GetUint32();
+            uint64_t    GetUint64();
+            int8_t      GetInt8();
+            int16_t     GetInt16();
+            int32_t     GetInt32();
+            int64_t     GetInt64();
+            bool        GetBool8();
+            float       GetFloat();
+            double      GetDouble();
+
+            // Checked reads. Upon failure, the value is unmodified and the reader is invalid.
+            void        ReadUint8(uint8_t& v);
+            void        ReadUint16(uint16_t& v);
+            void        ReadUint32(uint32_t& v);
+            void        ReadUint64(uint64_t& v);
+            void        ReadInt8(int8_t& v);
+            void        ReadInt16(int16_t& v);
+            void        ReadInt32(int32_t& v);
+            void        ReadInt64(int64_t& v);
+            void        ReadBool8(bool& v);
+            void        ReadFloat(float& v);
+            void        ReadDouble(double& v);
+
+            // Checked array reads. The bounds are checked once for the entire array.
+            void        ReadUint8(uint8_t* v, size_type count);
+            void        ReadUint16(uint16_t* v, size_type count);
+            void        ReadUint32(uint32_t* v, size_type count);
+            void        ReadUint64(uint64_t* v, size_type count);
+            void        ReadInt8(int8_t* v, size_type count);
+            void        ReadInt16(int16_t* v, size_type count);
+            void        ReadInt32(int32_t* v, size_type count);
+            void        ReadInt64(int64_t* v, size_type count);
+            void        ReadFloat(float* v, size_type count);
+            void        ReadDouble(double* v, size_type count);
+
+        protected:
+            template <typename T>
+            T           Get();
+
+            template <typename T>
+            void        ReadArray(T* v, size_type count);
+
+        protected:
+            const uint8_t* mpBegin;     /// The beginning of the buffer.
+            const uint8_t* mpCurrent;   /// The current position.
+            const uint8_t* mpEnd;       /// The end of the buffer.
+            bool           mSuccess;    /// False if any read has failed. See SetValid.
+        };
+
+
+
+        /// BufferWriter
+        ///
+        /// Writes basic types to a contiguous span of memory, converting them to 
+        /// endianType. This is the writing counterpart of BufferReader. The memory may
+        /// be, for example, the data of a FixedMemoryStream or the space returned by 
+        /// StreamBuffer::GetWriteSpan. The writer never grows the memory; a write 
+        /// beyond its end fails and makes the writer invalid.
+        ///
+        /// Example usage:
+        ///     size_type nAvailable;
+        ///     void*     pSpan = streamBuffer.GetWriteSpan(kPacketHeaderSize, nAvailable);
+        ///
+        ///     if(pSpan)
+        ///     {
+        ///         BufferWriter<kEndianBig> writer(pSpan, nAvailable);
+        ///
+        ///         writer.WriteUint32(packet.mId);
+        ///         writer.WriteUint16(packet.mFlags);
+        ///         writer.WriteFloat(packet.mWeight);
+        ///         streamBuffer.Commit(writer.GetPosition());
+        ///     }
+        ///
+        template <Endian endianType = kEndianBig>
+        class BufferWriter
+        {
+        public:
+            BufferWriter();
+            BufferWriter(void* pData, size_type nCapacity);
+
+            /// SetBuffer
+            /// Sets the memory to write to, sets the position to zero and makes the writer valid.
+            void        SetBuffer(void* pData, size_type nCapacity);
+
+            void        SetValid(bool success);
+            bool        IsValid() const;
+            operator    bool() const;
+            bool        operator !() const;
+
+            void*       GetData() const;                    /// Returns the beginning of the buffer.
+            void*       GetCurrent() const;                 /// Returns the current position within the buffer.
+            size_type   getSize() const;                    /// Returns the capacity of the buffer.
+            size_type   GetPosition() const;                /// Returns the number of bytes written, if the writer was used only sequentially.
+            bool        SetPosition(size_type nPosition);   /// Returns false, without invalidating the writer, if nPosition is beyond the end.
+            size_type   GetAvailable() const;
+
+            /// Require
+            /// Returns true if there is space for at least nSize bytes, else makes the 
+            /// writer invalid and returns false. Also returns false if the writer is invalid.
+            bool        Require(size_type nSize);
+
+            /// Skip
+            /// Advances the position by nSize bytes, as with a write, leaving them unmodified.
+            void        Skip(size_type nSize);
+
+            // Unchecked writes. The caller must first have called Require for the data.
+            void        PutUint8(uint8_t v);
+            void        PutUint16(uint16_t v);
+            void        PutUint32(uint32_t v);
+            void        PutUint64(uint64_t v);
+            void        PutInt8(int8_t v);
+            void        PutInt16(int16_t v);
+            void        PutInt32(int32_t v);
+            void        PutInt64(int64_t v);
+            void        PutBool8(bool v);
+            void        PutFloat(float v);
+            void        PutDouble(double v);
+
+            // Checked writes. Upon failure, nothing is written and the writer is invalid.
+            void        WriteUint8(uint8_t v);
+            void        WriteUint16(uint16_t v);
+            void        WriteUint32(uint32_t v);
+            void        WriteUint64(uint64_t v);
+            void        WriteInt8(int8_t v);
+            void        WriteInt16(int16_t v);
+            void        WriteInt32(int32_t v);
+            void        WriteInt64(int64_t v);
+            void        WriteBool8(bool v);
+            void        WriteFloat(float v);
+            void        WriteDouble(double v);
+
+            // Checked array writes. The bounds are checked once for the entire array.
+            void        WriteUint8(const uint8_t* v, size_type count);
+            void        WriteUint16(const uint16_t* v, size_type count);
+            void        WriteUint32(const uint32_t* v, size_type count);
+            void        WriteUint64(const uint64_t* v, size_type count);
+            void        WriteInt8(const int8_t* v, size_type count);
+            void        WriteInt16(const int16_t* v, size_type count);
+            void        WriteInt32(const int32_t* v, size_type count);
+            void        WriteInt64(const int64_t* v, size_type count);
+            void        WriteFloat(const float* v, size_type count);
+            void        WriteDouble(const double* v, size_type count);
+
+        protected:
+            template <typename T>
+            void        Put(T v);
+
+            template <typename T>
+            void        WriteArray(const T* v, size_type count);
+
+        protected:
+            uint8_t*    mpBegin;        /// The beginning of the buffer.
+            uint8_t*    mpCurrent;      /// The current position.
+            uint8_t*    mpEnd;          /// The end of the buffer.
+            bool        mSuccess;       /// False if any write has failed. See SetValid.
+        };
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+namespace IO
+{
+
+namespace BufferAdapterInternal
+{
+    // These are the same swizzles as used by the StreamAdapter functions. The 
+    // compiler recognizes them and generates single byte swap instructions.
+    inline uint8_t  Swizzle(uint8_t x)  { return x; }
+    inline uint16_t Swizzle(uint16_t x) { return (uint16_t)((x >> 8) | (x << 8)); }
+    inline uint32_t Swizzle(uint32_t x) { return (uint32_t)((x >> 24) | ((x << 24) & 0xff000000) | ((x << 8) & 0x00ff0000) | ((x >> 8) & 0x0000ff00)); }
+    inline uint64_t Swizzle(uint64_t x) { return ((uint64_t)Swizzle((uint32_t)x) << 32) | Swizzle((uint32_t)(x >> 32)); }
+
+    // Maps a type to the unsigned type of the same size, which is what gets swizzled.
+    template <size_t n> struct UintOfSize;
+    template <> struct UintOfSize<1> { typedef uint8_t  Type; };
+    template <> struct UintOfSize<2> { typedef uint16_t Type; };
+    template <> struct UintOfSize<4> { typedef uint32_t Type; };
+    template <> struct UintOfSize<8> { typedef uint64_t Type; };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BufferReader
+///////////////////////////////////////////////////////////////////////////////
+
+template <Endian endianType>
+inline BufferReader<endianType>::BufferReader()
+    : mpBegin(NULL), mpCurrent(NULL), mpEnd(NULL), mSuccess(true)
+{
+}
+
+
+template <Endian endianType>
+inline BufferReader<endianType>::BufferReader(const void* pData, size_type nSize)
+{
+    SetBuffer(pData, nSize);
+}
+
+
+template <Endian endianType>
+inline void BufferReader<endianType>::SetBuffer(const void* pData, size_type nSize)
+{
+    mpBegin   = (const uint8_t*)pData;
+    mpCurrent = mpBegin;
+    mpEnd     = mpBegin + nSize;
+    mSuccess  = true;
+}
+
+
+template <Endian endianType>
+inline void BufferReader<endianType>::SetValid(bool success)
+{
+    mSuccess = success;
+}
+
+
+template <Endian endianType>
+inline bool BufferReader<endianType>::IsValid() const
+{
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline BufferReader<endianType>::operator bool() const
+{
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline bool BufferReader<endianType>::operator!() const
+{
+    return !mSuccess;
+}
+
+
+template <Endian endianType>
+inline const void* BufferReader<endianType>::GetData() const
+{
+    return mpBegin;
+}
+
+
+template <Endian endianType>
+inline const void* BufferReader<endianType>::GetCurrent() const
+{
+    return mpCurrent;
+}
+
+
+template <Endian endianType>
+inline size_type BufferReader<endianType>::getSize() const
+{
+    return (size_type)(mpEnd - mpBegin);
+}
+
+
+template <Endian endianType>
+inline size_type BufferReader<endianType>::GetPosition() const
+{
+    return (size_type)(mpCurrent - mpBegin);
+}
+
+
+template <Endian endianType>
+inline bool BufferReader<endianType>::SetPosition(size_type nPosition)
+{
+    if(nPosition <= getSize())
+    {
+        mpCurrent = mpBegin + nPosition;
+        return true;
+    }
+
+    return false;
+}
+
+
+template <Endian endianType>
+inline size_type BufferReader<endianType>::GetAvailable() const
+{
+    return (size_type)(mpEnd - mpCurrent);
+}
+
+
+template <Endian endianType>
+inline bool BufferReader<endianType>::Require(size_type nSize)
+{
+    mSuccess = mSuccess && (nSize <= GetAvailable());
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline void BufferReader<endianType>::Skip(size_type nSize)
+{
+    if(Require(nSize))
+        mpCurrent += nSize;
+}
+
+
+template <Endian endianType>
+template <typename T>
+inline T BufferReader<endianType>::Get()
+{
+    typedef typename BufferAdapterInternal::UintOfSize<sizeof(T)>::Type Uint;
+
+    Uint n;
+    memcpy(&n, mpCurrent, sizeof(n)); // The data needn't be aligned. This compiles to a single load.
+    mpCurrent += sizeof(n);
+
+    if(endianType != kEndianLocal)
+        n = BufferAdapterInternal::Swizzle(n);
+
+    T v;
+    memcpy(&v, &n, sizeof(v));
+    return v;
+}
+
+
+template <Endian endianType>
+template <typename T>
+inline void BufferReader<endianType>::ReadArray(T* v, size_type count)
+{
+    if((count <= (GetAvailable() / sizeof(T))) && mSuccess)
+    {
+        if((endianType == kEndianLocal) || (sizeof(T) == 1))
+        {
+            memcpy(v, mpCurrent, (size_t)(count * sizeof(T)));
+            mpCurrent += (count * sizeof(T));
+        }
+        else
+        {
+            for(size_type i = 0; i < count; i++)
+                v[i] = Get<T>();
+        }
+    }
+    else
+        mSuccess = false;
+}
+
+
+template <Endian endianType> inline uint8_t  BufferReader<endianType>::GetUint8()  { return Get<uint8_t>();  }
+template <Endian endianType> inline uint16_t BufferReader<endianType>::GetUint16() { return Get<uint16_t>(); }
+template <Endian endianType> inline uint32_t BufferReader<endianType>::GetUint32() { return Get<uint32_t>(); }
+template <Endian endianType> inline uint64_t BufferReader<endianType>::GetUint64() { return Get<uint64_t>(); }
+template <Endian endianType> inline int8_t   BufferReader<endianType>::GetInt8()   { return Get<int8_t>();   }
+template <Endian endianType> inline int16_t  BufferReader<endianType>::GetInt16()  { return Get<int16_t>();  }
+template <Endian endianType> inline int32_t  BufferReader<endianType>::GetInt32()  { return Get<int32_t>();  }
+template <Endian endianType> inline int64_t  BufferReader<endianType>::GetInt64()  { return Get<int64_t>();  }
+template <Endian endianType> inline bool     BufferReader<endianType>::GetBool8()  { return Get<uint8_t>() != 0; }
+template <Endian endianType> inline float    BufferReader<endianType>::GetFloat()  { return Get<float>();    }
+template <Endian endianType> inline double   BufferReader<endianType>::GetDouble() { return Get<double>();   }
+
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint8(uint8_t& v)   { if(Require(sizeof(v))) v = Get<uint8_t>();  }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint16(uint16_t& v) { if(Require(sizeof(v))) v = Get<uint16_t>(); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint32(uint32_t& v) { if(Require(sizeof(v))) v = Get<uint32_t>(); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint64(uint64_t& v) { if(Require(sizeof(v))) v = Get<uint64_t>(); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt8(int8_t& v)     { if(Require(sizeof(v))) v = Get<int8_t>();   }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt16(int16_t& v)   { if(Require(sizeof(v))) v = Get<int16_t>();  }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt32(int32_t& v)   { if(Require(sizeof(v))) v = Get<int32_t>();  }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt64(int64_t& v)   { if(Require(sizeof(v))) v = Get<int64_t>();  }
+template <Endian endianType> inline void BufferReader<endianType>::ReadBool8(bool& v)      { if(Require(1))         v = (Get<uint8_t>() != 0); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadFloat(float& v)     { if(Require(sizeof(v))) v = Get<float>();    }
+template <Endian endianType> inline void BufferReader<endianType>::ReadDouble(double& v)   { if(Require(sizeof(v))) v = Get<double>();   }
+
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint8(uint8_t* v, size_type count)   { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint16(uint16_t* v, size_type count) { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint32(uint32_t* v, size_type count) { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadUint64(uint64_t* v, size_type count) { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt8(int8_t* v, size_type count)     { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt16(int16_t* v, size_type count)   { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt32(int32_t* v, size_type count)   { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadInt64(int64_t* v, size_type count)   { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadFloat(float* v, size_type count)     { ReadArray(v, count); }
+template <Endian endianType> inline void BufferReader<endianType>::ReadDouble(double* v, size_type count)   { ReadArray(v, count); }
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BufferWriter
+///////////////////////////////////////////////////////////////////////////////
+
+template <Endian endianType>
+inline BufferWriter<endianType>::BufferWriter()
+    : mpBegin(NULL), mpCurrent(NULL), mpEnd(NULL), mSuccess(true)
+{
+}
+
+
+template <Endian endianType>
+inline BufferWriter<endianType>::BufferWriter(void* pData, size_type nCapacity)
+{
+    SetBuffer(pData, nCapacity);
+}
+
+
+template <Endian endianType>
+inline void BufferWriter<endianType>::SetBuffer(void* pData, size_type nCapacity)
+{
+    mpBegin   = (uint8_t*)pData;
+    mpCurrent = mpBegin;
+    mpEnd     = mpBegin + nCapacity;
+    mSuccess  = true;
+}
+
+
+template <Endian endianType>
+inline void BufferWriter<endianType>::SetValid(bool success)
+{
+    mSuccess = success;
+}
+
+
+template <Endian endianType>
+inline bool BufferWriter<endianType>::IsValid() const
+{
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline BufferWriter<endianType>::operator bool() const
+{
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline bool BufferWriter<endianType>::operator!() const
+{
+    return !mSuccess;
+}
+
+
+template <Endian endianType>
+inline void* BufferWriter<endianType>::GetData() const
+{
+    return mpBegin;
+}
+
+
+template <Endian endianType>
+inline void* BufferWriter<endianType>::GetCurrent() const
+{
+    return mpCurrent;
+}
+
+
+template <Endian endianType>
+inline size_type BufferWriter<endianType>::getSize() const
+{
+    return (size_type)(mpEnd - mpBegin);
+}
+
+
+template <Endian endianType>
+inline size_type BufferWriter<endianType>::GetPosition() const
+{
+    return (size_type)(mpCurrent - mpBegin);
+}
+
+
+template <Endian endianType>
+inline bool BufferWriter<endianType>::SetPosition(size_type nPosition)
+{
+    if(nPosition <= getSize())
+    {
+        mpCurrent = mpBegin + nPosition;
+        return true;
+    }
+
+    return false;
+}
+
+
+template <Endian endianType>
+inline size_type BufferWriter<endianType>::GetAvailable() const
+{
+    return (size_type)(mpEnd - mpCurrent);
+}
+
+
+template <Endian endianType>
+inline bool BufferWriter<endianType>::Require(size_type nSize)
+{
+    mSuccess = mSuccess && (nSize <= GetAvailable());
+    return mSuccess;
+}
+
+
+template <Endian endianType>
+inline void BufferWriter<endianType>::Skip(size_type nSize)
+{
+    if(Require(nSize))
+        mpCurrent += nSize;
+}
+
+
+template <Endian endianType>
+template <typename T>
+inline void BufferWriter<endianType>::Put(T v)
+{
+    typedef typename BufferAdapterInternal::UintOfSize<sizeof(T)>::Type Uint;
+
+    Uint n;
+    memcpy(&n, &v, sizeof(n));
+
+    if(endianType != kEndianLocal)
+        n = BufferAdapterInternal::Swizzle(n);
+
+    memcpy(mpCurrent, &n, sizeof(n)); // The data needn't be aligned. This compiles to a single store.
+    mpCurrent += sizeof(n);
+}
+
+
+template <Endian endianType>
+template <typename T>
+inline void BufferWriter<endianType>::WriteArray(const T* v, size_type count)
+{
+    if((count <= (GetAvailable() / sizeof(T))) && mSuccess)
+    {
+        if((endianType == kEndianLocal) || (sizeof(T) == 1))
+        {
+            memcpy(mpCurrent, v, (size_t)(count * sizeof(T)));
+            mpCurrent += (count * sizeof(T));
+        }
+        else
+        {
+            for(size_type i = 0; i < count; i++)
+                Put<T>(v[i]);
+        }
+    }
+    else
+        mSuccess = false;
+}
+
+
+template <Endian endianType> inline void BufferWriter<endianType>::PutUint8(uint8_t v)   { Put<uint8_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::PutUint16(uint16_t v) { Put<uint16_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::PutUint32(uint32_t v) { Put<uint32_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::PutUint64(uint64_t v) { Put<uint64_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::PutInt8(int8_t v)     { Put<int8_t>(v);   }
+template <Endian endianType> inline void BufferWriter<endianType>::PutInt16(int16_t v)   { Put<int16_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::PutInt32(int32_t v)   { Put<int32_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::PutInt64(int64_t v)   { Put<int64_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::PutBool8(bool v)      { Put<uint8_t>(v ? 1 : 0); }
+template <Endian endianType> inline void BufferWriter<endianType>::PutFloat(float v)     { Put<float>(v);    }
+template <Endian endianType> inline void BufferWriter<endianType>::PutDouble(double v)   { Put<double>(v);   }
+
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint8(uint8_t v)   { if(Require(sizeof(v))) Put<uint8_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint16(uint16_t v) { if(Require(sizeof(v))) Put<uint16_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint32(uint32_t v) { if(Require(sizeof(v))) Put<uint32_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint64(uint64_t v) { if(Require(sizeof(v))) Put<uint64_t>(v); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt8(int8_t v)     { if(Require(sizeof(v))) Put<int8_t>(v);   }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt16(int16_t v)   { if(Require(sizeof(v))) Put<int16_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt32(int32_t v)   { if(Require(sizeof(v))) Put<int32_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt64(int64_t v)   { if(Require(sizeof(v))) Put<int64_t>(v);  }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteBool8(bool v)      { if(Require(1))         Put<uint8_t>(v ? 1 : 0); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteFloat(float v)     { if(Require(sizeof(v))) Put<float>(v);    }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteDouble(double v)   { if(Require(sizeof(v))) Put<double>(v);   }
+
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint8(const uint8_t* v, size_type count)   { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint16(const uint16_t* v, size_type count) { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint32(const uint32_t* v, size_type count) { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteUint64(const uint64_t* v, size_type count) { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt8(const int8_t* v, size_type count)     { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt16(const int16_t* v, size_type count)   { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt32(const int32_t* v, size_type count)   { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteInt64(const int64_t* v, size_type count)   { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteFloat(const float* v, size_type count)     { WriteArray(v, count); }
+template <Endian endianType> inline void BufferWriter<endianType>::WriteDouble(const double* v, size_type count)   { WriteArray(v, count); }
+
+
+} // namespace IO
+} // namespace EA
+
+
+#endif // Header include guard
@@ -41,6 +41,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <eaio/EAFileDirectory.h>
 #include <eaio/EAFileStream.h>
 #include <eaio/EAFileUtil.h>
+#include <eaio/EAStreamAdapter.h>
 #include <eaio/FnEncode.h>
 #include <eaio/PathString.h>
 #include <string.h>
@@ -71,6 +72,11 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
     #include <sys/types.h>
     #include <utime.h>		// Some versions may require <sys/utime.h>
 
+    #if defined(EA_PLATFORM_LINUX)
+        #include <sys/ioctl.h>
+        #include <linux/fs.h>   // FICLONE
+    #endif
+
     #ifndef S_ISREG
         #define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
     #endif
@@ -695,13 +701,17 @@ EAIO_API bool File::move(const char8_t* pPathSource, const char8_t* pPathDestina
 ///////////////////////////////////////////////////////////////////////////////
 // File::copy
 //
-EAIO_API bool File::copy(const char16_t* pPathSource, const char16_t* pPathDestination, bool bOverwriteIfPresent)
+EAIO_API bool File::copy(const char16_t* pPathSource, const char16_t* pPathDestination, bool bOverwriteIfPresent, size_type* pBytesCopied)
 {
     #if defined(EA_PLATFORM_WINDOWS)
 
-        return ::CopyFileW(pPathSource, pPathDestination, !bOverwriteIfPresent) != 0;
+        const bool bResult = (::CopyFileW(pPathSource, pPathDestination, !bOverwriteIfPresent) != 0);
 
-    #elif defined(EA_PLATFORM_XENON)
+        if(pBytesCopied)
+            *pBytesCopied = bResult ? getSize(pPathDestination) : kSizeTypeError;
+        return bResult;
+
+    #elif defined(EA_PLATFORM_XENON) || defined(EA_PLATFORM_LINUX)
 
         char8_t srcPath8[kMaxPathLength];
         StrlcpyUTF16ToUTF8(srcPath8, kMaxPathLength, pPathSource);
@@ -709,11 +719,13 @@ EAIO_API bool File::copy(const char16_t* pPathSource, const char16_t* pPathDesti
         char8_t dstPath8[kMaxPathLength];
         StrlcpyUTF16ToUTF8(dstPath8, kMaxPathLength, pPathDestination);
 
-
-        return ::CopyFileA(srcPath8, dstPath8, !bOverwriteIfPresent) != 0;
+        return copy(srcPath8, dstPath8, bOverwriteIfPresent, pBytesCopied);
 
     #elif defined(EA_PLATFORM_UNIX) || defined(EA_PLATFORM_PS3)
 
+        if(pBytesCopied)
+            *pBytesCopied = kSizeTypeError;
+
         if(bOverwriteIfPresent || !exists(pPathDestination))
         {
             char8_t srcPath8[kMaxPathLength];
@@ -765,6 +777,8 @@ EAIO_API bool File::copy(const char16_t* pPathSource, const char16_t* pPathDesti
                 ::close(nFileHandleSource);
             }
 
+            if((result >= 0) && pBytesCopied)
+                *pBytesCopied = getSize(pPathDestination);
             return result >= 0;
         }
 
@@ -774,20 +788,68 @@ EAIO_API bool File::copy(const char16_t* pPathSource, const char16_t* pPathDesti
 
         // Bug Paul Pedriana to finish this for the given platform.
         (void)pPathSource; (void)pPathDestination; (void)bOverwriteIfPresent;
+        if(pBytesCopied)
+            *pBytesCopied = kSizeTypeError;
         return false;
 
     #endif
 }
 
-EAIO_API bool File::copy(const char8_t* pPathSource, const char8_t* pPathDestination, bool bOverwriteIfPresent)
+EAIO_API bool File::copy(const char8_t* pPathSource, const char8_t* pPathDestination, bool bOverwriteIfPresent, size_type* pBytesCopied)
 {
     #if defined(EA_PLATFORM_WINDOWS) || \
         defined(EA_PLATFORM_XENON)
 
-        return ::CopyFileA(pPathSource, pPathDestination, !bOverwriteIfPresent) != 0;
+        const bool bResult = (::CopyFileA(pPathSource, pPathDestination, !bOverwriteIfPresent) != 0);
+
+        if(pBytesCopied)
+            *pBytesCopied = bResult ? getSize(pPathDestination) : kSizeTypeError;
+        return bResult;
+
+    #elif defined(EA_PLATFORM_LINUX)
+
+        size_type nCopied = kSizeTypeError;
+
+        if(bOverwriteIfPresent || !exists(pPathDestination))
+        {
+            FileStream  source(pPathSource);
+            FileStream  destination(pPathDestination);
+            struct stat statSource;
+
+            if(source.open(kAccessFlagRead, kCDOpenExisting) && 
+               (fstat(source.GetFileHandle(), &statSource) == 0) &&
+               destination.open(kAccessFlagWrite, kCDCreateAlways))
+            {
+                #if defined(FICLONE)
+                    // A reflink makes the destination share the data blocks of the source (copy-on-write),
+                    // so no data is copied. This fails if the file system doesn't support it or if the 
+                    // files are on different file systems.
+                    if(ioctl(destination.GetFileHandle(), FICLONE, source.GetFileHandle()) == 0)
+                        nCopied = (size_type)statSource.st_size;
+                    else
+                #endif
+                        nCopied = copyStream(&source, &destination); // This uses copy_file_range where possible.
+
+                if(nCopied != kSizeTypeError)
+                {
+                    // We do this last, as writing the data updates the modification time.
+                    const struct timespec times[2] = { statSource.st_atim, statSource.st_mtim };
+
+                    fchmod(destination.GetFileHandle(), statSource.st_mode & 07777);
+                    futimens(destination.GetFileHandle(), times);
+                }
+            }
+        }
+
+        if(pBytesCopied)
+            *pBytesCopied = nCopied;
+        return (nCopied != kSizeTypeError);
 
     #elif defined(EA_PLATFORM_UNIX) || defined(EA_PLATFORM_PS3)
 
+        if(pBytesCopied)
+            *pBytesCopied = kSizeTypeError;
+
         if(bOverwriteIfPresent || !exists(pPathDestination))
         {
             int result = 0;
@@ -831,6 +893,8 @@ EAIO_API bool File::copy(const char8_t* pPathSource, const char8_t* pPathDestina
                 ::close(nFileHandleSource);
             }
 
+            if((result >= 0) && pBytesCopied)
+                *pBytesCopied = getSize(pPathDestination);
             return result >= 0;
         }
 
@@ -840,6 +904,8 @@ EAIO_API bool File::copy(const char8_t* pPathSource, const char8_t* pPathDestina
 
         // Bug Paul Pedriana to finish this for the given platform.
         (void)pPathSource; (void)pPathDestination; (void)bOverwriteIfPresent;
+        if(pBytesCopied)
+            *pBytesCopied = kSizeTypeError;
         return false;
 
     #endif
@@ -144,8 +144,15 @@ namespace EA
             /// is true, then this function will overwrite an existing destination 
             /// file if it already exists. If false, then the copy will do nothing
             /// and return false if the destination file already exists.
-            EAIO_API bool copy(const char16_t* pPathSource, const char16_t* pPathDestination, bool bOverwriteIfPresent = true);
-            EAIO_API bool copy(const char8_t* pPathSource, const char8_t* pPathDestination, bool bOverwriteIfPresent = true);
+            /// If pBytesCopied is non-NULL, it receives the number of bytes copied,
+            /// or kSizeTypeError upon failure.
+            /// On Linux, the copy is made as a reflink where the file system supports 
+            /// it (e.g. btrfs, XFS), in which case the data blocks are shared rather than 
+            /// copied; else it is made within the kernel where possible (see copyStream).
+            /// The permissions and access/modification times of the source are replicated.
+            /// On Windows, CopyFile is used, which likewise replicates attributes and times.
+            EAIO_API bool copy(const char16_t* pPathSource, const char16_t* pPathDestination, bool bOverwriteIfPresent = true, size_type* pBytesCopied = NULL);
+            EAIO_API bool copy(const char8_t* pPathSource, const char8_t* pPathDestination, bool bOverwriteIfPresent = true, size_type* pBytesCopied = NULL);
 
             /// File::getSize
             /// Returns the length of the file at the given path. Returns (size_type)-1
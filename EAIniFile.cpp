@@ -430,6 +430,7 @@ IniFile::IniFile(const char16_t* pPath, int optionFlags, EA::Allocator::ICoreAll
     mbFileIsopenForWriting(false),
     mbLeaveFileopenBetweenOperations((optionFlags & kOptionLeaveFileopen) != 0),
     mbreadEntryCacheReady(false),
+    mbReplaceAtomic(false),
     mFileBusyWaitMs(0),
     mSectionPositionMap(Allocator::EAIOEASTLCoreAllocator(EAIO_ALLOC_PREFIX "EAIniFile", 
                         pCoreAllocator ? pCoreAllocator : EA::Allocator::ICoreAllocator::getDefaultAllocator())),
@@ -451,6 +452,7 @@ IniFile::IniFile(EA::IO::IStream* pStream, EA::Allocator::ICoreAllocator* pCoreA
     mbFileIsopenForWriting(false),
     mbLeaveFileopenBetweenOperations(true),
     mbreadEntryCacheReady(false),
+    mbReplaceAtomic(false),
     mFileBusyWaitMs(0),
     mSectionPositionMap(Allocator::EAIOEASTLCoreAllocator(EAIO_ALLOC_PREFIX "EAIniFile", 
                         pCoreAllocator ? pCoreAllocator : EA::Allocator::ICoreAllocator::getDefaultAllocator())),
@@ -479,9 +481,10 @@ void IniFile::setAllocator(EA::Allocator::ICoreAllocator* pCoreAllocator)
 //
 IniFile::~IniFile()
 {
-    // There is nothing to do.
     // If mpStream was user-specified, we leave it as-is.
-    // If mpStream points to mFileStream, it is automatically closed here.
+    // If mpStream points to mFileStream, we close it here. With kOptionReplaceAtomic, 
+    // merely destroying mFileStream would discard the edits.
+    IniFile::close();
 }
 
 
@@ -492,6 +495,10 @@ int IniFile::getOption(int option) const
 {
      if(option == kOptionLeaveFileopen)
           return mbLeaveFileopenBetweenOperations ? 1 : 0;
+     else if(option == kOptionBusyWaitTime)
+          return (int)mFileBusyWaitMs;
+     else if(option == kOptionReplaceAtomic)
+          return mbReplaceAtomic ? 1 : 0;
      return 0;
 }
 
@@ -516,6 +523,10 @@ void IniFile::setOption(int option, int value)
     {
         mFileBusyWaitMs = (uint32_t)(unsigned)value;
     }
+    else if(option == kOptionReplaceAtomic)
+    {
+        mbReplaceAtomic = (value != 0);
+    }
 }
 
 
@@ -609,7 +620,14 @@ bool IniFile::open(int nAccessFlags)
         }
         else if(mpStream == &mFileStream)
         {
-            const int nCreationMode = (nAccessFlags & IO::kAccessFlagWrite) ? IO::kCDOpenAlways      : IO::kCDOpenExisting;
+            // With kOptionReplaceAtomic, edits are made to a copy of the file which replaces it upon close, 
+            // so that a crash or a concurrent reader never sees a partially rewritten file.
+            #if EAIO_REPLACE_ATOMIC_ENABLED
+                const int nCreationModeWrite = mbReplaceAtomic ? IO::kCDReplaceAtomic : IO::kCDOpenAlways;
+            #else
+                const int nCreationModeWrite = IO::kCDOpenAlways;
+            #endif
+            const int nCreationMode = (nAccessFlags & IO::kAccessFlagWrite) ? nCreationModeWrite         : IO::kCDOpenExisting;
             const int nShareMode    = (nAccessFlags & IO::kAccessFlagWrite) ? FileStream::kShareNone : FileStream::kShareRead;
 
             uint32_t nCurrentTime = 0;
@@ -653,7 +671,7 @@ bool IniFile::close()
     if(mpStream)
     {
         if((mpStream == &mFileStream) && mpStream->GetAccessFlags()) // If stream is internal and it is open...
-            mpStream->close();
+            mFileStream.Commit(); // With kCDReplaceAtomic, this publishes the edits.
 
         mSectionPositionMap.clear();
         mbreadEntryCacheReady = false;
@@ -662,6 +680,26 @@ bool IniFile::close()
     return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// DiscardEdits
+//
+// Called when writeEntry fails part way through. If the file was opened with
+// kOptionReplaceAtomic, the edits made since it was opened are discarded and
+// the file is left unchanged. Otherwise the file is just closed, as it may 
+// be partially rewritten and our cached section offsets can't be trusted.
+//
+void IniFile::DiscardEdits()
+{
+    if(mpStream)
+    {
+        if((mpStream == &mFileStream) && mpStream->GetAccessFlags())
+            mFileStream.Discard();
+
+        mSectionPositionMap.clear();
+        mbreadEntryCacheReady = false;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // GetEncoding
 //
@@ -848,8 +886,12 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                     sToWrite1.sprintf(kSectionFormat, pSection, kTextFileNewLineString);
                     sToWrite2.sprintf(kKeyFormat, pKey, pValue, kTextFileNewLineString);
 
-                    ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length());
-                    ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length());
+                    if(!ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length()) ||
+                       !ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length()))
+                    {
+                        DiscardEdits();
+                        return false;
+                    }
 
                     if(!mbLeaveFileopenBetweenOperations)
                         close();
@@ -908,16 +950,24 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                         sToWrite1.sprintf(kValueFormat, kTextFileNewLineString);
                 }
 
-                ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length());        // Todo: Now that RZXGlobal has a decent suite or Unicode support, we can make a Unicode .ini file.
+                if(sToWrite1.length() && !ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length())) // Todo: Now that RZXGlobal has a decent suite or Unicode support, we can make a Unicode .ini file.
+                {
+                    DiscardEdits();
+                    return false;
+                }
 
                 // Now write the section header itself.
                 const IO::off_type nHeaderSectionPosition(mpStream->GetPosition()); // The position will be at the end of the file.
 
                 sToWrite1.sprintf(kSectionFormat, pSection, kTextFileNewLineString);
-                ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length());
-
                 sToWrite2.sprintf(kKeyFormat, pKey, pValue, kTextFileNewLineString);
-                ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length());
+
+                if(!ConvertAndWriteStream(sToWrite1.data(), sToWrite1.length()) ||
+                   !ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length()))
+                {
+                    DiscardEdits();
+                    return false;
+                }
 
                 // Update our data map with the new data.
                 mSectionPositionMap.insert(SectionLowerToPositionMap::value_type(sSectionLower, nHeaderSectionPosition));
@@ -959,19 +1009,26 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                                         IO::size_type   nBytesToSave = mpStream->getSize() - nPositionOfCurrentLine;
                                         char16_t* const pData        = (char16_t*)pAllocator->Alloc((size_t)nBytesToSave * sizeof(char16_t), EAIO_ALLOC_PREFIX "EAIniFile", 0);
 
+                                        bool            bResult      = true;
+
                                         mpStream->SetPosition(nPositionOfCurrentLine);
                                         nBytesToSave = mpStream->Read(pData, nBytesToSave);
                                         if(nBytesToSave != kSizeTypeError)
                                         {
                                             mpStream->SetPosition(nPositionOfCurrentLine);
                                             sToWrite2.sprintf(kKeyFormat, pKey, pValue, kTextFileNewLineString);
-                                            ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length());
-                                            mpStream->Write(pData, nBytesToSave);                   // To do: Check the return value from Write.
-                                            mpStream->SetSize((size_type)mpStream->GetPosition());  // To do: Check the return value from SetSize.
+                                            bResult = ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length()) &&
+                                                      mpStream->Write(pData, nBytesToSave) &&
+                                                      mpStream->SetSize((size_type)mpStream->GetPosition());
                                         }
 
                                         pAllocator->Free(pData);
                                         mbreadEntryCacheReady = false; // We are writing into the middle of the file, so header offsets have almost certainly changed.
+                                        if(!bResult)
+                                        {
+                                            DiscardEdits();
+                                            return false;
+                                        }
                                         if(!mbLeaveFileopenBetweenOperations)
                                             close();
                                         return true;
@@ -998,20 +1055,27 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                                         size_type nBytesToSave                 = mpStream->getSize() - nPositionOfNextLine;
                                         char16_t* const pData                  = (char16_t*)pAllocator->Alloc((size_t)nBytesToSave * sizeof(char16_t), EAIO_ALLOC_PREFIX "EAIniFile", 0);
 
+                                        bool                   bResult         = true;
+
                                         // mpStream->SeekToPosition(nPositionOfNextLine); // Not necessary because we are already there.
                                         nBytesToSave = mpStream->Read(pData, nBytesToSave);
                                         if(nBytesToSave != kSizeTypeError)
                                         {
                                             mpStream->SetPosition(nPositionOfCurrentLine);
                                             sToWrite2.sprintf(kKeyFormat, pKey, pValue, kTextFileNewLineString);
-                                            ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length());
-                                            ConvertAndWriteStream(kTextFileNewLineString, EA::IO::EAIOStrlen16(kTextFileNewLineString)); // right before section name
-                                            mpStream->Write(pData, nBytesToSave);                   // To do: Check the return value from Write.
-                                            mpStream->SetSize((size_type)mpStream->GetPosition());  // To do: Check the return value from SetSize.
+                                            bResult = ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length()) &&
+                                                      ConvertAndWriteStream(kTextFileNewLineString, EA::IO::EAIOStrlen16(kTextFileNewLineString)) && // right before section name
+                                                      mpStream->Write(pData, nBytesToSave) &&
+                                                      mpStream->SetSize((size_type)mpStream->GetPosition());
                                         }
 
                                         pAllocator->Free(pData);
                                         mbreadEntryCacheReady = false; // We are writing into the middle of the file, so header offsets have almost certainly changed.
+                                        if(!bResult)
+                                        {
+                                            DiscardEdits();
+                                            return false;
+                                        }
                                         if(!mbLeaveFileopenBetweenOperations)
                                             close();
                                         return true;
@@ -1032,7 +1096,12 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                         //We hit the end of the file without finding the key nor the next header. So just append the key-value data.
                         mpStream->SetPosition(0, IO::kPositionTypeEnd);
                         sToWrite2.sprintf(kKeyFormat, pKey, pValue, kTextFileNewLineString);
-                        ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length());
+
+                        if(!ConvertAndWriteStream(sToWrite2.data(), sToWrite2.length()))
+                        {
+                            DiscardEdits();
+                            return false;
+                        }
 
                         if(!mbLeaveFileopenBetweenOperations)
                             close();
@@ -1049,8 +1118,7 @@ bool IniFile::writeEntry(const char16_t* pSection, const char16_t* pKey, const c
                 }
             } //End of: else{ //The section does exist already...
 
-            if(!mbLeaveFileopenBetweenOperations)
-                close();
+            DiscardEdits(); // The section offsets are corrupt, so we can't trust what has been written.
         } //End of: if(open(IO::kAccessFlagReadWrite))
         else
         {
@@ -128,7 +128,8 @@ namespace EA
             {
                 kOptionNone,
                 kOptionLeaveFileopen,   /// Enabled by default. Setting to 1 allows for faster but non-shared access, but setting to 0 allows slower but shareable access.
-                kOptionBusyWaitTime     /// Zero by default. The number of milliseconds to wait for an un-openable file to open. It sometimes happens that shared contention for an ini file causes a reader to not be able to read the file right away.
+                kOptionBusyWaitTime,    /// Zero by default. The number of milliseconds to wait for an un-openable file to open. It sometimes happens that shared contention for an ini file causes a reader to not be able to read the file right away.
+                kOptionReplaceAtomic    /// Disabled by default; set via setOption and takes effect when the file is next opened for writing. Requires EAIO_REPLACE_ATOMIC_ENABLED. If enabled, edits go to a copy of the file which replaces it upon close (see kCDReplaceAtomic), so a crash or a concurrent reader never sees a partially rewritten file, and a failed edit leaves the file unchanged. The cost is a copy of the whole file each time it is opened for writing and two fsyncs each time it is closed, which is per writeEntry if kOptionLeaveFileopen is disabled.
             };
 
             /// IniFile
@@ -139,6 +140,7 @@ namespace EA
 
             /// ~IniFile
             /// This destructor will not close the stream if the stream was user-specified.
+            /// Otherwise it closes the file, which commits any edits made with kOptionReplaceAtomic.
             virtual ~IniFile();
 
             /// setAllocator
@@ -253,6 +255,7 @@ namespace EA
             virtual bool GetFileLine16To16(String16& sLine);
             virtual bool GetFileLine(String16& sLine);
             virtual bool ConvertAndWriteStream(const char16_t* pchar, size_t size);
+            void         DiscardEdits();
             virtual int  readEntry(const char16_t* pSection, const char16_t* pKey, char16_t* pValue, size_t nValueLength);
 
             // Member typedef
@@ -270,6 +273,7 @@ namespace EA
             bool                        mbFileIsopenForWriting;             ///< True if file is open in write mode. Else read mode.
             bool                        mbLeaveFileopenBetweenOperations;   ///< This allows for faster access, but not shared acess.
             bool                        mbreadEntryCacheReady;              ///< readEntry caching
+            bool                        mbReplaceAtomic;                    ///< See kOptionReplaceAtomic.
             uint32_t                    mFileBusyWaitMs;                    ///< The number of milliseconds to wait for an un-openable file to open. Defaults to zero. It sometimes happens that shared contention for an ini file causes a reader to not be able to read the file right away.
             SectionLowerToPositionMap   mSectionPositionMap;                ///< Map of sections names to starting position in file.
             SectionLowerToSectionMap    mSectionNameMap;                    ///< Converts section names from stored lower case to actual case.
@@ -0,0 +1,72 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAMappedFileStream.h
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Declares the MappedFileStream class, which is a read-only IStream that 
+// is backed by a memory mapping of a file. The implementation is platform-
+// specific; on platforms which don't have one, EAIO_MAPPED_FILE_STREAM_ENABLED
+// is defined as 0 and the MappedFileStream class is not available.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EAMAPPEDFILESTREAM_H
+#define EAIO_EAMAPPEDFILESTREAM_H
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAFileStream.h>
+
+
+#if defined(EA_PLATFORM_LINUX)
+   #include <eaio/Unix/EAMappedFileStreamUnix.h>
+
+   #define EAIO_MAPPED_FILE_STREAM_ENABLED 1
+#else
+   #define EAIO_MAPPED_FILE_STREAM_ENABLED 0
+#endif
+
+
+#endif // Header include guard
+
+
+
+
+
+
+
+
+
+
+
+
+
+
@@ -0,0 +1,651 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EASharedBlockCache.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a process-wide, memory-budgeted cache of stream blocks which
+// is shared between streams and threads.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EASharedBlockCache.h>
+#include <eaio/Allocator.h>
+#include <eastl/coreallocator/icoreallocator_interface.h>
+#include <string.h> // memcpy, etc.
+#include <new>
+#include EA_ASSERT_HEADER
+#if EAIO_THREAD_SAFETY_ENABLED
+    #include <eathread/eathread_futex.h>
+#endif
+#if defined(EA_PLATFORM_UNIX)
+    #include <sys/types.h>
+    #include <sys/stat.h>
+#endif
+
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+namespace SharedBlockCacheLocal
+{
+    SharedBlockCache* gpSharedBlockCache = NULL;
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // AutoLock
+    //
+    // Locks a stripe for the lifetime of the AutoLock. This is a no-op if 
+    // thread safety is disabled.
+    //
+    #if EAIO_THREAD_SAFETY_ENABLED
+        typedef EA::Thread::AutoFutex AutoLock;
+    #else
+        struct AutoLock { template <typename T> AutoLock(T&) { } };
+    #endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stripe
+//
+struct SharedBlockCache::Stripe
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        EA::Thread::Futex mFutex;   /// Guards everything below and the stripe's blocks, other than the data of pinned blocks.
+    #else
+        int               mFutex;   /// Placeholder, so that AutoLock has something to refer to.
+    #endif
+    int*                  mpHashTable;          /// The stripe's part of SharedBlockCache::mpHashTable.
+    int                   mnLRUHead;            /// The most recently used block.
+    int                   mnLRUTail;            /// The least recently used block. Replacement searches from here for an unpinned block.
+    uint32_t              mnGeneration;         /// Incremented by every Invalidate, so that a read which raced with one isn't published.
+    int                   mnBlockUsedCount;     /// Number of valid blocks.
+    int                   mnBlockPinCount;      /// Number of pinned blocks.
+    uint64_t              mnHitCount;
+    uint64_t              mnMissCount;
+    uint64_t              mnEvictCount;
+    uint64_t              mnFailCount;
+
+    Stripe() 
+      : mFutex(), mpHashTable(NULL), mnLRUHead(kBlockNone), mnLRUTail(kBlockNone), mnGeneration(0), 
+        mnBlockUsedCount(0), mnBlockPinCount(0), mnHitCount(0), mnMissCount(0), mnEvictCount(0), mnFailCount(0) { }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// getSharedBlockCache
+//
+EAIO_API SharedBlockCache* getSharedBlockCache()
+{
+    return SharedBlockCacheLocal::gpSharedBlockCache;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setSharedBlockCache
+//
+EAIO_API void setSharedBlockCache(SharedBlockCache* pSharedBlockCache)
+{
+    SharedBlockCacheLocal::gpSharedBlockCache = pSharedBlockCache;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SharedBlockCache
+//
+SharedBlockCache::SharedBlockCache(size_type nMemoryBudget, size_type nBlockSize, Allocator* pAllocator)
+  : mpAllocator(pAllocator ? pAllocator : IO::getAllocator()),
+    mnBlockSize(nBlockSize),
+    mnStripeBlockCount(0),
+    mnStripeHashTableSize(0),
+    mpStripeArray(NULL),
+    mpBlockArray(NULL),
+    mpHashTable(NULL),
+    mpBlockData(NULL)
+{
+    EA_ASSERT(nBlockSize && ((nBlockSize & (nBlockSize - 1)) == 0)); // Block positions are computed with masks.
+
+    const size_type nStripeBlockCount = nBlockSize ? (nMemoryBudget / nBlockSize / kStripeCount) : 0;
+
+    if(nStripeBlockCount && (nStripeBlockCount < 0x7fffffff / kStripeCount))
+    {
+        // We size the hash tables to have at least twice as many buckets as blocks.
+        for(mnStripeHashTableSize = 4; mnStripeHashTableSize < (nStripeBlockCount * 2); mnStripeHashTableSize *= 2)
+            { }
+
+        const size_type nBlockCount = nStripeBlockCount * kStripeCount;
+
+        void* const pStripeArray = mpAllocator->alloc(kStripeCount * sizeof(Stripe), EAIO_ALLOC_PREFIX "SharedBlockCache", 0);
+        mpBlockArray = (Block*)mpAllocator->alloc((size_t)(nBlockCount * sizeof(Block)), EAIO_ALLOC_PREFIX "SharedBlockCache", 0);
+        mpHashTable  = (int*)  mpAllocator->alloc((size_t)(kStripeCount * mnStripeHashTableSize * sizeof(int)), EAIO_ALLOC_PREFIX "SharedBlockCache", 0);
+        mpBlockData  = (char*) mpAllocator->alloc((size_t)(nBlockCount * nBlockSize), EAIO_ALLOC_PREFIX "SharedBlockCache", 0);
+
+        if(pStripeArray && mpBlockArray && mpHashTable && mpBlockData)
+        {
+            mnStripeBlockCount = (int)nStripeBlockCount;
+            mpStripeArray      = (Stripe*)pStripeArray;
+
+            // Array placement new may use memory beyond the elements to store the count,
+            // so we construct each element individually. The destructor destroys them.
+            for(int s = 0; s < kStripeCount; s++)
+            {
+                Stripe&   stripe      = *new(&mpStripeArray[s]) Stripe;
+                const int nBlockFirst = s * mnStripeBlockCount;
+
+                stripe.mpHashTable = mpHashTable + (s * mnStripeHashTableSize);
+
+                for(uint32_t i = 0; i < mnStripeHashTableSize; i++)
+                    stripe.mpHashTable[i] = kBlockNone;
+
+                for(int i = nBlockFirst; i < (nBlockFirst + mnStripeBlockCount); i++)
+                {
+                    Block& block = mpBlockArray[i];
+
+                    block.mStreamId    = SharedStreamId();
+                    block.mnBlockIndex = 0;
+                    block.mnSize       = 0;
+                    block.mnPinCount   = 0;
+                    block.mnHashNext   = kBlockNone;
+                    block.mbValid      = false;
+                    LinkBlockTail(stripe, i);
+                }
+            }
+        }
+        else
+        {
+            // Free whatever was allocated. The cache is disabled.
+            if(pStripeArray)
+                mpAllocator->free(pStripeArray, kStripeCount * sizeof(Stripe));
+            if(mpBlockArray)
+                mpAllocator->free(mpBlockArray, (size_t)(nBlockCount * sizeof(Block)));
+            if(mpHashTable)
+                mpAllocator->free(mpHashTable, (size_t)(kStripeCount * mnStripeHashTableSize * sizeof(int)));
+            if(mpBlockData)
+                mpAllocator->free(mpBlockData, (size_t)(nBlockCount * nBlockSize));
+
+            mpBlockArray          = NULL;
+            mpHashTable           = NULL;
+            mpBlockData           = NULL;
+            mnStripeHashTableSize = 0;
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ~SharedBlockCache
+//
+SharedBlockCache::~SharedBlockCache()
+{
+    if(mpStripeArray)
+    {
+        const size_type nBlockCount = (size_type)mnStripeBlockCount * kStripeCount;
+
+        #ifdef EA_DEBUG
+            for(int s = 0; s < kStripeCount; s++)
+                EA_ASSERT(mpStripeArray[s].mnBlockPinCount == 0); // If this fails, then somebody didn't Unpin.
+        #endif
+
+        for(int s = kStripeCount - 1; s >= 0; s--) // Destroy in the reverse order of construction.
+            mpStripeArray[s].~Stripe();
+
+        mpAllocator->free(mpStripeArray, kStripeCount * sizeof(Stripe));
+        mpAllocator->free(mpBlockArray, (size_t)(nBlockCount * sizeof(Block)));
+        mpAllocator->free(mpHashTable, (size_t)(kStripeCount * mnStripeHashTableSize * sizeof(int)));
+        mpAllocator->free(mpBlockData, (size_t)(nBlockCount * mnBlockSize));
+    }
+
+    if(SharedBlockCacheLocal::gpSharedBlockCache == this)
+        SharedBlockCacheLocal::gpSharedBlockCache = NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetHash
+//
+// This is an internal function.
+//
+// The low bits select the stripe and the high bits select the bucket within
+// the stripe, so that the two are independent.
+//
+uint32_t SharedBlockCache::GetHash(const SharedStreamId& streamId, size_type nBlockIndex) const
+{
+    uint64_t h = streamId.mnFile ^ (streamId.mnDevice * UINT64_C(0xD6E8FEB86659FD93)) ^ (streamId.mnTime * UINT64_C(0xFF51AFD7ED558CCD)) ^ 
+                 (streamId.mnSize * UINT64_C(0xC4CEB9FE1A85EC53)) ^ ((uint64_t)nBlockIndex * UINT64_C(0x9E3779B97F4A7C15));
+    h ^= (h >> 29);
+    h *= UINT64_C(0xBF58476D1CE4E5B9);
+    h ^= (h >> 32);
+    return (uint32_t)h;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FindBlock
+//
+// This is an internal function. The stripe must be locked.
+//
+int SharedBlockCache::FindBlock(const Stripe& stripe, uint32_t nHash, const SharedStreamId& streamId, size_type nBlockIndex) const
+{
+    int nBlock = stripe.mpHashTable[(nHash >> 16) & (mnStripeHashTableSize - 1)];
+
+    while((nBlock != kBlockNone) && ((mpBlockArray[nBlock].mnBlockIndex != nBlockIndex) || (mpBlockArray[nBlock].mStreamId != streamId)))
+        nBlock = mpBlockArray[nBlock].mnHashNext;
+
+    return nBlock;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LinkBlockHead / LinkBlockTail / UnlinkBlock
+//
+// These are internal functions. The stripe must be locked.
+//
+void SharedBlockCache::LinkBlockHead(Stripe& stripe, int nBlock)
+{
+    Block& block = mpBlockArray[nBlock];
+
+    block.mnLRUPrev = kBlockNone;
+    block.mnLRUNext = stripe.mnLRUHead;
+    if(stripe.mnLRUHead != kBlockNone)
+        mpBlockArray[stripe.mnLRUHead].mnLRUPrev = nBlock;
+    else
+        stripe.mnLRUTail = nBlock;
+    stripe.mnLRUHead = nBlock;
+}
+
+void SharedBlockCache::LinkBlockTail(Stripe& stripe, int nBlock)
+{
+    Block& block = mpBlockArray[nBlock];
+
+    block.mnLRUPrev = stripe.mnLRUTail;
+    block.mnLRUNext = kBlockNone;
+    if(stripe.mnLRUTail != kBlockNone)
+        mpBlockArray[stripe.mnLRUTail].mnLRUNext = nBlock;
+    else
+        stripe.mnLRUHead = nBlock;
+    stripe.mnLRUTail = nBlock;
+}
+
+void SharedBlockCache::UnlinkBlock(Stripe& stripe, int nBlock)
+{
+    Block& block = mpBlockArray[nBlock];
+
+    if(block.mnLRUPrev != kBlockNone)
+        mpBlockArray[block.mnLRUPrev].mnLRUNext = block.mnLRUNext;
+    else
+        stripe.mnLRUHead = block.mnLRUNext;
+
+    if(block.mnLRUNext != kBlockNone)
+        mpBlockArray[block.mnLRUNext].mnLRUPrev = block.mnLRUPrev;
+    else
+        stripe.mnLRUTail = block.mnLRUPrev;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RemoveBlock
+//
+// This is an internal function. The stripe must be locked.
+//
+// Removes a valid block from the hash table and makes it the least recently 
+// used. Its data and size are left as-is, as it may be pinned.
+//
+void SharedBlockCache::RemoveBlock(Stripe& stripe, int nBlock)
+{
+    Block& block = mpBlockArray[nBlock];
+    int*   pLink = &stripe.mpHashTable[(GetHash(block.mStreamId, block.mnBlockIndex) >> 16) & (mnStripeHashTableSize - 1)];
+
+    while(*pLink != nBlock)
+        pLink = &mpBlockArray[*pLink].mnHashNext;
+    *pLink = block.mnHashNext;
+
+    block.mnHashNext = kBlockNone;
+    block.mbValid    = false;
+    stripe.mnBlockUsedCount--;
+
+    UnlinkBlock(stripe, nBlock);
+    LinkBlockTail(stripe, nBlock);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pin
+//
+int SharedBlockCache::Pin(const SharedStreamId& streamId, size_type nBlockIndex, IStream* pStream)
+{
+    using namespace SharedBlockCacheLocal;
+
+    if(!mpStripeArray)
+        return kBlockNone;
+
+    const uint32_t nHash   = GetHash(streamId, nBlockIndex);
+    Stripe&        stripe  = mpStripeArray[nHash & (kStripeCount - 1)];
+    int            nBlock;
+    uint32_t       nGeneration;
+
+    { // Look up the block, and if it's not there, reserve the least recently used unpinned block for it.
+        AutoLock autoLock(stripe.mFutex);
+
+        nBlock = FindBlock(stripe, nHash, streamId, nBlockIndex);
+
+        if(nBlock != kBlockNone)
+        {
+            stripe.mnHitCount++;
+
+            if(mpBlockArray[nBlock].mnPinCount++ == 0)
+                stripe.mnBlockPinCount++;
+            UnlinkBlock(stripe, nBlock);
+            LinkBlockHead(stripe, nBlock);
+            return nBlock;
+        }
+
+        if(!pStream)
+            return kBlockNone;
+
+        stripe.mnMissCount++;
+
+        for(nBlock = stripe.mnLRUTail; (nBlock != kBlockNone) && mpBlockArray[nBlock].mnPinCount; nBlock = mpBlockArray[nBlock].mnLRUPrev)
+            { }
+
+        if(nBlock == kBlockNone) // If every block in the stripe is pinned...
+        {
+            stripe.mnFailCount++;
+            return kBlockNone;
+        }
+
+        if(mpBlockArray[nBlock].mbValid)
+        {
+            RemoveBlock(stripe, nBlock);
+            stripe.mnEvictCount++;
+        }
+
+        // The block is pinned but invalid, so nobody else will find or replace it while we read into it.
+        mpBlockArray[nBlock].mnPinCount = 1;
+        stripe.mnBlockPinCount++;
+        UnlinkBlock(stripe, nBlock);
+        LinkBlockHead(stripe, nBlock);
+        nGeneration = stripe.mnGeneration;
+    }
+
+    char* const     pData     = mpBlockData + ((size_type)nBlock * mnBlockSize);
+    const size_type nReadSize = pStream->SetPosition((off_type)(nBlockIndex * mnBlockSize)) ? pStream->Read(pData, mnBlockSize) : kSizeTypeError;
+
+    AutoLock autoLock(stripe.mFutex);
+    Block&   block = mpBlockArray[nBlock];
+
+    if(nReadSize == kSizeTypeError)
+    {
+        stripe.mnFailCount++;
+        block.mnPinCount = 0;
+        stripe.mnBlockPinCount--;
+        UnlinkBlock(stripe, nBlock);
+        LinkBlockTail(stripe, nBlock);
+        return kBlockNone;
+    }
+
+    block.mStreamId    = streamId;
+    block.mnBlockIndex = nBlockIndex;
+    block.mnSize       = nReadSize;
+
+    const int nBlockOther = FindBlock(stripe, nHash, streamId, nBlockIndex);
+
+    if(nBlockOther != kBlockNone) // If another thread read the same block meanwhile...
+    {
+        // We use theirs and return ours to the free end of the list.
+        block.mnPinCount = 0;
+        stripe.mnBlockPinCount--;
+        UnlinkBlock(stripe, nBlock);
+        LinkBlockTail(stripe, nBlock);
+
+        if(mpBlockArray[nBlockOther].mnPinCount++ == 0)
+            stripe.mnBlockPinCount++;
+        return nBlockOther;
+    }
+
+    if(nGeneration == stripe.mnGeneration) // If there was no Invalidate while we were reading...
+    {
+        int& nBucket = stripe.mpHashTable[(nHash >> 16) & (mnStripeHashTableSize - 1)];
+
+        block.mnHashNext = nBucket;
+        block.mbValid    = true;
+        nBucket          = nBlock;
+        stripe.mnBlockUsedCount++;
+    }
+    // Else the data may predate the Invalidate. The caller may use it, but we don't publish it.
+
+    return nBlock;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Unpin
+//
+void SharedBlockCache::Unpin(int nBlock)
+{
+    using namespace SharedBlockCacheLocal;
+
+    EA_ASSERT((nBlock >= 0) && (nBlock < (mnStripeBlockCount * kStripeCount)));
+
+    Stripe&  stripe = mpStripeArray[nBlock / mnStripeBlockCount];
+    AutoLock autoLock(stripe.mFutex);
+    Block&   block = mpBlockArray[nBlock];
+
+    EA_ASSERT(block.mnPinCount > 0);
+
+    if(--block.mnPinCount == 0)
+    {
+        stripe.mnBlockPinCount--;
+
+        if(!block.mbValid) // If the block was invalidated or never published, make it the next to be reused.
+        {
+            UnlinkBlock(stripe, nBlock);
+            LinkBlockTail(stripe, nBlock);
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Read
+//
+size_type SharedBlockCache::Read(const SharedStreamId& streamId, size_type nBlockIndex, size_type nOffset, void* pData, size_type nSize, IStream* pStream)
+{
+    EA_ASSERT((nOffset + nSize) <= mnBlockSize);
+
+    const int nBlock = Pin(streamId, nBlockIndex, pStream);
+
+    if(nBlock != kBlockNone)
+    {
+        size_type         nBlockSize;
+        const char* const pBlockData = (const char*)GetData(nBlock, nBlockSize);
+
+        if(nOffset >= nBlockSize) // If the read is at or beyond the end of the stream...
+            nSize = 0;
+        else if(nSize > (nBlockSize - nOffset))
+            nSize = (nBlockSize - nOffset);
+
+        memcpy(pData, pBlockData + nOffset, (size_t)nSize);
+        Unpin(nBlock);
+
+        return nSize;
+    }
+
+    // The block couldn't be cached, so we read what was asked for directly.
+    if(pStream && pStream->SetPosition((off_type)((nBlockIndex * mnBlockSize) + nOffset)))
+        return pStream->Read(pData, nSize);
+
+    return kSizeTypeError;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Invalidate
+//
+void SharedBlockCache::Invalidate(const SharedStreamId& streamId, size_type nBlockIndex)
+{
+    using namespace SharedBlockCacheLocal;
+
+    if(mpStripeArray)
+    {
+        const uint32_t nHash  = GetHash(streamId, nBlockIndex);
+        Stripe&        stripe = mpStripeArray[nHash & (kStripeCount - 1)];
+        AutoLock       autoLock(stripe.mFutex);
+        const int      nBlock = FindBlock(stripe, nHash, streamId, nBlockIndex);
+
+        if(nBlock != kBlockNone)
+            RemoveBlock(stripe, nBlock);
+        stripe.mnGeneration++;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// InvalidateStream
+//
+void SharedBlockCache::InvalidateStream(const SharedStreamId& streamId)
+{
+    using namespace SharedBlockCacheLocal;
+
+    for(int s = 0; mpStripeArray && (s < kStripeCount); s++)
+    {
+        Stripe&   stripe      = mpStripeArray[s];
+        AutoLock  autoLock(stripe.mFutex);
+        const int nBlockFirst = s * mnStripeBlockCount;
+
+        for(int i = nBlockFirst; i < (nBlockFirst + mnStripeBlockCount); i++)
+        {
+            if(mpBlockArray[i].mbValid && (mpBlockArray[i].mStreamId == streamId))
+                RemoveBlock(stripe, i);
+        }
+
+        stripe.mnGeneration++;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetStats
+//
+void SharedBlockCache::GetStats(Stats& stats) const
+{
+    using namespace SharedBlockCacheLocal;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.mnBlockCount = (size_type)mnStripeBlockCount * kStripeCount;
+
+    for(int s = 0; mpStripeArray && (s < kStripeCount); s++)
+    {
+        Stripe&  stripe = mpStripeArray[s];
+        AutoLock autoLock(stripe.mFutex);
+
+        stats.mnHitCount       += stripe.mnHitCount;
+        stats.mnMissCount      += stripe.mnMissCount;
+        stats.mnEvictCount     += stripe.mnEvictCount;
+        stats.mnFailCount      += stripe.mnFailCount;
+        stats.mnBlockUsedCount += (size_type)stripe.mnBlockUsedCount;
+        stats.mnBlockPinCount  += (size_type)stripe.mnBlockPinCount;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ResetStats
+//
+// Resets the counters. The block counts reflect the current state and aren't reset.
+//
+void SharedBlockCache::ResetStats()
+{
+    using namespace SharedBlockCacheLocal;
+
+    for(int s = 0; mpStripeArray && (s < kStripeCount); s++)
+    {
+        Stripe&  stripe = mpStripeArray[s];
+        AutoLock autoLock(stripe.mFutex);
+
+        stripe.mnHitCount   = 0;
+        stripe.mnMissCount  = 0;
+        stripe.mnEvictCount = 0;
+        stripe.mnFailCount  = 0;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MakeStreamId
+//
+SharedStreamId SharedBlockCache::MakeStreamId(const char8_t* pPath8)
+{
+    SharedStreamId streamId;
+
+    #if defined(EA_PLATFORM_UNIX)
+        struct stat tempStat;
+
+        if(stat(pPath8, &tempStat) == 0)
+        {
+            streamId.mnDevice = (uint64_t)tempStat.st_dev;
+            streamId.mnFile   = (uint64_t)tempStat.st_ino;
+            streamId.mnSize   = (uint64_t)tempStat.st_size;
+
+            #if defined(EA_PLATFORM_LINUX)
+                streamId.mnTime = ((uint64_t)tempStat.st_mtim.tv_sec * UINT64_C(1000000000)) + (uint64_t)tempStat.st_mtim.tv_nsec;
+            #elif defined(EA_PLATFORM_APPLE)
+                streamId.mnTime = ((uint64_t)tempStat.st_mtimespec.tv_sec * UINT64_C(1000000000)) + (uint64_t)tempStat.st_mtimespec.tv_nsec;
+            #else
+                streamId.mnTime = (uint64_t)tempStat.st_mtime * UINT64_C(1000000000);
+            #endif
+
+            return streamId;
+        }
+    #endif
+
+    // FNV-1a hash of the path.
+    uint64_t h = UINT64_C(14695981039346656037);
+
+    while(*pPath8)
+    {
+        h ^= (uint8_t)*pPath8++;
+        h *= UINT64_C(1099511628211);
+    }
+
+    streamId.mnFile = h;
+
+    return streamId;
+}
+
+
+} // namespace IO
+
+} // namespace EA
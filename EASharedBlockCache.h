@@ -0,0 +1,280 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EASharedBlockCache.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a process-wide, memory-budgeted cache of stream blocks which
+// is shared between streams and threads.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EASHAREDBLOCKCACHE_H
+#define EAIO_EASHAREDBLOCKCACHE_H
+
+
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+
+
+
+namespace EA
+{
+    namespace Allocator
+    {
+        class ICoreAllocator;
+    }
+
+    namespace IO
+    {
+        /// struct SharedStreamId
+        ///
+        /// Identifies the data of a stream to a SharedBlockCache. Blocks are shared
+        /// only between streams with equal ids. For a file, SharedBlockCache::MakeStreamId
+        /// fills in all of the members. For other streams, any number which is unique
+        /// among the users of the cache can be used via the uint64_t constructor.
+        ///
+        struct EAIO_API SharedStreamId
+        {
+            uint64_t mnDevice;      /// The device which holds the file, or 0.
+            uint64_t mnFile;        /// The number of the file on its device (e.g. the inode number), or a user-defined number.
+            uint64_t mnTime;        /// The modification time of the file, in nanoseconds where available, or 0.
+            uint64_t mnSize;        /// The size of the file, or 0.
+
+            SharedStreamId(uint64_t nFile = 0) 
+              : mnDevice(0), mnFile(nFile), mnTime(0), mnSize(0) { }
+
+            bool operator==(const SharedStreamId& x) const
+                { return (mnFile == x.mnFile) && (mnDevice == x.mnDevice) && (mnTime == x.mnTime) && (mnSize == x.mnSize); }
+
+            bool operator!=(const SharedStreamId& x) const
+                { return !(*this == x); }
+        };
+
+
+        /// class SharedBlockCache
+        ///
+        /// Implements a fixed-budget cache of fixed-size, block-aligned blocks of 
+        /// streams, keyed by a stream id and block index. Separate streams which 
+        /// read the same file, such as per-thread FileStreams of the same pack file,
+        /// use the same stream id and so share one cached copy of each block instead
+        /// of each buffering and re-reading it. The usual way to use this class is
+        /// through StreamBlockCache::SetSharedCache rather than directly.
+        ///
+        /// The cache is divided into kStripeCount stripes, each of which owns an 
+        /// equal part of the budget and has its own lock, LRU list and hash table,
+        /// so that lookups from different threads rarely contend. Locks are held
+        /// only for lookups and list updates; reading a missing block from its 
+        /// stream and copying block data are done outside of the lock, with the 
+        /// block pinned so that it can't be replaced meanwhile.
+        ///
+        /// This class is thread-safe if EAIO_THREAD_SAFETY_ENABLED is 1. The streams
+        /// passed to it are used only by the calling thread.
+        ///
+        /// Example usage:
+        ///     SharedBlockCache gPackCache(64 * 1024 * 1024);
+        ///
+        ///     StreamBlockCache* pCache = new StreamBlockCache(pFileStream, 0, 0);
+        ///     pCache->SetSharedCache(&gPackCache, SharedBlockCache::MakeStreamId(pPackPath));
+        ///
+        class EAIO_API SharedBlockCache
+        {
+        public:
+            static const size_type kBlockSizeDefault = 65536;   /// The default size of each block. This is a good size for reading compressed pack file entries.
+            static const int       kStripeCount      = 16;      /// The number of independently locked parts of the cache.
+            static const int       kBlockNone        = -1;      /// Returned by Pin when the block couldn't be pinned.
+
+            struct Stats
+            {
+                uint64_t  mnHitCount;       /// Number of Pin calls which found the block cached.
+                uint64_t  mnMissCount;      /// Number of Pin calls which had to read the block from its stream.
+                uint64_t  mnEvictCount;     /// Number of cached blocks which were replaced by other blocks.
+                uint64_t  mnFailCount;      /// Number of Pin calls which failed because all blocks were pinned or the read failed.
+                size_type mnBlockCount;     /// Total number of blocks in the cache.
+                size_type mnBlockUsedCount; /// Number of blocks which hold data.
+                size_type mnBlockPinCount;  /// Number of blocks which are currently pinned.
+            };
+
+            typedef Allocator::ICoreAllocator Allocator;
+
+        public:
+            /// SharedBlockCache
+            /// nMemoryBudget is rounded down to a multiple of kStripeCount * nBlockSize. 
+            /// nBlockSize must be a power of two. A budget of less than kStripeCount blocks 
+            /// disables the cache, in which case Pin always fails.
+            SharedBlockCache(size_type nMemoryBudget = 0, size_type nBlockSize = kBlockSizeDefault, Allocator* pAllocator = NULL);
+           ~SharedBlockCache();
+
+            size_type GetBlockSize() const;
+            size_type GetMemoryBudget() const;
+
+            /// Pin
+            /// Finds the given block, reading it from pStream if it isn't cached, and 
+            /// pins it so that it isn't replaced until Unpin is called. Returns a handle 
+            /// to the block or kBlockNone if it couldn't be pinned, which happens if all 
+            /// blocks which might hold it are pinned or if the read failed. If pStream 
+            /// is NULL, a block which isn't cached isn't read and kBlockNone is returned.
+            /// Pin moves the position of pStream.
+            int         Pin(const SharedStreamId& streamId, size_type nBlockIndex, IStream* pStream);
+
+            /// GetData
+            /// Returns the data of a pinned block. nSize is set to the number of valid 
+            /// bytes, which is less than the block size only for the last block of a stream.
+            const void* GetData(int nBlock, size_type& nSize) const;
+
+            /// Unpin
+            /// Releases a block pinned by Pin. Every successful Pin must be matched by Unpin.
+            void        Unpin(int nBlock);
+
+            /// Read
+            /// Copies nSize bytes at nOffset within the given block to pData, as with Pin, 
+            /// GetData and Unpin. If the block can't be pinned, the data is read directly
+            /// from pStream. Returns the number of bytes copied, which is less than nSize
+            /// only at the end of the stream, or kSizeTypeError upon error.
+            size_type   Read(const SharedStreamId& streamId, size_type nBlockIndex, size_type nOffset, void* pData, size_type nSize, IStream* pStream);
+
+            /// Invalidate
+            /// Discards the given cached block or all cached blocks of the given stream. 
+            /// This is needed if the stream's data was changed. Pinned blocks remain 
+            /// valid to their pinners but aren't found by subsequent Pin calls.
+            void        Invalidate(const SharedStreamId& streamId, size_type nBlockIndex);
+            void        InvalidateStream(const SharedStreamId& streamId);
+
+            void        GetStats(Stats& stats) const;
+            void        ResetStats();
+
+            /// MakeStreamId
+            /// Returns an id for the file with the given path which is the same for all 
+            /// paths which refer to the same file. Where the file system provides file 
+            /// identity, the id is made of the device and inode numbers along with the 
+            /// modification time and size, so that a file which was since modified or 
+            /// replaced (including by one which reuses the inode number) gets a different
+            /// id and doesn't share stale blocks. Thus the id should be made when the file
+            /// is opened. A modification which changes neither the size nor the time, as 
+            /// can happen within the time resolution of the file system, isn't detected;
+            /// call InvalidateStream after such modifications. Where the file system 
+            /// doesn't provide file identity, the id is a hash of the path.
+            static SharedStreamId MakeStreamId(const char8_t* pPath8);
+
+        protected:
+            struct Block
+            {
+                SharedStreamId mStreamId;       /// The stream the block belongs to.
+                size_type      mnBlockIndex;    /// The position of the block in the stream divided by the block size.
+                size_type      mnSize;          /// Number of valid bytes in the block.
+                int            mnPinCount;      /// Number of outstanding Pin calls. A pinned block isn't replaced.
+                int            mnLRUPrev;       /// The next more recently used block of the stripe, or kBlockNone.
+                int            mnLRUNext;       /// The next less recently used block of the stripe, or kBlockNone.
+                int            mnHashNext;      /// The next block in the same hash bucket, or kBlockNone.
+                bool           mbValid;         /// True if the block holds data and is in its stripe's hash table.
+            };
+
+            struct Stripe;
+
+            SharedBlockCache(const SharedBlockCache&);              // Not implemented.
+            SharedBlockCache& operator=(const SharedBlockCache&);   // Not implemented.
+
+            uint32_t  GetHash(const SharedStreamId& streamId, size_type nBlockIndex) const;
+            int       FindBlock(const Stripe& stripe, uint32_t nHash, const SharedStreamId& streamId, size_type nBlockIndex) const;
+            void      LinkBlockHead(Stripe& stripe, int nBlock);
+            void      LinkBlockTail(Stripe& stripe, int nBlock);
+            void      UnlinkBlock(Stripe& stripe, int nBlock);
+            void      RemoveBlock(Stripe& stripe, int nBlock);
+
+        protected:
+            Allocator*  mpAllocator;            /// The allocator for the arrays below.
+            size_type   mnBlockSize;            /// Size of each block. A power of two.
+            int         mnStripeBlockCount;     /// Number of blocks per stripe. Stripe i owns blocks [i * mnStripeBlockCount, (i + 1) * mnStripeBlockCount).
+            uint32_t    mnStripeHashTableSize;  /// Number of hash buckets per stripe. A power of two.
+            Stripe*     mpStripeArray;          /// Array of kStripeCount stripes.
+            Block*      mpBlockArray;           /// Array of kStripeCount * mnStripeBlockCount blocks.
+            int*        mpHashTable;            /// Array of kStripeCount * mnStripeHashTableSize bucket heads.
+            char*       mpBlockData;            /// Block data, mnBlockSize bytes per block.
+        };
+
+
+        /// getSharedBlockCache
+        ///
+        /// Gets the process-wide SharedBlockCache set by setSharedBlockCache, or NULL
+        /// if none was set.
+        ///
+        EAIO_API SharedBlockCache* getSharedBlockCache();
+
+
+        /// setSharedBlockCache
+        ///
+        /// Sets the process-wide SharedBlockCache which subsystems that read from
+        /// shared files, such as pack file readers, can opt into via getSharedBlockCache.
+        /// The cache is owned by the caller and must outlive its users.
+        ///
+        EAIO_API void setSharedBlockCache(SharedBlockCache* pSharedBlockCache);
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+    namespace IO
+    {
+        inline
+        size_type SharedBlockCache::GetBlockSize() const
+        {
+            return mnBlockSize;
+        }
+
+        inline
+        size_type SharedBlockCache::GetMemoryBudget() const
+        {
+            return (size_type)kStripeCount * (size_type)mnStripeBlockCount * mnBlockSize;
+        }
+
+        inline
+        const void* SharedBlockCache::GetData(int nBlock, size_type& nSize) const
+        {
+            nSize = mpBlockArray[nBlock].mnSize;
+            return mpBlockData + ((size_type)nBlock * mnBlockSize);
+        }
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif // Header include guard
@@ -140,7 +140,8 @@ namespace EA
             kCDOpenExisting     = 3,      /// Fails if file doesn't exist, keeps contents.
             kCDOpenAlways       = 4,      /// Never fails, creates if doesn't exist, keeps contents.
             kCDTruncateExisting = 5,      /// Fails if file doesn't exist, but truncates to 0 if it does.
-            kCDDefault          = 6       /// Default (implementation-specific) disposition
+            kCDDefault          = 6,      /// Default (implementation-specific) disposition
+            kCDReplaceAtomic    = 7       /// Never fails if the directory is writable. Writes go to a new file which atomically replaces the file upon FileStream::Commit; until then, or if the stream is closed without it, the file is unchanged. With read access, the new file starts as a copy of the file. Requires EAIO_REPLACE_ATOMIC_ENABLED.
         };
 
         /// enum PositionType
@@ -188,6 +189,23 @@ namespace EA
         };
 
 
+        /// struct IOVector
+        /// Describes one buffer of a scatter read; see IStream::ReadV.
+        struct IOVector
+        {
+            void*     mpData;
+            size_type mnSize;
+        };
+
+        /// struct ConstIOVector
+        /// Describes one buffer of a gather write; see IStream::WriteV.
+        struct ConstIOVector
+        {
+            const void* mpData;
+            size_type   mnSize;
+        };
+
+
 
         /// \class IStream
         /// \brief The base class for stream IO.
@@ -328,6 +346,92 @@ namespace EA
             /// If false is returned, you can use IStream::GetState to determine the error.
             /// Upon error, the stream pointer is at the position it was upon the error occurrence.
             virtual bool Write(const void* pData, size_type nSize) = 0;
+
+            /// ReadAt
+            /// Reads bytes from the given absolute position in the stream without using
+            /// or changing the current stream position. The return value is the same as
+            /// with the Read function.
+            ///
+            /// Stream subclasses which can implement this without touching the current
+            /// position (e.g. FileStream via pread) override this function, in which case
+            /// it is safe for multiple threads to call ReadAt on the same stream concurrently.
+            /// The default implementation here is a SetPosition/Read/SetPosition sequence
+            /// and so it has no thread safety beyond that of the stream itself.
+            virtual size_type ReadAt(size_type nPosition, void* pData, size_type nSize)
+            {
+                const off_type nPositionSaved = GetPosition();
+                size_type      nResult        = kSizeTypeError;
+
+                if(SetPosition((off_type)nPosition))
+                    nResult = Read(pData, nSize);
+                SetPosition(nPositionSaved);
+
+                return nResult;
+            }
+
+            /// WriteAt
+            /// Writes bytes to the given absolute position in the stream without using
+            /// or changing the current stream position. The return value is the same as
+            /// with the Write function. See ReadAt regarding thread safety.
+            virtual bool WriteAt(size_type nPosition, const void* pData, size_type nSize)
+            {
+                const off_type nPositionSaved = GetPosition();
+                bool           bResult        = false;
+
+                if(SetPosition((off_type)nPosition))
+                    bResult = Write(pData, nSize);
+                SetPosition(nPositionSaved);
+
+                return bResult;
+            }
+
+            /// ReadV
+            /// Reads into each of the nCount buffers in turn, as if Read were called
+            /// for each. Returns the total number of bytes read, which is less than the
+            /// total size of the buffers only if the end of the stream was reached.
+            /// Returns (size_type)-1 (a.k.a. kSizeTypeError) upon error.
+            ///
+            /// Stream subclasses override this to do the transfer in a single operation
+            /// (e.g. FileStream via readv). The default implementation here calls Read
+            /// for each buffer.
+            virtual size_type ReadV(const IOVector* pIOVectorArray, size_t nCount)
+            {
+                size_type nTotal = 0;
+
+                for(size_t i = 0; i < nCount; i++)
+                {
+                    const size_type nResult = Read(pIOVectorArray[i].mpData, pIOVectorArray[i].mnSize);
+
+                    if(nResult == kSizeTypeError)
+                        return kSizeTypeError;
+
+                    nTotal += nResult;
+
+                    if(nResult < pIOVectorArray[i].mnSize) // If the end of the stream was reached...
+                        break;
+                }
+
+                return nTotal;
+            }
+
+            /// WriteV
+            /// Writes each of the nCount buffers in turn, as if Write were called for each.
+            /// Returns true if all the bytes were written. See ReadV regarding overrides.
+            ///
+            /// Example usage:
+            ///     const ConstIOVector ioVectorArray[3] = { { &header, sizeof(header) }, { pPayload, nPayloadSize }, { &footer, sizeof(footer) } };
+            ///     pStream->WriteV(ioVectorArray, 3);
+            ///
+            virtual bool WriteV(const ConstIOVector* pIOVectorArray, size_t nCount)
+            {
+                for(size_t i = 0; i < nCount; i++)
+                {
+                    if(!Write(pIOVectorArray[i].mpData, pIOVectorArray[i].mnSize))
+                        return false;
+                }
+
+                return true;
+            }
         };
 
 
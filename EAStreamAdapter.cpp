@@ -41,7 +41,19 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <eaio/internal/Config.h>
 #include <eaio/EAStream.h>
 #include <eaio/EAStreamAdapter.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAStreamFixedMemory.h>
+#include <eaio/EAFileStream.h>
+#include <eaio/EAMappedFileStream.h>
+#include <eaio/EAStreamBuffer.h>
+#include <eaio/Allocator.h>
 #include <limits.h>
+#include <string.h>
+#if (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && defined(EA_COMPILER_MSVC)
+    #include <intrin.h>
+#elif (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && (defined(EA_COMPILER_GNUC) || defined(EA_COMPILER_CLANG))
+    #include <immintrin.h>
+#endif
 
 namespace {
 
@@ -89,13 +101,367 @@ namespace {
         //const uint32_t low32Bits  = EASwizzleUint32((uint32_t)(x >> 32));
         //return ((uint64_t)high32Bits << 32) | low32Bits;
     }
+
+
+    // SIMD byte swapping is used for the array read and write functions, which 
+    // swap many elements at a time. The instruction set is chosen at runtime, 
+    // so that a build for the baseline processor still uses AVX2 where present.
+    #if (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && (defined(EA_COMPILER_MSVC) || defined(EA_COMPILER_GNUC) || defined(EA_COMPILER_CLANG))
+        #define EAIO_SWIZZLE_SIMD_ENABLED 1
+    #else
+        #define EAIO_SWIZZLE_SIMD_ENABLED 0
+    #endif
+
+    // SSE2 isn't part of the baseline of 32 bit x86 builds, so it needs a target too.
+    #if EAIO_SWIZZLE_SIMD_ENABLED && defined(EA_COMPILER_MSVC)
+        #define EAIO_TARGET_SSE2
+        #define EAIO_TARGET_SSSE3
+        #define EAIO_TARGET_AVX2
+    #elif EAIO_SWIZZLE_SIMD_ENABLED
+        #define EAIO_TARGET_SSE2  __attribute__((target("sse2")))
+        #define EAIO_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define EAIO_TARGET_AVX2  __attribute__((target("avx2")))
+    #endif
+
+    const int kSwizzleLevelUnknown = -1; // See EA::IO::SwizzleLevel.
+
+
+    // Swaps count elements of nElementSize bytes (2, 4 or 8) from pSource to pDest.
+    // pDest may be the same as pSource but may not otherwise overlap it.
+    void SwizzleArrayScalar(void* pDest, const void* pSource, EA::IO::size_type count, size_t nElementSize)
+    {
+        // We use memcpy for the element accesses, as the arrays needn't be aligned.
+        char*       pDest8   = (char*)pDest;
+        const char* pSource8 = (const char*)pSource;
+
+        for(; count; count--, pDest8 += nElementSize, pSource8 += nElementSize)
+        {
+            if(nElementSize == 2)
+            {
+                uint16_t n;
+                memcpy(&n, pSource8, sizeof(n));
+                n = SwizzleUint16(n);
+                memcpy(pDest8, &n, sizeof(n));
+            }
+            else if(nElementSize == 4)
+            {
+                uint32_t n;
+                memcpy(&n, pSource8, sizeof(n));
+                n = SwizzleUint32(n);
+                memcpy(pDest8, &n, sizeof(n));
+            }
+            else
+            {
+                uint64_t n;
+                memcpy(&n, pSource8, sizeof(n));
+                n = SwizzleUint64(n);
+                memcpy(pDest8, &n, sizeof(n));
+            }
+        }
+    }
+
+
+    #if EAIO_SWIZZLE_SIMD_ENABLED
+        // Each of these swaps as many whole 16 or 32 byte vectors as there are and 
+        // returns the number of elements swapped. The caller swaps the remainder.
+
+        EAIO_TARGET_SSE2 EA::IO::size_type SwizzleArraySSE2(void* pDest, const void* pSource, EA::IO::size_type count, size_t nElementSize)
+        {
+            const EA::IO::size_type nVectorCount = (count * nElementSize) / 16;
+
+            for(EA::IO::size_type i = 0; i < nVectorCount; i++)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)pSource + i);
+
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)); // Swap the bytes of each 16 bit word.
+
+                if(nElementSize == 4) // Swap the words of each 32 bit element.
+                    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+                else if(nElementSize == 8) // Reverse the words of each 64 bit element.
+                    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+
+                _mm_storeu_si128((__m128i*)pDest + i, v);
+            }
+
+            return (nVectorCount * 16) / nElementSize;
+        }
+
+        EAIO_TARGET_SSSE3 __m128i GetSwizzleMask(size_t nElementSize)
+        {
+            if(nElementSize == 2)
+                return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            if(nElementSize == 4)
+                return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        }
+
+        EAIO_TARGET_SSSE3 EA::IO::size_type SwizzleArraySSSE3(void* pDest, const void* pSource, EA::IO::size_type count, size_t nElementSize)
+        {
+            const EA::IO::size_type nVectorCount = (count * nElementSize) / 16;
+            const __m128i           mask         = GetSwizzleMask(nElementSize);
+
+            for(EA::IO::size_type i = 0; i < nVectorCount; i++)
+                _mm_storeu_si128((__m128i*)pDest + i, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)pSource + i), mask));
+
+            return (nVectorCount * 16) / nElementSize;
+        }
+
+        EAIO_TARGET_AVX2 EA::IO::size_type SwizzleArrayAVX2(void* pDest, const void* pSource, EA::IO::size_type count, size_t nElementSize)
+        {
+            const EA::IO::size_type nVectorCount = (count * nElementSize) / 32;
+            const __m256i           mask         = _mm256_broadcastsi128_si256(GetSwizzleMask(nElementSize)); // vpshufb shuffles within each 16 byte lane.
+
+            for(EA::IO::size_type i = 0; i < nVectorCount; i++)
+                _mm256_storeu_si256((__m256i*)pDest + i, _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)pSource + i), mask));
+
+            return (nVectorCount * 32) / nElementSize;
+        }
+    #endif
+
+
+    #if EAIO_SWIZZLE_SIMD_ENABLED
+        // Returns the best SwizzleLevel that the processor and OS support.
+        int GetSwizzleLevel()
+        {
+            #if defined(EA_COMPILER_MSVC)
+                int info[4];
+
+                __cpuid(info, 0);
+                const int nInfoCount = info[0];
+                __cpuid(info, 1);
+
+                // AVX2 requires AVX and that the OS saves the YMM registers, which is indicated by 
+                // OSXSAVE and XCR0. XGETBV itself is available only if OSXSAVE is set.
+                if(((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) && (nInfoCount >= 7) && ((_xgetbv(0) & 6) == 6))
+                {
+                    int info7[4];
+
+                    __cpuidex(info7, 7, 0);
+                    if(info7[1] & (1 << 5))
+                        return EA::IO::kSwizzleLevelAVX2;
+                }
+
+                if(info[2] & (1 << 9))
+                    return EA::IO::kSwizzleLevelSSSE3;
+                if(info[3] & (1 << 26))
+                    return EA::IO::kSwizzleLevelSSE2;
+            #else
+                __builtin_cpu_init();
+
+                if(__builtin_cpu_supports("avx2"))
+                    return EA::IO::kSwizzleLevelAVX2;
+                if(__builtin_cpu_supports("ssse3"))
+                    return EA::IO::kSwizzleLevelSSSE3;
+                if(__builtin_cpu_supports("sse2"))
+                    return EA::IO::kSwizzleLevelSSE2;
+            #endif
+
+            return EA::IO::kSwizzleLevelScalar;
+        }
+
+        // This is set by the first call to SwizzleArray rather than during static initialization,
+        // so that it's valid for swizzling done by other static initializers. Threads which race
+        // to set it set the same value.
+        volatile int gSwizzleLevel = kSwizzleLevelUnknown;
+    #endif
+
+
+    // Swaps count elements of nElementSize bytes (2, 4 or 8) from pSource to pDest,
+    // with the fastest available instruction set. pDest may be the same as pSource 
+    // but may not otherwise overlap it.
+    void SwizzleArray(void* pDest, const void* pSource, EA::IO::size_type count, size_t nElementSize)
+    {
+        EA::IO::size_type nSwizzled = 0;
+
+        #if EAIO_SWIZZLE_SIMD_ENABLED
+            int nSwizzleLevel = gSwizzleLevel;
+
+            if(nSwizzleLevel == kSwizzleLevelUnknown)
+                gSwizzleLevel = nSwizzleLevel = GetSwizzleLevel();
+
+            switch(nSwizzleLevel)
+            {
+                case EA::IO::kSwizzleLevelAVX2:
+                    nSwizzled = SwizzleArrayAVX2(pDest, pSource, count, nElementSize);
+                    break;
+                case EA::IO::kSwizzleLevelSSSE3:
+                    nSwizzled = SwizzleArraySSSE3(pDest, pSource, count, nElementSize);
+                    break;
+                case EA::IO::kSwizzleLevelSSE2:
+                    nSwizzled = SwizzleArraySSE2(pDest, pSource, count, nElementSize);
+                    break;
+            }
+        #endif
+
+        SwizzleArrayScalar((char*)pDest + (nSwizzled * nElementSize), (const char*)pSource + (nSwizzled * nElementSize), count - nSwizzled, nElementSize);
+    }
+
+
+    // copyStream uses a heap buffer of this size when copying more than fits in its stack buffer.
+    // The alignment allows the buffer to be used for unbuffered (O_DIRECT) file I/O.
+    const EA::IO::size_type kCopyBufferSize      = 256 * 1024;
+    const unsigned          kCopyBufferAlignment = 4096;
+
+
+    // Returns a pointer to the beginning of the stream's data if the stream is one 
+    // whose contents are directly addressable in memory, else NULL. If bWritable is 
+    // true then read-only streams are excluded.
+    void* GetStreamMemory(EA::IO::IStream* pStream, bool bWritable)
+    {
+        using namespace EA::IO;
+
+        switch(pStream->GetType())
+        {
+            case MemoryStream::kTypeMemoryStream:
+                return static_cast<MemoryStream*>(pStream)->GetData();
+
+            case FixedMemoryStream::kTypeFixedMemoryStream:
+                return static_cast<FixedMemoryStream*>(pStream)->GetData();
+
+            #if EAIO_MAPPED_FILE_STREAM_ENABLED
+                case MappedFileStream::kTypeMappedFileStream:
+                    return bWritable ? NULL : const_cast<void*>(static_cast<MappedFileStream*>(pStream)->GetData());
+            #endif
+        }
+
+        return NULL;
+    }
+
+
+    // Reads count elements of nElementSize bytes, converting them from endianSource.
+    // When the stream's data is directly addressable, as with memory streams and the 
+    // read buffer of StreamBuffer, the elements are swapped while being copied out
+    // of it rather than being copied and then swapped in place.
+    bool ReadSwizzled(EA::IO::IStream* pIS, void* pData, EA::IO::size_type count, size_t nElementSize, EA::IO::Endian endianSource)
+    {
+        using namespace EA::IO;
+
+        const size_type nSize = (count * nElementSize);
+
+        if(endianSource == kEndianLocal)
+            return (pIS->Read(pData, nSize) == nSize);
+
+        if(const char* pStreamData = (const char*)GetStreamMemory(pIS, false))
+        {
+            if(pIS->GetAvailable() >= nSize)
+            {
+                const size_type nPosition = (size_type)pIS->GetPosition();
+
+                SwizzleArray(pData, pStreamData + nPosition, count, nElementSize);
+                return pIS->SetPosition((off_type)(nPosition + nSize));
+            }
+            // Else fall through to the regular path, which will read what's there and fail.
+        }
+        else if(pIS->GetType() == StreamBuffer::kTypeStreamBuffer)
+        {
+            StreamBuffer* const pStreamBuffer = static_cast<StreamBuffer*>(pIS);
+            char*               pData8        = (char*)pData;
+            size_type           nAvailable;
+
+            for(const char* p; count && ((p = (const char*)pStreamBuffer->Peek(nElementSize, nAvailable)) != NULL); )
+            {
+                size_type nCount = (nAvailable / nElementSize);
+
+                if(nCount == 0) // If the stream ends within an element...
+                    return false;
+                if(nCount > count)
+                    nCount = count;
+
+                SwizzleArray(pData8, p, nCount, nElementSize);
+                pStreamBuffer->Consume(nCount * nElementSize);
+                pData8 += (nCount * nElementSize);
+                count  -= nCount;
+            }
+
+            if((count == 0) || (pData8 != pData)) // If we are done or if Peek failed part way through...
+                return (count == 0);
+            // Else read buffering is disabled or the stream is at its end, which the regular path handles.
+        }
+
+        if(pIS->Read(pData, nSize) == nSize)
+        {
+            SwizzleArray(pData, pData, count, nElementSize);
+            return true;
+        }
+
+        return false;
+    }
+
+
+    // Writes count elements of nElementSize bytes, converting them to endianDestination.
+    // The elements are swapped directly into the write buffer of a StreamBuffer, and 
+    // otherwise swapped in chunks through a stack buffer.
+    bool WriteSwizzled(EA::IO::IStream* pOS, const void* pData, EA::IO::size_type count, size_t nElementSize, EA::IO::Endian endianDestination)
+    {
+        using namespace EA::IO;
+
+        const char* pData8 = (const char*)pData;
+
+        if(endianDestination == kEndianLocal)
+            return pOS->Write(pData, count * nElementSize);
+
+        if(pOS->GetType() == StreamBuffer::kTypeStreamBuffer)
+        {
+            StreamBuffer* const pStreamBuffer = static_cast<StreamBuffer*>(pOS);
+            size_type           nAvailable;
+
+            for(char* p; count && ((p = (char*)pStreamBuffer->GetWriteSpan(nElementSize, nAvailable)) != NULL); )
+            {
+                size_type nCount = (nAvailable / nElementSize);
+
+                if(nCount > count)
+                    nCount = count;
+
+                SwizzleArray(p, pData8, nCount, nElementSize);
+                pStreamBuffer->Commit(nCount * nElementSize);
+                pData8 += (nCount * nElementSize);
+                count  -= nCount;
+            }
+
+            if((count == 0) || (pData8 != pData)) // If we are done or if GetWriteSpan failed part way through...
+                return (count == 0);
+            // Else write buffering is disabled, which the regular path handles.
+        }
+
+        uint64_t        buffer[256];
+        const size_type nBufferCount = (sizeof(buffer) / nElementSize);
+
+        while(count)
+        {
+            const size_type nCount = (count < nBufferCount) ? count : nBufferCount;
+
+            SwizzleArray(buffer, pData8, nCount, nElementSize);
+
+            if(!pOS->Write(buffer, nCount * nElementSize))
+                return false;
+
+            pData8 += (nCount * nElementSize);
+            count  -= nCount;
+        }
+
+        return true;
+    }
+
 } // namespace
 
 
 
 bool EA::IO::StreamAdapter::VerifyArraySize(uint32_t elementCount, uint32_t elementSize)
 {
-    const uint64_t          elementDataSize = (uint64_t)elementCount * elementSize;
+    const uint64_t elementDataSize = (uint64_t)elementCount * elementSize;
+
+    if(mCachedSizeValid) // If a ReadReservation is active, check against it instead of against the stream.
+    {
+        if(elementDataSize > mCachedSize)
+        {
+            VerifyIO(false);
+            return false;
+        }
+
+        mCachedSize -= (EA::IO::size_type)elementDataSize;
+        return true;
+    }
+
     const EA::IO::off_type  currentPos      = mpStream->GetPosition();
     const EA::IO::size_type streamSize      = mpStream->getSize();
 
@@ -119,10 +485,61 @@ bool EA::IO::StreamAdapter::VerifyArraySize(uint32_t elementCount, uint32_t elem
 }
 
 
+EA::IO::StreamAdapter::ReadReservation::ReadReservation(StreamAdapter& adapter, EA::IO::size_type nSize)
+  : mAdapter(adapter),
+    mpPrevious(adapter.mpReservation),
+    mnReservedSize(0),
+    mnPreviousSize(adapter.mCachedSize),
+    mbValid(false)
+{
+    // We query the stream directly rather than any enclosing reservation, as that
+    // reservation may have been for less than what the stream has.
+    const EA::IO::off_type  currentPos = adapter.mpStream->GetPosition();
+    const EA::IO::size_type streamSize = adapter.mpStream->getSize();
+    EA::IO::size_type       sizeRemaining = 0;
+
+    if((currentPos >= 0) && (streamSize != kSizeTypeError) && ((EA::IO::size_type)currentPos <= streamSize))
+        sizeRemaining = streamSize - (EA::IO::size_type)currentPos;
+
+    if(nSize == kLengthNull)
+        nSize = sizeRemaining;
+
+    mbValid = (nSize <= sizeRemaining);
+
+    if(!mbValid)
+    {
+        adapter.VerifyIO(false);
+        nSize = 0; // Make any array checked during this reservation fail.
+    }
+
+    mnReservedSize           = nSize;
+    adapter.mCachedSize      = nSize;
+    adapter.mCachedSizeValid = true;
+    adapter.mpReservation    = this;
+}
+
+
+EA::IO::StreamAdapter::ReadReservation::~ReadReservation()
+{
+    // If setStream was called meanwhile, this and any enclosing reservations have ended
+    // and the adapter's state refers to the new stream, so we leave it alone.
+    if(mAdapter.mpReservation == this)
+    {
+        // Arrays checked during this reservation are deducted from any enclosing reservation as well.
+        const EA::IO::size_type nUsedSize = (mnReservedSize - mAdapter.mCachedSize);
+
+        mAdapter.mCachedSize      = (nUsedSize < mnPreviousSize) ? (mnPreviousSize - nUsedSize) : 0;
+        mAdapter.mCachedSizeValid = (mpPrevious != NULL);
+        mAdapter.mpReservation    = mpPrevious;
+    }
+}
+
+
 EAIO_API EA::IO::size_type EA::IO::copyStream(IStream* pSource, IStream* pDestination, size_type nSize)
 {
     char            buffer[2048];
     size_type       nCurrentCount, nRemaining;
+    size_type       nCopied = 0;
     const size_type nSourceSize = pSource->getSize();
 
     if(nSourceSize == kSizeTypeError) // If the source size is of undetermined size...
@@ -130,23 +547,124 @@ EAIO_API EA::IO::size_type EA::IO::copyStream(IStream* pSource, IStream* pDestin
     else if(nSize > nSourceSize)      // If the user size is too high...
         nSize = nSourceSize;          // Reduce the user size to be the source size.
 
-    for(nRemaining = nSize; nRemaining != 0; nRemaining -= nCurrentCount)
+    // If the source is in memory, we write from it directly with a single Write.
+    if(const uint8_t* pSourceData = (const uint8_t*)GetStreamMemory(pSource, false))
     {
-        nCurrentCount = ((nRemaining >= sizeof(buffer)) ? sizeof(buffer) : nRemaining);
-        nCurrentCount = pSource->Read(buffer, nCurrentCount);
+        const size_type nPosition  = (size_type)pSource->GetPosition();
+        const size_type nAvailable = pSource->GetAvailable();
+
+        if(nSize > nAvailable)
+            nSize = nAvailable;
 
-        if((nCurrentCount == kSizeTypeError) || !pDestination->Write(buffer, nCurrentCount))
+        if(nSize && !pDestination->Write(pSourceData + nPosition, nSize))
             return kSizeTypeError;
 
+        pSource->SetPosition((off_type)(nPosition + nSize));
+        return nSize;
+    }
+
+    // If the destination is in memory and the size is known, we read into it directly.
+    if((nSize != kLengthNull) && GetStreamMemory(pDestination, true))
+    {
+        const size_type nPosition = (size_type)pDestination->GetPosition();
+        const size_type nSizePrev = pDestination->getSize();
+
+        if(((nPosition + nSize) <= nSizePrev) || pDestination->SetSize(nPosition + nSize))
+        {
+            uint8_t* const pDestinationData = (uint8_t*)GetStreamMemory(pDestination, true); // SetSize may have reallocated the memory.
+
+            for(nCurrentCount = 0; nCopied < nSize; nCopied += nCurrentCount)
+            {
+                nCurrentCount = pSource->Read(pDestinationData + nPosition + nCopied, nSize - nCopied);
+
+                if((nCurrentCount == kSizeTypeError) || (nCurrentCount == 0)) // If there was an error or we have read the entire source...
+                    break;
+            }
+
+            if((nCopied < nSize) && ((nPosition + nSize) > nSizePrev)) // If we grew the destination by more than was copied...
+                pDestination->SetSize(((nPosition + nCopied) > nSizePrev) ? (nPosition + nCopied) : nSizePrev);
+            pDestination->SetPosition((off_type)(nPosition + nCopied));
+
+            return (nCurrentCount == kSizeTypeError) ? kSizeTypeError : nCopied;
+        }
+    }
+
+    #if defined(EA_PLATFORM_LINUX)
+        // If both streams are files, the kernel can copy between them without the data passing through user memory.
+        if((pSource->GetType() == FileStream::kTypeFileStream) && (pDestination->GetType() == FileStream::kTypeFileStream))
+        {
+            nCopied = static_cast<FileStream*>(pDestination)->CopyFrom(static_cast<FileStream*>(pSource), nSize);
+
+            if(nCopied == kSizeTypeError)
+                return kSizeTypeError;
+            // Else copy whatever remains below. This will be nothing if we reached the end of the source.
+        }
+    #endif
+
+    // Copying large streams through the small stack buffer would mean a Read/Write pair per 2 KB,
+    // so we use a larger heap buffer for them if one can be allocated.
+    char*     pBuffer     = buffer;
+    size_type nBufferSize = sizeof(buffer);
+    bool      bResult     = true;
+
+    if((nSize - nCopied) > sizeof(buffer))
+    {
+        nBufferSize = ((nSize - nCopied) < kCopyBufferSize) ? (nSize - nCopied) : kCopyBufferSize;
+        pBuffer     = (char*)IO::getAllocator()->alloc((size_t)nBufferSize, EAIO_ALLOC_PREFIX "copyStream", 0, kCopyBufferAlignment);
+
+        if(!pBuffer)
+        {
+            pBuffer     = buffer;
+            nBufferSize = sizeof(buffer);
+        }
+    }
+
+    for(nRemaining = (nSize - nCopied); nRemaining != 0; nRemaining -= nCurrentCount)
+    {
+        nCurrentCount = ((nRemaining >= nBufferSize) ? nBufferSize : nRemaining);
+        nCurrentCount = pSource->Read(pBuffer, nCurrentCount);
+
+        if((nCurrentCount == kSizeTypeError) || !pDestination->Write(pBuffer, nCurrentCount))
+        {
+            bResult = false;
+            break;
+        }
+
         if(nCurrentCount == 0) // If we have read the entire source...
             break;
     }
 
+    if(pBuffer != buffer)
+        IO::getAllocator()->free(pBuffer, (size_t)nBufferSize);
+
+    if(!bResult)
+        return kSizeTypeError;
+
     return (nSize - nRemaining); // Return the number of bytes copied. Note that nRemaining might be non-zero.
 }
 
 
 
+EAIO_API int EA::IO::SetSwizzleLevel(int nSwizzleLevel)
+{
+    #if EAIO_SWIZZLE_SIMD_ENABLED
+        const int nSupportedLevel = GetSwizzleLevel();
+
+        if(nSwizzleLevel > nSupportedLevel)
+            nSwizzleLevel = nSupportedLevel;
+        if(nSwizzleLevel < kSwizzleLevelScalar)
+            nSwizzleLevel = kSwizzleLevelScalar;
+
+        gSwizzleLevel = nSwizzleLevel;
+        return nSwizzleLevel;
+    #else
+        (void)nSwizzleLevel;
+        return kSwizzleLevelScalar;
+    #endif
+}
+
+
+
 EAIO_API bool EA::IO::ReadBool8(IStream* pIS, bool& value)
 {
     bool8_t n;
@@ -204,20 +722,7 @@ EAIO_API bool EA::IO::ReadUint16(IStream* pIS, uint16_t& value, Endian endianSou
 
 EAIO_API bool EA::IO::ReadUint16(IStream* pIS, uint16_t* value, size_type count, Endian endianSource)
 {
-    if(pIS->Read( value, count * sizeof(*value)) == count * sizeof(*value))
-    {
-        // Swizzle in place after the read
-        if(endianSource != kEndianLocal)
-        {
-            while(count--)
-            {
-                const uint16_t c = *value;
-                *value++ = SwizzleUint16(c); 
-            }
-        }
-        return true;
-    }
-    return false;
+    return ReadSwizzled(pIS, value, count, sizeof(*value), endianSource);
 }
 
 
@@ -247,20 +752,7 @@ EAIO_API bool EA::IO::ReadUint32(IStream* pIS, uint32_t& value, Endian endianSou
 
 EAIO_API bool EA::IO::ReadUint32(IStream* pIS, uint32_t* value, size_type count, Endian endianSource)
 {
-    if(pIS->Read(value, count * sizeof(*value)) == count * sizeof(*value))
-    {
-        // Swizzle in place after the read
-        if(endianSource != kEndianLocal)
-        {
-            while(count--)
-            {
-                const uint32_t c = *value;
-                *value++ = SwizzleUint32(c);
-            }
-        }
-        return true;
-    }
-    return false;
+    return ReadSwizzled(pIS, value, count, sizeof(*value), endianSource);
 }
 
 
@@ -290,20 +782,7 @@ EAIO_API bool EA::IO::ReadUint64(IStream* pIS, uint64_t& value, Endian endianSou
 
 EAIO_API bool EA::IO::ReadUint64(IStream* pIS, uint64_t* value, size_type count, Endian endianSource)
 {
-    if(pIS->Read(value, count * sizeof(*value)) == count * sizeof(*value))
-    {
-        // Swizzle in place after the read
-        if(endianSource != kEndianLocal)
-        {
-            while(count--)
-            {
-                const uint64_t c = *value;
-                *value++ = SwizzleUint64(c);
-            }
-        }
-        return true;
-    }
-    return false;
+    return ReadSwizzled(pIS, value, count, sizeof(*value), endianSource);
 }
 
 
@@ -659,23 +1138,7 @@ EAIO_API bool EA::IO::WriteUint16(IStream* pOS, uint16_t value, Endian endianDes
 
 EAIO_API bool EA::IO::WriteUint16(IStream* pOS, const uint16_t* value, size_type count, Endian endianDestination)
 {
-    if(endianDestination != kEndianLocal)
-    {
-        while(count--)
-        {
-            const uint16_t n = SwizzleUint16(*value++);
-
-            if(!pOS->Write( &n, sizeof( n )))
-                return false;
-        }
-    }
-    else
-    {
-        if(!pOS->Write(value, count * sizeof(*value)))
-            return false;
-    }
-
-    return true;
+    return WriteSwizzled(pOS, value, count, sizeof(*value), endianDestination);
 }
 
 
@@ -702,23 +1165,7 @@ EAIO_API bool EA::IO::WriteUint32(IStream* pOS, uint32_t value, Endian endianDes
 
 EAIO_API bool EA::IO::WriteUint32(IStream* pOS, const uint32_t* value, size_type count, Endian endianDestination)
 {
-    if(endianDestination != kEndianLocal)
-    {
-        while(count--)
-        {
-            const uint32_t n = SwizzleUint32(*value++);
-
-            if(!pOS->Write(&n, sizeof(n)))
-                return false;
-        }
-    }
-    else
-    {
-        if(!pOS->Write(value, count * sizeof(*value)))
-            return false;
-    }
-
-    return true;
+    return WriteSwizzled(pOS, value, count, sizeof(*value), endianDestination);
 }
 
 
@@ -745,23 +1192,7 @@ EAIO_API bool EA::IO::WriteUint64(IStream* pOS, uint64_t value, Endian endianDes
 
 EAIO_API bool EA::IO::WriteUint64(IStream* pOS, const uint64_t* value, size_type count, Endian endianDestination)
 {
-    if(endianDestination != kEndianLocal)
-    {
-        while(count--)
-        {
-            const uint64_t n = SwizzleUint64(*value++);
-
-            if(!pOS->Write(&n, sizeof(n)))
-                return false;
-        }
-    }
-    else
-    {
-        if(!pOS->Write(value, count * sizeof(*value)))
-            return false;
-    }
-
-    return true;
+    return WriteSwizzled(pOS, value, count, sizeof(*value), endianDestination);
 }
 
 
@@ -946,3 +1377,473 @@ EAIO_API bool EA::IO::WriteLine(IStream* pOS, const char16_t* pLine, size_type n
     return bResult;
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Variable-length integer functions
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+    // Decodes a VarUint (unsigned LEB128) from p, of which nAvailable bytes are valid.
+    // Returns the number of bytes decoded, or 0 if the encoding is incomplete within 
+    // nAvailable bytes, doesn't fit in 64 bits or isn't the shortest encoding of the
+    // value. An encoding is the shortest unless it ends with a zero byte after the first.
+    size_t DecodeVarUint(const uint8_t* p, size_t nAvailable, uint64_t& value)
+    {
+        const size_t nSizeMax = (nAvailable < EA::IO::kVarUint64SizeMax) ? nAvailable : (size_t)EA::IO::kVarUint64SizeMax;
+        uint64_t     n        = 0;
+
+        for(size_t i = 0; i < nSizeMax; i++)
+        {
+            const uint64_t b = p[i];
+
+            n |= ((b & 0x7f) << (7 * i));
+
+            if(b < 0x80)
+            {
+                if((i == 9) && (b > 1)) // If the tenth byte has bits beyond the 64th...
+                    return 0;
+
+                if((b == 0) && (i != 0)) // If the value would fit in fewer bytes (e.g. 0x80 0x00)...
+                    return 0;
+
+                value = n;
+                return (i + 1);
+            }
+        }
+
+        return 0;
+    }
+
+
+    // Encodes value as a VarUint to p, which must have room for kVarUint64SizeMax bytes.
+    // Returns the number of bytes encoded.
+    size_t EncodeVarUint(uint8_t* p, uint64_t value)
+    {
+        size_t i = 0;
+
+        for(; value >= 0x80; value >>= 7)
+            p[i++] = (uint8_t)(value | 0x80);
+        p[i++] = (uint8_t)value;
+
+        return i;
+    }
+
+
+    uint64_t LoadUint64Little(const uint8_t* p)
+    {
+        uint64_t n;
+        memcpy(&n, p, sizeof(n));
+
+        if(EA::IO::kEndianLocal != EA::IO::kEndianLittle)
+            n = SwizzleUint64(n);
+        return n;
+    }
+
+
+    void StoreUint64Little(uint8_t* p, uint64_t n)
+    {
+        if(EA::IO::kEndianLocal != EA::IO::kEndianLittle)
+            n = SwizzleUint64(n);
+        memcpy(p, &n, sizeof(n));
+    }
+
+
+    // Returns the number of bytes of the PrefixVarUint whose first byte is b.
+    size_t GetPrefixVarUintSize(uint8_t b)
+    {
+        if(b == 0)
+            return 9;
+
+        #if defined(EA_COMPILER_GNUC) || defined(EA_COMPILER_CLANG)
+            return (size_t)__builtin_ctz(b) + 1;
+        #else
+            size_t nSize = 1;
+            for(; !(b & 1); b >>= 1)
+                nSize++;
+            return nSize;
+        #endif
+    }
+
+
+    // Decodes a PrefixVarUint from p, of which nAvailable bytes are valid. Returns
+    // the number of bytes decoded, or 0 if the encoding is incomplete within nAvailable 
+    // bytes or isn't the shortest encoding of the value.
+    size_t DecodePrefixVarUint(const uint8_t* p, size_t nAvailable, uint64_t& value)
+    {
+        if(nAvailable == 0)
+            return 0;
+
+        const size_t nSize = GetPrefixVarUintSize(p[0]);
+
+        if(nSize > nAvailable)
+            return 0;
+
+        if(nSize == 9)
+        {
+            const uint64_t n = LoadUint64Little(p + 1);
+
+            if((n >> 56) == 0) // If the value would fit in 8 bytes...
+                return 0;
+
+            value = n;
+            return 9;
+        }
+
+        // We load 8 bytes at once and mask off those beyond the value, rather than 
+        // branch on each byte. Near the end of the data, we load from a copy instead.
+        uint64_t n;
+
+        if(nAvailable >= 8)
+            n = LoadUint64Little(p);
+        else
+        {
+            uint8_t buffer[8] = { 0 };
+            memcpy(buffer, p, nAvailable);
+            n = LoadUint64Little(buffer);
+        }
+
+        n = ((n & (~UINT64_C(0) >> (64 - (8 * nSize)))) >> nSize);
+
+        if((nSize > 1) && ((n >> (7 * (nSize - 1))) == 0)) // If the value would fit in fewer bytes...
+            return 0;
+
+        value = n;
+        return nSize;
+    }
+
+
+    // Encodes value as a PrefixVarUint to p, which must have room for kPrefixVarUint64SizeMax 
+    // bytes. Returns the number of bytes encoded.
+    size_t EncodePrefixVarUint(uint8_t* p, uint64_t value)
+    {
+        if(value >> 56) // If the value doesn't fit in 8 bytes of 7 bits each...
+        {
+            p[0] = 0;
+            StoreUint64Little(p + 1, value);
+            return 9;
+        }
+
+        size_t nSize = 1;
+
+        while((nSize < 8) && (value >> (7 * nSize)))
+            nSize++;
+
+        uint8_t buffer[8];
+        StoreUint64Little(buffer, (value << nSize) | ((uint64_t)1 << (nSize - 1)));
+        memcpy(p, buffer, nSize);
+
+        return nSize;
+    }
+
+
+    typedef size_t (*VarUintDecoder)(const uint8_t* p, size_t nAvailable, uint64_t& value);
+    typedef size_t (*VarUintEncoder)(uint8_t* p, uint64_t value);
+
+
+    // Converts a decoded VarUint to the destination type, zigzag decoding it for signed
+    // types. Returns false, leaving value unchanged, if the value doesn't fit in the type.
+    bool StoreVarValue(uint64_t n, uint32_t& value) { if(n >> 32) return false; value = (uint32_t)n;                         return true; }
+    bool StoreVarValue(uint64_t n, uint64_t& value) {                           value = n;                                   return true; }
+    bool StoreVarValue(uint64_t n, int32_t&  value) { if(n >> 32) return false; value = EA::IO::DecodeZigZag32((uint32_t)n); return true; }
+    bool StoreVarValue(uint64_t n, int64_t&  value) {                           value = EA::IO::DecodeZigZag64(n);           return true; }
+
+    // Converts a value to the VarUint to encode, zigzag encoding it for signed types.
+    uint64_t LoadVarValue(uint32_t value) { return value; }
+    uint64_t LoadVarValue(uint64_t value) { return value; }
+    uint64_t LoadVarValue(int32_t  value) { return EA::IO::EncodeZigZag32(value); }
+    uint64_t LoadVarValue(int64_t  value) { return EA::IO::EncodeZigZag64(value); }
+
+
+    // Reads one encoded value from a stream whose data isn't directly addressable.
+    bool ReadVarUintFromStream(EA::IO::IStream* pIS, VarUintDecoder pDecoder, uint64_t& value)
+    {
+        uint8_t buffer[EA::IO::kVarUint64SizeMax];
+        size_t  nSize = 0;
+
+        if(pDecoder == DecodePrefixVarUint)
+        {
+            if(pIS->Read(buffer, 1) != 1)
+                return false;
+
+            nSize = GetPrefixVarUintSize(buffer[0]);
+
+            if((nSize > 1) && (pIS->Read(buffer + 1, nSize - 1) != (nSize - 1)))
+                return false;
+        }
+        else
+        {
+            do {
+                if(pIS->Read(buffer + nSize, 1) != 1)
+                    return false;
+            } while((buffer[nSize++] & 0x80) && (nSize < sizeof(buffer)));
+        }
+
+        return (pDecoder(buffer, nSize, value) != 0);
+    }
+
+
+    // Reads count encoded values. As with ReadSwizzled, values are decoded directly
+    // from the stream's data if it's in memory or in the read buffer of a StreamBuffer.
+    template <typename T>
+    bool ReadVarArray(EA::IO::IStream* pIS, T* pValue, EA::IO::size_type count, VarUintDecoder pDecoder)
+    {
+        using namespace EA::IO;
+
+        uint64_t n;
+
+        if(const uint8_t* const pData = (const uint8_t*)GetStreamMemory(pIS, false))
+        {
+            const uint8_t* p       = pData + (size_type)pIS->GetPosition();
+            const uint8_t* pEnd    = p + pIS->GetAvailable();
+            bool           bResult = true;
+
+            for(; count && bResult; count--)
+            {
+                const size_t nSize = pDecoder(p, (size_t)(pEnd - p), n);
+
+                bResult = (nSize != 0) && StoreVarValue(n, *pValue++);
+                p += nSize;
+            }
+
+            pIS->SetPosition((off_type)(p - pData));
+            return bResult;
+        }
+
+        if(pIS->GetType() == StreamBuffer::kTypeStreamBuffer)
+        {
+            StreamBuffer* const pStreamBuffer = static_cast<StreamBuffer*>(pIS);
+            size_type           nAvailable;
+
+            for(const uint8_t* pBegin; count && ((pBegin = (const uint8_t*)pStreamBuffer->Peek(kVarUint64SizeMax, nAvailable)) != NULL); )
+            {
+                const uint8_t* const pEnd  = pBegin + nAvailable;
+                const uint8_t*       p     = pBegin;
+                size_t               nSize = 0;
+
+                for(; count && ((nSize = pDecoder(p, (size_t)(pEnd - p), n)) != 0); count--)
+                {
+                    if(!StoreVarValue(n, *pValue++))
+                    {
+                        pStreamBuffer->Consume((size_type)(p - pBegin));
+                        return false;
+                    }
+
+                    p += nSize;
+                }
+
+                pStreamBuffer->Consume((size_type)(p - pBegin));
+
+                // If we couldn't decode anything although Peek returned all it could, the 
+                // encoding is invalid or the stream ends within it. Otherwise the value 
+                // crossed the end of the read buffer and we Peek again.
+                if(count && (p == pBegin))
+                    return false;
+            }
+
+            if(count == 0)
+                return true;
+            // Else read buffering is disabled or the stream is at its end, which the regular path handles.
+        }
+
+        for(; count; count--)
+        {
+            if(!ReadVarUintFromStream(pIS, pDecoder, n) || !StoreVarValue(n, *pValue++))
+                return false;
+        }
+
+        return true;
+    }
+
+
+    // Writes count encoded values. They are encoded directly into the write buffer of a 
+    // StreamBuffer, and otherwise through a stack buffer.
+    template <typename T>
+    bool WriteVarArray(EA::IO::IStream* pOS, const T* pValue, EA::IO::size_type count, VarUintEncoder pEncoder)
+    {
+        using namespace EA::IO;
+
+        if(pOS->GetType() == StreamBuffer::kTypeStreamBuffer)
+        {
+            StreamBuffer* const pStreamBuffer = static_cast<StreamBuffer*>(pOS);
+            size_type           nAvailable;
+
+            for(uint8_t* pBegin; count && ((pBegin = (uint8_t*)pStreamBuffer->GetWriteSpan(kVarUint64SizeMax, nAvailable)) != NULL); )
+            {
+                uint8_t* const pEnd = pBegin + nAvailable - kVarUint64SizeMax; // Each value is encoded only if it surely fits.
+                uint8_t*       p    = pBegin;
+
+                for(; count && (p <= pEnd); count--)
+                    p += pEncoder(p, LoadVarValue(*pValue++));
+
+                pStreamBuffer->Commit((size_type)(p - pBegin));
+            }
+
+            if(count == 0)
+                return true;
+            // Else write buffering is disabled, which the regular path handles.
+        }
+
+        uint8_t buffer[2048];
+        size_t  nUsed = 0;
+
+        for(; count; count--)
+        {
+            nUsed += pEncoder(buffer + nUsed, LoadVarValue(*pValue++));
+
+            if(nUsed > (sizeof(buffer) - kVarUint64SizeMax)) // If the next value might not fit...
+            {
+                if(!pOS->Write(buffer, nUsed))
+                    return false;
+                nUsed = 0;
+            }
+        }
+
+        return (nUsed == 0) || pOS->Write(buffer, nUsed);
+    }
+
+} // namespace
+
+
+EAIO_API bool EA::IO::ReadVarUint32(IStream* pIS, uint32_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarUint32(IStream* pIS, uint32_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarUint64(IStream* pIS, uint64_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarUint64(IStream* pIS, uint64_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarInt32(IStream* pIS, int32_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarInt32(IStream* pIS, int32_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarInt64(IStream* pIS, int64_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadVarInt64(IStream* pIS, int64_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadPrefixVarUint64(IStream* pIS, uint64_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadPrefixVarUint64(IStream* pIS, uint64_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadPrefixVarInt64(IStream* pIS, int64_t& value)
+{
+    return ReadVarArray(pIS, &value, 1, DecodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::ReadPrefixVarInt64(IStream* pIS, int64_t* value, size_type count)
+{
+    return ReadVarArray(pIS, value, count, DecodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarUint32(IStream* pOS, uint32_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarUint32(IStream* pOS, const uint32_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarUint64(IStream* pOS, uint64_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarUint64(IStream* pOS, const uint64_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarInt32(IStream* pOS, int32_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarInt32(IStream* pOS, const int32_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarInt64(IStream* pOS, int64_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WriteVarInt64(IStream* pOS, const int64_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodeVarUint);
+}
+
+
+EAIO_API bool EA::IO::WritePrefixVarUint64(IStream* pOS, uint64_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::WritePrefixVarUint64(IStream* pOS, const uint64_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::WritePrefixVarInt64(IStream* pOS, int64_t value)
+{
+    return WriteVarArray(pOS, &value, 1, EncodePrefixVarUint);
+}
+
+
+EAIO_API bool EA::IO::WritePrefixVarInt64(IStream* pOS, const int64_t* value, size_type count)
+{
+    return WriteVarArray(pOS, value, count, EncodePrefixVarUint);
+}
@@ -111,8 +111,58 @@ namespace EA
             /// error code and return false. Generally the reason you'd want to
             /// do this instead of relying on I/O errors alone is so that you don't
             /// try to allocate a 15GB array before entering the read loop.
+            ///
+            /// This queries the stream's position and size, which for a FileStream means
+            /// system calls. While a ReadReservation is active, the array is instead checked
+            /// against what remains of the reservation, with no stream calls.
             bool VerifyArraySize(uint32_t elementCount, uint32_t elementSize);
 
+            /// ReadReservation
+            ///
+            /// Checks once that a block of data is available to be read, after which 
+            /// VerifyArraySize checks arrays against the reservation instead of against 
+            /// the stream. Each array which passes VerifyArraySize is assumed to be read,
+            /// and its size is deducted from the reservation, so that the arrays of the 
+            /// block together can't exceed it. Reads of other data aren't deducted, and 
+            /// so this is an upper bound rather than an exact check; reading beyond the 
+            /// data still fails as usual. Reservations may be nested. setStream ends all
+            /// active reservations, and their destruction then has no effect.
+            ///
+            /// An nSize of kLengthNull reserves all the data remaining in the stream. 
+            /// If less than nSize is available, the adapter is made invalid, as with a 
+            /// failed VerifyArraySize.
+            ///
+            /// Example usage:
+            ///     StreamAdapter adapter(pStream, kEndianLittle);
+            ///     StreamAdapter::ReadReservation reservation(adapter, chunkSize);
+            ///
+            ///     for(uint32_t i = 0; (i < meshCount) && adapter; i++)
+            ///     {
+            ///         adapter.ReadUint32(vertexCount);
+            ///
+            ///         if(adapter.VerifyArraySize(vertexCount, sizeof(Vertex)))
+            ///             ...
+            ///     }
+            ///
+            class EAIO_API ReadReservation
+            {
+            public:
+                ReadReservation(StreamAdapter& adapter, EA::IO::size_type nSize = EA::IO::kLengthNull);
+               ~ReadReservation();
+
+                bool IsValid() const;   /// Returns false if nSize wasn't available.
+
+            protected:
+                ReadReservation(const ReadReservation&);              // Not implemented.
+                ReadReservation& operator=(const ReadReservation&);   // Not implemented.
+
+                StreamAdapter&    mAdapter;
+                ReadReservation*  mpPrevious;       /// The enclosing reservation, or NULL.
+                EA::IO::size_type mnReservedSize;   /// The size this reservation started with.
+                EA::IO::size_type mnPreviousSize;   /// The enclosing reservation's remaining size, restored upon destruction.
+                bool              mbValid;
+            };
+
             // basic types
             inline void ReadUint8(uint8_t& v);
             inline void WriteUint8(uint8_t v);
@@ -193,15 +243,80 @@ namespace EA
             template <typename String16>
             void WriteString16(const String16& string);
 
+            // Structs with a field list. See ReadStruct. These are defined in EAStreamSerializer.h, which must be #included to use them.
+            template <typename T>
+            void ReadStruct(T& v);
+
+            template <typename T>
+            void WriteStruct(const T& v);
+
+            template <typename T>
+            void ReadStruct(T* v, uint32_t count);
+
+            template <typename T>
+            void WriteStruct(const T* v, uint32_t count);
+
+            // Variable-length integers. See ReadVarUint32, etc. These are endian-independent.
+            inline void ReadVarUint32(uint32_t& v);
+            inline void WriteVarUint32(uint32_t v);
+            inline void ReadVarUint64(uint64_t& v);
+            inline void WriteVarUint64(uint64_t v);
+            inline void ReadVarInt32(int32_t& v);
+            inline void WriteVarInt32(int32_t v);
+            inline void ReadVarInt64(int64_t& v);
+            inline void WriteVarInt64(int64_t v);
+            inline void ReadPrefixVarUint64(uint64_t& v);
+            inline void WritePrefixVarUint64(uint64_t v);
+            inline void ReadPrefixVarInt64(int64_t& v);
+            inline void WritePrefixVarInt64(int64_t v);
+
+            inline void ReadVarUint32(uint32_t* v, uint32_t count);
+            inline void WriteVarUint32(const uint32_t* v, uint32_t count);
+            inline void ReadVarUint64(uint64_t* v, uint32_t count);
+            inline void WriteVarUint64(const uint64_t* v, uint32_t count);
+            inline void ReadVarInt32(int32_t* v, uint32_t count);
+            inline void WriteVarInt32(const int32_t* v, uint32_t count);
+            inline void ReadVarInt64(int64_t* v, uint32_t count);
+            inline void WriteVarInt64(const int64_t* v, uint32_t count);
+            inline void ReadPrefixVarUint64(uint64_t* v, uint32_t count);
+            inline void WritePrefixVarUint64(const uint64_t* v, uint32_t count);
+            inline void ReadPrefixVarInt64(int64_t* v, uint32_t count);
+            inline void WritePrefixVarInt64(const int64_t* v, uint32_t count);
+
         protected:
             EA::IO::IStream*  mpStream;
-            EA::IO::size_type mCachedSize;
+            EA::IO::size_type mCachedSize;          /// The size remaining in the active ReadReservation.
             EA::IO::Endian    mEndianType; 
             bool              mSuccess;
-            bool              mCachedSizeValid;
+            bool              mCachedSizeValid;     /// True if a ReadReservation is active.
+            ReadReservation*  mpReservation;        /// The innermost active ReadReservation, or NULL. setStream clears this, which ends all reservations.
         };
 
 
+        /// SwizzleLevel
+        ///
+        /// The instruction sets which the array read and write functions below
+        /// (e.g. ReadUint32 with a count) can use to convert endian-ness.
+        ///
+        enum SwizzleLevel
+        {
+            kSwizzleLevelScalar,    /// Plain C++, one element at a time.
+            kSwizzleLevelSSE2,
+            kSwizzleLevelSSSE3,
+            kSwizzleLevelAVX2
+        };
+
+        /// SetSwizzleLevel
+        ///
+        /// Limits the array read and write functions to the given SwizzleLevel, and 
+        /// returns the level which will actually be used, which is lower if the processor 
+        /// doesn't support the given one. By default the best supported level is used, 
+        /// which SetSwizzleLevel(kSwizzleLevelAVX2) restores. This is intended for testing
+        /// and benchmarking, and must not be called while other threads use the functions.
+        ///
+        EAIO_API int SetSwizzleLevel(int nSwizzleLevel);
+
+
 
         ///////////////////////////////////////////////////////////////////
         // Adapter functions for reading data from streams
@@ -799,6 +914,94 @@ namespace EA
         bool WriteString16(EA::IO::IStream* pIS, const String16& s, Endian endianDestination = kEndianBig);
 
 
+
+        ///////////////////////////////////////////////////////////////////
+        // Variable-length integer functions
+        //
+        // These read and write integers in a variable number of bytes, so 
+        // that small values, which are the most common in practice, take less
+        // space than with the fixed-width functions above. The encodings are
+        // endian-independent.
+        //
+        // VarUint: Unsigned LEB128, as used by DWARF, WebAssembly and Protocol
+        //     Buffers. Each byte holds 7 bits of the value, low bits first, and 
+        //     the high bit of each byte is set if another byte follows. Values 
+        //     below 128 take 1 byte. A uint32_t takes at most 5 bytes and a 
+        //     uint64_t at most 10.
+        //
+        // VarInt: A signed value is zigzag encoded (see EncodeZigZag32) and then 
+        //     written as a VarUint, so that small negative values are small too.
+        //
+        // PrefixVarUint: The number of bytes is given by the number of trailing
+        //     zero bits of the first byte plus one, with a first byte of zero 
+        //     meaning 9 bytes. Each byte holds 7 bits, except that the ninth holds 8.
+        //     Since the length is known from the first byte, decoding doesn't branch
+        //     per byte, which makes it the fastest to read. Values take the same
+        //     number of bytes as with VarUint, except that a uint64_t takes at most 9.
+        //
+        // The functions return true if the value could be completely read or 
+        // written. A read also fails if the encoding is invalid, if it isn't the
+        // shortest encoding of the value (e.g. the VarUint 0x80 0x00 for 0), or if 
+        // the value doesn't fit the destination type, as when reading a 64 bit 
+        // value with ReadVarUint32. A failed read leaves the value which failed 
+        // unchanged. As with the fixed-width array reads, a failed array read may
+        // have consumed part of the stream and stored the values before the one 
+        // which failed.
+        //
+        // Example usage:
+        //    WriteVarUint32(pOS, nCount);
+        //    WriteVarInt32(pOS, nDelta);
+        //
+        //    ReadVarUint32(pIS, nCount);
+        //    ReadVarInt32(pIS, nDelta);
+        ///////////////////////////////////////////////////////////////////
+
+        const size_type kVarUint32SizeMax       =  5;  /// The maximum number of bytes written by WriteVarUint32 and WriteVarInt32.
+        const size_type kVarUint64SizeMax       = 10;  /// The maximum number of bytes written by WriteVarUint64 and WriteVarInt64.
+        const size_type kPrefixVarUint64SizeMax =  9;  /// The maximum number of bytes written by WritePrefixVarUint64 and WritePrefixVarInt64.
+
+        /// EncodeZigZag32 / EncodeZigZag64
+        ///
+        /// Maps signed values to unsigned values such that values of small magnitude
+        /// map to small values: 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3, etc.
+        ///
+        inline uint32_t EncodeZigZag32(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+        inline uint64_t EncodeZigZag64(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+
+        /// DecodeZigZag32 / DecodeZigZag64
+        ///
+        /// Reverses EncodeZigZag32 and EncodeZigZag64.
+        ///
+        inline int32_t DecodeZigZag32(uint32_t value) { return (int32_t)((value >> 1) ^ (0 - (value & 1))); }
+        inline int64_t DecodeZigZag64(uint64_t value) { return (int64_t)((value >> 1) ^ (0 - (value & 1))); }
+
+        EAIO_API bool ReadVarUint32(IStream* pIS, uint32_t& value);
+        EAIO_API bool ReadVarUint32(IStream* pIS, uint32_t* value, size_type count);
+        EAIO_API bool ReadVarUint64(IStream* pIS, uint64_t& value);
+        EAIO_API bool ReadVarUint64(IStream* pIS, uint64_t* value, size_type count);
+        EAIO_API bool ReadVarInt32(IStream* pIS, int32_t& value);
+        EAIO_API bool ReadVarInt32(IStream* pIS, int32_t* value, size_type count);
+        EAIO_API bool ReadVarInt64(IStream* pIS, int64_t& value);
+        EAIO_API bool ReadVarInt64(IStream* pIS, int64_t* value, size_type count);
+        EAIO_API bool ReadPrefixVarUint64(IStream* pIS, uint64_t& value);
+        EAIO_API bool ReadPrefixVarUint64(IStream* pIS, uint64_t* value, size_type count);
+        EAIO_API bool ReadPrefixVarInt64(IStream* pIS, int64_t& value);
+        EAIO_API bool ReadPrefixVarInt64(IStream* pIS, int64_t* value, size_type count);
+
+        EAIO_API bool WriteVarUint32(IStream* pOS, uint32_t value);
+        EAIO_API bool WriteVarUint32(IStream* pOS, const uint32_t* value, size_type count);
+        EAIO_API bool WriteVarUint64(IStream* pOS, uint64_t value);
+        EAIO_API bool WriteVarUint64(IStream* pOS, const uint64_t* value, size_type count);
+        EAIO_API bool WriteVarInt32(IStream* pOS, int32_t value);
+        EAIO_API bool WriteVarInt32(IStream* pOS, const int32_t* value, size_type count);
+        EAIO_API bool WriteVarInt64(IStream* pOS, int64_t value);
+        EAIO_API bool WriteVarInt64(IStream* pOS, const int64_t* value, size_type count);
+        EAIO_API bool WritePrefixVarUint64(IStream* pOS, uint64_t value);
+        EAIO_API bool WritePrefixVarUint64(IStream* pOS, const uint64_t* value, size_type count);
+        EAIO_API bool WritePrefixVarInt64(IStream* pOS, int64_t value);
+        EAIO_API bool WritePrefixVarInt64(IStream* pOS, const int64_t* value, size_type count);
+
+
     } // namespace IO
 
 } // namespace EA
@@ -845,16 +1048,22 @@ inline EA::IO::IStream& operator>>(EA::IO::IStream& s, double& val)         { EA
 
 inline StreamAdapter::StreamAdapter()
   : mpStream(NULL),
+    mCachedSize(0),
     mEndianType(EA::IO::kEndianBig), 
-    mSuccess(true)
+    mSuccess(true),
+    mCachedSizeValid(false),
+    mpReservation(NULL)
 {
 }
 
 
 inline StreamAdapter::StreamAdapter(EA::IO::IStream* pStream, EA::IO::Endian endianType)
   : mpStream(pStream),
+    mCachedSize(0),
     mEndianType(endianType), 
-    mSuccess(true)
+    mSuccess(true),
+    mCachedSizeValid(false),
+    mpReservation(NULL)
 {
 }
 
@@ -893,6 +1102,14 @@ inline EA::IO::IStream* StreamAdapter::getStream() const
 inline void StreamAdapter::setStream(EA::IO::IStream* pStream)
 {
     mpStream = pStream;
+    mCachedSizeValid = false; // Any active reservation was for the previous stream.
+    mpReservation    = NULL;
+}
+
+
+inline bool StreamAdapter::ReadReservation::IsValid() const
+{
+    return mbValid;
 }
 
 
@@ -980,6 +1197,33 @@ inline void StreamAdapter::WriteFloat(const float* v, uint32_t count)    { Verif
 inline void StreamAdapter::ReadDouble(double* v, uint32_t count)         { VerifyIO(EA::IO::ReadDouble(mpStream, v, count, mEndianType)); }
 inline void StreamAdapter::WriteDouble(const double* v, uint32_t count)  { VerifyIO(EA::IO::WriteDouble(mpStream, v, count, mEndianType)); }
 
+// variable-length integers
+inline void StreamAdapter::ReadVarUint32(uint32_t& v)        { VerifyIO(EA::IO::ReadVarUint32(mpStream, v));  }
+inline void StreamAdapter::WriteVarUint32(uint32_t v)        { VerifyIO(EA::IO::WriteVarUint32(mpStream, v)); }
+inline void StreamAdapter::ReadVarUint64(uint64_t& v)        { VerifyIO(EA::IO::ReadVarUint64(mpStream, v));  }
+inline void StreamAdapter::WriteVarUint64(uint64_t v)        { VerifyIO(EA::IO::WriteVarUint64(mpStream, v)); }
+inline void StreamAdapter::ReadVarInt32(int32_t& v)          { VerifyIO(EA::IO::ReadVarInt32(mpStream, v));   }
+inline void StreamAdapter::WriteVarInt32(int32_t v)          { VerifyIO(EA::IO::WriteVarInt32(mpStream, v));  }
+inline void StreamAdapter::ReadVarInt64(int64_t& v)          { VerifyIO(EA::IO::ReadVarInt64(mpStream, v));   }
+inline void StreamAdapter::WriteVarInt64(int64_t v)          { VerifyIO(EA::IO::WriteVarInt64(mpStream, v));  }
+inline void StreamAdapter::ReadPrefixVarUint64(uint64_t& v)  { VerifyIO(EA::IO::ReadPrefixVarUint64(mpStream, v));  }
+inline void StreamAdapter::WritePrefixVarUint64(uint64_t v)  { VerifyIO(EA::IO::WritePrefixVarUint64(mpStream, v)); }
+inline void StreamAdapter::ReadPrefixVarInt64(int64_t& v)    { VerifyIO(EA::IO::ReadPrefixVarInt64(mpStream, v));   }
+inline void StreamAdapter::WritePrefixVarInt64(int64_t v)    { VerifyIO(EA::IO::WritePrefixVarInt64(mpStream, v));  }
+
+inline void StreamAdapter::ReadVarUint32(uint32_t* v, uint32_t count)              { VerifyIO(EA::IO::ReadVarUint32(mpStream, v, count));  }
+inline void StreamAdapter::WriteVarUint32(const uint32_t* v, uint32_t count)       { VerifyIO(EA::IO::WriteVarUint32(mpStream, v, count)); }
+inline void StreamAdapter::ReadVarUint64(uint64_t* v, uint32_t count)              { VerifyIO(EA::IO::ReadVarUint64(mpStream, v, count));  }
+inline void StreamAdapter::WriteVarUint64(const uint64_t* v, uint32_t count)       { VerifyIO(EA::IO::WriteVarUint64(mpStream, v, count)); }
+inline void StreamAdapter::ReadVarInt32(int32_t* v, uint32_t count)                { VerifyIO(EA::IO::ReadVarInt32(mpStream, v, count));   }
+inline void StreamAdapter::WriteVarInt32(const int32_t* v, uint32_t count)         { VerifyIO(EA::IO::WriteVarInt32(mpStream, v, count));  }
+inline void StreamAdapter::ReadVarInt64(int64_t* v, uint32_t count)                { VerifyIO(EA::IO::ReadVarInt64(mpStream, v, count));   }
+inline void StreamAdapter::WriteVarInt64(const int64_t* v, uint32_t count)         { VerifyIO(EA::IO::WriteVarInt64(mpStream, v, count));  }
+inline void StreamAdapter::ReadPrefixVarUint64(uint64_t* v, uint32_t count)        { VerifyIO(EA::IO::ReadPrefixVarUint64(mpStream, v, count));  }
+inline void StreamAdapter::WritePrefixVarUint64(const uint64_t* v, uint32_t count) { VerifyIO(EA::IO::WritePrefixVarUint64(mpStream, v, count)); }
+inline void StreamAdapter::ReadPrefixVarInt64(int64_t* v, uint32_t count)          { VerifyIO(EA::IO::ReadPrefixVarInt64(mpStream, v, count));   }
+inline void StreamAdapter::WritePrefixVarInt64(const int64_t* v, uint32_t count)   { VerifyIO(EA::IO::WritePrefixVarInt64(mpStream, v, count));  }
+
 
 inline size_t StreamAdapter::ReadString8(char8_t* string, uint32_t capacity)
 {
@@ -0,0 +1,776 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAStreamBlockCache.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a stream which caches multiple fixed-size blocks of a random
+// access stream, for random access patterns which revisit the same data.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAStreamBlockCache.h>
+#include <eaio/EASharedBlockCache.h>
+#include <eaio/Allocator.h>
+#include <eastl/coreallocator/icoreallocator_interface.h>
+#include <string.h> // memcpy, etc.
+#include EA_ASSERT_HEADER
+
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+namespace StreamBlockCacheLocal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // kBlockNone
+    //
+    // Used for list links and hash bucket heads which refer to no block.
+    //
+    const int kBlockNone = -1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamBlockCache
+//
+StreamBlockCache::StreamBlockCache(IStream* pStream, size_type nBlockSize, size_type nBlockCount, Allocator* pAllocator)
+  : mpStream(NULL),
+    mnRefCount(0),
+    mnPosition(0),
+    mnPositionInternal(kSizeTypeError),
+    mpAllocator(pAllocator ? pAllocator : IO::getAllocator()),
+    mnBlockSize(0),
+    mnBlockCount(0),
+    mpBlockArray(NULL),
+    mpHashTable(NULL),
+    mnHashTableSize(0),
+    mpBlockData(NULL),
+    mnLRUHead(StreamBlockCacheLocal::kBlockNone),
+    mnLRUTail(StreamBlockCacheLocal::kBlockNone),
+    mnPartialBlock(StreamBlockCacheLocal::kBlockNone),
+    mStats(),
+    mpSharedCache(NULL),
+    mSharedStreamId()
+{
+    SetCacheSize(nBlockSize, nBlockCount);
+    setStream(pStream);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ~StreamBlockCache
+//
+StreamBlockCache::~StreamBlockCache()
+{
+    setStream(NULL);
+    FreeCache();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setStream
+//
+bool StreamBlockCache::setStream(IStream* pStream)
+{
+    if(pStream != mpStream)
+    {
+        Invalidate();
+
+        if(pStream)
+            pStream->AddRef();
+
+        if(mpStream)
+            mpStream->Release();
+
+        mpStream           = pStream;
+        mnPosition         = pStream ? (size_type)pStream->GetPosition() : 0;
+        mnPositionInternal = mnPosition;
+    }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SetCacheSize
+//
+bool StreamBlockCache::SetCacheSize(size_type nBlockSize, size_type nBlockCount)
+{
+    EA_ASSERT((nBlockSize & (nBlockSize - 1)) == 0); // Block positions are computed with masks.
+    EA_ASSERT(nBlockCount < 0x7fffffff);
+
+    FreeCache();
+
+    if(nBlockSize && nBlockCount && mpAllocator)
+    {
+        // We size the hash table to have at least twice as many buckets as blocks.
+        for(mnHashTableSize = 4; mnHashTableSize < (nBlockCount * 2); mnHashTableSize *= 2)
+            { }
+
+        mpBlockArray = (Block*)mpAllocator->alloc((size_t)(nBlockCount * sizeof(Block)),    EAIO_ALLOC_PREFIX "StreamBlockCache", 0);
+        mpHashTable  = (int*)  mpAllocator->alloc((size_t)(mnHashTableSize * sizeof(int)),  EAIO_ALLOC_PREFIX "StreamBlockCache", 0);
+        mpBlockData  = (char*) mpAllocator->alloc((size_t)(nBlockCount * nBlockSize),       EAIO_ALLOC_PREFIX "StreamBlockCache", 0);
+
+        if(mpBlockArray && mpHashTable && mpBlockData)
+        {
+            mnBlockSize  = nBlockSize;
+            mnBlockCount = nBlockCount;
+            Invalidate();
+            return true;
+        }
+
+        // FreeCache uses these to compute the sizes of whichever allocations succeeded.
+        mnBlockSize  = nBlockSize;
+        mnBlockCount = nBlockCount;
+        FreeCache();
+        return false;
+    }
+
+    return (nBlockCount == 0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FreeCache
+//
+// This is an internal function.
+//
+void StreamBlockCache::FreeCache()
+{
+    if(mpBlockArray)
+        mpAllocator->free(mpBlockArray, (size_t)(mnBlockCount * sizeof(Block)));
+    if(mpHashTable)
+        mpAllocator->free(mpHashTable, (size_t)(mnHashTableSize * sizeof(int)));
+    if(mpBlockData)
+        mpAllocator->free(mpBlockData, (size_t)(mnBlockCount * mnBlockSize));
+
+    mpBlockArray    = NULL;
+    mpHashTable     = NULL;
+    mpBlockData     = NULL;
+    mnHashTableSize = 0;
+    mnBlockSize     = 0;
+    mnBlockCount    = 0;
+    mnLRUHead       = StreamBlockCacheLocal::kBlockNone;
+    mnLRUTail       = StreamBlockCacheLocal::kBlockNone;
+    mnPartialBlock  = StreamBlockCacheLocal::kBlockNone;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Invalidate
+//
+void StreamBlockCache::Invalidate()
+{
+    using namespace StreamBlockCacheLocal;
+
+    // All blocks become unused and are linked in order from most to least recently used.
+    for(int i = 0, iEnd = (int)mnBlockCount; i < iEnd; i++)
+    {
+        Block& block = mpBlockArray[i];
+
+        block.mnBlockIndex = kSizeTypeError;
+        block.mnSize       = 0;
+        block.mnLRUPrev    = i - 1;
+        block.mnLRUNext    = ((i + 1) < iEnd) ? (i + 1) : kBlockNone;
+        block.mnHashNext   = kBlockNone;
+    }
+
+    for(uint32_t i = 0; i < mnHashTableSize; i++)
+        mpHashTable[i] = kBlockNone;
+
+    mnLRUHead      = mnBlockCount ? 0 : kBlockNone;
+    mnLRUTail      = (int)mnBlockCount - 1;
+    mnPartialBlock = kBlockNone;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SetSharedCache
+//
+void StreamBlockCache::SetSharedCache(SharedBlockCache* pCache, const SharedStreamId& streamId)
+{
+    mpSharedCache   = pCache;
+    mSharedStreamId = streamId;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetHashBucket
+//
+// This is an internal function.
+//
+uint32_t StreamBlockCache::GetHashBucket(size_type nBlockIndex) const
+{
+    // Fibonacci hashing spreads consecutive block indexes across the table.
+    return (uint32_t)(((uint64_t)nBlockIndex * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (mnHashTableSize - 1);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FindBlock
+//
+// This is an internal function.
+//
+// Returns the cached block with the given index, or kBlockNone.
+//
+int StreamBlockCache::FindBlock(size_type nBlockIndex) const
+{
+    using namespace StreamBlockCacheLocal;
+
+    int nBlock = mpHashTable[GetHashBucket(nBlockIndex)];
+
+    while((nBlock != kBlockNone) && (mpBlockArray[nBlock].mnBlockIndex != nBlockIndex))
+        nBlock = mpBlockArray[nBlock].mnHashNext;
+
+    return nBlock;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TouchBlock
+//
+// This is an internal function.
+//
+// Makes the given block the most recently used.
+//
+void StreamBlockCache::TouchBlock(int nBlock)
+{
+    using namespace StreamBlockCacheLocal;
+
+    if(nBlock != mnLRUHead)
+    {
+        Block& block = mpBlockArray[nBlock];
+
+        // Unlink. Since the block isn't the head, it has a previous block.
+        mpBlockArray[block.mnLRUPrev].mnLRUNext = block.mnLRUNext;
+        if(block.mnLRUNext != kBlockNone)
+            mpBlockArray[block.mnLRUNext].mnLRUPrev = block.mnLRUPrev;
+        else
+            mnLRUTail = block.mnLRUPrev;
+
+        // Link at the head.
+        block.mnLRUPrev = kBlockNone;
+        block.mnLRUNext = mnLRUHead;
+        mpBlockArray[mnLRUHead].mnLRUPrev = nBlock;
+        mnLRUHead = nBlock;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RemoveBlock
+//
+// This is an internal function.
+//
+// Makes the given block unused and the least recently used, so that it's
+// the next to be reused.
+//
+void StreamBlockCache::RemoveBlock(int nBlock)
+{
+    using namespace StreamBlockCacheLocal;
+
+    Block& block = mpBlockArray[nBlock];
+
+    if(block.mnBlockIndex != kSizeTypeError)
+    {
+        int* pLink = &mpHashTable[GetHashBucket(block.mnBlockIndex)];
+
+        while(*pLink != nBlock)
+            pLink = &mpBlockArray[*pLink].mnHashNext;
+        *pLink = block.mnHashNext;
+
+        block.mnBlockIndex = kSizeTypeError;
+        block.mnSize       = 0;
+        block.mnHashNext   = kBlockNone;
+
+        if(nBlock == mnPartialBlock)
+            mnPartialBlock = kBlockNone;
+    }
+
+    if(nBlock != mnLRUTail)
+    {
+        // Unlink. Since the block isn't the tail, it has a next block.
+        mpBlockArray[block.mnLRUNext].mnLRUPrev = block.mnLRUPrev;
+        if(block.mnLRUPrev != kBlockNone)
+            mpBlockArray[block.mnLRUPrev].mnLRUNext = block.mnLRUNext;
+        else
+            mnLRUHead = block.mnLRUNext;
+
+        // Link at the tail.
+        block.mnLRUPrev = mnLRUTail;
+        block.mnLRUNext = kBlockNone;
+        mpBlockArray[mnLRUTail].mnLRUNext = nBlock;
+        mnLRUTail = nBlock;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LoadBlock
+//
+// This is an internal function.
+//
+// Reads the block with the given index from the owned stream into the least
+// recently used block and makes it the most recently used. Returns the block,
+// or kBlockNone upon a read error.
+//
+// A block at or past the end of the stream holds no data and isn't cached; the
+// returned block is then unused and has a size of 0. Caching it would leave 
+// more than one block shorter than mnBlockSize, and InvalidateRange only 
+// discards the one in mnPartialBlock when a write extends the stream.
+//
+int StreamBlockCache::LoadBlock(size_type nBlockIndex)
+{
+    using namespace StreamBlockCacheLocal;
+
+    const int nBlock = mnLRUTail;
+    Block&    block  = mpBlockArray[nBlock];
+
+    if(block.mnBlockIndex != kSizeTypeError)
+    {
+        RemoveBlock(nBlock);
+        mStats.mnEvictCount++;
+    }
+
+    char* const     pData     = mpBlockData + ((size_type)nBlock * mnBlockSize);
+    const size_type nReadSize = SetStreamPosition(nBlockIndex * mnBlockSize) ? mpStream->Read(pData, mnBlockSize) : kSizeTypeError;
+
+    if(nReadSize == kSizeTypeError)
+    {
+        mnPositionInternal = kSizeTypeError;
+        return kBlockNone;
+    }
+
+    mnPositionInternal += nReadSize;
+
+    if(nReadSize == 0) // If the block is at or past the end of the stream...
+        return nBlock;
+
+    int& nBucket = mpHashTable[GetHashBucket(nBlockIndex)];
+
+    block.mnBlockIndex = nBlockIndex;
+    block.mnSize       = nReadSize;
+    block.mnHashNext   = nBucket;
+    nBucket            = nBlock;
+
+    if(nReadSize < mnBlockSize) // If this is the last block of the stream...
+        mnPartialBlock = nBlock;
+
+    TouchBlock(nBlock);
+    return nBlock;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// InvalidateRange
+//
+// This is an internal function.
+//
+// Discards the cached blocks which overlap the given range of the stream, as
+// well as the block at the end of the stream, whose size may have changed.
+//
+void StreamBlockCache::InvalidateRange(size_type nPosition, size_type nSize)
+{
+    using namespace StreamBlockCacheLocal;
+
+    if(mnBlockCount && nSize)
+    {
+        const size_type nBlockIndexFirst = nPosition / mnBlockSize;
+        const size_type nBlockIndexLast  = (nPosition + nSize - 1) / mnBlockSize;
+
+        if((nBlockIndexLast - nBlockIndexFirst) < mnBlockCount) // If there are fewer indexes to look up than there are blocks...
+        {
+            for(size_type i = nBlockIndexFirst; i <= nBlockIndexLast; i++)
+            {
+                const int nBlock = FindBlock(i);
+
+                if(nBlock != kBlockNone)
+                    RemoveBlock(nBlock);
+            }
+        }
+        else
+        {
+            for(int i = 0, iEnd = (int)mnBlockCount; i < iEnd; i++)
+            {
+                const size_type nBlockIndex = mpBlockArray[i].mnBlockIndex;
+
+                if((nBlockIndex != kSizeTypeError) && (nBlockIndex >= nBlockIndexFirst) && (nBlockIndex <= nBlockIndexLast))
+                    RemoveBlock(i);
+            }
+        }
+
+        if(mnPartialBlock != kBlockNone)
+            RemoveBlock(mnPartialBlock);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SetStreamPosition
+//
+// This is an internal function.
+//
+// Moves the owned stream to the given position, if it isn't already there.
+//
+bool StreamBlockCache::SetStreamPosition(size_type nPosition)
+{
+    if(mnPositionInternal != nPosition)
+    {
+        if(!mpStream->SetPosition((off_type)nPosition, kPositionTypeBegin))
+        {
+            mnPositionInternal = kSizeTypeError;
+            return false;
+        }
+
+        mnPositionInternal = nPosition;
+    }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AddRef
+//
+int StreamBlockCache::AddRef()
+{
+    return ++mnRefCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Release
+//
+int StreamBlockCache::Release()
+{
+    if(mnRefCount > 1)
+        return --mnRefCount;
+    delete this;
+    return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetAccessFlags
+//
+int StreamBlockCache::GetAccessFlags() const
+{
+    if(mpStream)
+        return mpStream->GetAccessFlags();
+    return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetState
+//
+int StreamBlockCache::GetState() const
+{
+    if(mpStream)
+        return mpStream->GetState();
+    return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// close
+//
+bool StreamBlockCache::close()
+{
+    if(mpStream)
+    {
+        Invalidate();
+        mnPositionInternal = kSizeTypeError;
+        return mpStream->close();
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// getSize
+//
+size_type StreamBlockCache::getSize() const
+{
+    if(mpStream)
+        return mpStream->getSize();
+    return kSizeTypeError;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SetSize
+//
+bool StreamBlockCache::SetSize(size_type nSize)
+{
+    if(mpStream)
+    {
+        Invalidate();
+        if(mpSharedCache)
+            mpSharedCache->InvalidateStream(mSharedStreamId);
+        mnPositionInternal = kSizeTypeError; // Some streams move their position upon a size change.
+        return mpStream->SetSize(nSize);
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetPosition
+//
+off_type StreamBlockCache::GetPosition(PositionType positionType) const
+{
+    if(mpStream)
+    {
+        switch(positionType)
+        {
+            case kPositionTypeBegin:
+                return (off_type)mnPosition;
+            case kPositionTypeEnd:
+                return (off_type)(mnPosition - getSize()); // This will yield a value <= 0.
+            case kPositionTypeCurrent:
+            default:
+                return 0; // kPositionTypeCurrent, which is always 0 for a 'get' operation.
+        }
+    }
+
+    return (off_type)kSizeTypeError;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SetPosition
+//
+// We don't move the owned stream here, as the next read may well be served
+// from the cache.
+//
+bool StreamBlockCache::SetPosition(off_type nPosition, PositionType positionType)
+{
+    if(mpStream)
+    {
+        if(positionType == kPositionTypeCurrent)
+            nPosition = (off_type)(nPosition + mnPosition);
+        else if(positionType == kPositionTypeEnd)
+            nPosition = (off_type)(nPosition + getSize());
+
+        if(nPosition >= 0)
+        {
+            mnPosition = (size_type)nPosition;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetAvailable
+//
+size_type StreamBlockCache::GetAvailable() const
+{
+    const size_type nSize = getSize();
+
+    if(nSize != kSizeTypeError)
+        return (mnPosition < nSize) ? (nSize - mnPosition) : 0;
+    return kSizeTypeError;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Read
+//
+size_type StreamBlockCache::Read(void* pData, size_type nSize)
+{
+    using namespace StreamBlockCacheLocal;
+
+    if(mpStream)
+    {
+        if(mpSharedCache && (nSize < mpSharedCache->GetMemoryBudget()))
+            return ReadShared(pData, nSize);
+
+        if(!mnBlockCount || mpSharedCache || (nSize >= (mnBlockSize * mnBlockCount))) // If the read should bypass the cache...
+        {
+            // The cache is write-through, so the owned stream is always up to date.
+            const size_type nReadSize = SetStreamPosition(mnPosition) ? mpStream->Read(pData, nSize) : kSizeTypeError;
+
+            mStats.mnBypassCount++;
+
+            if(nReadSize != kSizeTypeError)
+            {
+                mnPosition         += nReadSize;
+                mnPositionInternal += nReadSize;
+            }
+            else
+                mnPositionInternal = kSizeTypeError;
+
+            return nReadSize;
+        }
+
+        char*     pData8          = (char*)pData;
+        size_type nBytesRemaining = nSize;
+
+        while(nBytesRemaining)
+        {
+            const size_type nBlockIndex = (mnPosition / mnBlockSize);
+            const size_type nOffset     = (mnPosition & (mnBlockSize - 1));
+            int             nBlock      = FindBlock(nBlockIndex);
+
+            if(nBlock != kBlockNone)
+            {
+                mStats.mnHitCount++;
+                TouchBlock(nBlock);
+            }
+            else
+            {
+                mStats.mnMissCount++;
+                nBlock = LoadBlock(nBlockIndex);
+
+                if(nBlock == kBlockNone) // If there was a read error...
+                {
+                    if(nBytesRemaining == nSize) // If we weren't able to read anything...
+                        return kSizeTypeError;
+                    break;
+                }
+            }
+
+            const Block& block = mpBlockArray[nBlock];
+
+            if(nOffset >= block.mnSize) // If we are at the end of the stream...
+                break;
+
+            const size_type nCopySize = ((block.mnSize - nOffset) < nBytesRemaining) ? (block.mnSize - nOffset) : nBytesRemaining;
+
+            memcpy(pData8, mpBlockData + ((size_type)nBlock * mnBlockSize) + nOffset, (size_t)nCopySize);
+            pData8          += nCopySize;
+            nBytesRemaining -= nCopySize;
+            mnPosition      += nCopySize;
+        }
+
+        return (nSize - nBytesRemaining);
+    }
+
+    return kSizeTypeError;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ReadShared
+//
+// This is an internal function.
+//
+// Implements Read with mpSharedCache.
+//
+size_type StreamBlockCache::ReadShared(void* pData, size_type nSize)
+{
+    const size_type nSharedBlockSize = mpSharedCache->GetBlockSize();
+    char*           pData8           = (char*)pData;
+    size_type       nBytesRemaining  = nSize;
+
+    while(nBytesRemaining)
+    {
+        const size_type nOffset   = (mnPosition & (nSharedBlockSize - 1));
+        const size_type nCopySize = ((nSharedBlockSize - nOffset) < nBytesRemaining) ? (nSharedBlockSize - nOffset) : nBytesRemaining;
+        const size_type nReadSize = mpSharedCache->Read(mSharedStreamId, mnPosition / nSharedBlockSize, nOffset, pData8, nCopySize, mpStream);
+
+        mnPositionInternal = kSizeTypeError; // The shared cache moves the owned stream as it needs to.
+
+        if(nReadSize == kSizeTypeError) // If there was a read error...
+        {
+            if(nBytesRemaining == nSize) // If we weren't able to read anything...
+                return kSizeTypeError;
+            break;
+        }
+
+        pData8          += nReadSize;
+        nBytesRemaining -= nReadSize;
+        mnPosition      += nReadSize;
+
+        if(nReadSize < nCopySize) // If we are at the end of the stream...
+            break;
+    }
+
+    return (nSize - nBytesRemaining);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Flush
+//
+bool StreamBlockCache::Flush()
+{
+    if(mpStream)
+        return mpStream->Flush();
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write
+//
+bool StreamBlockCache::Write(const void* pData, size_type nSize)
+{
+    if(mpStream)
+    {
+        const bool bResult = SetStreamPosition(mnPosition) && mpStream->Write(pData, nSize);
+
+        // We discard rather than update the affected blocks, as writes are expected 
+        // to be rare relative to reads with this class. We do this even upon failure,
+        // as some of the data may have been written.
+        InvalidateRange(mnPosition, nSize);
+        if(mpSharedCache)
+            mpSharedCache->InvalidateStream(mSharedStreamId);
+
+        if(bResult)
+        {
+            mnPosition         += nSize;
+            mnPositionInternal += nSize;
+        }
+        else
+            mnPositionInternal = kSizeTypeError;
+
+        return bResult;
+    }
+
+    return false;
+}
+
+
+} // namespace IO
+
+} // namespace EA
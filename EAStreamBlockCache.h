@@ -0,0 +1,254 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAStreamBlockCache.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a stream which caches multiple fixed-size blocks of a random
+// access stream, for random access patterns which revisit the same data.
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EASTREAMBLOCKCACHE_H
+#define EAIO_EASTREAMBLOCKCACHE_H
+
+
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+#include <eaio/EASharedBlockCache.h>
+
+
+
+namespace EA
+{
+    namespace Allocator
+    {
+        class ICoreAllocator;
+    }
+
+    namespace IO
+    {
+        /// class StreamBlockCache
+        ///
+        /// Implements a read cache of fixed-size, block-aligned blocks of a random
+        /// access stream. The least recently used block is replaced when a block 
+        /// that isn't cached is read. Whereas StreamBuffer buffers a single window
+        /// of the stream, this class keeps many, so that reads which alternate between
+        /// a handful of regions, such as the nodes of an index which are visited by
+        /// every lookup, are served from memory.
+        ///
+        /// Writes go directly to the owned stream and replace any cached copies of 
+        /// the written data. Changes made to the owned stream other than through this
+        /// class aren't seen until Invalidate is called.
+        ///
+        /// Reads which are as large as the entire cache bypass it, so that a single 
+        /// large read doesn't evict all cached blocks.
+        ///
+        /// With SetSharedCache, blocks are instead kept in a SharedBlockCache, so that
+        /// multiple StreamBlockCache instances over the same file, such as one per 
+        /// thread, share cached blocks and a single memory budget.
+        ///
+        /// This class is not inherently thread-safe. As a result, thread-safe usage 
+        /// between multiple threads requires higher level coordination, such as a mutex.
+        /// A SharedBlockCache, however, may be used by instances in different threads.
+        ///
+        /// Example usage:
+        ///     StreamBlockCache cache(pFileStream, 4096, 64);
+        ///
+        ///     cache.SetPosition(nNodePosition);
+        ///     cache.Read(&node, sizeof(node));
+        ///
+        class EAIO_API StreamBlockCache : public IStream
+        {
+        public:
+            enum { kTypeStreamBlockCache = 0x34722330 };
+
+            static const size_type kBlockSizeDefault  = 4096;   /// The default size of each block. It is a typical memory page and disk block size.
+            static const size_type kBlockCountDefault = 16;     /// The default number of blocks.
+
+            struct Stats
+            {
+                uint64_t mnHitCount;        /// Number of block lookups which found the block cached.
+                uint64_t mnMissCount;       /// Number of block lookups which had to read the block from the owned stream.
+                uint64_t mnBypassCount;     /// Number of reads which were too large to cache and went directly to the owned stream.
+                uint64_t mnEvictCount;      /// Number of cached blocks which were replaced by other blocks.
+            };
+
+            typedef Allocator::ICoreAllocator Allocator;
+
+        public:
+            StreamBlockCache(IStream* pStream = NULL, size_type nBlockSize = kBlockSizeDefault, 
+                             size_type nBlockCount = kBlockCountDefault, Allocator* pAllocator = NULL);
+           ~StreamBlockCache();
+
+            IStream*  getStream() const;
+            bool      setStream(IStream* pStream);
+
+            /// SetCacheSize
+            /// Sets the size and number of blocks, discarding all cached blocks. nBlockSize 
+            /// must be a power of two. Returns false if the memory couldn't be allocated, 
+            /// in which case reads are uncached.
+            bool      SetCacheSize(size_type nBlockSize, size_type nBlockCount);
+            void      GetCacheSize(size_type& nBlockSize, size_type& nBlockCount) const;
+
+            /// Invalidate
+            /// Discards all cached blocks. This is needed if the owned stream was changed
+            /// other than through this class.
+            void      Invalidate();
+
+            /// SetSharedCache
+            /// Makes reads use the given shared cache instead of this instance's blocks,
+            /// whose memory may then be freed with SetCacheSize(0, 0). streamId identifies
+            /// the file to the shared cache; see SharedBlockCache::MakeStreamId. Writes and
+            /// SetSize invalidate all of the stream's shared blocks. A pCache of NULL 
+            /// reverts to this instance's blocks. The shared cache must outlive its use here.
+            /// While a shared cache is in use, only mnBypassCount of this instance's Stats
+            /// is updated; see SharedBlockCache::GetStats for the rest.
+            void      SetSharedCache(SharedBlockCache* pCache, const SharedStreamId& streamId);
+            SharedBlockCache* GetSharedCache() const;
+
+            void      GetStats(Stats& stats) const;
+            void      ResetStats();
+
+            virtual int       AddRef();
+            virtual int       Release();
+            virtual uint32_t  GetType() const { return kTypeStreamBlockCache; }
+            virtual int       GetAccessFlags() const;
+            virtual int       GetState() const;
+            virtual bool      close();
+            virtual size_type getSize() const;
+            virtual bool      SetSize(size_type size);
+            virtual off_type  GetPosition(PositionType positionType = kPositionTypeBegin) const;
+            virtual bool      SetPosition(off_type position, PositionType positionType = kPositionTypeBegin);
+
+            virtual size_type GetAvailable() const;
+            virtual size_type Read(void* pData, size_type nSize);
+
+            virtual bool      Flush();
+            virtual bool      Write(const void* pData, size_type nSize);
+
+        protected:
+            struct Block
+            {
+                size_type mnBlockIndex;     /// The position of the block in the stream divided by the block size, or kSizeTypeError if the block is unused.
+                size_type mnSize;           /// Number of valid bytes in the block. This is less than the block size only for the last block of the stream.
+                int       mnLRUPrev;        /// The next more recently used block, or -1.
+                int       mnLRUNext;        /// The next less recently used block, or -1.
+                int       mnHashNext;       /// The next block in the same hash bucket, or -1.
+            };
+
+            void      FreeCache();
+            int       FindBlock(size_type nBlockIndex) const;
+            int       LoadBlock(size_type nBlockIndex);
+            void      RemoveBlock(int nBlock);
+            void      TouchBlock(int nBlock);
+            void      InvalidateRange(size_type nPosition, size_type nSize);
+            bool      SetStreamPosition(size_type nPosition);
+            size_type ReadShared(void* pData, size_type nSize);
+            uint32_t  GetHashBucket(size_type nBlockIndex) const;
+
+        protected:
+            IStream*    mpStream;               /// The stream that we are caching.
+            int         mnRefCount;             /// The reference count, which may or may not be used.
+            size_type   mnPosition;             /// The position as the user sees it.
+            size_type   mnPositionInternal;     /// The position as the owned stream sees it, or kSizeTypeError if unknown.
+            Allocator*  mpAllocator;            /// The allocator for mpBlockArray, mpHashTable and mpBlockData.
+            size_type   mnBlockSize;            /// Size of each block. A power of two.
+            size_type   mnBlockCount;           /// Number of blocks.
+            Block*      mpBlockArray;           /// Array of mnBlockCount blocks.
+            int*        mpHashTable;            /// Array of mnHashTableSize bucket heads, each of which is a block index or -1.
+            uint32_t    mnHashTableSize;        /// A power of two.
+            char*       mpBlockData;            /// mnBlockCount * mnBlockSize bytes of block data.
+            int         mnLRUHead;              /// The most recently used block.
+            int         mnLRUTail;              /// The least recently used block. This is what gets replaced next.
+            int         mnPartialBlock;         /// The cached block which holds fewer than mnBlockSize bytes because it's at the end of the stream, or -1.
+            Stats       mStats;                 /// See GetStats.
+            SharedBlockCache* mpSharedCache;    /// If non-NULL, the cache used instead of mpBlockArray. See SetSharedCache.
+            SharedStreamId mSharedStreamId;     /// The id of the owned stream in mpSharedCache.
+        };
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+    namespace IO
+    {
+        inline
+        IStream* StreamBlockCache::getStream() const
+        {
+            // We do not AddRef the returned stream.
+            return mpStream;
+        }
+
+        inline
+        SharedBlockCache* StreamBlockCache::GetSharedCache() const
+        {
+            return mpSharedCache;
+        }
+
+        inline
+        void StreamBlockCache::GetCacheSize(size_type& nBlockSize, size_type& nBlockCount) const
+        {
+            nBlockSize  = mnBlockSize;
+            nBlockCount = mnBlockCount;
+        }
+
+        inline
+        void StreamBlockCache::GetStats(Stats& stats) const
+        {
+            stats = mStats;
+        }
+
+        inline
+        void StreamBlockCache::ResetStats()
+        {
+            mStats.mnHitCount    = 0;
+            mStats.mnMissCount   = 0;
+            mStats.mnBypassCount = 0;
+            mStats.mnEvictCount  = 0;
+        }
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif // Header include guard
@@ -42,7 +42,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <eastl/coreallocator/icoreallocator_interface.h>
 #include <string.h> // memcpy, etc.
 #include <stdlib.h>
+#include <new>
 #include EA_ASSERT_HEADER
+#if EAIO_THREAD_SAFETY_ENABLED
+    #include <eathread/eathread_thread.h>
+    #include <eathread/eathread_semaphore.h>
+#endif
 
 
 
@@ -86,10 +91,109 @@ namespace StreamBufferLocal
     // kSizeTypeUnset
     //
     const size_type kSizeTypeUnset = (size_type)-1;
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // kReadSequentialCountMin
+    //
+    // With kReadAheadSequential, this is the number of consecutive sequential 
+    // buffer fills after which read-ahead starts.
+    //
+    const int kReadSequentialCountMin = 2;
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // kWriteBehindCountMax
+    //
+    // The maximum number of write buffers with kOptionWriteBehind. This is also
+    // the maximum number of reads and writes which can be queued to the IOWorker.
+    //
+    const int kWriteBehindCountMax = 8;
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // kAdaptiveSizeMin / kAdaptiveGrowCount / kAdaptiveShrinkCount
+    //
+    // With kOptionBufferSizeAdaptive, buffers are kept to multiples of 
+    // kAdaptiveSizeMin, which is a typical memory page and disk block size. 
+    // A buffer is doubled after kAdaptiveGrowCount consecutive sequential 
+    // fills or flushes and halved after kAdaptiveShrinkCount consecutive 
+    // non-sequential ones.
+    //
+    const size_type kAdaptiveSizeMin     = 4096;
+    const int       kAdaptiveGrowCount   = 2;
+    const int       kAdaptiveShrinkCount = 4;
 }
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// IOWorker
+//
+// Owns the background thread which does read-ahead and write-behind. The 
+// thread executes queued reads and writes of the owned stream in the order
+// in which they were submitted, and signals the completion of each. The 
+// StreamBuffer doesn't touch the owned stream while any are incomplete, so
+// the stream needn't be thread-safe.
+//
+#if EAIO_THREAD_SAFETY_ENABLED
+    struct StreamBuffer::IOWorker : public EA::Thread::IRunnable
+    {
+        struct Job
+        {
+            IStream*  mpStream;     /// The stream to read from or write to.
+            char*     mpBuffer;     /// The buffer to read into or write from.
+            size_type mnSize;       /// The number of bytes to read or write.
+            size_type mnResult;     /// The number of bytes read or written, or kSizeTypeError.
+            bool      mbWrite;      /// True for a write, false for a read.
+        };
+
+        EA::Thread::Thread    mThread;
+        EA::Thread::Semaphore mRequestSemaphore;    /// Posted by the StreamBuffer once per submitted job, and to request shutdown.
+        EA::Thread::Semaphore mCompleteSemaphore;   /// Posted by the thread once per completed job.
+        Job                   mJobArray[StreamBufferLocal::kWriteBehindCountMax];
+        int                   mnJobBegin;           /// Index of the oldest job which hasn't been completed. Used only by the StreamBuffer.
+        int                   mnJobCount;           /// Number of jobs which haven't been completed. Used only by the StreamBuffer.
+        int                   mnJobNext;            /// Index of the next job to execute. Used only by the thread.
+        char*                 mpFreeBufferArray[StreamBufferLocal::kWriteBehindCountMax]; /// Write-behind buffers which aren't in use.
+        int                   mnFreeBufferCount;    /// Number of entries in mpFreeBufferArray.
+        int                   mnWriteBufferCount;   /// Total number of write buffers, including the StreamBuffer's mpWriteBuffer.
+        bool                  mbStarted;            /// True if mThread is running.
+        bool                  mbShutdown;           /// Tells the thread to exit upon its next request.
+
+        IOWorker()
+          : mThread(), mRequestSemaphore(), mCompleteSemaphore(), mnJobBegin(0), mnJobCount(0), mnJobNext(0),
+            mnFreeBufferCount(0), mnWriteBufferCount(1), mbStarted(false), mbShutdown(false) { }
+
+        intptr_t Run(void* /*pContext*/)
+        {
+            for(;;)
+            {
+                mRequestSemaphore.Wait();
+
+                if(mbShutdown)
+                    break;
+
+                Job& job = mJobArray[mnJobNext];
+                mnJobNext = (mnJobNext + 1) % StreamBufferLocal::kWriteBehindCountMax;
+
+                if(job.mbWrite)
+                    job.mnResult = job.mpStream->Write(job.mpBuffer, job.mnSize) ? job.mnSize : kSizeTypeError;
+                else
+                    job.mnResult = job.mpStream->Read(job.mpBuffer, job.mnSize);
+
+                mCompleteSemaphore.Post();
+            }
+
+            return 0;
+        }
+    };
+#else
+    struct StreamBuffer::IOWorker { };
+#endif
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // StreamBuffer
 //
@@ -111,7 +215,25 @@ StreamBuffer::StreamBuffer(size_type nReadBufferSize, size_type nWriteBufferSize
     mpWriteBuffer(NULL),
     mnWriteBufferSize(0),
     mnWriteBufferStartPosition(0),
-    mnWriteBufferUsed(0)
+    mnWriteBufferUsed(0),
+
+    mnReadAheadMode(kReadAheadNone),
+    mpIOWorker(NULL),
+    mpReadAheadBuffer(NULL),
+    mnReadAheadStartPosition(0),
+    mnReadAheadUsed(0),
+    mbReadAheadPending(false),
+    mnReadAheadStreamSize(kSizeTypeError),
+    mnReadSequentialPosition(0),
+    mnReadSequentialCount(0),
+    mnWriteBehindCount(0),
+    mnWriteBehindPending(0),
+    mbWriteBehindFailed(false),
+    mnAdaptiveSizeMax(0),
+    mnReadRandomCount(0),
+    mnWriteSequentialCount(0),
+    mnWriteRandomCount(0),
+    mStats()
 {
     SetBufferSizes(nReadBufferSize, nWriteBufferSize);
     setStream(pStream);
@@ -133,6 +255,8 @@ StreamBuffer::~StreamBuffer()
 //
 void StreamBuffer::FreeBuffers()
 {
+    ShutdownIO();
+
     if(mpReadBuffer)
     {
         if(mpAllocator)
@@ -262,6 +386,8 @@ bool StreamBuffer::SetBufferSizes(size_type nReadBufferSize, size_type nWriteBuf
             nReadBufferSize = kBufferSizeMax;
         if(nReadBufferSize < mnReadBufferSize)
             ClearReadBuffer();
+        if(nReadBufferSize != mnReadBufferSize)
+            FreeReadAheadBuffer(); // The read-ahead buffer is the same size as the read buffer. It will be recreated as needed.
         char* const pReadBufferSaved = mpReadBuffer;
         mpReadBuffer = (char*)Realloc(mpReadBuffer, mnReadBufferSize, nReadBufferSize);  // Note that Realloc specifies that passing NULL to realloc acts the same as malloc.
         if(mpReadBuffer)                                                                 // Realloc also specifies that a NULL return value means the reallocation failed and the old pointer is not freed.
@@ -281,6 +407,8 @@ bool StreamBuffer::SetBufferSizes(size_type nReadBufferSize, size_type nWriteBuf
             nWriteBufferSize = kBufferSizeMax;
         if(nWriteBufferSize < mnWriteBufferSize)
             FlushWriteBuffer();
+        if(nWriteBufferSize != mnWriteBufferSize)
+            FreeWriteBehindBuffers(); // The write-behind buffers are the same size as the write buffer. They will be recreated as needed.
         char* const pWriteBufferSaved = mpWriteBuffer;
         mpWriteBuffer = (char*)Realloc(mpWriteBuffer, mnWriteBufferSize, nWriteBufferSize);  // Note that Realloc specifies that passing NULL to realloc acts the same as malloc.
         if(mpWriteBuffer)                                                                    // Realloc also specifies that a NULL return value means the reallocation failed and the old pointer is not freed.
@@ -302,6 +430,7 @@ void StreamBuffer::SetBuffers(void* pReadBuffer, size_type nReadBufferSize, void
     using namespace StreamBufferLocal;
 
     // Setting buffers directly is currently an exclusive alternative to setting buffers via mpAllocator.
+    ShutdownIO();
     setAllocator(NULL);
 
     // We don't have a means of reallocating buffers via this function. So we assert that this isn't being done. 
@@ -337,6 +466,57 @@ void StreamBuffer::setOption(int option, int value)
 {
     if(option == kOptionCacheSize)
         mbEnableSizeCache = (value != 0);
+    else if(option == kOptionReadAhead)
+    {
+        EA_ASSERT((value >= kReadAheadNone) && (value <= kReadAheadAlways));
+        mnReadAheadMode = value;
+
+        if(mnReadAheadMode == kReadAheadNone)
+        {
+            if(mnWriteBehindCount) // If write-behind still uses the IOWorker thread...
+                FreeReadAheadBuffer();
+            else
+                ShutdownIO();
+        }
+    }
+    else if(option == kOptionWriteBehind)
+    {
+        EA_ASSERT((value >= 0) && (value <= StreamBufferLocal::kWriteBehindCountMax));
+        mnWriteBehindCount = (value >= 2) ? value : 0; // A single buffer is the same as no write-behind.
+
+        if(mnWriteBehindCount == 0)
+        {
+            if(mnReadAheadMode != kReadAheadNone) // If read-ahead still uses the IOWorker thread...
+                FreeWriteBehindBuffers();
+            else
+                ShutdownIO();
+        }
+    }
+    else if(option == kOptionBufferSizeAdaptive)
+    {
+        using namespace StreamBufferLocal;
+
+        EA_ASSERT(value >= 0);
+        mnAdaptiveSizeMax = (size_type)value;
+
+        if(mnAdaptiveSizeMax) // If enabling...
+        {
+            // Limit the maximum to a page multiple within our allowed range, and start 
+            // existing buffers from a page multiple. Disabled buffering stays disabled.
+            if(mnAdaptiveSizeMax > kBufferSizeMax)
+                mnAdaptiveSizeMax = kBufferSizeMax;
+            mnAdaptiveSizeMax -= (mnAdaptiveSizeMax % kAdaptiveSizeMin);
+            if(mnAdaptiveSizeMax < kAdaptiveSizeMin)
+                mnAdaptiveSizeMax = kAdaptiveSizeMin;
+
+            SetBufferSizes(mnReadBufferSize  ? LOCAL_MIN(RoundUpToAdaptiveSize(mnReadBufferSize),  mnAdaptiveSizeMax) : kBufferSizeUnspecified,
+                           mnWriteBufferSize ? LOCAL_MIN(RoundUpToAdaptiveSize(mnWriteBufferSize), mnAdaptiveSizeMax) : kBufferSizeUnspecified);
+        }
+
+        mnReadRandomCount      = 0;
+        mnWriteSequentialCount = 0;
+        mnWriteRandomCount     = 0;
+    }
 }
 
 
@@ -425,7 +605,18 @@ size_type StreamBuffer::getSize() const
         if(mnStreamSize != kSizeTypeUnset)  // If the cached value is valid...
             return mnStreamSize;
 
-        size_type nSize = mpStream->getSize();
+        size_type nSize;
+
+        if(mbReadAheadPending && !mnWriteBehindPending && (mnReadAheadStreamSize != kSizeTypeError))
+            nSize = mnReadAheadStreamSize; // A background read doesn't change the size, so we needn't wait for it.
+        else
+        {
+            // The owned stream may be in use by a background write. Waiting for it 
+            // doesn't change the stream as the user sees it, so this is still const.
+            const_cast<StreamBuffer*>(this)->WaitIO();
+
+            nSize = mpStream->getSize();
+        }
 
         if(nSize != kSizeTypeError) // If there wasn't an error...
         {
@@ -542,7 +733,14 @@ bool StreamBuffer::SetPosition(off_type nPosition, PositionType positionType)
         {
             // At this point, we do a true seek on the owned stream.
             // Possibly flush the write buffer. There's no reason to clear the read buffer.
-            FlushWriteBuffer();
+            WaitIO();
+            mnReadAheadUsed = 0;
+
+            if(mnWriteBufferUsed || mnWriteBehindPending) // If this seek interrupts a sequence of writes...
+            {
+                FlushWriteBuffer();
+                AdaptWriteBufferSize(false);
+            }
 
             // Do the seek with the owned stream.
             if(mpStream->SetPosition(nPosition, positionType))
@@ -587,8 +785,8 @@ size_type StreamBuffer::Read(void* pData, size_type nSize)
 
         if(nSize)
         {
-            // Possibly flush the write buffer.
-            if(mnWriteBufferUsed)
+            // Possibly flush the write buffer, including any write-behind writes.
+            if(mnWriteBufferUsed || mnWriteBehindPending)
                 FlushWriteBuffer();
 
             // Possibly get data from the read buffer.
@@ -620,45 +818,54 @@ size_type StreamBuffer::Read(void* pData, size_type nSize)
 
                 while(nBytesRemaining) // If there is anything else to read...
                 {
-                    // We need to clear the read buffer, move the current internal file pointer to 
-                    // be where we left off above, and start filling the cache from that position on.
-                    ClearReadBuffer();
-                    if(mnPositionInternal != mnPositionExternal)
-                        bResult = mpStream->SetPosition((off_type)mnPositionExternal, kPositionTypeBegin);
-                    if(bResult)
+                    // If the data we need was read ahead in the background, we simply switch to that buffer.
+                    if(!TakeReadAhead())
                     {
-                        mnPositionInternal = mnPositionExternal;
-
-                        // Check if the read is a large read -- say, twice the size of the
-                        // read buffer. If the read is very large, bypass the read buffer and
-                        // issue a read directly to the client's buffer.
-                        if(nBytesRemaining > (2 * mnReadBufferSize))
+                        // We need to clear the read buffer, move the current internal file pointer to 
+                        // be where we left off above, and start filling the cache from that position on.
+                        ClearReadBuffer();
+                        AdaptReadBufferSize();
+                        if(mnPositionInternal != mnPositionExternal)
+                            bResult = mpStream->SetPosition((off_type)mnPositionExternal, kPositionTypeBegin);
+                        if(bResult)
                         {
-                            EA_STREAM_BUFFER_DEV_ASSERT(mnPositionInternal == (size_type)mpStream->GetPosition());
-                            const size_type nReadSize = mpStream->Read(pData8, nBytesRemaining);
+                            mnPositionInternal = mnPositionExternal;
 
-                            if(nReadSize != kSizeTypeError)
+                            // Check if the read is a large read -- say, twice the size of the
+                            // read buffer. If the read is very large, bypass the read buffer and
+                            // issue a read directly to the client's buffer.
+                            if(nBytesRemaining > (2 * mnReadBufferSize))
                             {
-                                mnPositionInternal += nReadSize;
-                                mnPositionExternal += nReadSize;
-                                nBytesRemaining    -= nReadSize;
-                                pData8             += nReadSize;
+                                EA_STREAM_BUFFER_DEV_ASSERT(mnPositionInternal == (size_type)mpStream->GetPosition());
+                                const size_type nReadSize = mpStream->Read(pData8, nBytesRemaining);
+
+                                if(nReadSize != kSizeTypeError)
+                                {
+                                    mnPositionInternal += nReadSize;
+                                    mnPositionExternal += nReadSize;
+                                    nBytesRemaining    -= nReadSize;
+                                    pData8             += nReadSize;
+                                }
+                                else // else an error occurred
+                                    bResult = false;
+                                break;
                             }
-                            else // else an error occurred
-                                bResult = false;
-                            break;
+                            else
+                                bResult = FillReadBuffer();
                         }
-                        else
-                            bResult = FillReadBuffer();
                     }
 
                     if(bResult && mnReadBufferUsed)
                     {
-                        const size_type nBytesToGetFromReadBuffer = LOCAL_MIN(mnReadBufferUsed, nBytesRemaining);
+                        UpdateReadPattern();
+
+                        // The read-ahead buffer may begin before mnPositionExternal if the user skipped forward.
+                        const size_type nOffsetWithinReadBuffer   = mnPositionExternal - mnReadBufferStartPosition;
+                        const size_type nBytesToGetFromReadBuffer = LOCAL_MIN((mnReadBufferUsed - nOffsetWithinReadBuffer), nBytesRemaining);
 
                         EA_STREAM_BUFFER_DEV_ASSERT((nBytesToGetFromReadBuffer > 0) && (nBytesToGetFromReadBuffer < ((size_type)0 - mnReadBufferSize)) && (mnReadBufferSize >= nBytesToGetFromReadBuffer));
 
-                        memcpy(pData8, mpReadBuffer, (size_t)nBytesToGetFromReadBuffer);
+                        memcpy(pData8, mpReadBuffer + nOffsetWithinReadBuffer, (size_t)nBytesToGetFromReadBuffer);
                         nBytesRemaining    -= nBytesToGetFromReadBuffer;
                         pData8             += nBytesToGetFromReadBuffer;
                         mnPositionExternal += nBytesToGetFromReadBuffer;
@@ -677,7 +884,7 @@ size_type StreamBuffer::Read(void* pData, size_type nSize)
                 const size_type nReadSize = mpStream->Read(pData, nSize);
 
                 if(nReadSize != kSizeTypeError)
-                    mnPositionInternal += nSize;
+                    mnPositionInternal += nReadSize;
                 else
                     mnPositionInternal = (size_type)mpStream->GetPosition();
                 mnPositionExternal = mnPositionInternal;
@@ -693,6 +900,119 @@ size_type StreamBuffer::Read(void* pData, size_type nSize)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// PeekRefill
+//
+// This is the part of Peek which is executed when the read buffer doesn't
+// already hold nMinSize bytes at the current position.
+//
+const void* StreamBuffer::PeekRefill(size_type nMinSize, size_type& nAvailable)
+{
+    nAvailable = 0;
+
+    if(mpStream && mnReadBufferSize) // Peek requires read buffering.
+    {
+        bool bResult = true;
+
+        if(nMinSize > mnReadBufferSize)
+            nMinSize = mnReadBufferSize;
+
+        // Possibly flush the write buffer, including any write-behind writes.
+        if(mnWriteBufferUsed || mnWriteBehindPending)
+            FlushWriteBuffer();
+
+        if((mnPositionExternal - mnReadBufferStartPosition) >= mnReadBufferUsed) // If the read buffer doesn't hold the current position at all...
+        {
+            // This is the same as what Read does when it reaches the end of the read buffer.
+            if(!TakeReadAhead())
+            {
+                ClearReadBuffer();
+                AdaptReadBufferSize();
+                if(mnPositionInternal != mnPositionExternal)
+                    bResult = mpStream->SetPosition((off_type)mnPositionExternal, kPositionTypeBegin);
+                if(bResult)
+                {
+                    mnPositionInternal = mnPositionExternal;
+                    bResult = FillReadBuffer();
+                }
+            }
+
+            if(bResult && mnReadBufferUsed)
+                UpdateReadPattern();
+        }
+
+        if(bResult && ((mnPositionExternal - mnReadBufferStartPosition) < mnReadBufferUsed))
+        {
+            if((mnReadBufferUsed - (mnPositionExternal - mnReadBufferStartPosition)) < nMinSize) // If the requested bytes straddle the end of the read buffer...
+                CompactReadBuffer(nMinSize);
+
+            const size_type nOffsetWithinReadBuffer = mnPositionExternal - mnReadBufferStartPosition;
+
+            if(nOffsetWithinReadBuffer < mnReadBufferUsed) // This will be false only upon an error or the end of the stream.
+            {
+                nAvailable = (mnReadBufferUsed - nOffsetWithinReadBuffer);
+                return mpReadBuffer + nOffsetWithinReadBuffer;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GetWriteSpanFlush
+//
+// This is the part of GetWriteSpan which is executed when the write buffer
+// doesn't already have nMinSize bytes of free space after the current position.
+//
+void* StreamBuffer::GetWriteSpanFlush(size_type nMinSize, size_type& nAvailable)
+{
+    nAvailable = 0;
+
+    if(mpStream && mnWriteBufferSize) // GetWriteSpan requires write buffering.
+    {
+        bool bResult = true;
+
+        // Possibly clear the read buffer. This is the same as what Write does.
+        if(mnReadBufferUsed)
+        {
+            ClearReadBuffer();
+
+            if(mnPositionExternal != mnPositionInternal)
+            {
+                bResult = mpStream->SetPosition((off_type)mnPositionExternal);
+                mnPositionInternal = (size_type)mpStream->GetPosition();
+                mnPositionExternal = mnPositionInternal;
+            }
+        }
+
+        if(nMinSize > mnWriteBufferSize)
+            nMinSize = mnWriteBufferSize;
+
+        if(mnWriteBufferUsed && ((mnWriteBufferSize - mnWriteBufferUsed) < nMinSize))
+        {
+            bResult = (mnWriteBehindCount ? QueueWriteBuffer() : FlushWriteBuffer()) && bResult;
+            AdaptWriteBufferSize(true);
+        }
+
+        if(bResult)
+        {
+            if(mnWriteBufferUsed == 0) // If this is our first write to the buffer since it was last purged...
+            {
+                EA_STREAM_BUFFER_DEV_ASSERT(mnPositionInternal == mnPositionExternal);
+                mnWriteBufferStartPosition = mnPositionInternal;
+            }
+
+            nAvailable = (mnWriteBufferSize - mnWriteBufferUsed);
+            return mpWriteBuffer + mnWriteBufferUsed;
+        }
+    }
+
+    return NULL;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // FlushAndClearBuffers
 //
@@ -718,8 +1038,11 @@ void StreamBuffer::FlushAndClearBuffers()
 //
 void StreamBuffer::ClearReadBuffer()
 {
+    WaitIO(); // Upon return, the owned stream isn't in use by the IOWorker thread.
+
     mnReadBufferStartPosition = 0;
     mnReadBufferUsed          = 0;
+    mnReadAheadUsed           = 0;
 }
 
 
@@ -739,6 +1062,9 @@ bool StreamBuffer::FillReadBuffer()
 
     if(nReadSize != kSizeTypeError) // If there was no error...
     {
+        mStats.mnReadFillCount++;
+        mStats.mnReadFillSize += nReadSize;
+
         mnReadBufferStartPosition = mnPositionInternal; // We leave 'mnPositionExternal' alone.
         mnReadBufferUsed          = nReadSize;
         mnPositionInternal       += nReadSize;
@@ -753,6 +1079,546 @@ bool StreamBuffer::FillReadBuffer()
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// CompactReadBuffer
+//
+// This is an internal function.
+//
+// Moves the unread part of the read buffer, which begins at mnPositionExternal,
+// to the beginning of the buffer and appends the data which follows it, so that
+// Peek can return nMinSize contiguous bytes. The appended data is copied from 
+// the read-ahead buffer if it's there, else read from the owned stream.
+//
+bool StreamBuffer::CompactReadBuffer(size_type nMinSize)
+{
+    WaitIO();
+
+    const size_type nOffsetWithinReadBuffer = mnPositionExternal - mnReadBufferStartPosition;
+    size_type       nEndPosition            = mnReadBufferStartPosition + mnReadBufferUsed; // The position of the data which follows the read buffer.
+
+    EA_STREAM_BUFFER_DEV_ASSERT((nOffsetWithinReadBuffer < mnReadBufferUsed) && (nMinSize <= mnReadBufferSize));
+
+    memmove(mpReadBuffer, mpReadBuffer + nOffsetWithinReadBuffer, (size_t)(mnReadBufferUsed - nOffsetWithinReadBuffer));
+    mnReadBufferStartPosition = mnPositionExternal;
+    mnReadBufferUsed         -= nOffsetWithinReadBuffer;
+
+    if((nEndPosition - mnReadAheadStartPosition) < mnReadAheadUsed) // If the data which follows was read ahead...
+    {
+        // We copy only what was asked for and leave the read-ahead buffer as-is. It now overlaps 
+        // the end of the read buffer, which TakeReadAhead and Read already allow for.
+        const size_type nOffsetWithinReadAheadBuffer = nEndPosition - mnReadAheadStartPosition;
+        const size_type nCopySize = LOCAL_MIN(nMinSize - mnReadBufferUsed, mnReadAheadUsed - nOffsetWithinReadAheadBuffer);
+
+        memcpy(mpReadBuffer + mnReadBufferUsed, mpReadAheadBuffer + nOffsetWithinReadAheadBuffer, (size_t)nCopySize);
+        mnReadBufferUsed += nCopySize;
+        nEndPosition     += nCopySize;
+
+        if(mnReadBufferUsed >= nMinSize)
+            return true;
+        // Else we used the rest of the read-ahead buffer and read the remainder below.
+    }
+
+    mnReadAheadUsed = 0;
+
+    if(mnPositionInternal != nEndPosition)
+    {
+        if(!mpStream->SetPosition((off_type)nEndPosition, kPositionTypeBegin))
+        {
+            mnPositionInternal = (size_type)mpStream->GetPosition();
+            return false;
+        }
+
+        mnPositionInternal = nEndPosition;
+    }
+
+    const size_type nReadSize = mpStream->Read(mpReadBuffer + mnReadBufferUsed, mnReadBufferSize - mnReadBufferUsed);
+
+    if(nReadSize == kSizeTypeError)
+    {
+        mnPositionInternal = (size_type)mpStream->GetPosition();
+        return false;
+    }
+
+    mStats.mnReadFillCount++;
+    mStats.mnReadFillSize   += nReadSize;
+    mnReadBufferUsed        += nReadSize;
+    mnPositionInternal      += nReadSize;
+    mnReadSequentialPosition = (mnReadBufferStartPosition + mnReadBufferUsed); // A fill from here on continues the sequential read.
+    StartReadAhead();
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// UpdateReadPattern
+//
+// This is an internal function.
+//
+// Called after the read buffer is refilled. Tracks whether the stream is being
+// read sequentially, and if so possibly grows the read buffer and starts reading
+// the next buffer while the user consumes this one.
+//
+void StreamBuffer::UpdateReadPattern()
+{
+    if(mnReadBufferStartPosition == mnReadSequentialPosition)
+    {
+        mnReadSequentialCount++;
+        mnReadRandomCount = 0;
+    }
+    else
+    {
+        mnReadSequentialCount = 0;
+        mnReadRandomCount++;
+    }
+    mnReadSequentialPosition = (mnReadBufferStartPosition + mnReadBufferUsed);
+
+    AdaptReadBufferSize();
+    StartReadAhead();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// RoundUpToAdaptiveSize
+//
+// This is an internal function.
+//
+size_type StreamBuffer::RoundUpToAdaptiveSize(size_type nSize)
+{
+    using namespace StreamBufferLocal;
+
+    return (nSize + (kAdaptiveSizeMin - 1)) - ((nSize + (kAdaptiveSizeMin - 1)) % kAdaptiveSizeMin);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AdaptReadBufferSize
+//
+// This is an internal function.
+//
+// With kOptionBufferSizeAdaptive, doubles the read buffer while the stream is 
+// read sequentially and halves it while the stream is read randomly. Growing
+// keeps the buffered data, so it can be done at any time. Shrinking is done 
+// only when the read buffer is empty, which it is just before a fill that 
+// follows a seek.
+//
+void StreamBuffer::AdaptReadBufferSize()
+{
+    using namespace StreamBufferLocal;
+
+    if(mnAdaptiveSizeMax && mnReadBufferSize && mpAllocator) // Buffers supplied via SetBuffers can't be resized.
+    {
+        const size_type nSizeSaved = mnReadBufferSize;
+
+        if((mnReadSequentialCount >= kAdaptiveGrowCount) && (mnReadBufferSize < mnAdaptiveSizeMax))
+        {
+            SetBufferSizes(LOCAL_MIN(mnReadBufferSize * 2, mnAdaptiveSizeMax), kBufferSizeUnspecified);
+            if(mnReadBufferSize != nSizeSaved) // If the allocation succeeded...
+                mStats.mnReadGrowCount++;
+        }
+        else if((mnReadRandomCount >= kAdaptiveShrinkCount) && !mnReadBufferUsed && (mnReadBufferSize > kAdaptiveSizeMin))
+        {
+            SetBufferSizes(LOCAL_MAX(mnReadBufferSize / 2, kAdaptiveSizeMin), kBufferSizeUnspecified);
+            if(mnReadBufferSize != nSizeSaved)
+                mStats.mnReadShrinkCount++;
+            mnReadRandomCount = 0;
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AdaptWriteBufferSize
+//
+// This is an internal function.
+//
+// With kOptionBufferSizeAdaptive, called after the write buffer is flushed. 
+// bSequential is true if the flush was due to the buffer becoming full and 
+// false if it was due to a seek. Doubles the write buffer after consecutive
+// sequential flushes and halves it after consecutive non-sequential ones.
+//
+void StreamBuffer::AdaptWriteBufferSize(bool bSequential)
+{
+    using namespace StreamBufferLocal;
+
+    if(mnAdaptiveSizeMax && mnWriteBufferSize && !mnWriteBufferUsed && mpAllocator)
+    {
+        const size_type nSizeSaved = mnWriteBufferSize;
+
+        if(bSequential)
+        {
+            mnWriteSequentialCount++;
+            mnWriteRandomCount = 0;
+        }
+        else
+        {
+            mnWriteSequentialCount = 0;
+            mnWriteRandomCount++;
+        }
+
+        if((mnWriteSequentialCount >= kAdaptiveGrowCount) && (mnWriteBufferSize < mnAdaptiveSizeMax))
+        {
+            SetBufferSizes(kBufferSizeUnspecified, LOCAL_MIN(mnWriteBufferSize * 2, mnAdaptiveSizeMax));
+            if(mnWriteBufferSize != nSizeSaved) // If the allocation succeeded...
+                mStats.mnWriteGrowCount++;
+        }
+        else if((mnWriteRandomCount >= kAdaptiveShrinkCount) && (mnWriteBufferSize > kAdaptiveSizeMin))
+        {
+            SetBufferSizes(kBufferSizeUnspecified, LOCAL_MAX(mnWriteBufferSize / 2, kAdaptiveSizeMin));
+            if(mnWriteBufferSize != nSizeSaved)
+                mStats.mnWriteShrinkCount++;
+            mnWriteRandomCount = 0;
+        }
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CreateIOWorker
+//
+// This is an internal function.
+//
+// Creates the IOWorker and starts its thread, if not done already. Returns
+// false if background I/O is unavailable, in which case all I/O is done 
+// synchronously.
+//
+bool StreamBuffer::CreateIOWorker()
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(!mpIOWorker && mpAllocator) // If this is the first background I/O...
+        {
+            void* const pWorker = mpAllocator->alloc(sizeof(IOWorker), EAIO_ALLOC_PREFIX "StreamBuffer", 0);
+
+            if(pWorker)
+            {
+                mpIOWorker = new(pWorker) IOWorker;
+                mpIOWorker->mbStarted = (mpIOWorker->mThread.Begin(mpIOWorker) != EA::Thread::kThreadIdInvalid);
+            }
+
+            if(!mpIOWorker || !mpIOWorker->mbStarted)
+            {
+                ShutdownIO();
+                mnReadAheadMode    = kReadAheadNone; // Don't try again; we simply do I/O synchronously.
+                mnWriteBehindCount = 0;
+            }
+        }
+
+        return (mpIOWorker != NULL);
+    #else
+        return false;
+    #endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SubmitIO
+//
+// This is an internal function.
+//
+// Queues a read or write of the owned stream to the IOWorker. The caller 
+// must have made sure that the IOWorker exists and that the queue isn't full.
+//
+void StreamBuffer::SubmitIO(bool bWrite, char* pBuffer, size_type nSize)
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        using namespace StreamBufferLocal;
+
+        EA_ASSERT(mpIOWorker && (mpIOWorker->mnJobCount < kWriteBehindCountMax));
+
+        IOWorker::Job& job = mpIOWorker->mJobArray[(mpIOWorker->mnJobBegin + mpIOWorker->mnJobCount) % kWriteBehindCountMax];
+
+        job.mpStream = mpStream;
+        job.mpBuffer = pBuffer;
+        job.mnSize   = nSize;
+        job.mnResult = 0;
+        job.mbWrite  = bWrite;
+
+        mpIOWorker->mnJobCount++;
+        mpIOWorker->mRequestSemaphore.Post();
+    #else
+        (void)bWrite; (void)pBuffer; (void)nSize;
+    #endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompleteIO
+//
+// This is an internal function.
+//
+// Waits for the oldest queued read or write to complete and accounts for it.
+// Returns false if nothing was queued.
+//
+bool StreamBuffer::CompleteIO()
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        using namespace StreamBufferLocal;
+
+        if(mpIOWorker && mpIOWorker->mnJobCount)
+        {
+            mpIOWorker->mCompleteSemaphore.Wait();
+
+            const IOWorker::Job& job = mpIOWorker->mJobArray[mpIOWorker->mnJobBegin];
+
+            mpIOWorker->mnJobBegin = (mpIOWorker->mnJobBegin + 1) % kWriteBehindCountMax;
+            mpIOWorker->mnJobCount--;
+
+            if(job.mbWrite)
+            {
+                // mnPositionInternal was already advanced when the write was submitted.
+                mpIOWorker->mpFreeBufferArray[mpIOWorker->mnFreeBufferCount++] = job.mpBuffer;
+                mnWriteBehindPending -= job.mnSize;
+
+                if(job.mnResult == kSizeTypeError)
+                    mbWriteBehindFailed = true; // This is reported by the next FlushWriteBuffer.
+            }
+            else
+            {
+                mbReadAheadPending = false;
+
+                if(job.mnResult != kSizeTypeError) // If there was no error...
+                {
+                    mStats.mnReadFillCount++;
+                    mStats.mnReadFillSize += job.mnResult;
+                    mnReadAheadUsed     = job.mnResult;
+                    mnPositionInternal += mnReadAheadUsed;
+                }
+                else
+                {
+                    mnReadAheadUsed    = 0;
+                    mnPositionInternal = (size_type)mpStream->GetPosition();
+                }
+            }
+
+            return true;
+        }
+    #endif
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// WaitIO
+//
+// This is an internal function.
+//
+// Waits for all background reads and writes to complete. Upon return, the 
+// owned stream may be used and mnPositionInternal reflects them.
+//
+void StreamBuffer::WaitIO()
+{
+    while(CompleteIO())
+        { }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// StartReadAhead
+//
+// This is an internal function.
+//
+// Starts reading the buffer which follows the read buffer in the background,
+// if read-ahead is enabled and warranted. Returns true if the read was started.
+//
+bool StreamBuffer::StartReadAhead()
+{
+    using namespace StreamBufferLocal;
+
+    if((mnReadAheadMode != kReadAheadNone) && !mbReadAheadPending && 
+       (mnReadBufferUsed == mnReadBufferSize) && // A partial fill means we reached the end of the stream.
+       (mnPositionInternal == (mnReadBufferStartPosition + mnReadBufferUsed)) &&
+       ((mnReadAheadMode == kReadAheadAlways) || (mnReadSequentialCount >= kReadSequentialCountMin)) &&
+       CreateIOWorker())
+    {
+        if(!mpReadAheadBuffer) // If this is the first read-ahead...
+        {
+            mpReadAheadBuffer = (char*)mpAllocator->alloc((size_t)mnReadBufferSize, EAIO_ALLOC_PREFIX "StreamBuffer", 0);
+
+            if(!mpReadAheadBuffer)
+                return false;
+        }
+
+        // We get the size while the owned stream is still ours, so that getSize 
+        // can be answered during the read-ahead without waiting for it.
+        mnReadAheadStreamSize    = mnWriteBehindPending ? kSizeTypeError : mpStream->getSize();
+        mnReadAheadStartPosition = mnPositionInternal;
+        mnReadAheadUsed          = 0;
+        mbReadAheadPending       = true;
+        SubmitIO(false, mpReadAheadBuffer, mnReadBufferSize);
+
+        return true;
+    }
+
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TakeReadAhead
+//
+// This is an internal function.
+//
+// If the read-ahead buffer holds the data at mnPositionExternal, makes it the
+// read buffer and returns true. Otherwise discards it and returns false.
+//
+bool StreamBuffer::TakeReadAhead()
+{
+    WaitIO();
+
+    if(mnReadAheadUsed && 
+       (mnPositionExternal >= mnReadAheadStartPosition) && 
+       (mnPositionExternal < (mnReadAheadStartPosition + mnReadAheadUsed)))
+    {
+        char* const pReadBuffer = mpReadBuffer;
+
+        mpReadBuffer              = mpReadAheadBuffer;
+        mpReadAheadBuffer         = pReadBuffer;
+        mnReadBufferStartPosition = mnReadAheadStartPosition;
+        mnReadBufferUsed          = mnReadAheadUsed;
+        mnReadAheadUsed           = 0;
+
+        return true;
+    }
+
+    mnReadAheadUsed = 0;
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// QueueWriteBuffer
+//
+// This is an internal function.
+//
+// Hands the full write buffer to the IOWorker and replaces it with a free
+// buffer from the write-behind ring, growing the ring up to mnWriteBehindCount
+// buffers as needed. If the ring is exhausted, waits for the oldest write to 
+// complete. Falls back to FlushWriteBuffer if write-behind is unavailable or
+// if a previous write-behind write failed, so that the failure is reported.
+//
+bool StreamBuffer::QueueWriteBuffer()
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(!mbWriteBehindFailed && CreateIOWorker())
+        {
+            if(!mpIOWorker->mnFreeBufferCount && (mpIOWorker->mnWriteBufferCount < mnWriteBehindCount))
+            {
+                char* const pBuffer = (char*)mpAllocator->alloc((size_t)mnWriteBufferSize, EAIO_ALLOC_PREFIX "StreamBuffer", 0);
+
+                if(pBuffer)
+                {
+                    mpIOWorker->mpFreeBufferArray[mpIOWorker->mnFreeBufferCount++] = pBuffer;
+                    mpIOWorker->mnWriteBufferCount++;
+                }
+            }
+
+            while(!mpIOWorker->mnFreeBufferCount && CompleteIO()) // This is the backpressure case.
+                { }
+
+            if(mpIOWorker->mnFreeBufferCount && !mbWriteBehindFailed)
+            {
+                SubmitIO(true, mpWriteBuffer, mnWriteBufferUsed);
+
+                mStats.mnWriteFlushCount++;
+                mStats.mnWriteFlushSize += mnWriteBufferUsed;
+
+                mnWriteBehindPending      += mnWriteBufferUsed;
+                mnPositionInternal        += mnWriteBufferUsed; // mnPositionInternal is where the owned stream will be once the write completes.
+                mpWriteBuffer              = mpIOWorker->mpFreeBufferArray[--mpIOWorker->mnFreeBufferCount];
+                mnWriteBufferStartPosition = mnPositionInternal;
+                mnWriteBufferUsed          = 0;
+
+                return true;
+            }
+        }
+    #endif
+
+    return FlushWriteBuffer();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShutdownIO
+//
+// This is an internal function.
+//
+// Waits for all background I/O, stops the IOWorker thread and frees the 
+// read-ahead and spare write-behind buffers. They are recreated as needed.
+//
+void StreamBuffer::ShutdownIO()
+{
+    WaitIO();
+
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(mpIOWorker)
+        {
+            if(mpIOWorker->mbStarted)
+            {
+                mpIOWorker->mbShutdown = true;
+                mpIOWorker->mRequestSemaphore.Post();
+                mpIOWorker->mThread.WaitForEnd();
+            }
+
+            FreeWriteBehindBuffers();
+
+            mpIOWorker->~IOWorker();
+            mpAllocator->free(mpIOWorker, sizeof(IOWorker));
+            mpIOWorker = NULL;
+        }
+    #endif
+
+    FreeReadAheadBuffer();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FreeReadAheadBuffer
+//
+// This is an internal function.
+//
+// Waits for all background I/O and frees the read-ahead buffer, which is 
+// recreated as needed. This leaves the IOWorker thread running.
+//
+void StreamBuffer::FreeReadAheadBuffer()
+{
+    WaitIO();
+
+    if(mpReadAheadBuffer)
+    {
+        mpAllocator->free(mpReadAheadBuffer, mnReadBufferSize);
+        mpReadAheadBuffer = NULL;
+    }
+
+    mnReadAheadUsed = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FreeWriteBehindBuffers
+//
+// This is an internal function.
+//
+// Waits for all background I/O and frees the write-behind buffers other than
+// mpWriteBuffer. They are recreated as needed. This leaves the IOWorker 
+// thread running.
+//
+void StreamBuffer::FreeWriteBehindBuffers()
+{
+    WaitIO();
+
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(mpIOWorker)
+        {
+            // Since no writes are queued, all write buffers other than mpWriteBuffer are free.
+            while(mpIOWorker->mnFreeBufferCount)
+                mpAllocator->free(mpIOWorker->mpFreeBufferArray[--mpIOWorker->mnFreeBufferCount], mnWriteBufferSize);
+            mpIOWorker->mnWriteBufferCount = 1;
+        }
+    #endif
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Flush
 //
@@ -911,7 +1777,10 @@ bool StreamBuffer::FillWriteBuffer(const char* pData, size_type nSize)
                 EA_STREAM_BUFFER_DEV_ASSERT(mnWriteBufferUsed <= mnWriteBufferSize);
 
                 if(mnWriteBufferUsed == mnWriteBufferSize)
-                    bReturnValue = FlushWriteBuffer();
+                {
+                    bReturnValue = mnWriteBehindCount ? QueueWriteBuffer() : FlushWriteBuffer();
+                    AdaptWriteBufferSize(true);
+                }
             }
         }
     }
@@ -937,7 +1806,19 @@ bool StreamBuffer::FlushWriteBuffer()
     // until after the FillWriteBuffer function returns. Then things will become
     // aligned properly.
 
-    if(mnWriteBufferUsed) // If there is anything to write...
+    WaitIO(); // Upon return, any write-behind writes have been completed.
+
+    if(mbWriteBehindFailed) // If a write-behind write failed...
+    {
+        // We report the failure here, as the write which failed has long since returned
+        // to the user. As with a synchronous write failure, the buffered data is lost.
+        mnPositionInternal         = (size_type)mpStream->GetPosition();
+        mnWriteBufferStartPosition = mnPositionInternal;
+        mnWriteBufferUsed          = 0;
+        mbWriteBehindFailed        = false;
+        bReturnValue               = false;
+    }
+    else if(mnWriteBufferUsed) // If there is anything to write...
     {
         EA_STREAM_BUFFER_DEV_ASSERT(mpStream && !mnReadBufferUsed);
         EA_STREAM_BUFFER_DEV_ASSERT(mnPositionInternal == (size_type)mpStream->GetPosition());
@@ -946,6 +1827,9 @@ bool StreamBuffer::FlushWriteBuffer()
 
         if(mpStream->Write(mpWriteBuffer, mnWriteBufferUsed))
         {
+            mStats.mnWriteFlushCount++;
+            mStats.mnWriteFlushSize += mnWriteBufferUsed;
+
             mnPositionInternal        += mnWriteBufferUsed;
             mnWriteBufferStartPosition = mnPositionInternal;
             mnWriteBufferUsed          = 0;
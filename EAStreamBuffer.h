@@ -65,12 +65,55 @@ namespace EA
         /// you get with the C or C++ standard libaries, and it gives the 
         /// user some configurability options as well.
         ///
+        /// With kOptionReadAhead, the read buffer is double-buffered: while the user 
+        /// consumes one buffer, a background thread reads the next one from the owned
+        /// stream, so that decoding and disk I/O overlap. While a background read is 
+        /// in progress, the owned stream must not be used other than via this StreamBuffer.
+        ///
+        /// With kOptionWriteBehind, a full write buffer is handed to the same background
+        /// thread and replaced by a free buffer from a small ring, so that Write doesn't 
+        /// wait for the owned stream unless all buffers in the ring are still being written.
+        /// A failure of such a write is reported by the next Flush, SetPosition, SetSize,
+        /// Read or close call that waits for it.
+        ///
+        /// With kOptionBufferSizeAdaptive, the read and write buffers are resized to suit
+        /// the observed access pattern instead of being tuned via SetBufferSizes: a buffer
+        /// doubles while it is filled or flushed sequentially, up to the given maximum, 
+        /// and halves while the stream is accessed randomly. GetStats reports the resulting 
+        /// fill and flush sizes and the resizing decisions.
+        ///
         class EAIO_API StreamBuffer : public IStream
         {
         public:
             enum Option
             {
-                kOptionCacheSize = 1   /// If enabled, then the size of the stream is cached, for higher performance. You must only enable this if you know the stream size is unchanging, as with a read-only file. This option can be set at any time, including after a stream has been used.
+                kOptionCacheSize = 1,  /// If enabled, then the size of the stream is cached, for higher performance. You must only enable this if you know the stream size is unchanging, as with a read-only file. This option can be set at any time, including after a stream has been used.
+                kOptionReadAhead = 2,  /// One of enum ReadAhead. Default is kReadAheadNone. Read-ahead requires EAIO_THREAD_SAFETY_ENABLED and buffers allocated by the StreamBuffer rather than supplied via SetBuffers; otherwise this option has no effect.
+                kOptionWriteBehind = 3, /// The number of write buffers to rotate between, from 2 to 8. Default is 0, which disables write-behind. Has the same requirements as kOptionReadAhead.
+                kOptionBufferSizeAdaptive = 4 /// The maximum size in bytes that adaptive sizing may grow the read and write buffers to, rounded down to a multiple of 4096. Default is 0, which disables adaptive sizing. When enabled, buffers start at a multiple of 4096. Requires buffers allocated by the StreamBuffer rather than supplied via SetBuffers.
+            };
+
+            /// Stats
+            /// Reports how the buffers have been used since construction or ResetStats.
+            /// The average fill or flush size is the observed I/O size per call to the 
+            /// owned stream, which is what adaptive sizing seeks to increase.
+            struct Stats
+            {
+                uint64_t mnReadFillCount;       /// Number of reads of the owned stream into the read buffer, including read-ahead.
+                uint64_t mnReadFillSize;        /// Total number of bytes so read.
+                uint64_t mnWriteFlushCount;     /// Number of writes of the write buffer to the owned stream, including write-behind.
+                uint64_t mnWriteFlushSize;      /// Total number of bytes so written.
+                uint32_t mnReadGrowCount;       /// Number of times adaptive sizing grew the read buffer.
+                uint32_t mnReadShrinkCount;     /// Number of times adaptive sizing shrank the read buffer.
+                uint32_t mnWriteGrowCount;      /// Number of times adaptive sizing grew the write buffer.
+                uint32_t mnWriteShrinkCount;    /// Number of times adaptive sizing shrank the write buffer.
+            };
+
+            enum ReadAhead
+            {
+                kReadAheadNone       = 0,  /// The read buffer is filled only when the user reads past its end.
+                kReadAheadSequential = 1,  /// Read-ahead starts once the stream is being read sequentially, which is when consecutive buffer fills each begin where the previous one ended. It stops upon a seek outside the buffered data and resumes once sequential reading resumes.
+                kReadAheadAlways     = 2   /// Read-ahead starts after every buffer fill.
             };
 
             static const uint32_t  kTypeStreamBuffer = 0x12ea45bc;
@@ -96,6 +139,9 @@ namespace EA
             void SetBuffers(void* pReadBuffer, size_type nReadBufferSize, void* pWriteBuffer, size_type nWriteBufferSize);
 
             void setOption(int option, int value);
+
+            void GetStats(Stats& stats) const;
+            void ResetStats();
             void setAllocator(Allocator* pAllocator);
 
             virtual int       AddRef();
@@ -115,6 +161,43 @@ namespace EA
             virtual bool      Flush();
             virtual bool      Write(const void* pData, size_type nSize);
 
+            /// Peek
+            /// Returns a pointer to the read buffer at the current position, refilling the 
+            /// buffer as needed so that at least nMinSize bytes are available there. nMinSize 
+            /// is limited to the read buffer size. nAvailable is set to the number of bytes
+            /// available at the returned pointer, which is less than nMinSize only at the end 
+            /// of the stream. Returns NULL upon error, at the end of the stream, or if read 
+            /// buffering is disabled. The pointer is valid until the next call to a 
+            /// function of this class other than Consume.
+            ///
+            /// Example usage:
+            ///     size_type   nAvailable;
+            ///     const char* p;
+            ///
+            ///     while((p = (const char*)streamBuffer.Peek(4, nAvailable)) != NULL)
+            ///         streamBuffer.Consume(Tokenize(p, nAvailable));
+            ///
+            const void* Peek(size_type nMinSize, size_type& nAvailable);
+
+            /// Consume
+            /// Advances the current position by nSize bytes, which must be no more than 
+            /// the nAvailable returned by the most recent Peek.
+            void Consume(size_type nSize);
+
+            /// GetWriteSpan
+            /// Returns a pointer to the write buffer at the current position, flushing the
+            /// buffer as needed so that at least nMinSize bytes of space are available there. 
+            /// nMinSize is limited to the write buffer size. nAvailable is set to the amount
+            /// of space at the returned pointer. The user writes into the space and then 
+            /// calls Commit with the number of bytes written. Returns NULL upon error or if
+            /// write buffering is disabled.
+            void* GetWriteSpan(size_type nMinSize, size_type& nAvailable);
+
+            /// Commit
+            /// Advances the current position by nSize bytes written to the space returned
+            /// by the most recent GetWriteSpan. nSize must be no more than its nAvailable.
+            void Commit(size_type nSize);
+
         protected:
             void        FreeBuffers();
             void*       Realloc(void* p, size_type prevSize, size_type newSize);
@@ -124,6 +207,26 @@ namespace EA
             void        ClearWriteBuffer();
             bool        FillWriteBuffer(const char* pData, size_type nSize);
             bool        FlushWriteBuffer();
+            const void* PeekRefill(size_type nMinSize, size_type& nAvailable);
+            void*       GetWriteSpanFlush(size_type nMinSize, size_type& nAvailable);
+            bool        CompactReadBuffer(size_type nMinSize);
+            void        UpdateReadPattern();
+            void        AdaptReadBufferSize();
+            void        AdaptWriteBufferSize(bool bSequential);
+            void        FreeReadAheadBuffer();
+            void        FreeWriteBehindBuffers();
+
+            static size_type RoundUpToAdaptiveSize(size_type nSize);
+            bool        CreateIOWorker();
+            void        SubmitIO(bool bWrite, char* pBuffer, size_type nSize);
+            bool        CompleteIO();
+            void        WaitIO();
+            bool        StartReadAhead();
+            bool        TakeReadAhead();
+            bool        QueueWriteBuffer();
+            void        ShutdownIO();
+
+            struct IOWorker;
 
         protected:
             IStream*            mpStream;                      /// The stream that we are buffering.
@@ -143,6 +246,24 @@ namespace EA
             size_type           mnWriteBufferSize;             /// This is the size of the write buffer available for our usage.
             size_type           mnWriteBufferStartPosition;    /// This is where in the file the beginning the write buffer corresponds to.
             size_type           mnWriteBufferUsed;             /// This is the count of bytes in the write buffer that are valid.
+
+            int                 mnReadAheadMode;               /// See enum ReadAhead.
+            IOWorker*           mpIOWorker;                    /// The background thread which does read-ahead and write-behind. Created upon first use.
+            char*               mpReadAheadBuffer;             /// Buffer of mnReadBufferSize bytes which read-ahead fills. It is swapped with mpReadBuffer when the user reaches its data.
+            size_type           mnReadAheadStartPosition;      /// This is where in the file the beginning of the read-ahead buffer corresponds to.
+            size_type           mnReadAheadUsed;               /// This is the count of bytes in the read-ahead buffer that are valid.
+            bool                mbReadAheadPending;            /// True while the background thread is reading into mpReadAheadBuffer. The owned stream must not be used until WaitIO is called.
+            size_type           mnReadAheadStreamSize;         /// The size of mpStream when the pending read-ahead was started, or kSizeTypeError if unknown. A read doesn't change it, so getSize uses it rather than wait.
+            size_type           mnReadSequentialPosition;      /// The end position of the most recent buffer fill. A fill which begins here continues a sequential read.
+            int                 mnReadSequentialCount;         /// The number of consecutive sequential buffer fills.
+            int                 mnWriteBehindCount;            /// See kOptionWriteBehind. 0 if write-behind is disabled.
+            size_type           mnWriteBehindPending;          /// The count of bytes in write buffers queued to the background thread. They are already counted in mnPositionInternal.
+            bool                mbWriteBehindFailed;           /// True if a queued write failed and the failure hasn't been reported yet.
+            size_type           mnAdaptiveSizeMax;             /// See kOptionBufferSizeAdaptive. 0 if adaptive sizing is disabled.
+            int                 mnReadRandomCount;             /// The number of consecutive non-sequential read buffer fills.
+            int                 mnWriteSequentialCount;        /// The number of consecutive write buffer flushes due to the buffer being full.
+            int                 mnWriteRandomCount;            /// The number of consecutive write buffer flushes due to a seek.
+            Stats               mStats;                        /// See GetStats.
         };
 
 
@@ -183,6 +304,59 @@ namespace EA
             nWriteBufferSize = mnWriteBufferSize;
         }
 
+        inline
+        void StreamBuffer::GetStats(Stats& stats) const
+        {
+            stats = mStats;
+        }
+
+        inline
+        void StreamBuffer::ResetStats()
+        {
+            memset(&mStats, 0, sizeof(mStats));
+        }
+
+        inline
+        const void* StreamBuffer::Peek(size_type nMinSize, size_type& nAvailable)
+        {
+            // If the read buffer holds the current position, this yields an offset < mnReadBufferUsed.
+            const size_type nOffsetWithinReadBuffer = (mnPositionExternal - mnReadBufferStartPosition);
+
+            if((nOffsetWithinReadBuffer < mnReadBufferUsed) && ((mnReadBufferUsed - nOffsetWithinReadBuffer) >= nMinSize))
+            {
+                nAvailable = (mnReadBufferUsed - nOffsetWithinReadBuffer);
+                return mpReadBuffer + nOffsetWithinReadBuffer;
+            }
+
+            return PeekRefill(nMinSize, nAvailable);
+        }
+
+        inline
+        void StreamBuffer::Consume(size_type nSize)
+        {
+            mnPositionExternal += nSize;
+        }
+
+        inline
+        void* StreamBuffer::GetWriteSpan(size_type nMinSize, size_type& nAvailable)
+        {
+            // A non-empty write buffer implies that the read buffer is empty.
+            if(mnWriteBufferUsed && ((mnWriteBufferSize - mnWriteBufferUsed) >= nMinSize))
+            {
+                nAvailable = (mnWriteBufferSize - mnWriteBufferUsed);
+                return mpWriteBuffer + mnWriteBufferUsed;
+            }
+
+            return GetWriteSpanFlush(nMinSize, nAvailable);
+        }
+
+        inline
+        void StreamBuffer::Commit(size_type nSize)
+        {
+            mnWriteBufferUsed  += nSize;
+            mnPositionExternal += nSize;
+        }
+
 
     } // namespace IO
 
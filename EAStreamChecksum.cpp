@@ -0,0 +1,567 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAStreamChecksum.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a stream which computes a checksum of all the data which is 
+// read from or written to another stream.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAStreamChecksum.h>
+#include <string.h>
+#include EA_ASSERT_HEADER
+#if (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && defined(EA_COMPILER_MSVC)
+    #include <intrin.h>
+#elif (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && (defined(EA_COMPILER_GNUC) || defined(EA_COMPILER_CLANG))
+    #include <immintrin.h>
+#endif
+
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+namespace StreamChecksumLocal
+{
+    // The crc32 instruction is part of SSE 4.2. It is detected at runtime, so that
+    // a build for the baseline processor still uses it where present.
+    #if (defined(EA_PROCESSOR_X86) || defined(EA_PROCESSOR_X86_64)) && (defined(EA_COMPILER_MSVC) || defined(EA_COMPILER_GNUC) || defined(EA_COMPILER_CLANG))
+        #define EAIO_CRC32C_SSE42_ENABLED 1
+    #else
+        #define EAIO_CRC32C_SSE42_ENABLED 0
+    #endif
+
+    #if EAIO_CRC32C_SSE42_ENABLED && defined(EA_COMPILER_MSVC)
+        #define EAIO_TARGET_SSE42
+    #elif EAIO_CRC32C_SSE42_ENABLED
+        #define EAIO_TARGET_SSE42 __attribute__((target("sse4.2")))
+    #endif
+
+
+    inline uint32_t LoadUint32Little(const uint8_t* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline uint64_t LoadUint64Little(const uint8_t* p)
+    {
+        return (uint64_t)LoadUint32Little(p) | ((uint64_t)LoadUint32Little(p + 4) << 32);
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // CRC32CTable
+    //
+    // The tables for slicing-by-8. mTable[0] is the usual byte-at-a-time table for 
+    // the reflected Castagnoli polynomial; mTable[k] is the CRC of a byte followed 
+    // by k zero bytes, which allows 8 table lookups to be done independently.
+    //
+    struct CRC32CTable
+    {
+        uint32_t mTable[8][256];
+
+        CRC32CTable()
+        {
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t n = i;
+
+                for(int j = 0; j < 8; j++)
+                    n = (n >> 1) ^ (0x82f63b78 & (0 - (n & 1)));
+
+                mTable[0][i] = n;
+            }
+
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                for(int k = 1; k < 8; k++)
+                    mTable[k][i] = (mTable[k - 1][i] >> 8) ^ mTable[0][mTable[k - 1][i] & 0xff];
+            }
+        }
+    };
+
+    // The table is built upon first use rather than during static initialization,
+    // so that it's valid for checksums computed by other static initializers.
+    const CRC32CTable& GetCRC32CTable()
+    {
+        static const CRC32CTable sCRC32CTable;
+        return sCRC32CTable;
+    }
+
+
+    uint32_t UpdateCRC32CTable(uint32_t n, const uint8_t* p, size_type nSize)
+    {
+        const uint32_t (*const t)[256] = GetCRC32CTable().mTable;
+
+        for(; nSize >= 8; p += 8, nSize -= 8)
+        {
+            const uint32_t nLow  = n ^ LoadUint32Little(p);
+            const uint32_t nHigh = LoadUint32Little(p + 4);
+
+            n = t[7][nLow  & 0xff] ^ t[6][(nLow  >> 8) & 0xff] ^ t[5][(nLow  >> 16) & 0xff] ^ t[4][nLow  >> 24] ^
+                t[3][nHigh & 0xff] ^ t[2][(nHigh >> 8) & 0xff] ^ t[1][(nHigh >> 16) & 0xff] ^ t[0][nHigh >> 24];
+        }
+
+        for(; nSize; nSize--)
+            n = (n >> 8) ^ t[0][(n ^ *p++) & 0xff];
+
+        return n;
+    }
+
+
+    #if EAIO_CRC32C_SSE42_ENABLED
+        EAIO_TARGET_SSE42 uint32_t UpdateCRC32CSSE42(uint32_t n, const uint8_t* p, size_type nSize)
+        {
+            #if defined(EA_PROCESSOR_X86_64)
+                uint64_t n64 = n;
+
+                for(; nSize >= 8; p += 8, nSize -= 8)
+                {
+                    uint64_t nData;
+                    memcpy(&nData, p, sizeof(nData));
+                    n64 = _mm_crc32_u64(n64, nData);
+                }
+
+                n = (uint32_t)n64;
+            #endif
+
+            for(; nSize >= 4; p += 4, nSize -= 4)
+            {
+                uint32_t nData;
+                memcpy(&nData, p, sizeof(nData));
+                n = _mm_crc32_u32(n, nData);
+            }
+
+            for(; nSize; nSize--)
+                n = _mm_crc32_u8(n, *p++);
+
+            return n;
+        }
+
+
+        // Returns true if the processor supports the SSE 4.2 crc32 instruction.
+        bool GetCRC32CSSE42Supported()
+        {
+            #if defined(EA_COMPILER_MSVC)
+                int info[4];
+
+                __cpuid(info, 1);
+                return (info[2] & (1 << 20)) != 0;
+            #else
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("sse4.2") != 0;
+            #endif
+        }
+
+        // This is false for any use during static initialization before it's set,
+        // in which case the table is used instead, which gives the same result.
+        const bool gbCRC32CSSE42Supported = GetCRC32CSSE42Supported();
+    #endif
+
+
+    // xxHash64 constants and rounds. See http://cyan4973.github.io/xxHash/.
+    const uint64_t kXXPrime1 = UINT64_C(0x9e3779b185ebca87);
+    const uint64_t kXXPrime2 = UINT64_C(0xc2b2ae3d27d4eb4f);
+    const uint64_t kXXPrime3 = UINT64_C(0x165667b19e3779f9);
+    const uint64_t kXXPrime4 = UINT64_C(0x85ebca77c2b2ae63);
+    const uint64_t kXXPrime5 = UINT64_C(0x27d4eb2f165667c5);
+
+    inline uint64_t RotateLeft(uint64_t n, int nBitCount)
+    {
+        return (n << nBitCount) | (n >> (64 - nBitCount));
+    }
+
+    inline uint64_t XXRound(uint64_t nAccumulator, uint64_t nInput)
+    {
+        nAccumulator += nInput * kXXPrime2;
+        nAccumulator  = RotateLeft(nAccumulator, 31);
+        return nAccumulator * kXXPrime1;
+    }
+
+    inline uint64_t XXMergeRound(uint64_t nAccumulator, uint64_t nValue)
+    {
+        nAccumulator ^= XXRound(0, nValue);
+        return (nAccumulator * kXXPrime1) + kXXPrime4;
+    }
+
+    // Processes whole 32 byte stripes and returns the number of bytes processed.
+    size_type XXProcessStripes(uint64_t* pState, const uint8_t* p, size_type nSize)
+    {
+        uint64_t v1 = pState[0], v2 = pState[1], v3 = pState[2], v4 = pState[3];
+        const uint8_t* const pEnd = p + (nSize & ~(size_type)31);
+
+        for(; p < pEnd; p += 32)
+        {
+            v1 = XXRound(v1, LoadUint64Little(p));
+            v2 = XXRound(v2, LoadUint64Little(p + 8));
+            v3 = XXRound(v3, LoadUint64Little(p + 16));
+            v4 = XXRound(v4, LoadUint64Little(p + 24));
+        }
+
+        pState[0] = v1; pState[1] = v2; pState[2] = v3; pState[3] = v4;
+        return (nSize & ~(size_type)31);
+    }
+
+} // namespace StreamChecksumLocal
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ComputeCRC32C
+//
+EAIO_API uint32_t ComputeCRC32C(const void* pData, size_type nSize, uint32_t nCRC)
+{
+    using namespace StreamChecksumLocal;
+
+    // The CRC is kept inverted during computation, so that leading zero bytes affect it.
+    #if EAIO_CRC32C_SSE42_ENABLED
+        if(gbCRC32CSSE42Supported)
+            return ~UpdateCRC32CSSE42(~nCRC, (const uint8_t*)pData, nSize);
+    #endif
+
+    return ~UpdateCRC32CTable(~nCRC, (const uint8_t*)pData, nSize);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ComputeXXHash64
+//
+EAIO_API uint64_t ComputeXXHash64(const void* pData, size_type nSize, uint64_t nSeed)
+{
+    XXHash64 hash(nSeed);
+    hash.Update(pData, nSize);
+    return hash.GetValue();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// XXHash64
+///////////////////////////////////////////////////////////////////////////////
+
+XXHash64::XXHash64(uint64_t nSeed)
+{
+    Reset(nSeed);
+}
+
+
+void XXHash64::Reset(uint64_t nSeed)
+{
+    using namespace StreamChecksumLocal;
+
+    mState[0]    = nSeed + kXXPrime1 + kXXPrime2;
+    mState[1]    = nSeed + kXXPrime2;
+    mState[2]    = nSeed;
+    mState[3]    = nSeed - kXXPrime1;
+    mnTotalSize  = 0;
+    mnBufferUsed = 0;
+}
+
+
+void XXHash64::Update(const void* pData, size_type nSize)
+{
+    using namespace StreamChecksumLocal;
+
+    const uint8_t* p = (const uint8_t*)pData;
+
+    mnTotalSize += nSize;
+
+    if(mnBufferUsed) // If there is a partial stripe from before...
+    {
+        const size_type nCopySize = ((32 - mnBufferUsed) < nSize) ? (32 - mnBufferUsed) : nSize;
+
+        memcpy(mBuffer + mnBufferUsed, p, (size_t)nCopySize);
+        mnBufferUsed += nCopySize;
+        p            += nCopySize;
+        nSize        -= nCopySize;
+
+        if(mnBufferUsed < 32)
+            return;
+
+        XXProcessStripes(mState, mBuffer, 32);
+        mnBufferUsed = 0;
+    }
+
+    const size_type nProcessed = XXProcessStripes(mState, p, nSize);
+
+    mnBufferUsed = (nSize - nProcessed);
+    memcpy(mBuffer, p + nProcessed, (size_t)mnBufferUsed);
+}
+
+
+uint64_t XXHash64::GetValue() const
+{
+    using namespace StreamChecksumLocal;
+
+    uint64_t h;
+
+    if(mnTotalSize >= 32)
+    {
+        h = RotateLeft(mState[0], 1) + RotateLeft(mState[1], 7) + RotateLeft(mState[2], 12) + RotateLeft(mState[3], 18);
+        h = XXMergeRound(h, mState[0]);
+        h = XXMergeRound(h, mState[1]);
+        h = XXMergeRound(h, mState[2]);
+        h = XXMergeRound(h, mState[3]);
+    }
+    else
+        h = mState[2] + kXXPrime5; // mState[2] is still the seed.
+
+    h += mnTotalSize;
+
+    const uint8_t*       p    = mBuffer;
+    const uint8_t* const pEnd = mBuffer + mnBufferUsed;
+
+    for(; (p + 8) <= pEnd; p += 8)
+    {
+        h ^= XXRound(0, LoadUint64Little(p));
+        h  = (RotateLeft(h, 27) * kXXPrime1) + kXXPrime4;
+    }
+
+    if((p + 4) <= pEnd)
+    {
+        h ^= (uint64_t)LoadUint32Little(p) * kXXPrime1;
+        h  = (RotateLeft(h, 23) * kXXPrime2) + kXXPrime3;
+        p += 4;
+    }
+
+    for(; p < pEnd; p++)
+    {
+        h ^= (*p * kXXPrime5);
+        h  = RotateLeft(h, 11) * kXXPrime1;
+    }
+
+    h ^= (h >> 33);
+    h *= kXXPrime2;
+    h ^= (h >> 29);
+    h *= kXXPrime3;
+    h ^= (h >> 32);
+
+    return h;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamChecksum
+///////////////////////////////////////////////////////////////////////////////
+
+StreamChecksum::StreamChecksum(IStream* pStream, int nChecksumFlags, uint64_t nXXHash64Seed)
+  : mnRefCount(0),
+    mpStream(NULL),
+    mnChecksumFlags(nChecksumFlags),
+    mnXXHash64Seed(nXXHash64Seed),
+    mnCRC32C(0),
+    mXXHash64(nXXHash64Seed),
+    mnChecksumSize(0)
+{
+    setStream(pStream);
+}
+
+
+StreamChecksum::~StreamChecksum()
+{
+    setStream(NULL);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setStream
+//
+bool StreamChecksum::setStream(IStream* pStream)
+{
+    if(pStream != mpStream)
+    {
+        if(pStream)
+            pStream->AddRef();
+
+        if(mpStream)
+            mpStream->Release();
+
+        mpStream = pStream;
+        Reset();
+    }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Reset
+//
+void StreamChecksum::Reset()
+{
+    mnCRC32C       = 0;
+    mnChecksumSize = 0;
+    mXXHash64.Reset(mnXXHash64Seed);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Update
+//
+// This is an internal function.
+//
+void StreamChecksum::Update(const void* pData, size_type nSize)
+{
+    if(mnChecksumFlags & kChecksumCRC32C)
+        mnCRC32C = ComputeCRC32C(pData, nSize, mnCRC32C);
+
+    if(mnChecksumFlags & kChecksumXXHash64)
+        mXXHash64.Update(pData, nSize);
+
+    mnChecksumSize += nSize;
+}
+
+
+int StreamChecksum::AddRef()
+{
+    return ++mnRefCount;
+}
+
+
+int StreamChecksum::Release()
+{
+    if(mnRefCount > 1)
+        return --mnRefCount;
+    delete this;
+    return 0;
+}
+
+
+bool StreamChecksum::close()
+{
+    if(mpStream)
+        return mpStream->close();
+    return true;
+}
+
+
+int StreamChecksum::GetAccessFlags() const
+{
+    if(mpStream)
+        return mpStream->GetAccessFlags();
+    return 0;
+}
+
+
+int StreamChecksum::GetState() const
+{
+    if(mpStream)
+        return mpStream->GetState();
+    return kStateNotOpen;
+}
+
+
+size_type StreamChecksum::getSize() const
+{
+    if(mpStream)
+        return mpStream->getSize();
+    return kSizeTypeError;
+}
+
+
+bool StreamChecksum::SetSize(size_type size)
+{
+    if(mpStream)
+        return mpStream->SetSize(size);
+    return false;
+}
+
+
+off_type StreamChecksum::GetPosition(PositionType positionType) const
+{
+    if(mpStream)
+        return mpStream->GetPosition(positionType);
+    return (off_type)kSizeTypeError;
+}
+
+
+bool StreamChecksum::SetPosition(off_type position, PositionType positionType)
+{
+    if(mpStream)
+        return mpStream->SetPosition(position, positionType);
+    return false;
+}
+
+
+size_type StreamChecksum::GetAvailable() const
+{
+    if(mpStream)
+        return mpStream->GetAvailable();
+    return kSizeTypeError;
+}
+
+
+size_type StreamChecksum::Read(void* pData, size_type nSize)
+{
+    if(mpStream)
+    {
+        const size_type nResult = mpStream->Read(pData, nSize);
+
+        if((nResult != kSizeTypeError) && nResult)
+            Update(pData, nResult);
+
+        return nResult;
+    }
+
+    return kSizeTypeError;
+}
+
+
+bool StreamChecksum::Flush()
+{
+    if(mpStream)
+        return mpStream->Flush();
+    return false;
+}
+
+
+bool StreamChecksum::Write(const void* pData, size_type nSize)
+{
+    if(mpStream && mpStream->Write(pData, nSize))
+    {
+        Update(pData, nSize);
+        return true;
+    }
+
+    return false;
+}
+
+
+} // namespace IO
+
+} // namespace EA
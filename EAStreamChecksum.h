@@ -0,0 +1,229 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAStreamChecksum.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements a stream which computes a checksum of all the data which is 
+// read from or written to another stream, plus the checksum functions 
+// which it uses.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EASTREAMCHECKSUM_H
+#define EAIO_EASTREAMCHECKSUM_H
+
+
+#ifndef INCLUDED_eabase_H
+    #include <eastl/EABase/eabase.h>
+#endif
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// ComputeCRC32C
+        ///
+        /// Computes the CRC-32C (Castagnoli) of the given data, continuing from nCRC,
+        /// which is the CRC of any preceding data, or 0 for none. This is the CRC 
+        /// used by iSCSI, SCTP, ext4 and others; the CRC of "123456789" is 0xe3069283.
+        ///
+        /// This uses the SSE 4.2 crc32 instruction where the processor supports it,
+        /// and else a table-driven implementation which processes 8 bytes at a time.
+        ///
+        EAIO_API uint32_t ComputeCRC32C(const void* pData, size_type nSize, uint32_t nCRC = 0);
+
+
+        /// ComputeXXHash64
+        ///
+        /// Computes the 64 bit xxHash (XXH64) of the given data. This is much faster 
+        /// than CRC-32C on processors without a crc32 instruction, and its 64 bit 
+        /// result is better for detecting changes among large numbers of files.
+        ///
+        EAIO_API uint64_t ComputeXXHash64(const void* pData, size_type nSize, uint64_t nSeed = 0);
+
+
+        /// class XXHash64
+        ///
+        /// Computes an xxHash64 incrementally, for data which isn't contiguous.
+        /// The result is the same as with ComputeXXHash64 for the concatenated data.
+        ///
+        class EAIO_API XXHash64
+        {
+        public:
+            XXHash64(uint64_t nSeed = 0);
+
+            void     Reset(uint64_t nSeed = 0);
+            void     Update(const void* pData, size_type nSize);
+            uint64_t GetValue() const;     /// Returns the hash of all data so far. Update may be called further afterwards.
+
+        protected:
+            uint64_t  mState[4];        /// The four accumulators, which each process 8 of every 32 bytes.
+            uint64_t  mnTotalSize;      /// Total number of bytes so far.
+            uint8_t   mBuffer[32];      /// Bytes which don't yet form a whole 32 byte stripe.
+            size_type mnBufferUsed;
+        };
+
+
+        /// class StreamChecksum
+        ///
+        /// Implements a stream which passes all operations through to another stream,
+        /// while computing a checksum of all the data which is read or written. This 
+        /// allows data to be verified as it is loaded, while it is in the cache, rather 
+        /// than with a second pass over it afterwards.
+        ///
+        /// The checksum covers the bytes in the order in which they are transferred; 
+        /// SetPosition doesn't affect it. Thus to checksum a file, read it sequentially.
+        /// Reads and writes can both be checksummed, but they are combined into a 
+        /// single checksum, so usually only one or the other is done between Resets.
+        ///
+        /// This class is not inherently thread-safe. As a result, thread-safe usage 
+        /// between multiple threads requires higher level coordination, such as a mutex.
+        ///
+        /// Example usage:
+        ///     StreamChecksum streamChecksum(&fileStream, StreamChecksum::kChecksumCRC32C);
+        ///
+        ///     LoadPackFile(&streamChecksum);
+        ///
+        ///     if(streamChecksum.GetCRC32C() != packHeader.mCRC)
+        ///         HandleCorruption();
+        ///
+        class EAIO_API StreamChecksum : public IStream
+        {
+        public:
+            enum { kTypeStreamChecksum = 0x34722340 };
+
+            enum ChecksumFlags
+            {
+                kChecksumCRC32C   = 0x01,   /// Compute the CRC-32C. See ComputeCRC32C.
+                kChecksumXXHash64 = 0x02    /// Compute the xxHash64. See ComputeXXHash64.
+            };
+
+        public:
+            StreamChecksum(IStream* pStream = NULL, int nChecksumFlags = kChecksumCRC32C, uint64_t nXXHash64Seed = 0);
+           ~StreamChecksum();
+
+            IStream*  getStream() const;
+            bool      setStream(IStream* pStream);     /// Resets the checksums.
+
+            /// Reset
+            /// Restarts the checksums, as if no data had been read or written.
+            void      Reset();
+
+            uint32_t  GetCRC32C() const;        /// Returns 0 unless kChecksumCRC32C is enabled.
+            uint64_t  GetXXHash64() const;      /// Returns 0 unless kChecksumXXHash64 is enabled.
+            size_type GetChecksumSize() const;  /// Returns the number of bytes checksummed since the last Reset.
+
+            int       AddRef();
+            int       Release();
+            bool      close();
+            uint32_t  GetType() const { return kTypeStreamChecksum; }
+            int       GetAccessFlags() const;
+            int       GetState() const;
+            size_type getSize() const;
+            bool      SetSize(size_type size);
+            off_type  GetPosition(PositionType positionType = kPositionTypeBegin) const;
+            bool      SetPosition(off_type position, PositionType positionType = kPositionTypeBegin);
+
+            size_type GetAvailable() const;
+            size_type Read(void* pData, size_type nSize);
+
+            bool      Flush();
+            bool      Write(const void* pData, size_type nSize);
+
+        protected:
+            StreamChecksum(const StreamChecksum&);              // Not implemented.
+            StreamChecksum& operator=(const StreamChecksum&);   // Not implemented.
+
+            void      Update(const void* pData, size_type nSize);
+
+        protected:
+            int       mnRefCount;           /// Reference count. May or may not be in use.
+            IStream*  mpStream;             /// The stream that we are checksumming.
+            int       mnChecksumFlags;      /// See enum ChecksumFlags.
+            uint64_t  mnXXHash64Seed;
+            uint32_t  mnCRC32C;
+            XXHash64  mXXHash64;
+            size_type mnChecksumSize;
+        };
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+    namespace IO
+    {
+        inline
+        IStream* StreamChecksum::getStream() const
+        {
+            // We do not AddRef the returned stream.
+            return mpStream;
+        }
+
+        inline
+        uint32_t StreamChecksum::GetCRC32C() const
+        {
+            return mnCRC32C;
+        }
+
+        inline
+        uint64_t StreamChecksum::GetXXHash64() const
+        {
+            return (mnChecksumFlags & kChecksumXXHash64) ? mXXHash64.GetValue() : 0;
+        }
+
+        inline
+        size_type StreamChecksum::GetChecksumSize() const
+        {
+            return mnChecksumSize;
+        }
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif // Header include guard
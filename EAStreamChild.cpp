@@ -214,23 +214,19 @@ size_type StreamChild::Read(void* pData, size_type nSize)
 {
     if(mnAccessFlags) // If open...
     {
-        // We have a potential problem here with respect to multi-threaded 
-        // access to the parent. With multi-threaded usage of mpStreamParent
-        // it's possible that a second thread could alter the position of 
-        // the parent stream between the SetPosition and Read calls below.
-        if(mpStreamParent->SetPosition((off_type)(mnPositionParent + mnPosition)))
+        // We use ReadAt instead of SetPosition + Read so that we don't use or alter the 
+        // position of the parent. If the parent implements ReadAt atomically (as FileStream
+        // does), multiple StreamChild instances may read from the same parent concurrently.
+        size_type nAvailable(GetAvailable());
+        if (nAvailable < nSize) // allow read to end of our range
         {
-            size_type nAvailable(GetAvailable());
-            if (nAvailable < nSize) // allow read to end of our range
-            {
-                nSize = nAvailable;
-            }
-
-            if(mpStreamParent->Read(pData, nSize) == nSize)
-            {
-                mnPosition += nSize;
-                return nSize;
-            }
+            nSize = nAvailable;
+        }
+
+        if(mpStreamParent->ReadAt(mnPositionParent + mnPosition, pData, nSize) == nSize)
+        {
+            mnPosition += nSize;
+            return nSize;
         }
     }
     return kSizeTypeError;
@@ -251,8 +247,7 @@ bool StreamChild::Write(const void* pData, size_type nSize)
     if(nSize > (mnSize - mnPosition))
        nSize = (mnSize - mnPosition);
 
-    if(mpStreamParent->SetPosition((off_type)(mnPositionParent + mnPosition)) &&
-       mpStreamParent->Write(pData, nSize))
+    if(mpStreamParent->WriteAt(mnPositionParent + mnPosition, pData, nSize))
     {
         mnPosition += nSize;
         return true;
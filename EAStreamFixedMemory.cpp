@@ -189,6 +189,64 @@ bool EA::IO::FixedMemoryStream::Write( const void* pData, size_type nSize )
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+EA::IO::size_type EA::IO::FixedMemoryStream::ReadV( const IOVector* pIOVectorArray, size_t nCount )
+{
+    // We check the available size once for all of the buffers and then just copy.
+    EA_ASSERT(mnPosition <= mnSize);
+    const size_type nBytesAvailable( mnSize - mnPosition );
+    size_type       nTotal( 0 );
+
+    for (size_t i = 0; (i < nCount) && (nTotal < nBytesAvailable); i++)
+    {
+        size_type nSize( pIOVectorArray[i].mnSize );
+
+        if (nSize > (nBytesAvailable - nTotal))
+            nSize = (nBytesAvailable - nTotal);
+
+        memcpy( pIOVectorArray[i].mpData, (const uint8_t*)mpData + mnPosition + nTotal, (size_t)nSize );
+        nTotal += nSize;
+    }
+
+    mnPosition += nTotal;
+
+    return nTotal;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool EA::IO::FixedMemoryStream::WriteV( const ConstIOVector* pIOVectorArray, size_t nCount )
+{
+    size_type nTotal( 0 );
+
+    for (size_t i = 0; i < nCount; i++)
+        nTotal += pIOVectorArray[i].mnSize;
+
+    if ((mnPosition + nTotal) > mnCapacity) // If it doesn't all fit, we write what Write would.
+    {
+        for (size_t i = 0; i < nCount; i++)
+        {
+            if (!FixedMemoryStream::Write( pIOVectorArray[i].mpData, pIOVectorArray[i].mnSize ))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Else we check the capacity once for all of the buffers and then just copy.
+    EA_ASSERT(mnPosition <= mnSize);
+
+    for (size_t i = 0; i < nCount; i++)
+    {
+        memcpy( (uint8_t*)mpData + mnPosition, pIOVectorArray[i].mpData, (size_t)pIOVectorArray[i].mnSize );
+        mnPosition += pIOVectorArray[i].mnSize;
+    }
+
+    if (mnSize < mnPosition)
+        mnSize = mnPosition;
+
+    return true;
+}
+
 
 
 
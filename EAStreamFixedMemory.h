@@ -92,6 +92,9 @@ namespace EA
             bool        Flush();
             bool        Write(const void* pData, size_type nSize);
 
+            size_type   ReadV(const IOVector* pIOVectorArray, size_t nCount);
+            bool        WriteV(const ConstIOVector* pIOVectorArray, size_t nCount);
+
         protected:
             void         * mpData;
             int            mnRefCount;          /// Reference count. May or may not be in use.
@@ -527,6 +527,63 @@ bool EA::IO::MemoryStream::Write(const void* pData, size_type nSize)
 }
 
 
+EA::IO::size_type EA::IO::MemoryStream::ReadV(const IOVector* pIOVectorArray, size_t nCount)
+{
+    // We check the available size once for all of the buffers and then just copy.
+    EA_ASSERT(mnPosition <= mnSize);
+    const size_type nBytesAvailable(mnSize - mnPosition);
+    size_type       nTotal = 0;
+
+    for(size_t i = 0; (i < nCount) && (nTotal < nBytesAvailable); i++)
+    {
+        size_type nSize = pIOVectorArray[i].mnSize;
+
+        if(nSize > (nBytesAvailable - nTotal))
+            nSize = (nBytesAvailable - nTotal);
+
+        memcpy(pIOVectorArray[i].mpData, (const uint8_t*)mpSharedPointer->GetPointer() + mnPosition + nTotal, (size_t)nSize);
+        nTotal += nSize;
+    }
+
+    mnPosition += nTotal;
+
+    return nTotal;
+}
+
+
+bool EA::IO::MemoryStream::WriteV(const ConstIOVector* pIOVectorArray, size_t nCount)
+{
+    if(mbResizeEnabled) // Grow the buffer once for the total size, rather than potentially once per buffer.
+    {
+        size_type nTotal = 0;
+
+        for(size_t i = 0; i < nCount; i++)
+            nTotal += pIOVectorArray[i].mnSize;
+
+        const size_type nRequiredSize(mnPosition + nTotal);
+
+        if(nRequiredSize > mnCapacity)
+        {
+            size_type nNewCapacity = (size_type)((mnCapacity * mfResizeFactor) + mnResizeIncrement);
+
+            if(nNewCapacity < nRequiredSize)
+                nNewCapacity = nRequiredSize;
+
+            if(!Realloc(nNewCapacity))
+                return false;
+        }
+    }
+
+    for(size_t i = 0; i < nCount; i++)
+    {
+        if(!MemoryStream::Write(pIOVectorArray[i].mpData, pIOVectorArray[i].mnSize))
+            return false;
+    }
+
+    return true;
+}
+
+
 
 
 
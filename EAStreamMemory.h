@@ -163,6 +163,9 @@ namespace EA
             bool        Flush();
             bool        Write(const void* pData, size_type nSize);
 
+            size_type   ReadV(const IOVector* pIOVectorArray, size_t nCount);
+            bool        WriteV(const ConstIOVector* pIOVectorArray, size_t nCount);
+
         protected:
             bool Realloc(size_type nSize);
 
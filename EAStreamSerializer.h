@@ -0,0 +1,689 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAStreamSerializer.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Implements reading and writing of whole structs and arrays of structs
+// based on a per-type field list which is declared with macros.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EASTREAMSERIALIZER_H
+#define EAIO_EASTREAMSERIALIZER_H
+
+
+#ifndef INCLUDED_eabase_H
+    #include <eastl/EABase/eabase.h>
+#endif
+#include <eaio/internal/Config.h>
+#ifndef EAIO_EASTREAM_H
+    #include <eaio/EAStream.h>
+#endif
+#include <eaio/EAStreamAdapter.h>
+#include <eaio/EABufferAdapter.h>
+#include <string.h>
+
+
+
+/// EAIO_SERIALIZE_BEGIN / EAIO_SERIALIZE_FIELD / EAIO_SERIALIZE_END
+///
+/// Declares the fields of a struct, in the order in which they are serialized.
+/// This must be used at global scope, and Type must be fully qualified.
+/// A field may be any basic integer type, including the character types wchar_t, 
+/// char16_t and char32_t, bool (serialized as one byte), float, double, another 
+/// struct with a field list, or a fixed-size array of these.
+/// Enums and pointers aren't supported; serialize them through an integer field.
+///
+/// Example usage:
+///     struct Vertex { float x, y, z; uint32_t nColor; uint16_t u, v; };
+///
+///     EAIO_SERIALIZE_BEGIN(Vertex)
+///         EAIO_SERIALIZE_FIELD(x)
+///         EAIO_SERIALIZE_FIELD(y)
+///         EAIO_SERIALIZE_FIELD(z)
+///         EAIO_SERIALIZE_FIELD(nColor)
+///         EAIO_SERIALIZE_FIELD(u)
+///         EAIO_SERIALIZE_FIELD(v)
+///     EAIO_SERIALIZE_END()
+///
+#define EAIO_SERIALIZE_BEGIN(Type)                                              \
+    namespace EA { namespace IO {                                               \
+        template <> struct SerializeFields<Type>                                \
+        {                                                                       \
+            template <typename Visitor, typename T>                             \
+            static void Visit(Visitor& visitor, T& object)                      \
+            {
+
+#define EAIO_SERIALIZE_FIELD(name)                                              \
+                visitor(object.name);
+
+#define EAIO_SERIALIZE_END()                                                    \
+            }                                                                   \
+        };                                                                      \
+    } }
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// SerializeFields
+        ///
+        /// Specialized for a type by EAIO_SERIALIZE_BEGIN. 
+        /// SerializeFields<T>::Visit(visitor, object) calls visitor(object.field) for each field.
+        ///
+        template <typename T>
+        struct SerializeFields;
+
+
+        /// GetSerializedSize
+        ///
+        /// Returns the number of bytes which a struct is serialized as. 
+        /// This is the sum of the field sizes, and so doesn't include any padding.
+        ///
+        template <typename T>
+        size_type GetSerializedSize(const T& value);
+
+
+        /// ReadStruct
+        ///
+        /// Reads a struct or an array of structs, converting each field from endianSource.
+        ///
+        /// The fields of a struct, and of all count structs of an array, are read with
+        /// a single stream Read rather than a Read per field. If the struct's memory 
+        /// layout is the same as its serialized layout (i.e. it has no padding and no 
+        /// bool fields), the data is read directly into the struct and is then byte-
+        /// swapped in place if endianSource isn't kEndianLocal. Otherwise it is read 
+        /// into a buffer a group of structs at a time and is decoded from there, or for
+        /// a struct larger than the buffer, is decoded as it's read through the buffer.
+        /// The layout is checked at runtime by comparing field offsets, which the 
+        /// compiler can usually fold into a constant with optimization enabled; at 
+        /// worst, this is one pass over the field list per call. The byte-swapping
+        /// is resolved at compile time.
+        ///
+        /// Returns false if the data couldn't be fully read. In that case the contents
+        /// of the struct(s) are undefined.
+        ///
+        template <typename T>
+        bool ReadStruct(IStream* pIS, T& value, Endian endianSource = kEndianBig);
+
+        template <typename T>
+        bool ReadStruct(IStream* pIS, T* value, size_type count, Endian endianSource = kEndianBig);
+
+
+        /// WriteStruct
+        ///
+        /// Writes a struct or an array of structs, converting each field to endianDestination.
+        /// As with ReadStruct, the data is written with a single stream Write when 
+        /// possible, and otherwise with one Write per group of structs.
+        ///
+        template <typename T>
+        bool WriteStruct(IStream* pOS, const T& value, Endian endianDestination = kEndianBig);
+
+        template <typename T>
+        bool WriteStruct(IStream* pOS, const T* value, size_type count, Endian endianDestination = kEndianBig);
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+namespace IO
+{
+
+namespace SerializeInternal
+{
+    // The size of the buffer used when structs can't be read or written directly.
+    const size_type kBufferSize = 512;
+
+    const Endian kEndianNonLocal = (kEndianLocal == kEndianBig) ? kEndianLittle : kEndianBig;
+
+    template <typename T> struct RemoveConst          { typedef T Type; };
+    template <typename T> struct RemoveConst<const T> { typedef T Type; };
+
+    // Classifies field types.
+    enum FieldKind
+    {
+        kFieldKindStruct,   // A struct with SerializeFields.
+        kFieldKindNumber,   // An integer or floating point type, serialized as-is.
+        kFieldKindBool      // A bool, serialized as a uint8_t of 0 or 1.
+    };
+
+    template <int n> struct KindTag { };
+
+    template <typename T> struct FieldTraits { static const FieldKind kKind = kFieldKindStruct; };
+
+    #define EAIO_SERIALIZE_NUMBER(T) template <> struct FieldTraits<T> { static const FieldKind kKind = kFieldKindNumber; };
+    EAIO_SERIALIZE_NUMBER(char)
+    EAIO_SERIALIZE_NUMBER(signed char)
+    EAIO_SERIALIZE_NUMBER(unsigned char)
+    EAIO_SERIALIZE_NUMBER(signed short)
+    EAIO_SERIALIZE_NUMBER(unsigned short)
+    EAIO_SERIALIZE_NUMBER(signed int)
+    EAIO_SERIALIZE_NUMBER(unsigned int)
+    EAIO_SERIALIZE_NUMBER(signed long)
+    EAIO_SERIALIZE_NUMBER(unsigned long)
+    EAIO_SERIALIZE_NUMBER(signed long long)
+    EAIO_SERIALIZE_NUMBER(unsigned long long)
+    EAIO_SERIALIZE_NUMBER(float)
+    EAIO_SERIALIZE_NUMBER(double)
+
+    // The character types are distinct types only with some compilers. Where they 
+    // aren't (e.g. EABase's char16_t typedef), they are covered by the above.
+    #if !defined(EA_WCHAR_T_NON_NATIVE)
+        EAIO_SERIALIZE_NUMBER(wchar_t)
+    #endif
+    #if defined(EA_CHAR16_NATIVE) && EA_CHAR16_NATIVE
+        EAIO_SERIALIZE_NUMBER(char16_t)
+    #endif
+    #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+        EAIO_SERIALIZE_NUMBER(char32_t)
+    #endif
+    #undef EAIO_SERIALIZE_NUMBER
+
+    template <> struct FieldTraits<bool> { static const FieldKind kKind = kFieldKindBool; };
+
+
+    // VisitorBase is the base for the visitors below, which implement VisitNumber and VisitBool.
+    // It dispatches each field by its kind, recursing into structs and arrays.
+    template <typename Visitor>
+    struct VisitorBase
+    {
+        template <typename T>
+        void operator()(T& field)
+        {
+            Dispatch(field, KindTag<FieldTraits<typename RemoveConst<T>::Type>::kKind>());
+        }
+
+        template <typename T, size_t N>
+        void operator()(T (&array)[N])
+        {
+            for(size_t i = 0; i < N; ++i)
+                (*this)(array[i]);
+        }
+
+        template <typename T>
+        void Dispatch(T& field, KindTag<kFieldKindStruct>)
+        {
+            SerializeFields<typename RemoveConst<T>::Type>::Visit(static_cast<Visitor&>(*this), field);
+        }
+
+        template <typename T>
+        void Dispatch(T& field, KindTag<kFieldKindNumber>)
+        {
+            static_cast<Visitor*>(this)->VisitNumber(field);
+        }
+
+        template <typename T>
+        void Dispatch(T& field, KindTag<kFieldKindBool>)
+        {
+            static_cast<Visitor*>(this)->VisitBool(field);
+        }
+    };
+
+
+    // Sums the serialized field sizes.
+    struct SizeVisitor : public VisitorBase<SizeVisitor>
+    {
+        size_type mnSize;
+
+        SizeVisitor() : mnSize(0) { }
+
+        template <typename T>
+        void VisitNumber(T&)   { mnSize += sizeof(T); }
+        void VisitBool(const bool&) { mnSize += 1; }
+    };
+
+
+    // Determines if each field is in memory at the same offset as it is serialized at.
+    struct LayoutVisitor : public VisitorBase<LayoutVisitor>
+    {
+        const uint8_t* mpBase;
+        size_type      mnOffset;
+        bool           mbNative;
+
+        LayoutVisitor(const void* pBase) : mpBase((const uint8_t*)pBase), mnOffset(0), mbNative(true) { }
+
+        template <typename T>
+        void VisitNumber(T& field)
+        {
+            mbNative  = mbNative && (((const uint8_t*)&field - mpBase) == (ptrdiff_t)mnOffset);
+            mnOffset += sizeof(T);
+        }
+
+        void VisitBool(const bool&) // A bool in memory can't safely be set to an arbitrary serialized byte.
+        {
+            mbNative  = false;
+            mnOffset += 1;
+        }
+    };
+
+
+    // Byte-swaps each field in place.
+    struct SwizzleVisitor : public VisitorBase<SwizzleVisitor>
+    {
+        template <typename T>
+        void VisitNumber(T& field)
+        {
+            typedef typename BufferAdapterInternal::UintOfSize<sizeof(T)>::Type Uint;
+
+            Uint n;
+            memcpy(&n, &field, sizeof(n));
+            n = BufferAdapterInternal::Swizzle(n);
+            memcpy(&field, &n, sizeof(n));
+        }
+
+        void VisitBool(bool&) { }
+    };
+
+
+    // Decodes each field from serialized data.
+    template <Endian endianType>
+    struct DecodeVisitor : public VisitorBase< DecodeVisitor<endianType> >
+    {
+        const uint8_t* mpData;
+
+        DecodeVisitor(const uint8_t* pData) : mpData(pData) { }
+
+        template <typename T>
+        void VisitNumber(T& field)
+        {
+            typedef typename BufferAdapterInternal::UintOfSize<sizeof(T)>::Type Uint;
+
+            Uint n;
+            memcpy(&n, mpData, sizeof(n));
+            mpData += sizeof(n);
+
+            if(endianType != kEndianLocal)
+                n = BufferAdapterInternal::Swizzle(n);
+            memcpy(&field, &n, sizeof(n));
+        }
+
+        void VisitBool(bool& field)
+        {
+            field = (*mpData++ != 0);
+        }
+    };
+
+
+    // Decodes each field from serialized data which is read from a stream through a 
+    // buffer, for structs whose serialized size exceeds kBufferSize. nSize is the 
+    // number of bytes to read in all. Upon a read failure, mbSuccess becomes false 
+    // and the remaining fields are left as they were.
+    template <Endian endianType>
+    struct StreamDecodeVisitor : public VisitorBase< StreamDecodeVisitor<endianType> >
+    {
+        IStream*  mpStream;
+        size_type mnRemaining;      // Bytes not yet read from the stream.
+        size_type mnBegin;          // The position of the next unused byte in mBuffer.
+        size_type mnEnd;            // The end of the valid bytes in mBuffer.
+        bool      mbSuccess;
+        uint8_t   mBuffer[kBufferSize];
+
+        StreamDecodeVisitor(IStream* pStream, size_type nSize) 
+          : mpStream(pStream), mnRemaining(nSize), mnBegin(0), mnEnd(0), mbSuccess(true) { }
+
+        // Makes at least nNeeded bytes available at mBuffer + mnBegin.
+        bool Fill(size_type nNeeded)
+        {
+            if(mbSuccess && ((mnEnd - mnBegin) < nNeeded))
+            {
+                const size_type nUnused = (mnEnd - mnBegin);
+                size_type       nRead   = (kBufferSize - nUnused);
+
+                if(nRead > mnRemaining)
+                    nRead = mnRemaining;
+
+                memmove(mBuffer, mBuffer + mnBegin, (size_t)nUnused);
+                mnBegin = 0;
+                mnEnd   = nUnused;
+
+                mbSuccess = ((nUnused + nRead) >= nNeeded) && (mpStream->Read(mBuffer + nUnused, nRead) == nRead);
+                mnEnd       += nRead;
+                mnRemaining -= nRead;
+            }
+
+            return mbSuccess;
+        }
+
+        template <typename T>
+        void VisitNumber(T& field)
+        {
+            if(Fill(sizeof(T)))
+            {
+                DecodeVisitor<endianType> visitor(mBuffer + mnBegin);
+                visitor.VisitNumber(field);
+                mnBegin += sizeof(T);
+            }
+        }
+
+        void VisitBool(bool& field)
+        {
+            if(Fill(1))
+                field = (mBuffer[mnBegin++] != 0);
+        }
+    };
+
+
+    // Encodes each field to serialized data.
+    template <Endian endianType>
+    struct EncodeVisitor : public VisitorBase< EncodeVisitor<endianType> >
+    {
+        uint8_t* mpData;
+
+        EncodeVisitor(uint8_t* pData) : mpData(pData) { }
+
+        template <typename T>
+        void VisitNumber(const T& field)
+        {
+            typedef typename BufferAdapterInternal::UintOfSize<sizeof(T)>::Type Uint;
+
+            Uint n;
+            memcpy(&n, &field, sizeof(n));
+
+            if(endianType != kEndianLocal)
+                n = BufferAdapterInternal::Swizzle(n);
+
+            memcpy(mpData, &n, sizeof(n));
+            mpData += sizeof(n);
+        }
+
+        void VisitBool(const bool& field)
+        {
+            *mpData++ = (uint8_t)(field ? 1 : 0);
+        }
+    };
+
+
+    // Encodes each field to serialized data which is written to a stream through a 
+    // buffer, for structs whose serialized size exceeds kBufferSize. Flush must be 
+    // called after the last field. Upon a write failure, mbSuccess becomes false.
+    template <Endian endianType>
+    struct StreamEncodeVisitor : public VisitorBase< StreamEncodeVisitor<endianType> >
+    {
+        IStream*  mpStream;
+        size_type mnEnd;            // The end of the encoded bytes in mBuffer.
+        bool      mbSuccess;
+        uint8_t   mBuffer[kBufferSize];
+
+        StreamEncodeVisitor(IStream* pStream) 
+          : mpStream(pStream), mnEnd(0), mbSuccess(true) { }
+
+        bool Flush()
+        {
+            if(mbSuccess && mnEnd)
+                mbSuccess = mpStream->Write(mBuffer, mnEnd);
+            mnEnd = 0;
+            return mbSuccess;
+        }
+
+        template <typename T>
+        void VisitNumber(const T& field)
+        {
+            if(((kBufferSize - mnEnd) >= sizeof(T)) || Flush())
+            {
+                EncodeVisitor<endianType> visitor(mBuffer + mnEnd);
+                visitor.VisitNumber(field);
+                mnEnd += sizeof(T);
+            }
+        }
+
+        void VisitBool(const bool& field)
+        {
+            if((mnEnd < kBufferSize) || Flush())
+                mBuffer[mnEnd++] = (uint8_t)(field ? 1 : 0);
+        }
+    };
+
+
+    // Returns true if T can be read and written directly as memory, aside from byte-swapping.
+    // This is a runtime check of the field offsets of value. As they are constant, an 
+    // optimizing compiler can usually reduce it to a constant, but that isn't guaranteed.
+    template <typename T>
+    inline bool IsLayoutNative(const T& value)
+    {
+        LayoutVisitor visitor(&value);
+        SerializeFields<T>::Visit(visitor, value);
+        return visitor.mbNative && (visitor.mnOffset == sizeof(T)); // sizeof(T) differs if there is trailing padding.
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // ReadStructArray
+    //
+    // This is an internal function.
+    //
+    template <Endian endianType, typename T>
+    bool ReadStructArray(IStream* pIS, T* value, size_type count)
+    {
+        if(!count)
+            return true;
+
+        const size_type nSize = GetSerializedSize(*value);
+
+        if(IsLayoutNative(*value))
+        {
+            const size_type nTotalSize = nSize * count;
+
+            if(pIS->Read(value, nTotalSize) != nTotalSize)
+                return false;
+
+            if(endianType != kEndianLocal)
+            {
+                SwizzleVisitor visitor;
+
+                for(size_type i = 0; i < count; i++)
+                    SerializeFields<T>::Visit(visitor, value[i]);
+            }
+
+            return true;
+        }
+
+        uint8_t buffer[kBufferSize];
+
+        if(nSize <= kBufferSize)
+        {
+            const size_type nGroupCountMax = (kBufferSize / nSize);
+
+            while(count)
+            {
+                const size_type nGroupCount = (count < nGroupCountMax) ? count : nGroupCountMax;
+                const size_type nGroupSize  = (nGroupCount * nSize);
+
+                if(pIS->Read(buffer, nGroupSize) != nGroupSize)
+                    return false;
+
+                DecodeVisitor<endianType> visitor(buffer);
+
+                for(size_type i = 0; i < nGroupCount; i++)
+                    SerializeFields<T>::Visit(visitor, value[i]);
+
+                value += nGroupCount;
+                count -= nGroupCount;
+            }
+
+            return true;
+        }
+
+        // Else the struct is too large for the buffer, and we decode it as it's read
+        // through the buffer. This is uncommon enough that the extra copy doesn't matter.
+        StreamDecodeVisitor<endianType> visitor(pIS, nSize * count);
+
+        for(size_type i = 0; (i < count) && visitor.mbSuccess; i++)
+            SerializeFields<T>::Visit(visitor, value[i]);
+
+        return visitor.mbSuccess;
+    }
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // WriteStructArray
+    //
+    // This is an internal function.
+    //
+    template <Endian endianType, typename T>
+    bool WriteStructArray(IStream* pOS, const T* value, size_type count)
+    {
+        if(!count)
+            return true;
+
+        const size_type nSize = GetSerializedSize(*value);
+
+        if((endianType == kEndianLocal) && IsLayoutNative(*value))
+            return pOS->Write(value, nSize * count);
+
+        uint8_t buffer[kBufferSize];
+
+        if(nSize <= kBufferSize)
+        {
+            const size_type nGroupCountMax = (kBufferSize / nSize);
+
+            while(count)
+            {
+                const size_type nGroupCount = (count < nGroupCountMax) ? count : nGroupCountMax;
+
+                EncodeVisitor<endianType> visitor(buffer);
+
+                for(size_type i = 0; i < nGroupCount; i++)
+                    SerializeFields<T>::Visit(visitor, value[i]);
+
+                if(!pOS->Write(buffer, nGroupCount * nSize))
+                    return false;
+
+                value += nGroupCount;
+                count -= nGroupCount;
+            }
+
+            return true;
+        }
+
+        // Else the struct is too large for the buffer. See ReadStructArray.
+        StreamEncodeVisitor<endianType> visitor(pOS);
+
+        for(size_type i = 0; (i < count) && visitor.mbSuccess; i++)
+            SerializeFields<T>::Visit(visitor, value[i]);
+
+        return visitor.Flush();
+    }
+
+} // namespace SerializeInternal
+
+
+
+template <typename T>
+inline size_type GetSerializedSize(const T& value)
+{
+    SerializeInternal::SizeVisitor visitor;
+    SerializeFields<T>::Visit(visitor, value);
+    return visitor.mnSize;
+}
+
+
+template <typename T>
+inline bool ReadStruct(IStream* pIS, T& value, Endian endianSource)
+{
+    return ReadStruct(pIS, &value, 1, endianSource);
+}
+
+
+template <typename T>
+inline bool ReadStruct(IStream* pIS, T* value, size_type count, Endian endianSource)
+{
+    // We convert the endian to a template parameter so that the byte-swapping is resolved at compile time.
+    if(endianSource == kEndianLocal)
+        return SerializeInternal::ReadStructArray<kEndianLocal>(pIS, value, count);
+    return SerializeInternal::ReadStructArray<SerializeInternal::kEndianNonLocal>(pIS, value, count);
+}
+
+
+template <typename T>
+inline bool WriteStruct(IStream* pOS, const T& value, Endian endianDestination)
+{
+    return WriteStruct(pOS, &value, 1, endianDestination);
+}
+
+
+template <typename T>
+inline bool WriteStruct(IStream* pOS, const T* value, size_type count, Endian endianDestination)
+{
+    if(endianDestination == kEndianLocal)
+        return SerializeInternal::WriteStructArray<kEndianLocal>(pOS, value, count);
+    return SerializeInternal::WriteStructArray<SerializeInternal::kEndianNonLocal>(pOS, value, count);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamAdapter
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+inline void StreamAdapter::ReadStruct(T& v)
+{
+    VerifyIO(EA::IO::ReadStruct(mpStream, &v, 1, mEndianType));
+}
+
+
+template <typename T>
+inline void StreamAdapter::WriteStruct(const T& v)
+{
+    VerifyIO(EA::IO::WriteStruct(mpStream, &v, 1, mEndianType));
+}
+
+
+template <typename T>
+inline void StreamAdapter::ReadStruct(T* v, uint32_t count)
+{
+    VerifyIO(EA::IO::ReadStruct(mpStream, v, count, mEndianType));
+}
+
+
+template <typename T>
+inline void StreamAdapter::WriteStruct(const T* v, uint32_t count)
+{
+    VerifyIO(EA::IO::WriteStruct(mpStream, v, count, mEndianType));
+}
+
+
+} // namespace IO
+} // namespace EA
+
+
+#endif // Header include guard
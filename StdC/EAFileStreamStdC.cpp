@@ -232,6 +232,10 @@ bool FileStream::open(int nAccessFlags, int nCreationDisposition, int nSharing,
             case kCDTruncateExisting:       // open the file if it exists, and truncate it if so.
                 nOpenFlags |= O_TRUNC;
                 break;
+
+            case kCDReplaceAtomic:          // Not supported; see EAIO_REPLACE_ATOMIC_ENABLED.
+                mnLastError = kStateError;
+                return false;
         }
 
         mnFileHandle = open(mPath8.c_str(), nOpenFlags);
@@ -428,6 +432,57 @@ bool FileStream::Write(const void* pData, size_type nSize)
 }
 
 
+bool FileStream::Commit()
+{
+    return close();
+}
+
+
+bool FileStream::Discard()
+{
+    close();
+    return false;
+}
+
+
+void FileStream::setOption(int /*option*/, int /*value*/)
+{
+}
+
+
+bool FileStream::Prefetch(size_type /*nPosition*/, size_type /*nSize*/)
+{
+    return (GetAccessFlags() != 0);
+}
+
+
+bool FileStream::Preallocate(size_type /*nPosition*/, size_type /*nSize*/, bool /*bKeepSize*/)
+{
+    return false;
+}
+
+
+bool FileStream::PunchHole(size_type /*nPosition*/, size_type /*nSize*/)
+{
+    return false;
+}
+
+
+bool FileStream::FindData(size_type nPosition, size_type& nDataBegin, size_type& nDataEnd) const
+{
+    const size_type nSize = getSize();
+
+    if((nSize != kSizeTypeError) && (nPosition < nSize))
+    {
+        nDataBegin = nPosition;
+        nDataEnd   = nSize;
+        return true;
+    }
+
+    return false;
+}
+
+
 bool FileStream::Flush()
 {
     if(mnFileHandle != kFileHandleInvalid)
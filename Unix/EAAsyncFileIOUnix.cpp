@@ -0,0 +1,836 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAAsyncFileIOUnix.cpp
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Provides an asynchronous file read/write request queue for Linux.
+// The io_uring backend talks to the kernel directly via system calls and
+// its shared ring buffers, so there is no dependency on liburing.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAAsyncFileIO.h>
+#include <eaio/Allocator.h>
+#include <new>
+#include EA_ASSERT_HEADER
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#if EAIO_IO_URING_ENABLED
+    #include <sys/syscall.h>
+    #include <linux/io_uring.h>
+
+    #if !defined(__NR_io_uring_setup) || !defined(__NR_io_uring_enter)
+        #undef  EAIO_IO_URING_ENABLED
+        #define EAIO_IO_URING_ENABLED 0
+    #endif
+#endif
+
+#if EAIO_THREAD_SAFETY_ENABLED
+    #include <eathread/eathread_thread.h>
+    #include <eathread/eathread_mutex.h>
+    #include <eathread/eathread_condition.h>
+#endif
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncIORequest
+///////////////////////////////////////////////////////////////////////////////
+
+AsyncIORequest::AsyncIORequest()
+  : mpFileStream(NULL),
+    mOperation(kOperationRead),
+    mnPosition(0),
+    mpData(NULL),
+    mnSize(0),
+    mpCallback(NULL),
+    mpCallbackContext(NULL),
+    mStatus(kStatusNone),
+    mnResult(0),
+    mnError(0),
+    mpNext(NULL)
+{
+    mIOVec.iov_base = NULL;
+    mIOVec.iov_len  = 0;
+}
+
+
+void AsyncIORequest::SetRead(FileStream* pFileStream, size_type nPosition, void* pData, size_type nSize, 
+                             CompletionCallback pCallback, void* pCallbackContext)
+{
+    EA_ASSERT(mStatus != kStatusPending);
+
+    mpFileStream      = pFileStream;
+    mOperation        = kOperationRead;
+    mnPosition        = nPosition;
+    mpData            = pData;
+    mnSize            = nSize;
+    mpCallback        = pCallback;
+    mpCallbackContext = pCallbackContext;
+}
+
+
+void AsyncIORequest::SetWrite(FileStream* pFileStream, size_type nPosition, const void* pData, size_type nSize, 
+                              CompletionCallback pCallback, void* pCallbackContext)
+{
+    EA_ASSERT(mStatus != kStatusPending);
+
+    mpFileStream      = pFileStream;
+    mOperation        = kOperationWrite;
+    mnPosition        = nPosition;
+    mpData            = const_cast<void*>(pData); // The data is only read from for a write operation.
+    mnSize            = nSize;
+    mpCallback        = pCallback;
+    mpCallbackContext = pCallbackContext;
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ThreadPool
+///////////////////////////////////////////////////////////////////////////////
+
+// The worker threads of the thread pool backend, and the queues they share 
+// with the AsyncFileIO, which are guarded by mMutex.
+#if EAIO_THREAD_SAFETY_ENABLED
+    struct AsyncFileIO::ThreadPool
+    {
+        EA::Thread::Mutex     mMutex;
+        EA::Thread::Condition mWorkCondition;       /// Signaled when work is queued or upon shutdown.
+        EA::Thread::Condition mDoneCondition;       /// Signaled when a request is done.
+        EA::Thread::Thread*   mpThreadArray;        /// Its first mnThreadCount elements are constructed.
+        unsigned              mnThreadCapacity;     /// Number of elements allocated for mpThreadArray.
+        unsigned              mnThreadCount;        /// Number of threads started.
+        bool                  mbShutdown;
+        AsyncIORequest*       mpWorkHead;           /// Requests waiting for a worker thread.
+        AsyncIORequest*       mpWorkTail;
+        AsyncIORequest*       mpDoneHead;           /// Requests finished by worker threads but not yet reaped.
+        AsyncIORequest*       mpDoneTail;
+
+        ThreadPool()
+          : mMutex(), mWorkCondition(), mDoneCondition(), mpThreadArray(NULL), mnThreadCapacity(0), mnThreadCount(0),
+            mbShutdown(false), mpWorkHead(NULL), mpWorkTail(NULL), mpDoneHead(NULL), mpDoneTail(NULL) { }
+    };
+#else
+    struct AsyncFileIO::ThreadPool { };
+#endif
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncFileIO
+///////////////////////////////////////////////////////////////////////////////
+
+AsyncFileIO::AsyncFileIO()
+  : mBackend(kBackendNone),
+    mnQueueDepth(0),
+    mnPendingCount(0),
+    mnInFlightCount(0),
+    mpQueueHead(NULL),
+    mpQueueTail(NULL),
+    mnRingFD(-1),
+    mpSQRing(NULL),
+    mnSQRingSize(0),
+    mpCQRing(NULL),
+    mnCQRingSize(0),
+    mpSQEArray(NULL),
+    mnSQEArraySize(0),
+    mpSQHead(NULL),
+    mpSQTail(NULL),
+    mpSQIndexArray(NULL),
+    mnSQMask(0),
+    mnSQEntries(0),
+    mnSQUnsubmitted(0),
+    mpCQHead(NULL),
+    mpCQTail(NULL),
+    mpCQEArray(NULL),
+    mnCQMask(0),
+    mpThreadPool(NULL)
+{
+}
+
+
+AsyncFileIO::~AsyncFileIO()
+{
+    AsyncFileIO::Shutdown();
+}
+
+
+bool AsyncFileIO::Init(unsigned nQueueDepth, unsigned nThreadCount, bool bAllowIOUring)
+{
+    if(mBackend == kBackendNone)
+    {
+        mnQueueDepth = nQueueDepth ? nQueueDepth : (unsigned)kQueueDepthDefault;
+
+        if(bAllowIOUring && InitIOUring(mnQueueDepth))
+            mBackend = kBackendIOUring;
+        else if(InitThreadPool(nThreadCount ? nThreadCount : (unsigned)kThreadCountDefault))
+            mBackend = kBackendThreadPool;
+        else
+            mBackend = kBackendSynchronous;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+void AsyncFileIO::Shutdown()
+{
+    if(mBackend != kBackendNone)
+    {
+        while(mnPendingCount)
+            Wait(mnPendingCount);
+
+        if(mBackend == kBackendIOUring)
+            ShutdownIOUring();
+        else
+            ShutdownThreadPool();
+
+        mBackend = kBackendNone;
+    }
+}
+
+
+bool AsyncFileIO::Submit(AsyncIORequest* pRequest)
+{
+    return Submit(&pRequest, 1);
+}
+
+
+bool AsyncFileIO::Submit(AsyncIORequest** pRequestArray, size_t nRequestCount)
+{
+    bool bResult = true;
+
+    for(size_t i = 0; i < nRequestCount; i++)
+    {
+        AsyncIORequest* const pRequest = pRequestArray[i];
+
+        EA_ASSERT(pRequest->mStatus != AsyncIORequest::kStatusPending);
+
+        pRequest->mnResult = 0;
+        pRequest->mnError  = 0;
+        pRequest->mpNext   = NULL;
+
+        if(mBackend == kBackendNone)
+            pRequest->mnError = EINVAL;
+        else if(!pRequest->mpFileStream || (pRequest->mpFileStream->GetFileHandle() == -1))
+            pRequest->mnError = EBADF;
+
+        if(pRequest->mnError)
+        {
+            pRequest->mnResult = kSizeTypeError;
+            pRequest->mStatus  = AsyncIORequest::kStatusNone;
+            bResult = false;
+        }
+        else
+        {
+            pRequest->mStatus = AsyncIORequest::kStatusPending;
+
+            if(mpQueueTail)
+                mpQueueTail->mpNext = pRequest;
+            else
+                mpQueueHead = pRequest;
+            mpQueueTail = pRequest;
+
+            mnPendingCount++;
+        }
+    }
+
+    StartQueuedRequests(false); // With io_uring, the system call is deferred until Flush, Poll or Wait, so that it covers many submissions.
+
+    return bResult;
+}
+
+
+void AsyncFileIO::Flush()
+{
+    StartQueuedRequests(true);
+}
+
+
+size_t AsyncFileIO::Poll()
+{
+    size_t nCount = 0;
+
+    if(mnPendingCount)
+    {
+        StartQueuedRequests(true);
+        nCount = ReapCompletions(false);
+        StartQueuedRequests(true);
+    }
+
+    return nCount;
+}
+
+
+size_t AsyncFileIO::Wait(size_t nMinCompletions)
+{
+    size_t nCount = 0;
+
+    StartQueuedRequests(true);
+
+    while(mnPendingCount)
+    {
+        nCount += ReapCompletions(nCount < nMinCompletions);
+        StartQueuedRequests(true);
+
+        if(nCount >= nMinCompletions)
+            break;
+    }
+
+    return nCount;
+}
+
+
+// Accounts for the result of a single read or write system call made on behalf
+// of the request. nResult is the byte count, or -errno upon error. Returns true
+// if the request is finished, or false if the remainder of the transfer needs
+// to be issued, as happens when a transfer is short or interrupted.
+bool AsyncFileIO::CompleteTransfer(AsyncIORequest* pRequest, ssize_t nResult)
+{
+    if(nResult < 0)
+    {
+        if((nResult == -EINTR) || (nResult == -EAGAIN))
+            return false;
+
+        pRequest->mnError = (int)-nResult;
+        return true;
+    }
+
+    pRequest->mnResult += (size_type)nResult;
+
+    if(pRequest->mnResult >= pRequest->mnSize)
+        return true;
+
+    if(nResult == 0) // If no progress was made...
+    {
+        if(pRequest->mOperation == AsyncIORequest::kOperationWrite)
+            pRequest->mnError = EIO;
+        return true; // For a read, this is the end of the file.
+    }
+
+    return false;
+}
+
+
+void AsyncFileIO::CompleteRequest(AsyncIORequest* pRequest)
+{
+    if(pRequest->mnError)
+        pRequest->mnResult = kSizeTypeError;
+
+    pRequest->mStatus = AsyncIORequest::kStatusComplete;
+    mnPendingCount--;
+
+    if(pRequest->mpCallback)
+        pRequest->mpCallback(pRequest, pRequest->mpCallbackContext); // The callback may resubmit the request or submit others.
+}
+
+
+void AsyncFileIO::ExecuteRequest(AsyncIORequest* pRequest)
+{
+    const int fileHandle = pRequest->mpFileStream->GetFileHandle();
+    ssize_t   nResult;
+
+    do {
+        char* const     pData      = (char*)pRequest->mpData + pRequest->mnResult;
+        const size_type nRemaining = pRequest->mnSize - pRequest->mnResult;
+        const off_t     position   = (off_t)(pRequest->mnPosition + pRequest->mnResult);
+
+        if(pRequest->mOperation == AsyncIORequest::kOperationRead)
+            nResult = pread(fileHandle, pData, nRemaining, position);
+        else
+            nResult = pwrite(fileHandle, pData, nRemaining, position);
+
+        if(nResult < 0)
+            nResult = -errno;
+    } while(!CompleteTransfer(pRequest, nResult));
+}
+
+
+// Hands queued requests to the backend, up to the queue depth. With io_uring, 
+// the requests are written to the submission ring, and if bSubmit is true then
+// everything written to it since the last submission is passed to the kernel
+// with a single system call.
+void AsyncFileIO::StartQueuedRequests(bool bSubmit)
+{
+    if(!mpQueueHead && !mnSQUnsubmitted)
+        return;
+
+    #if EAIO_IO_URING_ENABLED
+        if(mBackend == kBackendIOUring)
+        {
+            while(mpQueueHead && (mnInFlightCount < mnQueueDepth))
+            {
+                const unsigned nHead = __atomic_load_n(mpSQHead, __ATOMIC_ACQUIRE);
+                const unsigned nTail = *mpSQTail; // We are the only writer of the tail.
+
+                if((nTail - nHead) >= mnSQEntries)
+                    break;
+
+                AsyncIORequest* const pRequest = mpQueueHead;
+                mpQueueHead = pRequest->mpNext;
+                if(!mpQueueHead)
+                    mpQueueTail = NULL;
+                pRequest->mpNext = NULL;
+
+                pRequest->mIOVec.iov_base = (char*)pRequest->mpData + pRequest->mnResult;
+                pRequest->mIOVec.iov_len  = (size_t)(pRequest->mnSize - pRequest->mnResult);
+
+                const unsigned nIndex = (nTail & mnSQMask);
+                io_uring_sqe*  pSQE   = &mpSQEArray[nIndex];
+
+                memset(pSQE, 0, sizeof(*pSQE));
+                pSQE->opcode    = (pRequest->mOperation == AsyncIORequest::kOperationRead) ? IORING_OP_READV : IORING_OP_WRITEV;
+                pSQE->fd        = pRequest->mpFileStream->GetFileHandle();
+                pSQE->off       = (uint64_t)(pRequest->mnPosition + pRequest->mnResult);
+                pSQE->addr      = (uint64_t)(uintptr_t)&pRequest->mIOVec;
+                pSQE->len       = 1;
+                pSQE->user_data = (uint64_t)(uintptr_t)pRequest;
+
+                mpSQIndexArray[nIndex] = nIndex;
+                __atomic_store_n(mpSQTail, nTail + 1, __ATOMIC_RELEASE);
+
+                mnInFlightCount++;
+                mnSQUnsubmitted++;
+            }
+
+            if(bSubmit && mnSQUnsubmitted)
+            {
+                const int nSubmitted = (int)syscall(__NR_io_uring_enter, mnRingFD, mnSQUnsubmitted, 0, 0, NULL, 0);
+
+                if(nSubmitted > 0) // Upon failure (e.g. EAGAIN, EBUSY), we try again on the next call.
+                    mnSQUnsubmitted -= (unsigned)nSubmitted;
+            }
+
+            return;
+        }
+    #endif
+
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(mBackend == kBackendThreadPool)
+        {
+            ThreadPool* const pPool = mpThreadPool;
+
+            pPool->mMutex.Lock();
+
+            while(mpQueueHead && (mnInFlightCount < mnQueueDepth))
+            {
+                AsyncIORequest* const pRequest = mpQueueHead;
+                mpQueueHead = pRequest->mpNext;
+                if(!mpQueueHead)
+                    mpQueueTail = NULL;
+                pRequest->mpNext = NULL;
+
+                if(pPool->mpWorkTail)
+                    pPool->mpWorkTail->mpNext = pRequest;
+                else
+                    pPool->mpWorkHead = pRequest;
+                pPool->mpWorkTail = pRequest;
+
+                mnInFlightCount++;
+                pPool->mWorkCondition.Signal();
+            }
+
+            pPool->mMutex.Unlock();
+        }
+    #endif
+
+    // With kBackendSynchronous, requests stay queued until ReapCompletions executes them.
+    (void)bSubmit;
+}
+
+
+// Returns the number of requests which completed. If bBlock is true then this
+// blocks until at least one system call finishes, though that isn't necessarily
+// the completion of a request, as a short transfer is requeued for the remainder.
+size_t AsyncFileIO::ReapCompletions(bool bBlock)
+{
+    size_t nCount = 0;
+
+    #if EAIO_IO_URING_ENABLED
+        if(mBackend == kBackendIOUring)
+        {
+            unsigned nHead = *mpCQHead; // We are the only writer of the head.
+            unsigned nTail = __atomic_load_n(mpCQTail, __ATOMIC_ACQUIRE);
+
+            if(bBlock && (nHead == nTail) && mnInFlightCount)
+            {
+                // This also submits anything unsubmitted, and returns the number submitted.
+                const int nSubmitted = (int)syscall(__NR_io_uring_enter, mnRingFD, mnSQUnsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+                if(nSubmitted > 0)
+                    mnSQUnsubmitted -= (unsigned)nSubmitted;
+                nTail = __atomic_load_n(mpCQTail, __ATOMIC_ACQUIRE);
+            }
+
+            while(nHead != nTail)
+            {
+                const io_uring_cqe*   pCQE     = &mpCQEArray[nHead & mnCQMask];
+                AsyncIORequest* const pRequest = (AsyncIORequest*)(uintptr_t)pCQE->user_data;
+                const ssize_t         nResult  = pCQE->res;
+
+                // Release the CQE before doing anything which could call back into us.
+                __atomic_store_n(mpCQHead, ++nHead, __ATOMIC_RELEASE);
+                mnInFlightCount--;
+
+                if(CompleteTransfer(pRequest, nResult))
+                {
+                    CompleteRequest(pRequest);
+                    nCount++;
+                }
+                else
+                {
+                    pRequest->mpNext = mpQueueHead; // Issue the remainder ahead of everything else.
+                    mpQueueHead = pRequest;
+                    if(!mpQueueTail)
+                        mpQueueTail = pRequest;
+                }
+            }
+
+            return nCount;
+        }
+    #endif
+
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(mBackend == kBackendThreadPool)
+        {
+            ThreadPool* const pPool = mpThreadPool;
+
+            pPool->mMutex.Lock();
+
+            if(bBlock)
+            {
+                while(!pPool->mpDoneHead && mnInFlightCount)
+                    pPool->mDoneCondition.Wait(&pPool->mMutex);
+            }
+
+            AsyncIORequest* pRequest = pPool->mpDoneHead;
+            pPool->mpDoneHead = pPool->mpDoneTail = NULL;
+
+            pPool->mMutex.Unlock();
+
+            while(pRequest)
+            {
+                AsyncIORequest* const pNext = pRequest->mpNext;
+
+                pRequest->mpNext = NULL;
+                mnInFlightCount--;   // Worker threads never access this, so the mutex isn't needed.
+                CompleteRequest(pRequest);
+                nCount++;
+
+                pRequest = pNext;
+            }
+
+            return nCount;
+        }
+    #endif
+
+    if(mBackend == kBackendSynchronous)
+    {
+        // Requests which completion callbacks submit are left for the next call.
+        AsyncIORequest* pRequest = mpQueueHead;
+        mpQueueHead = mpQueueTail = NULL;
+
+        while(pRequest)
+        {
+            AsyncIORequest* const pNext = pRequest->mpNext;
+
+            pRequest->mpNext = NULL;
+            ExecuteRequest(pRequest);
+            CompleteRequest(pRequest);
+            nCount++;
+
+            pRequest = pNext;
+        }
+    }
+
+    return nCount;
+}
+
+
+bool AsyncFileIO::InitIOUring(unsigned nQueueDepth)
+{
+    #if EAIO_IO_URING_ENABLED
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        mnRingFD = (int)syscall(__NR_io_uring_setup, nQueueDepth, &params);
+
+        if(mnRingFD < 0) // This is expected on kernels prior to 5.1 or where io_uring is disabled.
+        {
+            mnRingFD = -1;
+            return false;
+        }
+
+        mnSQRingSize   = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+        mnCQRingSize   = params.cq_off.cqes  + (params.cq_entries * sizeof(io_uring_cqe));
+        mnSQEArraySize = params.sq_entries * sizeof(io_uring_sqe);
+
+        const bool bSingleMap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+
+        if(bSingleMap) // The SQ and CQ rings share a single mapping.
+        {
+            if(mnCQRingSize > mnSQRingSize)
+                mnSQRingSize = mnCQRingSize;
+            mnCQRingSize = mnSQRingSize;
+        }
+
+        mpSQRing = mmap(NULL, mnSQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mnRingFD, IORING_OFF_SQ_RING);
+        if(mpSQRing == MAP_FAILED)
+            mpSQRing = NULL;
+
+        if(mpSQRing)
+        {
+            if(bSingleMap)
+                mpCQRing = mpSQRing;
+            else
+            {
+                mpCQRing = mmap(NULL, mnCQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mnRingFD, IORING_OFF_CQ_RING);
+                if(mpCQRing == MAP_FAILED)
+                    mpCQRing = NULL;
+            }
+        }
+
+        if(mpCQRing)
+        {
+            mpSQEArray = (io_uring_sqe*)mmap(NULL, mnSQEArraySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mnRingFD, IORING_OFF_SQES);
+            if(mpSQEArray == MAP_FAILED)
+                mpSQEArray = NULL;
+        }
+
+        if(!mpSQEArray)
+        {
+            ShutdownIOUring();
+            return false;
+        }
+
+        char* const pSQ = (char*)mpSQRing;
+        char* const pCQ = (char*)mpCQRing;
+
+        mpSQHead        = (unsigned*)(pSQ + params.sq_off.head);
+        mpSQTail        = (unsigned*)(pSQ + params.sq_off.tail);
+        mpSQIndexArray  = (unsigned*)(pSQ + params.sq_off.array);
+        mnSQMask        = *(unsigned*)(pSQ + params.sq_off.ring_mask);
+        mnSQEntries     = params.sq_entries;
+        mnSQUnsubmitted = 0;
+
+        mpCQHead        = (unsigned*)(pCQ + params.cq_off.head);
+        mpCQTail        = (unsigned*)(pCQ + params.cq_off.tail);
+        mpCQEArray      = (io_uring_cqe*)(pCQ + params.cq_off.cqes);
+        mnCQMask        = *(unsigned*)(pCQ + params.cq_off.ring_mask);
+
+        // The CQ ring is at least as large as the SQ ring, so limiting the number of 
+        // requests in flight to the SQ size means the CQ ring can never overflow.
+        if(mnQueueDepth > mnSQEntries)
+            mnQueueDepth = mnSQEntries;
+
+        return true;
+    #else
+        (void)nQueueDepth;
+        return false;
+    #endif
+}
+
+
+void AsyncFileIO::ShutdownIOUring()
+{
+    if(mpSQEArray)
+        munmap(mpSQEArray, mnSQEArraySize);
+    if(mpCQRing && (mpCQRing != mpSQRing))
+        munmap(mpCQRing, mnCQRingSize);
+    if(mpSQRing)
+        munmap(mpSQRing, mnSQRingSize);
+    if(mnRingFD != -1)
+        ::close(mnRingFD);
+
+    mnRingFD   = -1;
+    mpSQRing   = NULL;
+    mpCQRing   = NULL;
+    mpSQEArray = NULL;
+    mpSQHead   = mpSQTail = mpSQIndexArray = NULL;
+    mpCQHead   = mpCQTail = NULL;
+    mpCQEArray = NULL;
+}
+
+
+bool AsyncFileIO::InitThreadPool(unsigned nThreadCount)
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        Allocator::ICoreAllocator* const pAllocator   = IO::getAllocator();
+        void* const                      pPoolMemory  = pAllocator->alloc(sizeof(ThreadPool), EAIO_ALLOC_PREFIX "AsyncFileIO", 0);
+        void* const                      pThreadArray = pAllocator->alloc(nThreadCount * sizeof(EA::Thread::Thread), EAIO_ALLOC_PREFIX "AsyncFileIO", 0);
+
+        if(pPoolMemory && pThreadArray)
+        {
+            mpThreadPool = new(pPoolMemory) ThreadPool;
+            mpThreadPool->mpThreadArray    = (EA::Thread::Thread*)pThreadArray;
+            mpThreadPool->mnThreadCapacity = nThreadCount;
+
+            // Each thread object is constructed only when it's about to be started, so that
+            // ShutdownThreadPool destroys exactly those which were started.
+            while(mpThreadPool->mnThreadCount < nThreadCount)
+            {
+                EA::Thread::Thread* const pThread = new(&mpThreadPool->mpThreadArray[mpThreadPool->mnThreadCount]) EA::Thread::Thread;
+
+                if(pThread->Begin(ThreadFunction, this) == EA::Thread::kThreadIdInvalid)
+                {
+                    pThread->~Thread();
+                    break;
+                }
+
+                mpThreadPool->mnThreadCount++;
+            }
+
+            if(mpThreadPool->mnThreadCount)
+                return true;
+
+            ShutdownThreadPool();
+        }
+        else
+        {
+            if(pThreadArray)
+                pAllocator->free(pThreadArray, nThreadCount * sizeof(EA::Thread::Thread));
+            if(pPoolMemory)
+                pAllocator->free(pPoolMemory, sizeof(ThreadPool));
+        }
+    #else
+        (void)nThreadCount;
+    #endif
+
+    return false;
+}
+
+
+void AsyncFileIO::ShutdownThreadPool()
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        if(mpThreadPool)
+        {
+            ThreadPool* const pPool = mpThreadPool;
+
+            pPool->mMutex.Lock();
+            pPool->mbShutdown = true;
+            pPool->mWorkCondition.Signal(true);
+            pPool->mMutex.Unlock();
+
+            for(unsigned i = pPool->mnThreadCount; i > 0; i--)
+            {
+                EA::Thread::Thread& thread = pPool->mpThreadArray[i - 1];
+
+                thread.WaitForEnd();
+                thread.~Thread();
+            }
+
+            Allocator::ICoreAllocator* const pAllocator = IO::getAllocator();
+
+            pAllocator->free(pPool->mpThreadArray, pPool->mnThreadCapacity * sizeof(EA::Thread::Thread));
+            pPool->~ThreadPool();
+            pAllocator->free(pPool, sizeof(ThreadPool));
+            mpThreadPool = NULL;
+        }
+    #endif
+}
+
+
+intptr_t AsyncFileIO::ThreadFunction(void* pContext)
+{
+    #if EAIO_THREAD_SAFETY_ENABLED
+        AsyncFileIO* const pAsyncFileIO = (AsyncFileIO*)pContext;
+        ThreadPool* const  pPool        = pAsyncFileIO->mpThreadPool;
+
+        pPool->mMutex.Lock();
+
+        for(;;)
+        {
+            while(!pPool->mpWorkHead && !pPool->mbShutdown)
+                pPool->mWorkCondition.Wait(&pPool->mMutex);
+
+            AsyncIORequest* const pRequest = pPool->mpWorkHead;
+
+            if(!pRequest) // If shutting down...
+                break;
+
+            pPool->mpWorkHead = pRequest->mpNext;
+            if(!pPool->mpWorkHead)
+                pPool->mpWorkTail = NULL;
+            pRequest->mpNext = NULL;
+
+            pPool->mMutex.Unlock();
+            pAsyncFileIO->ExecuteRequest(pRequest);
+            pPool->mMutex.Lock();
+
+            if(pPool->mpDoneTail)
+                pPool->mpDoneTail->mpNext = pRequest;
+            else
+                pPool->mpDoneHead = pRequest;
+            pPool->mpDoneTail = pRequest;
+
+            pPool->mDoneCondition.Signal();
+        }
+
+        pPool->mMutex.Unlock();
+    #else
+        (void)pContext;
+    #endif
+
+    return 0;
+}
+
+
+} // namespace IO
+
+} // namespace EA
+
+
+
+
+
+
+
+
+
+
@@ -0,0 +1,282 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAAsyncFileIOUnix.h
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Implements an asynchronous read/write request queue for FileStream, 
+// based on io_uring where available and on a thread pool otherwise.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EAASYNCFILEIO_UNIX_H
+#define EAIO_EAASYNCFILEIO_UNIX_H
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAFileStream.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// struct AsyncIORequest
+        ///
+        /// Describes a single positional read or write against an open FileStream.
+        /// The user owns the request memory and fills in the input fields before
+        /// calling AsyncFileIO::Submit. The request and the data buffer it refers
+        /// to must remain valid and untouched until the request is complete.
+        /// A request can be reused (resubmitted) once it is complete, including
+        /// from within its completion callback.
+        ///
+        /// A request doesn't use or change the position of its FileStream, so any 
+        /// number of requests may be outstanding against the same stream at once.
+        ///
+        struct EAIO_API AsyncIORequest
+        {
+            enum Operation
+            {
+                kOperationRead,
+                kOperationWrite
+            };
+
+            enum Status
+            {
+                kStatusNone,        /// The request hasn't been submitted.
+                kStatusPending,     /// The request is queued or in progress.
+                kStatusComplete     /// The request has completed; see mnResult and mnError.
+            };
+
+            typedef void (*CompletionCallback)(AsyncIORequest* pRequest, void* pContext);
+
+            AsyncIORequest();
+
+            /// Sets the input fields for a read of nSize bytes at nPosition into pData.
+            void SetRead(FileStream* pFileStream, size_type nPosition, void* pData, size_type nSize, 
+                         CompletionCallback pCallback = NULL, void* pCallbackContext = NULL);
+
+            /// Sets the input fields for a write of nSize bytes at nPosition from pData.
+            void SetWrite(FileStream* pFileStream, size_type nPosition, const void* pData, size_type nSize, 
+                          CompletionCallback pCallback = NULL, void* pCallbackContext = NULL);
+
+            bool IsComplete() const { return (mStatus == kStatusComplete); }
+
+            // Input, set by the user.
+            FileStream*        mpFileStream;        /// The stream to read from or write to. It must be open.
+            Operation          mOperation;          /// See enum Operation.
+            size_type          mnPosition;          /// File position to read from or write to.
+            void*              mpData;              /// Source or destination buffer.
+            size_type          mnSize;              /// Number of bytes to read or write.
+            CompletionCallback mpCallback;          /// Optional; called from AsyncFileIO::Poll or Wait upon completion.
+            void*              mpCallbackContext;   /// Passed to mpCallback.
+
+            // Output, set by AsyncFileIO.
+            int                mStatus;             /// See enum Status.
+            size_type          mnResult;            /// Bytes transferred, or kSizeTypeError upon error. A read may transfer less than mnSize if it reaches the end of the file.
+            int                mnError;             /// errno value upon error, else 0.
+
+            // Internal, used by AsyncFileIO.
+            AsyncIORequest*    mpNext;
+            struct iovec       mIOVec;
+        };
+
+
+
+        /// class AsyncFileIO
+        ///
+        /// Executes AsyncIORequests with up to a given number of requests in flight
+        /// at once. Loading thousands of small files through FileStream::Read is 
+        /// strictly sequential, whereas having many reads outstanding lets the 
+        /// storage device and kernel overlap and reorder them.
+        ///
+        /// The io_uring backend batches all requests submitted between calls to
+        /// Flush, Poll or Wait into a single system call. If io_uring isn't available 
+        /// (older kernel, seccomp filter, EAIO_IO_URING_ENABLED = 0), a pool of 
+        /// worker threads executing pread/pwrite is used instead. That requires
+        /// EAIO_THREAD_SAFETY_ENABLED; without it, requests are executed one at a 
+        /// time on the calling thread within Poll and Wait. All backends behave 
+        /// identically from the user's point of view, other than in performance.
+        ///
+        /// This class is not thread-safe: Submit, Poll and Wait are expected to be
+        /// called from a single thread, and completion callbacks are called from 
+        /// that thread within Poll and Wait.
+        ///
+        /// Example usage:
+        ///     AsyncFileIO    asyncIO;
+        ///     AsyncIORequest requests[kAssetCount];
+        ///
+        ///     asyncIO.Init();
+        ///
+        ///     for(int i = 0; i < kAssetCount; i++)
+        ///     {
+        ///         requests[i].SetRead(&packStream, assets[i].mnOffset, assets[i].mpBuffer, assets[i].mnSize, OnAssetLoaded, &assets[i]);
+        ///         asyncIO.Submit(&requests[i]);
+        ///     }
+        ///
+        ///     while(asyncIO.GetPendingCount())
+        ///         asyncIO.Wait();
+        ///
+        ///     asyncIO.Shutdown();
+        ///
+        class EAIO_API AsyncFileIO
+        {
+        public:
+            enum Backend
+            {
+                kBackendNone,           /// Not initialized.
+                kBackendIOUring,        /// Linux io_uring.
+                kBackendThreadPool,     /// Worker threads executing pread/pwrite.
+                kBackendSynchronous     /// pread/pwrite on the calling thread, within Poll and Wait.
+            };
+
+            enum
+            {
+                kQueueDepthDefault  = 64,
+                kThreadCountDefault = 4
+            };
+
+            AsyncFileIO();
+           ~AsyncFileIO();
+
+            /// Init
+            /// nQueueDepth is the maximum number of requests in flight at once; further
+            /// submitted requests wait in a queue. nThreadCount is the number of worker 
+            /// threads used by the thread pool backend. bAllowIOUring can be set to false 
+            /// to force the thread pool backend, or the synchronous backend where the 
+            /// thread pool is unavailable. Returns false if already initialized.
+            bool    Init(unsigned nQueueDepth = kQueueDepthDefault, unsigned nThreadCount = kThreadCountDefault, bool bAllowIOUring = true);
+
+            /// Shutdown
+            /// Waits for all outstanding requests to complete, then releases all resources.
+            void    Shutdown();
+
+            Backend GetBackend() const { return mBackend; }
+
+            /// Submit
+            /// Queues the request for execution. Returns false if the request can't be 
+            /// submitted, in which case its mnError is set. The request isn't guaranteed 
+            /// to be started until the next call to Flush, Poll or Wait.
+            bool    Submit(AsyncIORequest* pRequest);
+            bool    Submit(AsyncIORequest** pRequestArray, size_t nRequestCount);
+
+            /// Flush
+            /// Starts the submitted requests, up to the queue depth, without waiting 
+            /// for any to complete. With io_uring, this is a single system call for 
+            /// all requests submitted since the last Flush, Poll or Wait.
+            void    Flush();
+
+            /// Poll
+            /// Processes any completed requests without blocking and starts queued ones.
+            /// Returns the number of requests which completed.
+            size_t  Poll();
+
+            /// Wait
+            /// Blocks until at least nMinCompletions requests have completed or no more
+            /// requests are pending. Returns the number of requests which completed.
+            size_t  Wait(size_t nMinCompletions = 1);
+
+            /// Returns the number of submitted requests which have not yet completed.
+            size_t  GetPendingCount() const { return mnPendingCount; }
+
+        protected:
+            struct ThreadPool;
+
+            static intptr_t ThreadFunction(void* pContext);
+
+            bool    InitIOUring(unsigned nQueueDepth);
+            void    ShutdownIOUring();
+            bool    InitThreadPool(unsigned nThreadCount);
+            void    ShutdownThreadPool();
+
+            void    StartQueuedRequests(bool bSubmit);
+            size_t  ReapCompletions(bool bBlock);
+            bool    CompleteTransfer(AsyncIORequest* pRequest, ssize_t nResult);
+            void    CompleteRequest(AsyncIORequest* pRequest);
+            void    ExecuteRequest(AsyncIORequest* pRequest);
+
+        protected:
+            AsyncFileIO(const AsyncFileIO&);
+            AsyncFileIO& operator=(const AsyncFileIO&);
+
+            Backend           mBackend;
+            unsigned          mnQueueDepth;         /// Max number of requests in flight.
+            size_t            mnPendingCount;       /// Requests submitted but not completed.
+            size_t            mnInFlightCount;      /// Requests handed to the backend but not completed.
+            AsyncIORequest*   mpQueueHead;          /// Requests waiting for a free slot.
+            AsyncIORequest*   mpQueueTail;
+
+            // io_uring backend
+            int               mnRingFD;
+            void*             mpSQRing;
+            size_t            mnSQRingSize;
+            void*             mpCQRing;
+            size_t            mnCQRingSize;
+            io_uring_sqe*     mpSQEArray;
+            size_t            mnSQEArraySize;
+            unsigned*         mpSQHead;
+            unsigned*         mpSQTail;
+            unsigned*         mpSQIndexArray;
+            unsigned          mnSQMask;
+            unsigned          mnSQEntries;
+            unsigned          mnSQUnsubmitted;      /// SQEs written but not yet passed to io_uring_enter.
+            unsigned*         mpCQHead;
+            unsigned*         mpCQTail;
+            io_uring_cqe*     mpCQEArray;
+            unsigned          mnCQMask;
+
+            // Thread pool backend
+            ThreadPool*       mpThreadPool;         /// The worker threads and their queues. Used only with EAIO_THREAD_SAFETY_ENABLED.
+
+        }; // class AsyncFileIO
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif  // #ifndef EAIO_EAASYNCFILEIO_UNIX_H
+
+
+
+
+
+
+
+
+
+
@@ -0,0 +1,831 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EADirectFileStreamUnix.cpp
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Provides an unbuffered (O_DIRECT) file stream for Linux.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EADirectFileStream.h>
+#include <eaio/Allocator.h>
+#include <eaio/FnEncode.h>
+#include EA_ASSERT_HEADER
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if EAIO_THREAD_SAFETY_ENABLED
+    #include <eathread/eathread_futex.h>
+#endif
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+
+const int kFileHandleInvalid = -1;
+
+
+namespace DirectFileStreamLocal
+{
+    // Opening and closing many direct streams in succession (e.g. when 
+    // streaming through a directory of files) would otherwise allocate and 
+    // free a megabyte of aligned memory per file. We keep a small free list 
+    // of buffers which is shared by all DirectFileStream instances. The list 
+    // is guarded only if thread safety is enabled.
+    const size_t kPoolCapacity   = 8;
+    const size_t kBufferCapacity = (size_t)DirectFileStream::kBufferSize + (size_t)DirectFileStream::kAlignment; // The extra block is scratch space for FlushBuffer.
+
+    uint8_t* gPool[kPoolCapacity];
+    size_t   gPoolCount = 0;
+
+
+    #if EAIO_THREAD_SAFETY_ENABLED
+        typedef EA::Thread::AutoFutex AutoLock;
+
+        // The futex is constructed upon first use, so that streams may be opened during static initialization.
+        EA::Thread::Futex& GetPoolFutex()
+        {
+            static EA::Thread::Futex sPoolFutex;
+            return sPoolFutex;
+        }
+    #else
+        struct AutoLock { AutoLock(int) { } };
+
+        inline int GetPoolFutex()
+        {
+            return 0;
+        }
+    #endif
+
+
+    uint8_t* AcquireBuffer()
+    {
+        uint8_t* pBuffer = NULL;
+
+        {
+            AutoLock autoLock(GetPoolFutex());
+            if(gPoolCount)
+                pBuffer = gPool[--gPoolCount];
+        }
+
+        if(!pBuffer)
+            pBuffer = (uint8_t*)IO::getAllocator()->alloc(kBufferCapacity, EAIO_ALLOC_PREFIX "DirectFileStream", 0, DirectFileStream::kAlignment);
+
+        return pBuffer;
+    }
+
+
+    void ReleaseBuffer(uint8_t* pBuffer)
+    {
+        {
+            AutoLock autoLock(GetPoolFutex());
+            if(gPoolCount < kPoolCapacity)
+            {
+                gPool[gPoolCount++] = pBuffer;
+                pBuffer = NULL;
+            }
+        }
+
+        if(pBuffer)
+            IO::getAllocator()->free(pBuffer, kBufferCapacity);
+    }
+
+
+    inline size_type AlignDown(size_type n)
+    {
+        return n & ~(size_type)(DirectFileStream::kAlignment - 1);
+    }
+
+
+    inline size_type AlignUp(size_type n)
+    {
+        return (n + (DirectFileStream::kAlignment - 1)) & ~(size_type)(DirectFileStream::kAlignment - 1);
+    }
+
+
+    inline bool IsAligned(const void* p)
+    {
+        return ((uintptr_t)p & (DirectFileStream::kAlignment - 1)) == 0;
+    }
+
+} // namespace DirectFileStreamLocal
+
+
+
+DirectFileStream::DirectFileStream(const char8_t* pPath8)
+  : IStream(),
+    mnFileHandle(kFileHandleInvalid),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen),
+    mbDirect(false),
+    mnPosition(0),
+    mnSize(0),
+    mpBuffer(NULL),
+    mnBufferPosition(0),
+    mnBufferSize(0),
+    mbBufferDirty(false)
+{
+    DirectFileStream::setPath(pPath8); // Note that in a constructor, the virtual function mechanism is inoperable, so we qualify the function call.
+}
+
+
+DirectFileStream::DirectFileStream(const char16_t* pPath16)
+  : IStream(),
+    mnFileHandle(kFileHandleInvalid),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen),
+    mbDirect(false),
+    mnPosition(0),
+    mnSize(0),
+    mpBuffer(NULL),
+    mnBufferPosition(0),
+    mnBufferSize(0),
+    mbBufferDirty(false)
+{
+    DirectFileStream::setPath(pPath16);
+}
+
+
+DirectFileStream::DirectFileStream(const DirectFileStream& fs)
+  : IStream(),
+    mnFileHandle(kFileHandleInvalid),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(fs.mnUsageHints),
+    mnLastError(kStateNotOpen),
+    mbDirect(false),
+    mnPosition(0),
+    mnSize(0),
+    mpBuffer(NULL),
+    mnBufferPosition(0),
+    mnBufferSize(0),
+    mbBufferDirty(false)
+{
+    DirectFileStream::setPath(fs.mPath8.c_str());
+}
+
+
+DirectFileStream::~DirectFileStream()
+{
+    DirectFileStream::close(); // Note that in a destructor, the virtual function mechanism is inoperable, so we qualify the function call.
+}
+
+
+DirectFileStream& DirectFileStream::operator=(const DirectFileStream& fs)
+{
+    close();
+    setPath(fs.mPath8.c_str());
+
+    mnUsageHints = fs.mnUsageHints;
+    mnLastError  = kStateNotOpen;
+
+    return *this;
+}
+
+
+int DirectFileStream::AddRef()
+{
+    return ++mnRefCount;
+}
+
+
+int DirectFileStream::Release()
+{
+    if(mnRefCount > 1)
+        return --mnRefCount;
+    delete this;
+    return 0;
+}
+
+
+void DirectFileStream::setPath(const char8_t* pPath8)
+{
+    if((mnFileHandle == kFileHandleInvalid) && pPath8)
+        mPath8 = pPath8;
+}
+
+
+void DirectFileStream::setPath(const char16_t* pPath16)
+{
+    if((mnFileHandle == kFileHandleInvalid) && pPath16)
+        ConvertPathUTF16ToUTF8(mPath8, pPath16);
+}
+
+
+size_t DirectFileStream::getPath(char8_t* pPath8, size_t nPathCapacity)
+{
+    // Return the required strlen of the destination path.
+    return EAIOStrlcpy8(pPath8, mPath8.c_str(), nPathCapacity);
+}
+
+
+size_t DirectFileStream::getPath(char16_t* pPath16, size_t nPathCapacity)
+{
+    // Return the required strlen of the destination path.
+    return StrlcpyUTF8ToUTF16(pPath16, nPathCapacity, mPath8.c_str(), mPath8.length());
+}
+
+
+bool DirectFileStream::open(int nAccessFlags, int nCreationDisposition, int /*nSharing*/, int nUsageHints)
+{
+    if((mnFileHandle == kFileHandleInvalid) && nAccessFlags) // If not already open and if some kind of access is requested...
+    {
+        // Unaligned writes are implemented as read-modify-write of the 
+        // surrounding blocks, so write access implies read access.
+        int nOpenFlags = (nAccessFlags & kAccessFlagWrite) ? O_RDWR : O_RDONLY;
+
+        if(nCreationDisposition == kCDDefault)
+        {
+            if(nAccessFlags & kAccessFlagWrite)
+                nCreationDisposition = kCDOpenAlways;
+            else
+                nCreationDisposition = kCDOpenExisting;
+        }
+
+        switch(nCreationDisposition)
+        {
+            case kCDcreateNew:
+                nOpenFlags |= O_CREAT;
+                nOpenFlags |= O_EXCL;
+                break;
+
+            case kCDCreateAlways:
+                nOpenFlags |= O_CREAT;
+                nOpenFlags |= O_TRUNC;
+                break;
+
+            case kCDOpenExisting:
+                break;
+
+            case kCDOpenAlways:
+                nOpenFlags |= O_CREAT;
+                break;
+
+            case kCDTruncateExisting:
+                nOpenFlags |= O_TRUNC;
+                break;
+
+            case kCDReplaceAtomic:      // Not supported by this class.
+                mnLastError = kStateError;
+                return false;
+        }
+
+        mnFileHandle = ::open(mPath8.c_str(), nOpenFlags | O_DIRECT, 0666);
+        mbDirect     = (mnFileHandle != kFileHandleInvalid);
+
+        // Some file systems (e.g. tmpfs) reject O_DIRECT with EINVAL. 
+        // We fall back to regular I/O rather than failing the open.
+        if((mnFileHandle == kFileHandleInvalid) && (errno == EINVAL))
+            mnFileHandle = ::open(mPath8.c_str(), nOpenFlags, 0666);
+
+        if(mnFileHandle == kFileHandleInvalid)
+        {
+            mnLastError = errno;
+            return false;
+        }
+
+        struct stat tempStat;
+
+        if(fstat(mnFileHandle, &tempStat) == 0)
+            mpBuffer = DirectFileStreamLocal::AcquireBuffer();
+        else
+            mnLastError = errno;
+
+        if(mpBuffer)
+        {
+            mnAccessFlags    = nAccessFlags;
+            mnUsageHints     = nUsageHints;
+            mnLastError      = 0;
+            mnPosition       = 0;
+            mnSize           = (size_type)tempStat.st_size;
+            mnBufferPosition = 0;
+            mnBufferSize     = 0;
+            mbBufferDirty    = false;
+
+            #if defined(POSIX_FADV_SEQUENTIAL)
+                // With O_DIRECT the page cache isn't used, so page cache advice is pointless. 
+                // Otherwise, as with FileStream, advice is applied to the whole file (length 0) 
+                // and failure is harmless and ignored.
+                if(!mbDirect)
+                {
+                    if(nUsageHints & FileStream::kUsageHintSequential)
+                        posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    else if(nUsageHints & FileStream::kUsageHintRandom)
+                        posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_RANDOM);
+
+                    if(nUsageHints & FileStream::kUsageHintNoReuse)
+                        posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_NOREUSE);
+
+                    if(nUsageHints & FileStream::kUsageHintWillNeed)
+                        posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_WILLNEED);
+                }
+            #endif
+        }
+        else
+        {
+            if(!mnLastError)
+                mnLastError = kStateError;
+
+            ::close(mnFileHandle);
+            mnFileHandle = kFileHandleInvalid;
+            mbDirect     = false;
+        }
+    }
+
+    return (mnFileHandle != kFileHandleInvalid);
+}
+
+
+bool DirectFileStream::close()
+{
+    bool bResult = true;
+
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        bResult = FlushBuffer();
+
+        DirectFileStreamLocal::ReleaseBuffer(mpBuffer);
+
+        ::close(mnFileHandle); // This returns -1 upon error. But there's not much to do about it.
+
+        mnFileHandle     = kFileHandleInvalid;
+        mnAccessFlags    = 0;
+        mnUsageHints     = 0;
+        mnLastError      = kStateNotOpen;
+        mbDirect         = false;
+        mnPosition       = 0;
+        mnSize           = 0;
+        mpBuffer         = NULL;
+        mnBufferPosition = 0;
+        mnBufferSize     = 0;
+        mbBufferDirty    = false;
+    }
+
+    return bResult;
+}
+
+
+void DirectFileStream::ShrinkBufferPool()
+{
+    using namespace DirectFileStreamLocal;
+
+    AutoLock autoLock(GetPoolFutex());
+    while(gPoolCount)
+        IO::getAllocator()->free(gPool[--gPoolCount], kBufferCapacity);
+}
+
+
+int DirectFileStream::GetAccessFlags() const
+{
+    return mnAccessFlags;
+}
+
+
+int DirectFileStream::GetState() const
+{
+    return mnLastError;
+}
+
+
+size_type DirectFileStream::getSize() const
+{
+    if(mnFileHandle != kFileHandleInvalid)
+        return mnSize;
+
+    return kSizeTypeError;
+}
+
+
+bool DirectFileStream::SetSize(size_type size)
+{
+    if((mnFileHandle != kFileHandleInvalid) && (mnAccessFlags & kAccessFlagWrite))
+    {
+        if(FlushBuffer())
+        {
+            // The buffer may hold data beyond the new size, or padding which 
+            // would now be exposed by growing the file, so we discard it.
+            mnBufferPosition = 0;
+            mnBufferSize     = 0;
+
+            if(ftruncate(mnFileHandle, (off_t)size) == 0)
+            {
+                mnSize = size;
+                return true;
+            }
+
+            mnLastError = errno;
+        }
+    }
+
+    return false;
+}
+
+
+off_type DirectFileStream::GetPosition(PositionType positionType) const
+{
+    switch(positionType)
+    {
+        case kPositionTypeBegin:
+            return (off_type)mnPosition;
+
+        case kPositionTypeEnd:
+            return (off_type)(mnPosition - mnSize);
+
+        case kPositionTypeCurrent:
+        default:
+            break;
+    }
+
+    return 0; // For kPositionTypeCurrent the result is always zero for a 'get' operation.
+}
+
+
+bool DirectFileStream::SetPosition(off_type nPosition, PositionType positionType)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        switch(positionType)
+        {
+            case kPositionTypeBegin:
+                break;
+
+            case kPositionTypeCurrent:
+                nPosition = (off_type)(nPosition + mnPosition);
+                break;
+
+            case kPositionTypeEnd:
+                nPosition = (off_type)(nPosition + mnSize);
+                break;
+        }
+
+        // As with lseek, positioning beyond the end of the file is allowed; 
+        // a subsequent write fills the gap with zeroes.
+        if(nPosition >= 0)
+        {
+            mnPosition = (size_type)nPosition;
+            return true;
+        }
+
+        mnLastError = EINVAL;
+    }
+
+    return false;
+}
+
+
+size_type DirectFileStream::GetAvailable() const
+{
+    if(mnFileHandle != kFileHandleInvalid)
+        return (mnPosition < mnSize) ? (mnSize - mnPosition) : 0;
+
+    return kSizeTypeError;
+}
+
+
+size_type DirectFileStream::Read(void* pData, size_type nSize)
+{
+    using namespace DirectFileStreamLocal;
+
+    if((mnFileHandle != kFileHandleInvalid) && (mnAccessFlags & kAccessFlagRead))
+    {
+        uint8_t*  pData8     = (uint8_t*)pData;
+        size_type nSizeTotal = 0;
+
+        if(nSize > GetAvailable())
+            nSize = GetAvailable();
+
+        while(nSize)
+        {
+            if((mnPosition >= mnBufferPosition) && (mnPosition < (mnBufferPosition + mnBufferSize))) // If the position is within the buffer...
+            {
+                const size_type nOffset = (mnPosition - mnBufferPosition);
+                const size_type nCount  = ((mnBufferSize - nOffset) < nSize) ? (mnBufferSize - nOffset) : nSize;
+
+                memcpy(pData8, mpBuffer + nOffset, (size_t)nCount);
+                pData8     += nCount;
+                mnPosition += nCount;
+                nSizeTotal += nCount;
+                nSize      -= nCount;
+            }
+            else
+            {
+                if(!FlushBuffer())
+                    return kSizeTypeError;
+
+                if((nSize >= kBufferSize) && (AlignDown(mnPosition) == mnPosition) && IsAligned(pData8))
+                {
+                    // Large aligned reads go directly from the device to the user's memory.
+                    const size_type nRequest = AlignDown(nSize);
+                    size_type       nCount;
+
+                    if(!ReadAligned(mnPosition, pData8, nRequest, nCount))
+                        return kSizeTypeError;
+
+                    pData8     += nCount;
+                    mnPosition += nCount;
+                    nSizeTotal += nCount;
+                    nSize      -= nCount;
+
+                    if(nCount < nRequest) // If the file was truncated from under us...
+                        break;
+                }
+                else
+                {
+                    if(!FillBuffer(AlignDown(mnPosition)))
+                        return kSizeTypeError;
+
+                    if((mnBufferPosition + mnBufferSize) <= mnPosition) // If the file was truncated from under us...
+                        break;
+                }
+            }
+        }
+
+        return nSizeTotal;
+    }
+
+    return kSizeTypeError;
+}
+
+
+bool DirectFileStream::Write(const void* pData, size_type nSize)
+{
+    using namespace DirectFileStreamLocal;
+
+    if((mnFileHandle != kFileHandleInvalid) && (mnAccessFlags & kAccessFlagWrite))
+    {
+        const uint8_t* pData8 = (const uint8_t*)pData;
+
+        while(nSize)
+        {
+            if((nSize >= kBufferSize) && (AlignDown(mnPosition) == mnPosition) && IsAligned(pData8) && 
+               !(mbBufferDirty && (mnPosition == (mnBufferPosition + mnBufferSize)))) // If large, aligned, and not continuing a buffered write...
+            {
+                // Large aligned writes go directly from the user's memory to the device.
+                // Buffered data is written first, and the buffer is discarded since it may overlap.
+                const size_type nCount = AlignDown(nSize);
+
+                if(!FlushBuffer())
+                    return false;
+
+                mnBufferPosition = 0;
+                mnBufferSize     = 0;
+
+                if(!WriteAligned(mnPosition, pData8, nCount))
+                    return false;
+
+                pData8     += nCount;
+                mnPosition += nCount;
+                nSize      -= nCount;
+
+                if(mnSize < mnPosition)
+                    mnSize = mnPosition;
+            }
+            else if((mnPosition >= mnBufferPosition) && 
+                    (mnPosition <= (mnBufferPosition + mnBufferSize)) && 
+                    (mnPosition <  (mnBufferPosition + kBufferSize))) // If the position is within or just past the valid part of the buffer...
+            {
+                const size_type nOffset = (mnPosition - mnBufferPosition);
+                const size_type nCount  = ((kBufferSize - nOffset) < nSize) ? (kBufferSize - nOffset) : nSize;
+
+                memcpy(mpBuffer + nOffset, pData8, (size_t)nCount);
+                pData8        += nCount;
+                mnPosition    += nCount;
+                nSize         -= nCount;
+                mbBufferDirty  = true;
+
+                if(mnBufferSize < (nOffset + nCount))
+                    mnBufferSize = (nOffset + nCount);
+
+                if(mnSize < mnPosition)
+                    mnSize = mnPosition;
+
+                if(mnBufferSize == kBufferSize) // If the buffer is full, write it and start a new one where this one ends.
+                {
+                    if(!FlushBuffer())
+                        return false;
+
+                    mnBufferPosition += kBufferSize;
+                    mnBufferSize      = 0;
+                }
+            }
+            else
+            {
+                // Start a new buffer at the block which contains the position. The buffer 
+                // must be valid from its beginning to the position, so we read the part 
+                // of that block which precedes the position, zero-filling any part of 
+                // it that lies beyond the end of the file.
+                if(!FlushBuffer())
+                    return false;
+
+                const size_type nBlockPosition = AlignDown(mnPosition);
+                const size_type nHeadSize      = (mnPosition - nBlockPosition);
+                size_type       nCount         = 0;
+
+                mnBufferPosition = nBlockPosition;
+                mnBufferSize     = 0;
+
+                if(nHeadSize && (nBlockPosition < mnSize))
+                {
+                    if(!ReadAligned(nBlockPosition, mpBuffer, kAlignment, nCount))
+                        return false;
+                }
+
+                if(nCount < nHeadSize)
+                    memset(mpBuffer + nCount, 0, (size_t)(nHeadSize - nCount));
+
+                mnBufferSize = (nCount > nHeadSize) ? nCount : nHeadSize;
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+bool DirectFileStream::Flush()
+{
+    if(mnFileHandle != kFileHandleInvalid)
+        return FlushBuffer();
+
+    return false;
+}
+
+
+bool DirectFileStream::FillBuffer(size_type nPosition)
+{
+    EA_ASSERT(!mbBufferDirty && (DirectFileStreamLocal::AlignDown(nPosition) == nPosition));
+
+    size_type nCount;
+
+    mnBufferPosition = nPosition;
+    mnBufferSize     = 0;
+
+    if(!ReadAligned(nPosition, mpBuffer, kBufferSize, nCount))
+        return false;
+
+    mnBufferSize = nCount;
+    return true;
+}
+
+
+bool DirectFileStream::FlushBuffer()
+{
+    using namespace DirectFileStreamLocal;
+
+    if(mbBufferDirty)
+    {
+        // O_DIRECT writes must be a multiple of the block size, so the final partial 
+        // block of the buffer is padded. If the file has data beyond the buffer, the 
+        // padding must be that data, which we read into the scratch block after the buffer.
+        const size_type nEnd       = (mnBufferPosition + mnBufferSize);
+        const size_type nWriteSize = AlignUp(mnBufferSize);
+
+        if(nWriteSize > mnBufferSize)
+        {
+            const size_type nTailOffset = (nWriteSize - kAlignment);
+            size_type       nCount      = 0;
+
+            if(mnSize > nEnd)
+            {
+                uint8_t* const pScratch = (mpBuffer + kBufferSize);
+
+                if(!ReadAligned(mnBufferPosition + nTailOffset, pScratch, kAlignment, nCount))
+                    return false;
+
+                if(nCount > (mnBufferSize - nTailOffset))
+                    memcpy(mpBuffer + mnBufferSize, pScratch + (mnBufferSize - nTailOffset), (size_t)(nCount - (mnBufferSize - nTailOffset)));
+            }
+
+            if((nTailOffset + nCount) < nWriteSize)
+            {
+                const size_type nPadBegin = ((nTailOffset + nCount) > mnBufferSize) ? (nTailOffset + nCount) : mnBufferSize;
+                memset(mpBuffer + nPadBegin, 0, (size_t)(nWriteSize - nPadBegin));
+            }
+        }
+
+        if(!WriteAligned(mnBufferPosition, mpBuffer, nWriteSize))
+            return false;
+
+        // The padding may have extended the file beyond its logical size.
+        if((mnBufferPosition + nWriteSize) > mnSize)
+        {
+            if(ftruncate(mnFileHandle, (off_t)mnSize) != 0)
+            {
+                mnLastError = errno;
+                return false;
+            }
+        }
+
+        mbBufferDirty = false;
+    }
+
+    return true;
+}
+
+
+bool DirectFileStream::ReadAligned(size_type nPosition, void* pData, size_type nSize, size_type& nSizeRead)
+{
+    nSizeRead = 0;
+
+    while(nSizeRead < nSize)
+    {
+        const size_type nRequest = (nSize - nSizeRead);
+        const ssize_t   nResult  = pread(mnFileHandle, (uint8_t*)pData + nSizeRead, (size_t)nRequest, (off_t)(nPosition + nSizeRead));
+
+        if(nResult >= 0)
+        {
+            nSizeRead += (size_type)nResult;
+
+            // A short read means we hit the end of the file. We don't try again, as 
+            // with O_DIRECT a read from the resulting unaligned position would fail.
+            if((size_type)nResult < nRequest)
+                break;
+        }
+        else if(errno != EINTR)
+        {
+            mnLastError = errno;
+            return false;
+        }
+    }
+
+    #if defined(POSIX_FADV_DONTNEED)
+        // Without O_DIRECT, we release the pages we read as we go, so that the 
+        // stream still doesn't fill the page cache.
+        if(!mbDirect && (mnUsageHints & FileStream::kUsageHintDontNeed) && nSizeRead)
+            posix_fadvise(mnFileHandle, (off_t)nPosition, (off_t)nSizeRead, POSIX_FADV_DONTNEED);
+    #endif
+
+    return true;
+}
+
+
+bool DirectFileStream::WriteAligned(size_type nPosition, const void* pData, size_type nSize)
+{
+    size_type nSizeWritten = 0;
+
+    while(nSizeWritten < nSize)
+    {
+        const ssize_t nResult = pwrite(mnFileHandle, (const uint8_t*)pData + nSizeWritten, (size_t)(nSize - nSizeWritten), (off_t)(nPosition + nSizeWritten));
+
+        if(nResult > 0)
+            nSizeWritten += (size_type)nResult;
+        else if((nResult == 0) || (errno != EINTR))
+        {
+            mnLastError = nResult ? errno : ENOSPC; // A write of nothing would otherwise loop forever.
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+} // namespace IO
+
+
+} // namespace EA
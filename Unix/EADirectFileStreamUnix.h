@@ -0,0 +1,195 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EADirectFileStreamUnix.h
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Implements a file stream which uses O_DIRECT to bypass the kernel page 
+// cache, with transparent handling of unaligned reads and writes.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EADIRECTFILESTREAM_UNIX_H
+#define EAIO_EADIRECTFILESTREAM_UNIX_H
+
+
+#include <eaio/EAFileStream.h>
+#include <eaio/EAFileBase.h>
+#include <eaio/PathString.h>
+#include <stddef.h>
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// class DirectFileStream
+        ///
+        /// Implements a file stream which transfers data directly between the 
+        /// storage device and user memory (O_DIRECT), bypassing the kernel page 
+        /// cache. This is useful for streaming through very large files once,
+        /// which with FileStream would evict everything else from the page cache.
+        ///
+        /// O_DIRECT requires that file offsets, transfer sizes and memory addresses
+        /// be multiples of the device block size. This class hides that from the 
+        /// user by staging data through an internal page-aligned buffer of kBufferSize
+        /// bytes, which is taken from a process-wide pool upon open and returned to
+        /// it upon close. Reads of at least kBufferSize bytes into kAlignment-aligned 
+        /// memory at kAlignment-aligned positions bypass the buffer entirely.
+        ///
+        /// Written data is held in the buffer until it fills, until Flush or close is
+        /// called, or until the stream is repositioned outside the buffer. A partially 
+        /// written final block is padded for the write and then the file is truncated 
+        /// back to its logical size, so the result is indistinguishable from FileStream.
+        ///
+        /// If the file system doesn't support O_DIRECT (e.g. tmpfs), the file is 
+        /// opened normally and the stream behaves like a buffered FileStream; see IsDirect.
+        /// The usage hints given to open (see FileStream::UsageHints) are applied only in 
+        /// that case, as O_DIRECT bypasses the page cache which they advise.
+        /// Since unaligned writes may require reading the surrounding block, a stream 
+        /// opened for writing is opened with read access as well.
+        ///
+        /// This class is not inherently thread-safe.
+        ///
+        /// Example usage:
+        ///     DirectFileStream stream("/data/ingest/capture.bin");
+        ///
+        ///     if(stream.open(kAccessFlagRead))
+        ///     {
+        ///         while((nCount = stream.Read(pBuffer, nBufferSize)) > 0)
+        ///             Process(pBuffer, nCount);
+        ///         stream.close();
+        ///     }
+        ///
+        class EAIO_API DirectFileStream : public IStream
+        {
+        public:
+            enum { kTypeDirectFileStream = 0x34722320 };
+
+            enum
+            {
+                kAlignment  = 4096,         /// Alignment of file positions, sizes and memory used with O_DIRECT. This is a multiple of the logical block size of practically all devices.
+                kBufferSize = 1024 * 1024   /// Size of the internal buffer. A multiple of kAlignment.
+            };
+
+        public:
+            DirectFileStream(const char8_t* pPath8 = NULL);
+            DirectFileStream(const char16_t* pPath16);
+
+            // DirectFileStream
+            // Does not copy information related to an open file, such as the file handle.
+            DirectFileStream(const DirectFileStream& fs);
+
+            virtual ~DirectFileStream();
+
+            // operator=
+            // Does not copy information related to an open file, such as the file handle.
+            DirectFileStream& operator=(const DirectFileStream& fs);
+
+            virtual int       AddRef();
+            virtual int       Release();
+
+            virtual void      setPath(const char8_t* pPath8);
+            virtual void      setPath(const char16_t* pPath16);
+            virtual size_t    getPath(char8_t* pPath8, size_t nPathCapacity);
+            virtual size_t    getPath(char16_t* pPath16, size_t nPathCapacity);
+
+            virtual bool      open(int nAccessFlags = kAccessFlagRead, int nCreationDisposition = kCDDefault, int nSharing = FileStream::kShareRead, int nUsageHints = FileStream::kUsageHintNone);
+            virtual bool      close();
+            virtual uint32_t  GetType() const { return kTypeDirectFileStream; }
+            virtual int       GetAccessFlags() const;
+            virtual int       GetState() const;
+
+            virtual size_type getSize() const;
+            virtual bool      SetSize(size_type size);
+
+            virtual off_type  GetPosition(PositionType positionType = kPositionTypeBegin) const;
+            virtual bool      SetPosition(off_type position, PositionType positionType = kPositionTypeBegin);
+
+            virtual size_type GetAvailable() const;
+
+            virtual size_type Read(void* pData, size_type nSize);
+            virtual bool      Write(const void* pData, size_type nSize);
+
+            // Writes any buffered data to the file. As with O_DIRECT in general, this doesn't 
+            // guarantee that file metadata such as the size is on the device; use fsync for that.
+            virtual bool      Flush();
+
+            /// Returns true if the file is open with O_DIRECT, or false if the file system
+            /// didn't support it and the file was opened normally.
+            bool              IsDirect() const { return mbDirect; }
+
+            /// Frees the buffers held by the process-wide buffer pool. Buffers in use by 
+            /// open streams are unaffected and are returned to the pool when the streams close.
+            static void       ShrinkBufferPool();
+
+        protected:
+            bool              FillBuffer(size_type nPosition);
+            bool              FlushBuffer();
+            bool              ReadAligned(size_type nPosition, void* pData, size_type nSize, size_type& nSizeRead);
+            bool              WriteAligned(size_type nPosition, const void* pData, size_type nSize);
+
+        protected:
+            typedef EA::IO::Path::PathString8 PathString8;
+
+            int         mnFileHandle;
+            PathString8 mPath8;                     /// Path for the file.
+            int         mnRefCount;                 /// Reference count, which may or may not be in use.
+            int         mnAccessFlags;              /// See enum AccessFlags.
+            int         mnUsageHints;               /// See enum FileStream::UsageHints.
+            mutable int mnLastError;                /// Used for error reporting.
+            bool        mbDirect;                   /// True if the file was opened with O_DIRECT.
+            size_type   mnPosition;                 /// Current logical stream position.
+            size_type   mnSize;                     /// Logical file size, including buffered but unwritten data.
+            uint8_t*    mpBuffer;                   /// Aligned buffer of kBufferSize bytes, followed by a kAlignment byte scratch block.
+            size_type   mnBufferPosition;           /// File position of mpBuffer[0]. Always a multiple of kAlignment.
+            size_type   mnBufferSize;               /// Number of valid bytes in mpBuffer.
+            bool        mbBufferDirty;              /// True if mpBuffer has data which hasn't been written to the file.
+
+        }; // class DirectFileStream
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif  // #ifndef EAIO_EADIRECTFILESTREAM_UNIX_H
+
+
+
+
+
+
+
+
+
+
@@ -40,13 +40,22 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <eaio/internal/Config.h>
 #include <eaio/EAFileStream.h>
+#include <eaio/EAStreamAdapter.h>
 #include <eaio/Allocator.h>
 #include <eaio/FnEncode.h>
 #include EA_ASSERT_HEADER
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#if defined(EA_PLATFORM_LINUX)
+    #include <sys/sendfile.h>
+    #include <sys/syscall.h>
+#endif
 
 
 namespace EA
@@ -58,6 +67,53 @@ namespace IO
 
 const int kFileHandleInvalid = -1;
 
+// With kUsageHintDontNeed, read pages are released in runs of at least this
+// many bytes, so that small reads don't each cost a posix_fadvise call.
+const size_type kReleaseGranularity = 1024 * 1024;
+
+// The number of buffers ReadV and WriteV pass to each readv or writev call. 
+// This is well below IOV_MAX, which is 1024 on Linux.
+const size_t kIOVectorBatchSize = 32;
+
+// The maximum number of bytes CopyFrom passes to each copy_file_range or sendfile call. 
+// Linux transfers at most about 2 GB per call regardless.
+const size_type kCopyBatchSize = 1024 * 1024 * 1024;
+
+// The number of temporary file names kCDReplaceAtomic tries before giving up.
+const unsigned kReplacementAttemptCount = 64;
+
+
+// Makes the path of the directory which contains pPath8.
+static void MakeDirectoryPath(EA::IO::Path::PathString8& directory8, const char8_t* pPath8)
+{
+    const char8_t* const pFileName = strrchr(pPath8, '/');
+
+    if(pFileName)
+        directory8.assign(pPath8, (size_t)(pFileName + 1 - pPath8));
+    else
+        directory8 = ".";
+}
+
+
+// Makes the path of a hidden temporary file in the same directory as pPath8, 
+// so that it can later be renamed over pPath8. For example, "/data/app.ini" 
+// becomes "/data/.app.ini.1f2e-3d4c5b6a-0.tmp". The name is unique per process 
+// and stream, and nAttempt distinguishes retries after a collision.
+static void MakeReplacementPath(EA::IO::Path::PathString8& tempPath8, const char8_t* pPath8, const void* pStream, unsigned nAttempt)
+{
+    const char8_t* const pFileName = strrchr(pPath8, '/');
+    const size_t         nDirLength = pFileName ? (size_t)(pFileName + 1 - pPath8) : 0;
+    char8_t              buffer[64];
+
+    snprintf(buffer, sizeof(buffer), "%x-%lx-%u.tmp", (unsigned)getpid(), (unsigned long)(uintptr_t)pStream, nAttempt);
+
+    tempPath8.assign(pPath8, nDirLength);
+    tempPath8 += '.';
+    tempPath8 += (pPath8 + nDirLength);
+    tempPath8 += '.';
+    tempPath8 += buffer;
+}
+
 
 
 FileStream::FileStream(const char8_t* pPath8)
@@ -68,7 +124,18 @@ FileStream::FileStream(const char8_t* pPath8)
     mnAccessFlags(0),
     mnCD(0),
     mnSharing(0),
-    mnLastError(kStateNotOpen)
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen),
+    mTempPath8(),
+    mReplacePath8(),
+    mnReleaseBegin(0),
+    mnReleaseEnd(0),
+    mnPosition(0),
+    mbEnableSizeCache(false),
+    mnSize(kSizeTypeError),
+    mnFlushPolicy(kFlushPolicySync),
+    mbPreallocate(false),
+    mbWriteFailed(false)
 {
     FileStream::setPath(pPath8); // Note that in a constructor, the virtual function mechanism is inoperable, so we qualify the function call.
 }
@@ -82,7 +149,18 @@ FileStream::FileStream(const char16_t* pPath16)
     mnAccessFlags(0),
     mnCD(0),
     mnSharing(0),
-    mnLastError(kStateNotOpen)
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen),
+    mTempPath8(),
+    mReplacePath8(),
+    mnReleaseBegin(0),
+    mnReleaseEnd(0),
+    mnPosition(0),
+    mbEnableSizeCache(false),
+    mnSize(kSizeTypeError),
+    mnFlushPolicy(kFlushPolicySync),
+    mbPreallocate(false),
+    mbWriteFailed(false)
 {
     FileStream::setPath(pPath16);
 }
@@ -97,7 +175,17 @@ FileStream::FileStream(const FileStream& fs)
     mnCD(0),
     mnSharing(0),
     mnUsageHints(fs.mnUsageHints),
-    mnLastError(kStateNotOpen)
+    mnLastError(kStateNotOpen),
+    mTempPath8(),
+    mReplacePath8(),
+    mnReleaseBegin(0),
+    mnReleaseEnd(0),
+    mnPosition(0),
+    mbEnableSizeCache(fs.mbEnableSizeCache),
+    mnSize(kSizeTypeError),
+    mnFlushPolicy(fs.mnFlushPolicy),
+    mbPreallocate(fs.mbPreallocate),
+    mbWriteFailed(false)
 {
     FileStream::setPath(fs.mPath8.c_str());
 }
@@ -121,6 +209,10 @@ FileStream& FileStream::operator=(const FileStream& fs)
     mnUsageHints  = fs.mnUsageHints;
     mnLastError   = kStateNotOpen;
 
+    mbEnableSizeCache = fs.mbEnableSizeCache;
+    mnFlushPolicy     = fs.mnFlushPolicy;
+    mbPreallocate     = fs.mbPreallocate;
+
     return *this;
 }
 
@@ -215,9 +307,15 @@ bool FileStream::open(int nAccessFlags, int nCreationDisposition, int nSharing,
             case kCDTruncateExisting:       // open the file if it exists, and truncate it if so.
                 nOpenFlags |= O_TRUNC;
                 break;
+
+            case kCDReplaceAtomic:          // open a new file which replaces the file upon close.
+                break;                      // Handled by OpenReplacement.
         }
 
-        mnFileHandle = ::open(mPath8.c_str(), nOpenFlags, 0666);
+        if(nCreationDisposition == kCDReplaceAtomic)
+            mnFileHandle = OpenReplacement(nOpenFlags);
+        else
+            mnFileHandle = ::open(mPath8.c_str(), nOpenFlags, 0666);
 
         if(mnFileHandle == kFileHandleInvalid) // If it failed...
         {
@@ -234,6 +332,48 @@ bool FileStream::open(int nAccessFlags, int nCreationDisposition, int nSharing,
             mnSharing     = nSharing;
             mnUsageHints  = nUsageHints;
             mnLastError   = 0;
+
+            #if defined(POSIX_FADV_SEQUENTIAL)
+                // Advice is applied to the whole file (length 0). Failure here is harmless and ignored.
+                if(nUsageHints & kUsageHintSequential)
+                    posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_SEQUENTIAL);
+                else if(nUsageHints & kUsageHintRandom)
+                    posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_RANDOM);
+
+                if(nUsageHints & kUsageHintNoReuse)
+                    posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_NOREUSE);
+
+                if(nUsageHints & kUsageHintWillNeed)
+                    posix_fadvise(mnFileHandle, 0, 0, POSIX_FADV_WILLNEED);
+            #endif
+
+            mnReleaseBegin = mnReleaseEnd = 0;
+            mnPosition     = 0;
+            mnSize         = kSizeTypeError;
+            mbWriteFailed  = false;
+
+            // With read access, the replacement starts out as a copy of the file, so that 
+            // the user can modify it in place as if it were the file itself.
+            if((nCreationDisposition == kCDReplaceAtomic) && (nAccessFlags & kAccessFlagRead))
+            {
+                FileStream source(mPath8.c_str());
+
+                if(source.open(kAccessFlagRead))
+                {
+                    if((copyStream(&source, this) == kSizeTypeError) || !SetPosition(0))
+                    {
+                        const int nError = mnLastError ? mnLastError : source.GetState();
+
+                        Discard();
+                        mnLastError = nError ? nError : kStateError;
+                    }
+                }
+                else if(source.GetState() != ENOENT) // If the file exists but couldn't be read...
+                {
+                    Discard();
+                    mnLastError = source.GetState();
+                }
+            }
         }
     }
 
@@ -241,10 +381,160 @@ bool FileStream::open(int nAccessFlags, int nCreationDisposition, int nSharing,
 }
 
 
+// Opens the file which is to replace mPath8 upon close. Returns the file 
+// handle, or kFileHandleInvalid with errno set upon failure.
+int FileStream::OpenReplacement(int nOpenFlags)
+{
+    const int nAccessMode  = (nOpenFlags & O_ACCMODE);
+    int       nFileHandle  = kFileHandleInvalid;
+
+    mTempPath8.clear();
+
+    if(nAccessMode == O_RDONLY) // A replacement that can't be written is of no use.
+    {
+        errno = EINVAL;
+        return kFileHandleInvalid;
+    }
+
+    // If mPath8 is a symbolic link, we replace the file it refers to rather than the link itself, 
+    // and so the replacement must be made in that file's directory. If the file doesn't exist 
+    // yet, realpath fails and we create it at mPath8.
+    char8_t* const pRealPath8 = realpath(mPath8.c_str(), NULL);
+
+    if(pRealPath8)
+    {
+        mReplacePath8 = pRealPath8;
+        free(pRealPath8);
+    }
+    else
+        mReplacePath8 = mPath8;
+
+    #if defined(O_TMPFILE)
+        // An O_TMPFILE file has no name until PublishReplacement links it into the directory, 
+        // so nothing is left behind if we crash. Linking it requires /proc/self/fd.
+        if(access("/proc/self/fd", X_OK) == 0)
+        {
+            PathString8 directory8;
+
+            MakeDirectoryPath(directory8, mReplacePath8.c_str());
+            nFileHandle = ::open(directory8.c_str(), O_TMPFILE | nAccessMode, 0666);
+        }
+    #endif
+
+    // Else, or if the file system doesn't support O_TMPFILE, we use a hidden temporary file.
+    for(unsigned i = 0; (nFileHandle == kFileHandleInvalid) && (i < kReplacementAttemptCount); i++)
+    {
+        MakeReplacementPath(mTempPath8, mReplacePath8.c_str(), this, i);
+
+        nFileHandle = ::open(mTempPath8.c_str(), O_CREAT | O_EXCL | nAccessMode, 0666);
+
+        if(nFileHandle == kFileHandleInvalid)
+        {
+            const int nError = errno;
+            mTempPath8.clear();
+            errno = nError;
+
+            if(nError != EEXIST)
+                break;
+        }
+    }
+
+    if(nFileHandle != kFileHandleInvalid)
+    {
+        struct stat tempStat;
+
+        if(stat(mReplacePath8.c_str(), &tempStat) == 0) // If replacing an existing file, keep its owner and permissions.
+        {
+            // Only a privileged process can give a file away, but the owner can usually set its group. 
+            // Failure is ignored, so the new file may be owned by us. This precedes fchmod, as 
+            // changing the owner can clear the set-user-ID and set-group-ID bits.
+            if(fchown(nFileHandle, tempStat.st_uid, tempStat.st_gid) != 0)
+                (void)fchown(nFileHandle, (uid_t)-1, tempStat.st_gid);
+
+            fchmod(nFileHandle, tempStat.st_mode & 07777);
+        }
+    }
+
+    return nFileHandle;
+}
+
+
+// Makes the replacement file durable and renames it over mPath8.
+bool FileStream::PublishReplacement()
+{
+    // The data must be on the device before the file appears under the destination name,
+    // else a crash could leave an empty or partially written file there.
+    bool bResult = (fsync(mnFileHandle) == 0);
+
+    if(bResult && mTempPath8.empty()) // If the file is anonymous (O_TMPFILE)...
+    {
+        char8_t procPath[32];
+        snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", mnFileHandle);
+
+        // linkat can't replace an existing file, so we give the file a temporary name and rename that.
+        for(unsigned i = 0; i < kReplacementAttemptCount; i++)
+        {
+            MakeReplacementPath(mTempPath8, mReplacePath8.c_str(), this, i);
+
+            if(linkat(AT_FDCWD, procPath, AT_FDCWD, mTempPath8.c_str(), AT_SYMLINK_FOLLOW) == 0)
+                break;
+
+            mTempPath8.clear();
+
+            if(errno != EEXIST)
+                break;
+        }
+
+        bResult = !mTempPath8.empty();
+    }
+
+    if(bResult)
+        bResult = (rename(mTempPath8.c_str(), mReplacePath8.c_str()) == 0);
+
+    if(bResult)
+    {
+        // Make the rename itself durable. Failure here is harmless and ignored.
+        PathString8 directory8;
+
+        MakeDirectoryPath(directory8, mReplacePath8.c_str());
+        const int nDirectoryHandle = ::open(directory8.c_str(), O_RDONLY | O_DIRECTORY);
+
+        if(nDirectoryHandle != kFileHandleInvalid)
+        {
+            fsync(nDirectoryHandle);
+            ::close(nDirectoryHandle);
+        }
+    }
+    else
+    {
+        mnLastError = errno;
+
+        if(!mTempPath8.empty())
+            unlink(mTempPath8.c_str());
+    }
+
+    mTempPath8.clear();
+    mReplacePath8.clear();
+
+    return bResult;
+}
+
+
 bool FileStream::close()
 {
+    bool bResult = true;
+
     if((mnFileHandle != kFileHandleInvalid))
     {
+        if(mnReleaseEnd > mnReleaseBegin)
+            ReleaseReadPages(mnReleaseEnd, 0); // Release the pending run.
+
+        if(mnCD == kCDReplaceAtomic) // If the replacement wasn't committed, the data written is lost.
+        {
+            DiscardReplacement();
+            bResult = false;
+        }
+
         ::close(mnFileHandle); // This returns -1 upon error. But there's not much to do about it.
 
         mnFileHandle  = kFileHandleInvalid;
@@ -253,9 +543,71 @@ bool FileStream::close()
         mnSharing     = 0;
         mnUsageHints  = 0;
         mnLastError   = kStateNotOpen;
+        mnPosition    = 0;
+        mnSize        = kSizeTypeError;
+        mbWriteFailed = false;
     }
 
-    return true;
+    return bResult;
+}
+
+
+bool FileStream::Commit()
+{
+    bool bResult = true;
+
+    if((mnFileHandle != kFileHandleInvalid) && (mnCD == kCDReplaceAtomic))
+    {
+        if(mbWriteFailed) // A replacement which is missing some of what was written must never be published.
+        {
+            DiscardReplacement();
+            bResult = false;
+        }
+        else
+            bResult = PublishReplacement();
+
+        mnCD = kCDDefault; // So that close doesn't discard it.
+    }
+
+    return close() && bResult;
+}
+
+
+bool FileStream::Discard()
+{
+    if(mnCD == kCDReplaceAtomic)
+        DiscardReplacement();
+
+    return close();
+}
+
+
+// Removes the replacement file, leaving the destination unchanged.
+void FileStream::DiscardReplacement()
+{
+    if(!mTempPath8.empty())
+        unlink(mTempPath8.c_str());
+
+    mTempPath8.clear();
+    mReplacePath8.clear();
+    mnCD = kCDDefault;
+}
+
+
+void FileStream::setOption(int option, int value)
+{
+    if(option == kOptionCacheSize)
+    {
+        mbEnableSizeCache = (value != 0);
+        mnSize            = kSizeTypeError;
+    }
+    else if(option == kOptionFlushPolicy)
+    {
+        EA_ASSERT((value >= kFlushPolicyNone) && (value <= kFlushPolicySync));
+        mnFlushPolicy = value;
+    }
+    else if(option == kOptionPreallocate)
+        mbPreallocate = (value != 0);
 }
 
 
@@ -275,17 +627,16 @@ size_type FileStream::getSize() const
 {
     if(mnFileHandle != kFileHandleInvalid)
     {
-        const off_t nPositionSaved = lseek(mnFileHandle, 0, SEEK_CUR);
+        if(mnSize != kSizeTypeError) // If the cached value is valid...
+            return mnSize;
 
-        if(nPositionSaved >= 0)
-        {
-            const off_t nSize = lseek(mnFileHandle, 0, SEEK_END);
+        struct stat fileStat;
 
-            if(nSize >= 0)
-            {
-                lseek(mnFileHandle, nPositionSaved, SEEK_SET);
-                return (size_type)nSize;
-            }
+        if(fstat(mnFileHandle, &fileStat) == 0)
+        {
+            if(mbEnableSizeCache)
+                mnSize = (size_type)fileStat.st_size;
+            return (size_type)fileStat.st_size;
         }
 
         mnLastError = errno;
@@ -305,10 +656,27 @@ bool FileStream::SetSize(size_type size)
             // Solution for this?
             (void)size;
         #else
+            if(mbPreallocate)
+            {
+                const size_type nSizeCurrent = getSize();
+
+                if((nSizeCurrent != kSizeTypeError) && (size > nSizeCurrent))
+                {
+                    if(Preallocate(nSizeCurrent, size - nSizeCurrent, false))
+                        return true;
+                    // Else fall back to ftruncate below.
+                }
+            }
+
             const int result = ftruncate(mnFileHandle, (off_t)size);
             if(result == 0) // If the result is OK...
+            {
+                if(mbEnableSizeCache)
+                    mnSize = size;
                 return true;
-            mnLastError = errno;
+            }
+            mnLastError   = errno;
+            mbWriteFailed = true;
         #endif
     }
 
@@ -320,18 +688,17 @@ off_type FileStream::GetPosition(PositionType positionType) const
 {
     off_type result;
 
-    if(positionType == kPositionTypeBegin)
-        result = (off_type)lseek(mnFileHandle, 0, SEEK_CUR);
+    if(mnFileHandle == kFileHandleInvalid)
+        result = (off_type)-1;
+    else if(positionType == kPositionTypeBegin)
+        result = (off_type)mnPosition;
     else if(positionType == kPositionTypeEnd)
     {
-        result = (off_type)lseek(mnFileHandle, 0, SEEK_CUR);
+        result = (off_type)mnPosition;
 
-        if(result != (off_type)-1)
-        {
-            const size_type nSize = getSize();
-            if(nSize != kSizeTypeError)
-                result = (off_type)(result - (off_type)nSize);
-        }
+        const size_type nSize = getSize();
+        if(nSize != kSizeTypeError)
+            result = (off_type)(result - (off_type)nSize);
     }
     else
         result = 0;
@@ -364,7 +731,10 @@ bool FileStream::SetPosition(off_type position, PositionType positionType)
         const off_t nResult = lseek(mnFileHandle, (off_t)position, nMethod);
 
         if(nResult != -1)
+        {
+            mnPosition = (size_type)nResult;
             return true;
+        }
 
         mnLastError = errno;
     }
@@ -375,10 +745,13 @@ bool FileStream::SetPosition(off_type position, PositionType positionType)
 
 size_type FileStream::GetAvailable() const
 {
-    const off_type nPosition = GetPosition(kPositionTypeEnd);
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        const size_type nSize = getSize();
 
-    if(nPosition != (off_type)kSizeTypeError)
-        return (size_type)-nPosition;
+        if(nSize != kSizeTypeError)
+            return (mnPosition < nSize) ? (nSize - mnPosition) : 0;
+    }
 
     return kSizeTypeError;
 }
@@ -390,7 +763,13 @@ size_type FileStream::Read(void* pData, size_type nSize)
     {
         const size_type nCount = read(mnFileHandle, pData, (size_t)nSize);
         if(nCount != kSizeTypeError)
+        {
+            if((mnUsageHints & kUsageHintDontNeed) && nCount)
+                ReleaseReadPages(mnPosition, nCount);
+
+            mnPosition += nCount;
             return nCount;
+        }
     }
     return kSizeTypeError;
 }
@@ -402,19 +781,465 @@ bool FileStream::Write(const void* pData, size_type nSize)
     {
         const size_type nCount = write(mnFileHandle, pData, (size_t)nSize);
         if(nCount != kSizeTypeError)
+        {
+            mnPosition += nCount;
+
+            if((mnSize != kSizeTypeError) && (mnPosition > mnSize))
+                mnSize = mnPosition;
+
+            if(nCount != nSize) // A short write isn't reported as a failure here, but the file is now missing data.
+                mbWriteFailed = true;
+            return true;
+        }
+
+        mnLastError   = errno;
+        mbWriteFailed = true;
+    }
+    return false;
+}
+
+
+size_type FileStream::ReadAt(size_type nPosition, void* pData, size_type nSize)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        ssize_t nCount;
+
+        do {
+            nCount = pread(mnFileHandle, pData, (size_t)nSize, (off_t)nPosition);
+        } while((nCount < 0) && (errno == EINTR));
+
+        if(nCount >= 0)
+            return (size_type)nCount;
+
+        __atomic_store_n(&mnLastError, errno, __ATOMIC_RELAXED); // Atomic, as ReadAt may be called from multiple threads.
+    }
+    return kSizeTypeError;
+}
+
+
+bool FileStream::WriteAt(size_type nPosition, const void* pData, size_type nSize)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        const char* pData8 = (const char*)pData;
+
+        // The Posix standard allows for a write call to write only some of what you ask.
+        while(nSize)
+        {
+            const ssize_t nCount = pwrite(mnFileHandle, pData8, (size_t)nSize, (off_t)nPosition);
+
+            if(nCount > 0)
+            {
+                pData8    += nCount;
+                nPosition += (size_type)nCount;
+                nSize     -= (size_type)nCount;
+            }
+            else if((nCount == 0) || (errno != EINTR)) // pwrite returns 0 only if it can make no progress, such as when the device is full.
+            {
+                // The stream state which WriteAt changes is changed atomically, as WriteAt 
+                // may be called from multiple threads. See the declaration.
+                __atomic_store_n(&mnLastError, nCount ? errno : ENOSPC, __ATOMIC_RELAXED);
+                __atomic_store_n(&mbWriteFailed, true, __ATOMIC_RELAXED);
+                return false;
+            }
+        }
+
+        size_type nSizeCached = __atomic_load_n(&mnSize, __ATOMIC_RELAXED);
+
+        while((nSizeCached != kSizeTypeError) && (nPosition > nSizeCached) && 
+              !__atomic_compare_exchange_n(&mnSize, &nSizeCached, nPosition, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            // nSizeCached was updated to the current value. Try again.
+        }
+        return true;
+    }
+    return false;
+}
+
+
+
+bool FileStream::Prefetch(size_type nPosition, size_type nSize)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        #if defined(POSIX_FADV_WILLNEED)
+            // On Linux, POSIX_FADV_WILLNEED initiates asynchronous readahead of the range, 
+            // whereas readahead() may block until the read is complete.
+            const int result = posix_fadvise(mnFileHandle, (off_t)nPosition, (off_t)nSize, POSIX_FADV_WILLNEED);
+
+            if(result == 0)
+                return true;
+
+            mnLastError = result; // posix_fadvise returns the error code rather than setting errno.
+        #else
+            (void)nPosition;
+            (void)nSize;
+        #endif
+    }
+    return false;
+}
+
+
+bool FileStream::Preallocate(size_type nPosition, size_type nSize, bool bKeepSize)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        int result = EOPNOTSUPP; // result is an errno value.
+
+        #if defined(FALLOC_FL_KEEP_SIZE)
+            do {
+                result = fallocate(mnFileHandle, bKeepSize ? FALLOC_FL_KEEP_SIZE : 0, (off_t)nPosition, (off_t)nSize);
+                if(result != 0)
+                    result = errno;
+            } while(result == EINTR);
+        #endif
+
+        // posix_fallocate emulates allocation by writing zeros where the file system can't do it
+        // natively. It can't keep the file size unchanged, so we only use it when that isn't requested.
+        if((result == EOPNOTSUPP) && !bKeepSize)
+            result = posix_fallocate(mnFileHandle, (off_t)nPosition, (off_t)nSize); // This returns the error code rather than setting errno.
+
+        if(result == 0)
+        {
+            if(!bKeepSize && (mnSize != kSizeTypeError) && ((nPosition + nSize) > mnSize))
+                mnSize = (nPosition + nSize);
             return true;
+        }
+
+        mnLastError = result;
     }
+
     return false;
 }
 
 
+bool FileStream::PunchHole(size_type nPosition, size_type nSize)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        #if defined(FALLOC_FL_PUNCH_HOLE)
+            if(fallocate(mnFileHandle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)nPosition, (off_t)nSize) == 0)
+                return true;
+            mnLastError = errno;
+        #else
+            (void)nPosition;
+            (void)nSize;
+            mnLastError = ENOTSUP;
+        #endif
+    }
+
+    return false;
+}
+
+
+bool FileStream::FindData(size_type nPosition, size_type& nDataBegin, size_type& nDataEnd) const
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        #if defined(SEEK_DATA) && defined(SEEK_HOLE)
+            // These lseek calls move the file offset, so we restore it to mnPosition afterward.
+            // There is always an implicit hole at the end of the file, so SEEK_HOLE succeeds if SEEK_DATA did.
+            const off_t nBegin = lseek(mnFileHandle, (off_t)nPosition, SEEK_DATA);
+            const off_t nEnd   = (nBegin >= 0) ? lseek(mnFileHandle, nBegin, SEEK_HOLE) : (off_t)-1;
+
+            if(nEnd < 0)
+                mnLastError = errno; // ENXIO means there is no data at or after nPosition.
+
+            lseek(mnFileHandle, (off_t)mnPosition, SEEK_SET);
+
+            if(nEnd >= 0)
+            {
+                nDataBegin = (size_type)nBegin;
+                nDataEnd   = (size_type)nEnd;
+                return true;
+            }
+        #else
+            // Without hole information, the whole file is treated as data.
+            const size_type nSize = getSize();
+
+            if((nSize != kSizeTypeError) && (nPosition < nSize))
+            {
+                nDataBegin = nPosition;
+                nDataEnd   = nSize;
+                return true;
+            }
+        #endif
+    }
+
+    return false;
+}
+
+
+// Records that the given range has been read and releases its pages from the
+// page cache once a large enough contiguous run has accumulated. An nSize of 0
+// releases the pending run immediately.
+void FileStream::ReleaseReadPages(size_type nPosition, size_type nSize)
+{
+    if((nPosition != mnReleaseEnd) || !nSize || ((mnReleaseEnd - mnReleaseBegin) >= kReleaseGranularity))
+    {
+        #if defined(POSIX_FADV_DONTNEED)
+            if(mnReleaseEnd > mnReleaseBegin)
+                posix_fadvise(mnFileHandle, (off_t)mnReleaseBegin, (off_t)(mnReleaseEnd - mnReleaseBegin), POSIX_FADV_DONTNEED);
+        #endif
+
+        mnReleaseBegin = mnReleaseEnd = nPosition;
+    }
+
+    mnReleaseEnd += nSize;
+}
+
+size_type FileStream::ReadV(const IOVector* pIOVectorArray, size_t nCount)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        size_type nTotal = 0;
+
+        while(nCount)
+        {
+            struct iovec ioVecArray[kIOVectorBatchSize];
+            const size_t nBatchCount = (nCount < kIOVectorBatchSize) ? nCount : kIOVectorBatchSize;
+            size_type    nBatchSize  = 0;
+
+            for(size_t i = 0; i < nBatchCount; i++)
+            {
+                ioVecArray[i].iov_base = pIOVectorArray[i].mpData;
+                ioVecArray[i].iov_len  = (size_t)pIOVectorArray[i].mnSize;
+                nBatchSize += pIOVectorArray[i].mnSize;
+            }
+
+            ssize_t nResult;
+
+            do {
+                nResult = readv(mnFileHandle, ioVecArray, (int)nBatchCount);
+            } while((nResult < 0) && (errno == EINTR));
+
+            if(nResult < 0)
+            {
+                mnLastError = errno;
+                return kSizeTypeError;
+            }
+
+            if((mnUsageHints & kUsageHintDontNeed) && nResult)
+                ReleaseReadPages(mnPosition, (size_type)nResult);
+
+            mnPosition += (size_type)nResult;
+            nTotal     += (size_type)nResult;
+
+            if((size_type)nResult < nBatchSize) // If the end of the file was reached...
+                break;
+
+            pIOVectorArray += nBatchCount;
+            nCount         -= nBatchCount;
+        }
+
+        return nTotal;
+    }
+    return kSizeTypeError;
+}
+
+
+bool FileStream::WriteV(const ConstIOVector* pIOVectorArray, size_t nCount)
+{
+    if(mnFileHandle != kFileHandleInvalid)
+    {
+        while(nCount)
+        {
+            struct iovec ioVecArray[kIOVectorBatchSize];
+            const size_t nBatchCount = (nCount < kIOVectorBatchSize) ? nCount : kIOVectorBatchSize;
+
+            for(size_t i = 0; i < nBatchCount; i++)
+            {
+                ioVecArray[i].iov_base = const_cast<void*>(pIOVectorArray[i].mpData); // writev only reads from it.
+                ioVecArray[i].iov_len  = (size_t)pIOVectorArray[i].mnSize;
+            }
+
+            // The Posix standard allows for a write call to write only some of what you ask,
+            // in which case we advance past what was written and issue the remainder.
+            struct iovec* pIOVec      = ioVecArray;
+            int           nIOVecCount = (int)nBatchCount;
+
+            while(nIOVecCount)
+            {
+                const ssize_t nResult = writev(mnFileHandle, pIOVec, nIOVecCount);
+
+                if(nResult < 0)
+                {
+                    if(errno == EINTR)
+                        continue;
+                    mnLastError   = errno;
+                    mbWriteFailed = true;
+                    return false;
+                }
+
+                mnPosition += (size_type)nResult;
+
+                size_t nRemaining = (size_t)nResult;
+
+                while(nIOVecCount && (nRemaining >= pIOVec->iov_len)) // Skip the buffers which were entirely written.
+                {
+                    nRemaining -= pIOVec->iov_len;
+                    pIOVec++;
+                    nIOVecCount--;
+                }
+
+                if(nIOVecCount && !nResult) // writev returns 0 for a nonzero size only if it can make no progress, such as when the device is full.
+                {
+                    mnLastError   = ENOSPC;
+                    mbWriteFailed = true;
+                    return false;
+                }
+
+                if(nIOVecCount) // If a buffer was partially written...
+                {
+                    pIOVec->iov_base = (char*)pIOVec->iov_base + nRemaining;
+                    pIOVec->iov_len -= nRemaining;
+                }
+            }
+
+            pIOVectorArray += nBatchCount;
+            nCount         -= nBatchCount;
+        }
+
+        if((mnSize != kSizeTypeError) && (mnPosition > mnSize))
+            mnSize = mnPosition;
+        return true;
+    }
+    return false;
+}
+
+
+size_type FileStream::CopyFrom(FileStream* pSource, size_type nSize)
+{
+    if((mnFileHandle == kFileHandleInvalid) || (pSource->mnFileHandle == kFileHandleInvalid))
+        return kSizeTypeError;
+
+    size_type nCopied = 0;
+
+    #if defined(EA_PLATFORM_LINUX)
+        // We track the positions here and apply them to both streams at the end, as copy_file_range  
+        // with explicit offsets doesn't move the file offsets, whereas sendfile moves the output one.
+        size_type nPositionIn  = pSource->mnPosition;
+        size_type nPositionOut = mnPosition;
+        bool      bUseCopyFileRange = true;
+        bool      bResult = true;
+
+        #if !defined(__NR_copy_file_range)
+            bUseCopyFileRange = false;
+        #endif
+
+        while(nCopied < nSize)
+        {
+            const size_t nBatchSize = (size_t)(((nSize - nCopied) < kCopyBatchSize) ? (nSize - nCopied) : kCopyBatchSize);
+            ssize_t      nResult = 0;
+
+            if(bUseCopyFileRange)
+            {
+                #if defined(__NR_copy_file_range)
+                    // We use the system call directly because glibc prior to 2.27 lacks a wrapper for it.
+                    loff_t nOffsetIn  = (loff_t)nPositionIn;
+                    loff_t nOffsetOut = (loff_t)nPositionOut;
+
+                    nResult = (ssize_t)syscall(__NR_copy_file_range, pSource->mnFileHandle, &nOffsetIn, mnFileHandle, &nOffsetOut, nBatchSize, 0);
+
+                    // These indicate that copy_file_range isn't supported by the kernel (prior to 4.5), isn't supported  
+                    // between different file systems (prior to 5.3), or isn't supported for these file types.
+                    if((nResult < 0) && ((errno == ENOSYS) || (errno == EXDEV) || (errno == EINVAL) || (errno == EOPNOTSUPP)))
+                    {
+                        bUseCopyFileRange = false;
+
+                        if(lseek(mnFileHandle, (off_t)nPositionOut, SEEK_SET) == (off_t)-1) // sendfile writes at the output file offset.
+                            break;
+                        continue;
+                    }
+                #endif
+            }
+            else
+            {
+                off_t nOffsetIn = (off_t)nPositionIn;
+
+                nResult = sendfile(mnFileHandle, pSource->mnFileHandle, &nOffsetIn, nBatchSize);
+
+                if((nResult < 0) && ((errno == ENOSYS) || (errno == EINVAL) || (errno == EOPNOTSUPP)))
+                    break; // The caller will need to copy the remainder.
+            }
+
+            if(nResult < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+
+                mnLastError   = errno;
+                mbWriteFailed = true;
+                bResult       = false;
+                break;
+            }
+
+            if(nResult == 0) // If the end of the source was reached...
+                break;
+
+            nPositionIn  += (size_type)nResult;
+            nPositionOut += (size_type)nResult;
+            nCopied      += (size_type)nResult;
+        }
+
+        pSource->SetPosition((off_type)nPositionIn);
+        SetPosition((off_type)nPositionOut);
+
+        if((mnSize != kSizeTypeError) && (nPositionOut > mnSize))
+            mnSize = nPositionOut;
+
+        if(!bResult)
+            return kSizeTypeError;
+    #else
+        (void)nSize;
+    #endif
+
+    return nCopied;
+}
+
+
 bool FileStream::Flush()
 {
     if(mnFileHandle != kFileHandleInvalid)
     {
-        // Linux: On kernels before 2.4, fsync on big files can be inefficient. 
-        //          An alternative might be to use the O_SYNC flag to open(2).
-        fsync(mnFileHandle);
+        int result = 0;
+
+        switch(mnFlushPolicy)
+        {
+            case kFlushPolicyNone:
+                break;
+
+            case kFlushPolicyWriteBehind:
+                #if defined(SYNC_FILE_RANGE_WRITE)
+                    // Offset 0 and length 0 mean the whole file. This only queues the dirty pages
+                    // for writeback and returns; it gives no durability guarantee.
+                    result = sync_file_range(mnFileHandle, 0, 0, SYNC_FILE_RANGE_WRITE);
+                #endif
+                break;
+
+            case kFlushPolicyDataSync:
+                #if defined(EA_PLATFORM_LINUX)
+                    result = fdatasync(mnFileHandle);
+                #else
+                    result = fsync(mnFileHandle); // fdatasync isn't available everywhere, and fsync is a superset of it.
+                #endif
+                break;
+
+            default:
+            case kFlushPolicySync:
+                // Linux: On kernels before 2.4, fsync on big files can be inefficient. 
+                //          An alternative might be to use the O_SYNC flag to open(2).
+                result = fsync(mnFileHandle);
+                break;
+        }
+
+        if(result != 0) // The data which failed to be written back may be lost even if a later sync succeeds.
+        {
+            mnLastError   = errno;
+            mbWriteFailed = true;
+            return false;
+        }
     }
     return true;
 }
@@ -66,8 +66,26 @@ namespace EA
             enum UsageHints
             {
                 kUsageHintNone       = 0x00,
-                kUsageHintSequential = 0x01,
-                kUsageHintRandom     = 0x02
+                kUsageHintSequential = 0x01,     /// The file will be read mostly sequentially. The kernel readahead window is enlarged.
+                kUsageHintRandom     = 0x02,     /// The file will be read in random order. Kernel readahead is disabled.
+                kUsageHintWillNeed   = 0x04,     /// The whole file will be needed soon. The kernel starts reading it into the page cache upon open.
+                kUsageHintDontNeed   = 0x08,     /// Data won't be reread after Read returns it, so its cached pages are released behind the reader.
+                kUsageHintNoReuse    = 0x10      /// Data will be accessed only once.
+            };
+
+            enum Option
+            {
+                kOptionCacheSize   = 1,  /// If enabled, then the file size is cached after it is first retrieved and is kept up to date by this stream's Write, WriteAt and SetSize. You must only enable this if the file isn't resized by anything other than this stream. This option can be set at any time.
+                kOptionFlushPolicy = 2,  /// One of enum FlushPolicy. Selects what Flush does. The default is kFlushPolicySync. This option can be set at any time, including before open, and is retained across close and open.
+                kOptionPreallocate = 3   /// If enabled, then SetSize allocates disk blocks for the new bytes when growing the file (see Preallocate), rather than merely extending the size and leaving a hole. Disabled by default. Retained across close and open.
+            };
+
+            enum FlushPolicy
+            {
+                kFlushPolicyNone        = 0,  /// Flush does nothing beyond what Write already did, which is to hand the data to the kernel. The data is visible to other processes but survives only an application crash.
+                kFlushPolicyWriteBehind = 1,  /// Flush starts writeback of dirty pages to the device (sync_file_range) but doesn't wait for it. Limits the amount of unwritten data without stalling the writer.
+                kFlushPolicyDataSync    = 2,  /// Flush waits until the data and the metadata needed to read it back (e.g. the file size) are on the device (fdatasync).
+                kFlushPolicySync        = 3   /// Flush waits until the data and all metadata, such as timestamps, are on the device (fsync).
             };
 
         public:
@@ -92,15 +110,47 @@ namespace EA
             virtual size_t    getPath(char8_t* pPath8, size_t nPathCapacity);
             virtual size_t    getPath(char16_t* pPath16, size_t nPathCapacity);
 
+            // With kCDReplaceAtomic, the stream writes to an anonymous file (O_TMPFILE) or, if the file system 
+            // doesn't support that, to a hidden temporary file in the same directory. Upon Commit, that file
+            // is synced to the device and renamed over the destination, so other processes see either the 
+            // complete old file or the complete new one, even across a crash. If the path is a symbolic 
+            // link, the file it refers to is replaced and the link is kept. The new file gets the 
+            // permissions of the old one, and its owner and group where the process is permitted 
+            // to set them. Other attributes of the old file, such as ACLs and extended attributes, 
+            // aren't preserved, and other hard links to it keep referring to the old data.
+            // Closing such a stream without Commit, including via the destructor, discards what 
+            // was written and returns false.
             virtual bool      open(int nAccessFlags = kAccessFlagRead, int nCreationDisposition = kCDDefault, int nSharing = kShareRead, int nUsageHints = kUsageHintNone); 
             virtual bool      close();
+
+            /// Commit
+            /// Closes the stream. If it was opened with kCDReplaceAtomic, the new file replaces the 
+            /// destination file, unless any write, size change or flush failed since open, in which 
+            /// case the new file is discarded. Returns false if the destination wasn't replaced, 
+            /// in which case it is unchanged. Otherwise this is the same as close.
+            bool              Commit();
+
+            /// Discard
+            /// Closes the stream. If it was opened with kCDReplaceAtomic, the data written is discarded 
+            /// and the destination file is left unchanged. Otherwise this is the same as close.
+            bool              Discard();
             virtual uint32_t  GetType() const { return kTypeFileStream; }
             virtual int       GetAccessFlags() const;
             virtual int       GetState() const;
 
+            // Returns the underlying Posix file descriptor, or -1 if the stream isn't open.
+            // The stream caches its file position, so the descriptor's file offset must not 
+            // be moved by the user (e.g. via lseek or read); use pread and pwrite instead.
+            int               GetFileHandle() const { return mnFileHandle; }
+
+            void              setOption(int option, int value);
+
+            // getSize uses a single fstat call, or no system call if kOptionCacheSize is enabled.
             virtual size_type getSize() const;
             virtual bool      SetSize(size_type size);
 
+            // GetPosition and GetAvailable use the cached file position and so make no system call 
+            // for kPositionTypeBegin; the others additionally require getSize.
             virtual off_type  GetPosition(PositionType positionType = kPositionTypeBegin) const;
             virtual bool      SetPosition(off_type position, PositionType positionType = kPositionTypeBegin);
 
@@ -108,8 +158,87 @@ namespace EA
 
             virtual size_type Read(void* pData, size_type nSize);
             virtual bool      Write(const void* pData, size_type nSize);
+
+            /// Flush
+            /// Does what the kOptionFlushPolicy policy selects. Returns false if the sync fails, 
+            /// in which case GetState returns the error, written data may have been lost even if 
+            /// a later Flush succeeds, and a kCDReplaceAtomic replacement is discarded by Commit.
+            /// With kFlushPolicyNone this returns true, and with kFlushPolicyWriteBehind a return 
+            /// of true means only that writeback was started.
             virtual bool      Flush();
 
+            // These use pread/pwrite and so don't move the file position. They may be called 
+            // concurrently with each other from multiple threads on the same FileStream, as the 
+            // only stream state they change is changed atomically: upon failure, the error which 
+            // GetState returns and, for WriteAt, the write failure which makes Commit discard a 
+            // kCDReplaceAtomic replacement; and for WriteAt, the size cached with kOptionCacheSize.
+            // They aren't synchronized with the other functions (e.g. Read, Write, getSize), 
+            // which need external synchronization as usual. The interleaving of concurrent 
+            // writes to the same bytes is undefined.
+            virtual size_type ReadAt(size_type nPosition, void* pData, size_type nSize);
+            virtual bool      WriteAt(size_type nPosition, const void* pData, size_type nSize);
+
+            // These use readv/writev, so multiple buffers are transferred with a single system call.
+            virtual size_type ReadV(const IOVector* pIOVectorArray, size_t nCount);
+            virtual bool      WriteV(const ConstIOVector* pIOVectorArray, size_t nCount);
+
+            /// CopyFrom
+            /// Copies up to nSize bytes from the current position of pSource to the current position
+            /// of this stream within the kernel (copy_file_range, else sendfile), without the data 
+            /// passing through user memory. On file systems which support it, copy_file_range shares 
+            /// the data blocks instead of duplicating them. Both stream positions are advanced by the 
+            /// number of bytes copied, which is returned. This is less than nSize if the end of the 
+            /// source was reached or if the kernel can't copy between these two files, in which case 
+            /// the caller should copy the remainder by other means, such as copyStream.
+            /// Returns kSizeTypeError upon an I/O error. This is used by copyStream.
+            size_type         CopyFrom(FileStream* pSource, size_type nSize);
+
+            /// Prefetch
+            /// Asks the kernel to start reading the given range of the file into the page
+            /// cache in the background, so that a subsequent read of it doesn't block on 
+            /// the device. An nSize of 0 means through the end of the file. This is only
+            /// advice; it returns false if the stream isn't open or the advice is rejected.
+            bool              Prefetch(size_type nPosition, size_type nSize);
+
+            /// Preallocate
+            /// Allocates disk blocks for the given range of the file (fallocate), so that later writes to 
+            /// it don't need to allocate blocks or extend the file. Preallocating a large, contiguous range 
+            /// reduces fragmentation and metadata updates for files which grow by appending.
+            /// If bKeepSize is true then the file size is unchanged, even if the range extends beyond the 
+            /// end of the file; else the file grows to include the range. If the file system doesn't 
+            /// support fallocate and bKeepSize is false, blocks are allocated by writing zeros 
+            /// (posix_fallocate), which is slow. Returns false upon failure.
+            ///
+            /// Example usage:
+            ///     fileStream.Preallocate(fileStream.getSize(), 1024 * 1024 * 1024, true); // Reserve another 1 GB for appending.
+            ///
+            bool              Preallocate(size_type nPosition, size_type nSize, bool bKeepSize = false);
+
+            /// PunchHole
+            /// Deallocates the disk blocks of the given range, which then reads as zeros. The file size 
+            /// is unchanged. Returns false if the stream isn't open or if the file system doesn't support it.
+            bool              PunchHole(size_type nPosition, size_type nSize);
+
+            /// FindData
+            /// Finds the first range of allocated data which begins at or contains nPosition. The range is 
+            /// returned as [nDataBegin, nDataEnd). Returns false if there is no data at or after nPosition.
+            /// Files which aren't sparse, or file systems which don't track holes, report the entire file 
+            /// as a single data range. The stream position is unchanged.
+            ///
+            /// Example usage:
+            ///     size_type nBegin, nEnd;
+            ///
+            ///     for(size_type nPosition = 0; fileStream.FindData(nPosition, nBegin, nEnd); nPosition = nEnd)
+            ///         ProcessRange(nBegin, nEnd);
+            ///
+            bool              FindData(size_type nPosition, size_type& nDataBegin, size_type& nDataEnd) const;
+
+        protected:
+            void              ReleaseReadPages(size_type nPosition, size_type nSize);
+            int               OpenReplacement(int nOpenFlags);
+            bool              PublishReplacement();
+            void              DiscardReplacement();
+
         protected:
             typedef EA::IO::Path::PathString8 PathString8;
 
@@ -121,6 +250,16 @@ namespace EA
             int         mnSharing;                  /// See enum Share.
             int         mnUsageHints;               /// See enum UsageHints.
             mutable int mnLastError;                /// Used for error reporting.
+            PathString8 mTempPath8;                 /// With kCDReplaceAtomic, the path of the file which replaces mPath8 upon Commit, or empty while the file is anonymous.
+            PathString8 mReplacePath8;              /// With kCDReplaceAtomic, the path of the file being replaced, which is mPath8 with symbolic links resolved.
+            size_type   mnReleaseBegin;             /// With kUsageHintDontNeed, the beginning of the range which has been read but whose pages haven't yet been released.
+            size_type   mnReleaseEnd;               /// With kUsageHintDontNeed, the end of the above range.
+            size_type   mnPosition;                 /// Cached file position, which mirrors the file offset of mnFileHandle.
+            bool        mbEnableSizeCache;          /// See kOptionCacheSize.
+            mutable size_type mnSize;               /// Cached file size if mbEnableSizeCache is true, or kSizeTypeError if not yet known.
+            int         mnFlushPolicy;              /// See enum FlushPolicy.
+            bool        mbPreallocate;              /// See kOptionPreallocate.
+            bool        mbWriteFailed;              /// True if a write (including WriteAt), size change or flush failed since open. Commit then discards the replacement.
 
         }; // class FileStream
 
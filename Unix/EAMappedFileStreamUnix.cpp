@@ -0,0 +1,435 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAMappedFileStreamUnix.cpp
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Provides a memory-mapped read-only file stream for Unix-compatible 
+// platforms. These include Linux, Mac OS X, Solaris, BSD.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include <eaio/internal/Config.h>
+#include <eaio/EAMappedFileStream.h>
+#include <eaio/Allocator.h>
+#include <eaio/FnEncode.h>
+#include EA_ASSERT_HEADER
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+namespace EA
+{
+
+namespace IO
+{
+
+
+MappedFileStream::MappedFileStream(const char8_t* pPath8)
+  : IStream(),
+    mpData(NULL),
+    mnSize(0),
+    mnPosition(0),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen)
+{
+    MappedFileStream::setPath(pPath8); // Note that in a constructor, the virtual function mechanism is inoperable, so we qualify the function call.
+}
+
+
+MappedFileStream::MappedFileStream(const char16_t* pPath16)
+  : IStream(),
+    mpData(NULL),
+    mnSize(0),
+    mnPosition(0),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(0),
+    mnLastError(kStateNotOpen)
+{
+    MappedFileStream::setPath(pPath16);
+}
+
+
+MappedFileStream::MappedFileStream(const MappedFileStream& fs)
+  : IStream(),
+    mpData(NULL),
+    mnSize(0),
+    mnPosition(0),
+    mPath8(),
+    mnRefCount(0),
+    mnAccessFlags(0),
+    mnUsageHints(fs.mnUsageHints),
+    mnLastError(kStateNotOpen)
+{
+    MappedFileStream::setPath(fs.mPath8.c_str());
+}
+
+
+MappedFileStream::~MappedFileStream()
+{
+    MappedFileStream::close(); // Note that in a destructor, the virtual function mechanism is inoperable, so we qualify the function call.
+}
+
+
+MappedFileStream& MappedFileStream::operator=(const MappedFileStream& fs)
+{
+    close();
+    setPath(fs.mPath8.c_str());
+
+    mnUsageHints = fs.mnUsageHints;
+    mnLastError  = kStateNotOpen;
+
+    return *this;
+}
+
+
+int MappedFileStream::AddRef()
+{
+    return ++mnRefCount;
+}
+
+
+int MappedFileStream::Release()
+{
+    if(mnRefCount > 1)
+        return --mnRefCount;
+    delete this;
+    return 0;
+}
+
+
+void MappedFileStream::setPath(const char8_t* pPath8)
+{
+    if(!mnAccessFlags && pPath8)
+        mPath8 = pPath8;
+}
+
+
+void MappedFileStream::setPath(const char16_t* pPath16)
+{
+    if(!mnAccessFlags && pPath16)
+        ConvertPathUTF16ToUTF8(mPath8, pPath16);
+}
+
+
+size_t MappedFileStream::getPath(char8_t* pPath8, size_t nPathCapacity)
+{
+    // Return the required strlen of the destination path.
+    return EAIOStrlcpy8(pPath8, mPath8.c_str(), nPathCapacity);
+}
+
+
+size_t MappedFileStream::getPath(char16_t* pPath16, size_t nPathCapacity)
+{
+    // Return the required strlen of the destination path.
+    return StrlcpyUTF8ToUTF16(pPath16, nPathCapacity, mPath8.c_str(), mPath8.length());
+}
+
+
+bool MappedFileStream::open(int nAccessFlags, int nCreationDisposition, int /*nSharing*/, int nUsageHints)
+{
+    if(!mnAccessFlags) // If not already open...
+    {
+        if((nAccessFlags != kAccessFlagRead) || 
+           ((nCreationDisposition != kCDOpenExisting) && (nCreationDisposition != kCDDefault)))
+        {
+            mnLastError = kStateError; // A mapped file stream is read-only and can't create files.
+            return false;
+        }
+
+        const int nFileHandle = ::open(mPath8.c_str(), O_RDONLY);
+
+        if(nFileHandle < 0)
+        {
+            mnLastError = errno;
+            return false;
+        }
+
+        struct stat tempStat;
+
+        if(fstat(nFileHandle, &tempStat) == 0)
+        {
+            mnSize = (size_type)tempStat.st_size;
+
+            // mmap fails for zero-length mappings, so we represent an empty file with a NULL mapping.
+            // With a 32 bit size_t, a file can be larger than the address space can map.
+            if(mnSize != (size_type)(size_t)mnSize)
+                mnLastError = EFBIG;
+            else if(mnSize)
+            {
+                void* const pData = mmap(NULL, (size_t)mnSize, PROT_READ, MAP_SHARED, nFileHandle, 0);
+
+                if(pData != MAP_FAILED)
+                {
+                    mpData = pData;
+
+                    if(nUsageHints & FileStream::kUsageHintSequential)
+                        madvise(mpData, (size_t)mnSize, MADV_SEQUENTIAL);
+                    else if(nUsageHints & FileStream::kUsageHintRandom)
+                        madvise(mpData, (size_t)mnSize, MADV_RANDOM);
+
+                    if(nUsageHints & FileStream::kUsageHintWillNeed)
+                        madvise(mpData, (size_t)mnSize, MADV_WILLNEED);
+                }
+                else
+                    mnLastError = errno;
+            }
+
+            if(mpData || !mnSize)
+            {
+                mnPosition    = 0;
+                mnAccessFlags = kAccessFlagRead;
+                mnUsageHints  = nUsageHints;
+                mnLastError   = 0;
+            }
+            else
+                mnSize = 0;
+        }
+        else
+            mnLastError = errno;
+
+        // The mapping remains valid after the file descriptor is closed, 
+        // so we don't tie up a descriptor for the lifetime of the stream.
+        ::close(nFileHandle);
+    }
+
+    return (mnAccessFlags != 0);
+}
+
+
+bool MappedFileStream::close()
+{
+    if(mnAccessFlags)
+    {
+        if(mpData)
+            munmap(mpData, (size_t)mnSize); // This returns -1 upon error. But there's not much to do about it.
+
+        mpData        = NULL;
+        mnSize        = 0;
+        mnPosition    = 0;
+        mnAccessFlags = 0;
+        mnUsageHints  = 0;
+        mnLastError   = kStateNotOpen;
+    }
+
+    return true;
+}
+
+
+int MappedFileStream::GetAccessFlags() const
+{
+    return mnAccessFlags;
+}
+
+
+int MappedFileStream::GetState() const
+{
+    return mnLastError;
+}
+
+
+size_type MappedFileStream::getSize() const
+{
+    if(mnAccessFlags)
+        return mnSize;
+
+    return kSizeTypeError;
+}
+
+
+bool MappedFileStream::SetSize(size_type)
+{
+    return false; // The stream is read-only.
+}
+
+
+off_type MappedFileStream::GetPosition(PositionType positionType) const
+{
+    switch(positionType)
+    {
+        case kPositionTypeBegin:
+            return (off_type)mnPosition;
+
+        case kPositionTypeEnd:
+            return (off_type)(mnPosition - mnSize);
+
+        case kPositionTypeCurrent:
+        default:
+            break;
+    }
+
+    return 0; // For kPositionTypeCurrent the result is always zero for a 'get' operation.
+}
+
+
+bool MappedFileStream::SetPosition(off_type nPosition, PositionType positionType)
+{
+    if(mnAccessFlags)
+    {
+        switch(positionType)
+        {
+            case kPositionTypeBegin:
+                break;
+
+            case kPositionTypeCurrent:
+                nPosition = (off_type)(nPosition + mnPosition);
+                break;
+
+            case kPositionTypeEnd:
+                nPosition = (off_type)(nPosition + mnSize);
+                break;
+        }
+
+        // Deal with out-of-bounds situations that result from the above.
+        if(nPosition < 0)
+            mnPosition = 0;
+        else if((size_type)nPosition > mnSize)
+            mnPosition = mnSize;
+        else
+        {
+            mnPosition = (size_type)nPosition;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+size_type MappedFileStream::GetAvailable() const
+{
+    if(mnAccessFlags)
+        return (mnSize - mnPosition);
+
+    return kSizeTypeError;
+}
+
+
+size_type MappedFileStream::Read(void* pData, size_type nSize)
+{
+    if(mnAccessFlags)
+    {
+        EA_ASSERT(mnPosition <= mnSize);
+        const size_type nBytesAvailable(mnSize - mnPosition);
+
+        if(nSize > nBytesAvailable)
+            nSize = nBytesAvailable;
+
+        if(nSize)
+        {
+            memcpy(pData, (const uint8_t*)mpData + mnPosition, (size_t)nSize);
+            mnPosition += nSize;
+        }
+
+        return nSize;
+    }
+
+    return kSizeTypeError;
+}
+
+
+size_type MappedFileStream::ReadAt(size_type nPosition, void* pData, size_type nSize)
+{
+    if(mnAccessFlags)
+    {
+        if(nPosition > mnSize)
+            nPosition = mnSize;
+
+        const size_type nBytesAvailable(mnSize - nPosition);
+
+        if(nSize > nBytesAvailable)
+            nSize = nBytesAvailable;
+
+        if(nSize)
+            memcpy(pData, (const uint8_t*)mpData + nPosition, (size_t)nSize);
+
+        return nSize;
+    }
+
+    return kSizeTypeError;
+}
+
+
+bool MappedFileStream::Prefetch(size_type nPosition, size_type nSize)
+{
+    if(mpData && (nPosition < mnSize))
+    {
+        if(!nSize || (nSize > (mnSize - nPosition)))
+            nSize = (mnSize - nPosition);
+
+        // madvise requires a page-aligned address; we round the beginning of the range down.
+        const size_type nPageSize = (size_type)sysconf(_SC_PAGESIZE);
+        const size_type nBegin    = nPosition - (nPosition % nPageSize);
+
+        if(madvise((uint8_t*)mpData + nBegin, (size_t)(nPosition + nSize - nBegin), MADV_WILLNEED) == 0)
+            return true;
+
+        mnLastError = errno;
+    }
+    return false;
+}
+
+
+bool MappedFileStream::Write(const void*, size_type)
+{
+    return false; // The stream is read-only.
+}
+
+
+bool MappedFileStream::Flush()
+{
+    return true; // Nothing to do.
+}
+
+
+} // namespace IO
+
+
+} // namespace EA
+
+
+
+
+
+
+
+
+
+
@@ -0,0 +1,199 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAMappedFileStreamUnix.h
+//
+// copyright (c) 2003, Electronic Arts Inc. All rights reserved.
+//
+// Implements a read-only file stream which is backed by a memory mapping
+// of the file instead of by read() calls.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIO_EAMAPPEDFILESTREAM_UNIX_H
+#define EAIO_EAMAPPEDFILESTREAM_UNIX_H
+
+
+#include <eaio/EAFileStream.h>
+#include <eaio/EAFileBase.h>
+#include <eaio/PathString.h>
+#include <stddef.h>
+
+
+
+namespace EA
+{
+    namespace IO
+    {
+        /// class MappedFileStream
+        ///
+        /// Implements a read-only file stream which maps the entire file into
+        /// memory upon open. Read, SetPosition and GetAvailable are then simple
+        /// pointer arithmetic on the mapping and involve no system calls.
+        /// GetData returns a pointer to the mapped bytes, which allows the user
+        /// to bypass Read and its memcpy entirely.
+        ///
+        /// Since the mapping is shared, multiple processes which map the same
+        /// file share the same physical pages in the system file cache.
+        ///
+        /// This class is not inherently thread-safe. However, once the stream is
+        /// open, the memory returned by GetData can be read by any number of
+        /// threads concurrently, as it doesn't change until the stream is closed.
+        ///
+        /// The mapping reflects the file itself rather than a copy of it. If another 
+        /// process truncates the file while it is mapped, then touching the mapped 
+        /// pages beyond the new end of the file, whether through GetData or through 
+        /// Read and ReadAt, raises SIGBUS rather than returning an error. Don't map 
+        /// files which may be truncated while in use. Files larger than the address
+        /// space (i.e. over 4 GB with a 32 bit size_t) fail to open with EFBIG.
+        ///
+        /// Example usage:
+        ///     MappedFileStream stream("/data/pack.big");
+        ///
+        ///     if(stream.open())
+        ///     {
+        ///         const uint8_t* pData = (const uint8_t*)stream.GetData();
+        ///         ParsePack(pData, stream.getSize());
+        ///         stream.close();
+        ///     }
+        ///
+        class EAIO_API MappedFileStream : public IStream
+        {
+        public:
+            enum { kTypeMappedFileStream = 0x34722310 };
+
+        public:
+            MappedFileStream(const char8_t* pPath8 = NULL);
+            MappedFileStream(const char16_t* pPath16);
+
+            // MappedFileStream
+            // Does not copy information related to an open file, such as the mapping.
+            MappedFileStream(const MappedFileStream& fs);
+
+            virtual ~MappedFileStream();
+
+            // operator=
+            // Does not copy information related to an open file, such as the mapping.
+            MappedFileStream& operator=(const MappedFileStream& fs);
+
+            virtual int       AddRef();
+            virtual int       Release();
+
+            virtual void      setPath(const char8_t* pPath8);
+            virtual void      setPath(const char16_t* pPath16);
+            virtual size_t    getPath(char8_t* pPath8, size_t nPathCapacity);
+            virtual size_t    getPath(char16_t* pPath16, size_t nPathCapacity);
+
+            // Only kAccessFlagRead is supported. The creation disposition must be kCDOpenExisting or kCDDefault.
+            // kUsageHintSequential, kUsageHintRandom and kUsageHintWillNeed are passed on to the kernel as paging advice for the mapping.
+            virtual bool      open(int nAccessFlags = kAccessFlagRead, int nCreationDisposition = kCDOpenExisting, int nSharing = FileStream::kShareRead, int nUsageHints = FileStream::kUsageHintNone);
+            virtual bool      close();
+            virtual uint32_t  GetType() const { return kTypeMappedFileStream; }
+            virtual int       GetAccessFlags() const;
+            virtual int       GetState() const;
+
+            virtual size_type getSize() const;
+            virtual bool      SetSize(size_type size);
+
+            virtual off_type  GetPosition(PositionType positionType = kPositionTypeBegin) const;
+            virtual bool      SetPosition(off_type position, PositionType positionType = kPositionTypeBegin);
+
+            virtual size_type GetAvailable() const;
+
+            virtual size_type Read(void* pData, size_type nSize);
+            virtual bool      Write(const void* pData, size_type nSize);
+            virtual bool      Flush();
+
+            // Doesn't use or change the stream position and so may be called concurrently from multiple threads.
+            virtual size_type ReadAt(size_type nPosition, void* pData, size_type nSize);
+
+            /// Prefetch
+            /// Asks the kernel to start paging in the given range of the mapping in the
+            /// background. An nSize of 0 means through the end of the file.
+            bool              Prefetch(size_type nPosition, size_type nSize);
+
+            /// GetData
+            /// Returns a pointer to the beginning of the mapped file data, or NULL if the
+            /// stream isn't open or if the file is empty. The pointer is valid until close.
+            const void*       GetData() const;
+
+        protected:
+            typedef EA::IO::Path::PathString8 PathString8;
+
+            void*       mpData;                     /// Pointer to the mapped file data.
+            size_type   mnSize;                     /// Size of the mapping, which is the file size at the time of open.
+            size_type   mnPosition;                 /// Current read position within the mapping.
+            PathString8 mPath8;                     /// Path for the file.
+            int         mnRefCount;                 /// Reference count, which may or may not be in use.
+            int         mnAccessFlags;              /// See enum AccessFlags.
+            int         mnUsageHints;               /// See enum FileStream::UsageHints.
+            mutable int mnLastError;                /// Used for error reporting.
+
+        }; // class MappedFileStream
+
+    } // namespace IO
+
+} // namespace EA
+
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// inlines
+/////////////////////////////////////////////////////////////////////////////
+
+namespace EA
+{
+    namespace IO
+    {
+        inline
+        const void* MappedFileStream::GetData() const
+        {
+            return mpData;
+        }
+
+    } // namespace IO
+
+} // namespace EA
+
+
+#endif  // #ifndef EAIO_EAMAPPEDFILESTREAM_UNIX_H
+
+
+
+
+
+
+
+
+
+
+
+
@@ -98,7 +98,25 @@ namespace EA
             {
                 kUsageHintNone       = 0x00,
                 kUsageHintSequential = 0x01,
-                kUsageHintRandom     = 0x02
+                kUsageHintRandom     = 0x02,
+                kUsageHintWillNeed   = 0x04,     /// Currently ignored on this platform.
+                kUsageHintDontNeed   = 0x08,     /// Currently ignored on this platform.
+                kUsageHintNoReuse    = 0x10      /// Currently ignored on this platform.
+            };
+
+            enum Option
+            {
+                kOptionCacheSize   = 1,  /// Currently ignored on this platform.
+                kOptionFlushPolicy = 2,  /// Currently ignored on this platform; Flush always does a full flush.
+                kOptionPreallocate = 3   /// Currently ignored on this platform.
+            };
+
+            enum FlushPolicy
+            {
+                kFlushPolicyNone        = 0,
+                kFlushPolicyWriteBehind = 1,
+                kFlushPolicyDataSync    = 2,
+                kFlushPolicySync        = 3
             };
 
         public:
@@ -125,6 +143,15 @@ namespace EA
 
             virtual bool      open(int nAccessFlags = kAccessFlagRead, int nCreationDisposition = kCDDefault, int nSharing = kShareRead, int nUsageHints = kUsageHintNone); 
             virtual bool      close();
+
+            /// Commit
+            /// kCDReplaceAtomic isn't supported on this platform, so this is the same as close.
+            bool              Commit();
+
+            /// Discard
+            /// kCDReplaceAtomic isn't supported on this platform, so there is never written data 
+            /// to discard. This closes the stream like close but returns false.
+            bool              Discard();
             virtual uint32_t  GetType() const { return kTypeFileStream; }
             virtual int       GetAccessFlags() const;
             virtual int       GetState() const;
@@ -141,6 +168,20 @@ namespace EA
             virtual bool      Write(const void* pData, size_type nSize);
             virtual bool      Flush();
 
+            // Advisory; currently has no effect on this platform.
+            bool              Prefetch(size_type nPosition, size_type nSize);
+
+            // Currently unsupported on this platform; these return false.
+            bool              Preallocate(size_type nPosition, size_type nSize, bool bKeepSize = false);
+            bool              PunchHole(size_type nPosition, size_type nSize);
+
+            /// FindData
+            /// Holes aren't tracked on this platform, so this reports the entire file 
+            /// as a single data range. Returns false if there is no data at or after nPosition.
+            bool              FindData(size_type nPosition, size_type& nDataBegin, size_type& nDataEnd) const;
+
+            void              setOption(int option, int value);
+
         protected:
             void*             mhFile;                     /// We defined as void* instead of HANDLE in order to simplify header includes. HANDLE is typedef'd to (void *) on all Windows platforms.
             char16_t          mpPath16[kMaxPathLength];   /// Path for the file.
@@ -259,6 +259,41 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// EAIO_IO_URING_ENABLED
+//
+// Defined as 0 or 1. Default is 1 on Linux.
+// If enabled then AsyncFileIO uses the Linux io_uring interface when the
+// running kernel supports it, and falls back to a thread pool otherwise.
+// Disable this if building against kernel headers which lack <linux/io_uring.h>.
+//
+#ifndef EAIO_IO_URING_ENABLED
+    #if defined(EA_PLATFORM_LINUX)
+        #define EAIO_IO_URING_ENABLED 1
+    #else
+        #define EAIO_IO_URING_ENABLED 0
+    #endif
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// EAIO_REPLACE_ATOMIC_ENABLED
+//
+// Defined as 0 or 1. Default is 1 on Linux.
+// If enabled then FileStream supports the kCDReplaceAtomic creation disposition.
+// Elsewhere, opening a FileStream with kCDReplaceAtomic fails.
+//
+#ifndef EAIO_REPLACE_ATOMIC_ENABLED
+    #if defined(EA_PLATFORM_LINUX)
+        #define EAIO_REPLACE_ATOMIC_ENABLED 1
+    #else
+        #define EAIO_REPLACE_ATOMIC_ENABLED 0
+    #endif
+#endif
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // EAIO_CPP_STREAM_ENABLED
 //
@@ -14,6 +14,8 @@ StaticLibrary {
             {Config="ignore"; Pattern="Win32/"},
             {Config="ignore"; Pattern="Unix/"},
             {Config="ignore"; Pattern="StdC/"},
+            -- these are built into eaiotest
+            {Config="ignore"; Pattern="test/"},
          },
       },
    },
@@ -24,3 +26,19 @@ StaticLibrary {
    },
    Depends = { "eastl" },
 }
+
+Program {
+   Name = "eaiotest",
+   Sources = {
+      FGlob {
+         Dir = _G.LIBROOT_EAIO .. "/test/source",
+         Extensions = { ".h", ".cpp" },
+      },
+   },
+   Env = {
+      CPPPATH = {
+         "extlibs",
+      },
+   },
+   Depends = { "eaio", "eastl" },
+}
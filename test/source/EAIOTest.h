@@ -0,0 +1,88 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAIOTest.h
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Declares the EAIO unit tests and the helpers they share.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef EAIOTEST_EAIOTEST_H
+#define EAIOTEST_EAIOTEST_H
+
+
+#include <eastl/EABase/eabase.h>
+#include <stddef.h>
+#include <stdio.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// EAIOTEST_VERIFY
+//
+// Reports a failed expectation and counts it in the enclosing function's 
+// nErrorCount, which each test function returns.
+//
+#define EAIOTEST_VERIFY(expression)                                                     \
+    do {                                                                                \
+        if(!(expression))                                                               \
+        {                                                                               \
+            printf("%s(%d): Test failure: %s\n", __FILE__, __LINE__, #expression);     \
+            nErrorCount++;                                                              \
+        }                                                                               \
+    } while(0)
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MakeTestPath
+//
+// Makes the path of a file with the given name in the directory the tests
+// use for their files, which is given on the command line or else is the 
+// current directory.
+//
+void MakeTestPath(char8_t* pPath8, size_t nPathCapacity, const char8_t* pFileName8);
+
+
+// Each returns the number of errors found.
+int TestMappedFileStream();
+int TestBitStream();
+int TestStreamChecksum();
+int TestStreamAdapter();
+int TestStreamSerializer();
+int TestFileStream();
+int TestDirectFileStream();
+int TestStreamBuffer();
+int TestStreamBlockCache();
+int TestSharedBlockCache();
+int TestAsyncFileIO();
+
+
+#endif // Header include guard
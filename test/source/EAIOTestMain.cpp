@@ -0,0 +1,157 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// EAIOTestMain.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+// Runs the EAIO unit tests. The optional command line argument is the 
+// directory in which tests create their files. The exit code is the 
+// number of errors found.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eastl/coreallocator/icoreallocator_interface.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+namespace EAIOTestLocal
+{
+    const char8_t* gpTestDirectory = ".";
+
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // TestAllocator
+    //
+    // A malloc-based allocator. The application provides the default allocator, 
+    // so the test program must too. Every block is aligned by offsetting it within
+    // a larger allocation and storing the original pointer just before it, so that
+    // free needn't know which alloc function it came from.
+    //
+    class TestAllocator : public EA::Allocator::ICoreAllocator
+    {
+    public:
+        void* alloc(size_t size, const char* /*name*/, unsigned int /*flags*/)
+        {
+            return AllocAligned(size, 16, 0);
+        }
+
+        void* alloc(size_t size, const char* /*name*/, unsigned int /*flags*/, unsigned int align, unsigned int alignOffset)
+        {
+            return AllocAligned(size, (align > 16) ? align : 16, alignOffset);
+        }
+
+        void free(void* block, size_t /*size*/)
+        {
+            if(block)
+                ::free(((void**)block)[-1]);
+        }
+
+    protected:
+        static void* AllocAligned(size_t size, size_t align, size_t alignOffset)
+        {
+            char* const pBase = (char*)malloc(size + align + sizeof(void*));
+
+            if(pBase)
+            {
+                const uintptr_t nAligned = ((uintptr_t)(pBase + sizeof(void*) + alignOffset + align - 1) & ~(uintptr_t)(align - 1)) - alignOffset;
+                void** const    pBlock   = (void**)nAligned;
+
+                pBlock[-1] = pBase;
+                return pBlock;
+            }
+
+            return NULL;
+        }
+    };
+}
+
+
+namespace EA
+{
+    namespace Allocator
+    {
+        ICoreAllocator* ICoreAllocator::getDefaultAllocator()
+        {
+            static EAIOTestLocal::TestAllocator sTestAllocator;
+            return &sTestAllocator;
+        }
+    }
+}
+
+
+void MakeTestPath(char8_t* pPath8, size_t nPathCapacity, const char8_t* pFileName8)
+{
+    snprintf(pPath8, nPathCapacity, "%s/%s", EAIOTestLocal::gpTestDirectory, pFileName8);
+}
+
+
+int main(int argc, char** argv)
+{
+    typedef int (*TestFunction)();
+
+    struct TestInfo
+    {
+        const char*  mpName;
+        TestFunction mpFunction;
+    };
+
+    const TestInfo testArray[] = 
+    {
+        { "MappedFileStream",   TestMappedFileStream },
+        { "BitStream",          TestBitStream        },
+        { "StreamChecksum",     TestStreamChecksum   },
+        { "StreamAdapter",      TestStreamAdapter    },
+        { "StreamSerializer",   TestStreamSerializer },
+        { "FileStream",         TestFileStream       },
+        { "DirectFileStream",   TestDirectFileStream },
+        { "StreamBuffer",       TestStreamBuffer     },
+        { "StreamBlockCache",   TestStreamBlockCache },
+        { "SharedBlockCache",   TestSharedBlockCache },
+        { "AsyncFileIO",        TestAsyncFileIO      }
+    };
+
+    int nErrorCount = 0;
+
+    if(argc > 1)
+        EAIOTestLocal::gpTestDirectory = argv[1];
+
+    for(size_t i = 0; i < (sizeof(testArray) / sizeof(testArray[0])); i++)
+    {
+        const int nTestErrorCount = testArray[i].mpFunction();
+
+        printf("%-24s %s\n", testArray[i].mpName, nTestErrorCount ? "failed" : "passed");
+        nErrorCount += nTestErrorCount;
+    }
+
+    return nErrorCount;
+}
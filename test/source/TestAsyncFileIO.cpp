@@ -0,0 +1,182 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestAsyncFileIO.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAAsyncFileIO.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+
+#if EAIO_ASYNC_FILE_IO_ENABLED
+
+namespace TestAsyncFileIOLocal
+{
+    const size_t kBlockSize  = 1000;
+    const size_t kBlockCount = 40;
+
+    struct ResubmitContext
+    {
+        EA::IO::AsyncFileIO* mpAsyncFileIO;
+        int                  mnRemaining;    /// Number of times left to resubmit.
+    };
+
+    // Resubmits the request from within its own completion callback.
+    void ResubmitCallback(EA::IO::AsyncIORequest* pRequest, void* pContext)
+    {
+        ResubmitContext* const pResubmitContext = (ResubmitContext*)pContext;
+
+        if(pResubmitContext->mnRemaining-- > 0)
+            pResubmitContext->mpAsyncFileIO->Submit(pRequest);
+    }
+
+    // Writes kBlockCount blocks with one batch of requests, then reads them back
+    // with another, with the queue depth less than the number of requests.
+    int TestBackend(const char8_t* pPath8, bool bAllowIOUring)
+    {
+        using namespace EA::IO;
+
+        int nErrorCount = 0;
+
+        static uint8_t writeArray[kBlockCount][kBlockSize];
+        static uint8_t readArray[kBlockCount][kBlockSize];
+        AsyncIORequest requestArray[kBlockCount];
+        AsyncIORequest* pRequestArray[kBlockCount];
+
+        for(size_t i = 0; i < kBlockCount; i++)
+        {
+            for(size_t j = 0; j < kBlockSize; j++)
+                writeArray[i][j] = (uint8_t)(i + j);
+            pRequestArray[i] = &requestArray[i];
+        }
+
+        memset(readArray, 0, sizeof(readArray));
+
+        FileStream  fileStream(pPath8);
+        AsyncFileIO asyncFileIO;
+
+        EAIOTEST_VERIFY(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways));
+        EAIOTEST_VERIFY(asyncFileIO.Init(8, 3, bAllowIOUring));
+        EAIOTEST_VERIFY(!asyncFileIO.Init());
+        EAIOTEST_VERIFY(asyncFileIO.GetBackend() != AsyncFileIO::kBackendNone);
+        EAIOTEST_VERIFY(bAllowIOUring || (asyncFileIO.GetBackend() != AsyncFileIO::kBackendIOUring));
+
+        for(size_t i = 0; i < kBlockCount; i++)
+            requestArray[i].SetWrite(&fileStream, (size_type)(i * kBlockSize), writeArray[i], kBlockSize);
+
+        EAIOTEST_VERIFY(asyncFileIO.Submit(pRequestArray, kBlockCount));
+        asyncFileIO.Flush();
+        EAIOTEST_VERIFY(asyncFileIO.GetPendingCount() <= kBlockCount);
+
+        while(asyncFileIO.GetPendingCount())
+            asyncFileIO.Wait();
+
+        for(size_t i = 0; i < kBlockCount; i++)
+        {
+            EAIOTEST_VERIFY(requestArray[i].IsComplete());
+            EAIOTEST_VERIFY(requestArray[i].mnResult == kBlockSize);
+            EAIOTEST_VERIFY(requestArray[i].mnError == 0);
+        }
+
+        EAIOTEST_VERIFY(fileStream.getSize() == (size_type)(kBlockCount * kBlockSize));
+
+        for(size_t i = 0; i < kBlockCount; i++)
+            requestArray[i].SetRead(&fileStream, (size_type)(i * kBlockSize), readArray[i], kBlockSize);
+
+        EAIOTEST_VERIFY(asyncFileIO.Submit(pRequestArray, kBlockCount));
+        EAIOTEST_VERIFY(asyncFileIO.Wait(kBlockCount) == kBlockCount);
+        EAIOTEST_VERIFY(asyncFileIO.GetPendingCount() == 0);
+        EAIOTEST_VERIFY(memcmp(readArray, writeArray, sizeof(readArray)) == 0);
+
+        { // A read at the end of the file transfers less than requested.
+            uint8_t buffer[16];
+
+            requestArray[0].SetRead(&fileStream, (size_type)((kBlockCount * kBlockSize) - 4), buffer, sizeof(buffer));
+            EAIOTEST_VERIFY(asyncFileIO.Submit(&requestArray[0]));
+            asyncFileIO.Wait();
+            EAIOTEST_VERIFY(requestArray[0].mnResult == 4);
+            EAIOTEST_VERIFY(memcmp(buffer, &writeArray[kBlockCount - 1][kBlockSize - 4], 4) == 0);
+        }
+
+        { // A callback can resubmit its request.
+            uint8_t         buffer[kBlockSize];
+            ResubmitContext resubmitContext = { &asyncFileIO, 3 };
+
+            requestArray[0].SetRead(&fileStream, 0, buffer, kBlockSize, ResubmitCallback, &resubmitContext);
+            EAIOTEST_VERIFY(asyncFileIO.Submit(&requestArray[0]));
+
+            while(asyncFileIO.GetPendingCount())
+                asyncFileIO.Poll();
+
+            EAIOTEST_VERIFY(resubmitContext.mnRemaining < 0);
+            EAIOTEST_VERIFY(requestArray[0].mnResult == kBlockSize);
+        }
+
+        asyncFileIO.Shutdown();
+        EAIOTEST_VERIFY(asyncFileIO.GetBackend() == AsyncFileIO::kBackendNone);
+
+        // A request against a closed stream fails immediately.
+        fileStream.close();
+        requestArray[0].SetRead(&fileStream, 0, readArray[0], kBlockSize);
+        EAIOTEST_VERIFY(asyncFileIO.Init(8, 3, bAllowIOUring));
+        EAIOTEST_VERIFY(!asyncFileIO.Submit(&requestArray[0]));
+        EAIOTEST_VERIFY(requestArray[0].mnError == EBADF);
+        EAIOTEST_VERIFY(asyncFileIO.GetPendingCount() == 0);
+
+        return nErrorCount;
+    }
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestAsyncFileIO
+//
+int TestAsyncFileIO()
+{
+    int nErrorCount = 0;
+
+    #if EAIO_ASYNC_FILE_IO_ENABLED
+        char8_t path8[EA::IO::kMaxPathLength];
+        MakeTestPath(path8, EA::IO::kMaxPathLength, "AsyncFileIO.bin");
+
+        nErrorCount += TestAsyncFileIOLocal::TestBackend(path8, true);  // io_uring, where available.
+        nErrorCount += TestAsyncFileIOLocal::TestBackend(path8, false); // Thread pool, or synchronous.
+    #endif
+
+    return nErrorCount;
+}
@@ -0,0 +1,166 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestBitStream.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EABitStream.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAStreamBuffer.h>
+
+
+namespace TestBitStreamLocal
+{
+    const size_t kFieldCount = 5000;
+
+    // A MemoryStream which doesn't identify itself as one, so that the bit streams 
+    // can't use their direct memory access path and must go through Read and Write.
+    class OpaqueMemoryStream : public EA::IO::MemoryStream
+    {
+    public:
+        uint32_t GetType() const { return 0x3472234f; }
+    };
+
+    uint64_t Random64(uint64_t& nState)
+    {
+        nState = (nState * UINT64_C(6364136223846793005)) + UINT64_C(1442695040888963407);
+        return (nState >> 11) ^ (nState << 29);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestBitStream
+//
+// Writes fields of random widths from 0 to 64 bits and reads them back, with
+// the memory stream fast path, through Read and Write, and through a 
+// StreamBuffer whose buffer size isn't a multiple of the bit buffer size.
+//
+int TestBitStream()
+{
+    using namespace EA::IO;
+    using namespace TestBitStreamLocal;
+
+    int nErrorCount = 0;
+
+    static int      widthArray[kFieldCount];
+    static uint64_t valueArray[kFieldCount];
+    uint64_t        nState = 1;
+    size_type       nBitCount = 0;
+
+    for(size_t i = 0; i < kFieldCount; i++)
+    {
+        widthArray[i] = (int)(Random64(nState) % 65);
+        valueArray[i] = Random64(nState);
+
+        if(widthArray[i] < 64)
+            valueArray[i] &= ((UINT64_C(1) << widthArray[i]) - 1);
+        nBitCount += (size_type)widthArray[i];
+    }
+
+    for(int mode = 0; mode < 3; mode++)
+    {
+        MemoryStream* const pMemoryStream = (mode == 1) ? new OpaqueMemoryStream : new MemoryStream;
+
+        pMemoryStream->AddRef();
+        pMemoryStream->setOption(MemoryStream::kOptionResizeEnabled, 1);
+        pMemoryStream->Write("HDR", 3);
+
+        {
+            BitStreamWriter writer(pMemoryStream);
+
+            for(size_t i = 0; i < kFieldCount; i++)
+            {
+                if(widthArray[i] <= 32)
+                    writer.WriteBits((uint32_t)valueArray[i], widthArray[i]);
+                else
+                    writer.WriteBits64(valueArray[i], widthArray[i]);
+            }
+
+            EAIOTEST_VERIFY(writer.GetBitPosition() == nBitCount);
+            EAIOTEST_VERIFY(writer.Flush());
+            EAIOTEST_VERIFY(writer.IsValid());
+        }
+
+        pMemoryStream->Write("T", 1);
+
+        const size_type nStreamSize = pMemoryStream->getSize();
+        EAIOTEST_VERIFY(nStreamSize == (3 + ((nBitCount + 7) / 8) + 1));
+
+        IStream*      pStream       = pMemoryStream;
+        StreamBuffer* pStreamBuffer = NULL;
+
+        if(mode == 2)
+        {
+            pStreamBuffer = new StreamBuffer(100, 0, pMemoryStream);
+            pStreamBuffer->AddRef();
+            pStream = pStreamBuffer;
+        }
+
+        pStream->SetPosition(3);
+
+        {
+            BitStreamReader reader(pStream);
+            size_type       nBitPosition = 0;
+
+            for(size_t i = 0; i < kFieldCount; i++)
+            {
+                const uint64_t value = (widthArray[i] <= 32) ? reader.ReadBits(widthArray[i]) : reader.ReadBits64(widthArray[i]);
+
+                EAIOTEST_VERIFY(value == valueArray[i]);
+                nBitPosition += (size_type)widthArray[i];
+                EAIOTEST_VERIFY(reader.GetBitPosition() == nBitPosition);
+            }
+
+            // Sync leaves the stream just past the last byte which was read from.
+            EAIOTEST_VERIFY(reader.IsValid());
+            EAIOTEST_VERIFY(reader.Sync());
+            EAIOTEST_VERIFY((size_type)pStream->GetPosition() == (nStreamSize - 1));
+
+            // Reading past the end of the stream makes the reader invalid.
+            reader.setStream(NULL);
+            reader.setStream(pStream);
+            EAIOTEST_VERIFY(reader.ReadBits(8) == 'T');
+            EAIOTEST_VERIFY(reader.IsValid());
+            EAIOTEST_VERIFY(reader.ReadBits(1) == 0);
+            EAIOTEST_VERIFY(!reader.IsValid());
+        }
+
+        if(pStreamBuffer)
+            pStreamBuffer->Release();
+        pMemoryStream->Release();
+    }
+
+    return nErrorCount;
+}
@@ -0,0 +1,360 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestDirectFileStream.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EADirectFileStream.h>
+#include <eaio/EAFileStream.h>
+#include <string.h>
+#include <stdio.h>
+
+
+#if EAIO_DIRECT_FILE_STREAM_ENABLED
+
+namespace TestDirectFileStreamLocal
+{
+    using EA::IO::DirectFileStream;
+    using EA::IO::size_type;
+
+    // Large enough that some transfers exceed the stream's buffer and go directly to the device.
+    const size_type kFileCapacity = (2 * DirectFileStream::kBufferSize) + (4 * DirectFileStream::kAlignment);
+
+    // What the file is expected to hold. The tests keep this in step with their writes.
+    uint8_t   gExpected[kFileCapacity];
+    size_type gExpectedSize = 0;
+
+    // Transfer memory, kAlignment-aligned so that large transfers can bypass the buffer.
+    uint8_t   gMemory[kFileCapacity + DirectFileStream::kAlignment];
+
+    uint8_t* AlignedMemory()
+    {
+        return gMemory + (DirectFileStream::kAlignment - ((uintptr_t)gMemory % DirectFileStream::kAlignment)) % DirectFileStream::kAlignment;
+    }
+
+    // Writes nSize bytes of a pattern seeded by nSeed at the stream's position, and to gExpected.
+    bool Write(DirectFileStream& stream, const uint8_t* pMemory, size_type nSize, int nSeed)
+    {
+        const size_type nPosition = (size_type)stream.GetPosition();
+        uint8_t* const  pData     = const_cast<uint8_t*>(pMemory);
+
+        for(size_type i = 0; i < nSize; i++)
+            pData[i] = (uint8_t)(((nPosition + i) * 31) + nSeed + ((nPosition + i) >> 12));
+
+        if(gExpectedSize < nPosition) // Writing past the end fills the gap with zeroes.
+            memset(gExpected + gExpectedSize, 0, (size_t)(nPosition - gExpectedSize));
+
+        memcpy(gExpected + nPosition, pData, (size_t)nSize);
+
+        if(gExpectedSize < (nPosition + nSize))
+            gExpectedSize = (nPosition + nSize);
+
+        return stream.Write(pData, nSize);
+    }
+
+    // Reads nSize bytes at nPosition into pMemory and compares them with gExpected.
+    bool ReadEquals(DirectFileStream& stream, size_type nPosition, uint8_t* pMemory, size_type nSize)
+    {
+        memset(pMemory, 0xee, (size_t)nSize);
+
+        return stream.SetPosition((EA::IO::off_type)nPosition) && 
+               (stream.Read(pMemory, nSize) == nSize) && 
+               (stream.GetPosition() == (EA::IO::off_type)(nPosition + nSize)) &&
+               (memcmp(pMemory, gExpected + nPosition, (size_t)nSize) == 0);
+    }
+
+    // Returns true if the file at pPath8, read with a regular FileStream, matches gExpected.
+    bool FileEqualsExpected(const char8_t* pPath8)
+    {
+        EA::IO::FileStream fileStream(pPath8);
+        uint8_t* const     pMemory = AlignedMemory();
+
+        return fileStream.open(EA::IO::kAccessFlagRead) && 
+               (fileStream.getSize() == gExpectedSize) &&
+               (fileStream.Read(pMemory, kFileCapacity) == gExpectedSize) &&
+               (memcmp(pMemory, gExpected, (size_t)gExpectedSize) == 0);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestDirectFileStreamReadWrite
+//
+// Aligned and unaligned reads and writes, which cross block and buffer boundaries.
+//
+static int TestDirectFileStreamReadWrite()
+{
+    using namespace EA::IO;
+    using namespace TestDirectFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    const size_type kAlignment  = DirectFileStream::kAlignment;
+    const size_type kBufferSize = DirectFileStream::kBufferSize;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "DirectFileStreamReadWrite.bin");
+
+    uint8_t* const pAligned   = AlignedMemory();
+    uint8_t* const pUnaligned = AlignedMemory() + 3;
+
+    gExpectedSize = 0;
+
+    {
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagReadWrite, kCDCreateAlways));
+        EAIOTEST_VERIFY(stream.getSize() == 0);
+
+        // An aligned write larger than the buffer, which mostly bypasses it.
+        EAIOTEST_VERIFY(Write(stream, pAligned, kBufferSize + kAlignment + 100, 1));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+
+        // Unaligned writes which continue it and cross block boundaries.
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, 5000, 2));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, 3 * kAlignment, 3));
+
+        // An unaligned overwrite in the middle of the file, straddling two blocks, 
+        // whose surrounding data must survive the read-modify-write.
+        EAIOTEST_VERIFY(stream.SetPosition((off_type)((3 * kAlignment) - 10)));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, 20, 4));
+
+        // An aligned overwrite which is smaller than a block.
+        EAIOTEST_VERIFY(stream.SetPosition((off_type)(5 * kAlignment)));
+        EAIOTEST_VERIFY(Write(stream, pAligned, 100, 5));
+
+        // Unflushed data is visible to reads.
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(ReadEquals(stream, (5 * kAlignment) - 50, pUnaligned, 200));
+        EAIOTEST_VERIFY(ReadEquals(stream, (3 * kAlignment) - 100, pUnaligned, 200));
+
+        // Reads which cross block and buffer boundaries, aligned and not.
+        EAIOTEST_VERIFY(ReadEquals(stream, 0, pAligned, gExpectedSize));
+        EAIOTEST_VERIFY(ReadEquals(stream, 1, pUnaligned, gExpectedSize - 1));
+        EAIOTEST_VERIFY(ReadEquals(stream, kAlignment, pAligned, kBufferSize + kAlignment));
+        EAIOTEST_VERIFY(ReadEquals(stream, kBufferSize - 7, pUnaligned, 2 * kAlignment));
+        EAIOTEST_VERIFY(ReadEquals(stream, gExpectedSize - 1, pUnaligned, 1));
+
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    EAIOTEST_VERIFY(FileEqualsExpected(path8));
+
+    { // Reopening and reading gets the same data, whether or not O_DIRECT is in use.
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagRead, kCDOpenExisting, FileStream::kShareRead, FileStream::kUsageHintSequential));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(ReadEquals(stream, 0, pAligned, gExpectedSize));
+        EAIOTEST_VERIFY(ReadEquals(stream, kAlignment + 1, pUnaligned, kBufferSize));
+        EAIOTEST_VERIFY(!stream.Write(pAligned, 1));
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    { // A write which starts unaligned within the existing data and extends the file.
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagReadWrite, kCDOpenExisting));
+        EAIOTEST_VERIFY(stream.SetPosition(-50, kPositionTypeEnd));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, kAlignment + 7, 6));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    EAIOTEST_VERIFY(FileEqualsExpected(path8));
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestDirectFileStreamSetSize
+//
+static int TestDirectFileStreamSetSize()
+{
+    using namespace EA::IO;
+    using namespace TestDirectFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    const size_type kAlignment = DirectFileStream::kAlignment;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "DirectFileStreamSetSize.bin");
+
+    uint8_t* const pUnaligned = AlignedMemory() + 1;
+
+    gExpectedSize = 0;
+
+    {
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagReadWrite, kCDCreateAlways));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, (4 * kAlignment) + 300, 1));
+
+        // Shrinking to an unaligned size discards buffered data beyond it.
+        EAIOTEST_VERIFY(stream.SetSize((2 * kAlignment) + 11));
+        gExpectedSize = (2 * kAlignment) + 11;
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(ReadEquals(stream, kAlignment - 5, pUnaligned, kAlignment + 16));
+        EAIOTEST_VERIFY(stream.GetAvailable() == 0);
+
+        // Growing exposes zeroes, not the discarded data.
+        EAIOTEST_VERIFY(stream.SetSize((3 * kAlignment) + 5));
+        memset(gExpected + gExpectedSize, 0, (size_t)(((3 * kAlignment) + 5) - gExpectedSize));
+        gExpectedSize = (3 * kAlignment) + 5;
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(ReadEquals(stream, 0, pUnaligned, gExpectedSize));
+
+        // Writes after a size change land in the right place.
+        EAIOTEST_VERIFY(stream.SetPosition(10, kPositionTypeEnd));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, 20, 2));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    EAIOTEST_VERIFY(FileEqualsExpected(path8));
+
+    { // SetSize requires write access.
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagRead));
+        EAIOTEST_VERIFY(!stream.SetSize(0));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestDirectFileStreamEOF
+//
+// Reads at and past the end of the file.
+//
+static int TestDirectFileStreamEOF()
+{
+    using namespace EA::IO;
+    using namespace TestDirectFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    const size_type kAlignment = DirectFileStream::kAlignment;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "DirectFileStreamEOF.bin");
+
+    uint8_t* const pAligned   = AlignedMemory();
+    uint8_t* const pUnaligned = AlignedMemory() + 5;
+
+    gExpectedSize = 0;
+
+    {
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagReadWrite, kCDCreateAlways));
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, kAlignment + 100, 1));
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    {
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagRead));
+
+        // A read which crosses the end is truncated to it.
+        EAIOTEST_VERIFY(stream.SetPosition(kAlignment - 8));
+        EAIOTEST_VERIFY(stream.Read(pUnaligned, 1000) == 108);
+        EAIOTEST_VERIFY(memcmp(pUnaligned, gExpected + kAlignment - 8, 108) == 0);
+        EAIOTEST_VERIFY(stream.GetPosition() == (off_type)gExpectedSize);
+
+        // At the end, and beyond it, reads return nothing.
+        EAIOTEST_VERIFY(stream.GetAvailable() == 0);
+        EAIOTEST_VERIFY(stream.Read(pUnaligned, 10) == 0);
+        EAIOTEST_VERIFY(stream.SetPosition(3 * kAlignment));
+        EAIOTEST_VERIFY(stream.GetAvailable() == 0);
+        EAIOTEST_VERIFY(stream.Read(pAligned, DirectFileStream::kBufferSize) == 0);
+        EAIOTEST_VERIFY(stream.GetPosition() == (off_type)(3 * kAlignment));
+
+        // A large aligned read which crosses the end is truncated to it too.
+        EAIOTEST_VERIFY(stream.SetPosition(0));
+        EAIOTEST_VERIFY(stream.Read(pAligned, DirectFileStream::kBufferSize) == gExpectedSize);
+        EAIOTEST_VERIFY(memcmp(pAligned, gExpected, (size_t)gExpectedSize) == 0);
+
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    { // Writing past the end fills the gap with zeroes.
+        DirectFileStream stream(path8);
+
+        EAIOTEST_VERIFY(stream.open(kAccessFlagReadWrite));
+        EAIOTEST_VERIFY(stream.SetPosition((3 * kAlignment) + 1));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(Write(stream, pUnaligned, 10, 2));
+        EAIOTEST_VERIFY(stream.getSize() == gExpectedSize);
+        EAIOTEST_VERIFY(ReadEquals(stream, 0, pUnaligned, gExpectedSize));
+        EAIOTEST_VERIFY(stream.close());
+    }
+
+    EAIOTEST_VERIFY(FileEqualsExpected(path8));
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+#endif // EAIO_DIRECT_FILE_STREAM_ENABLED
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestDirectFileStream
+//
+int TestDirectFileStream()
+{
+    int nErrorCount = 0;
+
+    #if EAIO_DIRECT_FILE_STREAM_ENABLED
+        nErrorCount += TestDirectFileStreamReadWrite();
+        nErrorCount += TestDirectFileStreamSetSize();
+        nErrorCount += TestDirectFileStreamEOF();
+    #endif
+
+    return nErrorCount;
+}
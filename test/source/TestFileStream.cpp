@@ -0,0 +1,849 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestFileStream.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAFileStream.h>
+#include <eaio/EAStreamChild.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAStreamFixedMemory.h>
+#include <eaio/EAFileUtil.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(EA_PLATFORM_UNIX)
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+#endif
+
+
+namespace TestFileStreamLocal
+{
+    // Returns true if the file at pPath8 holds exactly the given text.
+    bool FileEquals(const char8_t* pPath8, const char* pText)
+    {
+        EA::IO::FileStream fileStream(pPath8);
+        char               buffer[256];
+
+        if(fileStream.open(EA::IO::kAccessFlagRead))
+        {
+            const EA::IO::size_type nSize = fileStream.Read(buffer, sizeof(buffer));
+            return (nSize == strlen(pText)) && (memcmp(buffer, pText, (size_t)nSize) == 0);
+        }
+
+        return false;
+    }
+
+    // Writes with WriteV and reads back with ReadV, through more buffers than 
+    // FileStream passes to a single system call. pStream must be empty, and 
+    // must be able to hold kVectorIOSize bytes.
+    const EA::IO::size_type kVectorIOSize = 3900;   // The sum of (i * 5) for i in [0, 40).
+
+    int VerifyVectorIO(EA::IO::IStream* pStream)
+    {
+        using namespace EA::IO;
+
+        int nErrorCount = 0;
+
+        static uint8_t data[kVectorIOSize];
+        static uint8_t buffer[kVectorIOSize + 600];
+
+        for(size_type i = 0; i < kVectorIOSize; i++)
+            data[i] = (uint8_t)((i * 7) + (i >> 8));
+
+        ConstIOVector writeVectorArray[40];
+        size_type     nPosition = 0;
+
+        for(size_type i = 0; i < 40; i++) // The first buffer is empty.
+        {
+            writeVectorArray[i].mpData = data + nPosition;
+            writeVectorArray[i].mnSize = i * 5;
+            nPosition += writeVectorArray[i].mnSize;
+        }
+
+        EAIOTEST_VERIFY(pStream->WriteV(writeVectorArray, 40));
+        EAIOTEST_VERIFY(pStream->GetPosition() == (off_type)kVectorIOSize);
+        EAIOTEST_VERIFY(pStream->getSize() == kVectorIOSize);
+
+        // The reads are split differently from the writes, and extend past the end.
+        IOVector readVectorArray[45];
+
+        for(size_type i = 0; i < 45; i++)
+        {
+            readVectorArray[i].mpData = buffer + (i * 100);
+            readVectorArray[i].mnSize = 100;
+        }
+
+        memset(buffer, 0, sizeof(buffer));
+        EAIOTEST_VERIFY(pStream->SetPosition(0));
+        EAIOTEST_VERIFY(pStream->ReadV(readVectorArray, 45) == kVectorIOSize);
+        EAIOTEST_VERIFY(memcmp(buffer, data, (size_t)kVectorIOSize) == 0);
+        EAIOTEST_VERIFY(pStream->GetPosition() == (off_type)kVectorIOSize);
+        EAIOTEST_VERIFY(pStream->ReadV(readVectorArray, 2) == 0);
+
+        // A short vector read from the middle.
+        EAIOTEST_VERIFY(pStream->SetPosition(1000));
+        EAIOTEST_VERIFY(pStream->ReadV(readVectorArray + 1, 3) == 300);
+        EAIOTEST_VERIFY(memcmp(buffer + 100, data + 1000, 300) == 0);
+        EAIOTEST_VERIFY(pStream->GetPosition() == 1300);
+
+        return nErrorCount;
+    }
+
+    bool WriteFile(const char8_t* pPath8, const char* pText)
+    {
+        EA::IO::FileStream fileStream(pPath8);
+
+        return fileStream.open(EA::IO::kAccessFlagWrite, EA::IO::kCDCreateAlways) && 
+               fileStream.Write(pText, strlen(pText)) && 
+               fileStream.close();
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamReplaceAtomic
+//
+static int TestFileStreamReplaceAtomic()
+{
+    using namespace EA::IO;
+    using namespace TestFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    #if EAIO_REPLACE_ATOMIC_ENABLED
+        char8_t path8[kMaxPathLength];
+        MakeTestPath(path8, kMaxPathLength, "ReplaceAtomic.txt");
+
+        EAIOTEST_VERIFY(WriteFile(path8, "old"));
+
+        { // The destination is unchanged until Commit.
+            FileStream fileStream(path8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("new", 3));
+            EAIOTEST_VERIFY(FileEquals(path8, "old"));
+            EAIOTEST_VERIFY(fileStream.Commit());
+            EAIOTEST_VERIFY(FileEquals(path8, "new"));
+        }
+
+        { // With read access, the replacement starts as a copy of the file.
+            FileStream fileStream(path8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagReadWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.SetPosition(0, kPositionTypeEnd));
+            EAIOTEST_VERIFY(fileStream.Write("er", 2));
+            EAIOTEST_VERIFY(fileStream.Commit());
+            EAIOTEST_VERIFY(FileEquals(path8, "newer"));
+        }
+
+        { // close and Discard don't publish.
+            FileStream fileStream(path8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("lost", 4));
+            EAIOTEST_VERIFY(!fileStream.close());
+            EAIOTEST_VERIFY(FileEquals(path8, "newer"));
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("lost", 4));
+            EAIOTEST_VERIFY(fileStream.Discard());
+            EAIOTEST_VERIFY(FileEquals(path8, "newer"));
+        }
+
+        { // Neither does the destructor.
+            FileStream fileStream(path8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("lost", 4));
+        }
+        EAIOTEST_VERIFY(FileEquals(path8, "newer"));
+
+        { // A failed size change prevents Commit from publishing.
+            FileStream fileStream(path8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("lost", 4));
+            EAIOTEST_VERIFY(!fileStream.SetSize((size_type)-2));
+            EAIOTEST_VERIFY(!fileStream.Commit());
+            EAIOTEST_VERIFY(FileEquals(path8, "newer"));
+        }
+
+        // A read-only replacement is of no use.
+        {
+            FileStream fileStream(path8);
+            EAIOTEST_VERIFY(!fileStream.open(kAccessFlagRead, kCDReplaceAtomic));
+        }
+
+        #if defined(EA_PLATFORM_UNIX)
+        { // Permissions are kept, and a symbolic link is followed rather than replaced.
+            char8_t linkPath8[kMaxPathLength];
+            MakeTestPath(linkPath8, kMaxPathLength, "ReplaceAtomicLink.txt");
+
+            unlink(linkPath8);
+            EAIOTEST_VERIFY(chmod(path8, 0640) == 0);
+            EAIOTEST_VERIFY(symlink("ReplaceAtomic.txt", linkPath8) == 0);
+
+            FileStream fileStream(linkPath8);
+
+            EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+            EAIOTEST_VERIFY(fileStream.Write("linked", 6));
+            EAIOTEST_VERIFY(fileStream.Commit());
+            EAIOTEST_VERIFY(FileEquals(path8, "linked"));
+
+            struct stat linkStat, fileStat;
+            EAIOTEST_VERIFY((lstat(linkPath8, &linkStat) == 0) && S_ISLNK(linkStat.st_mode));
+            EAIOTEST_VERIFY((stat(path8, &fileStat) == 0) && ((fileStat.st_mode & 0777) == 0640));
+
+            unlink(linkPath8);
+        }
+        #endif
+
+        remove(path8);
+    #endif
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamReadAtWriteAt
+//
+// ReadAt and WriteAt neither use nor move the stream position, and StreamChild
+// reads its parent through ReadAt.
+//
+static int TestFileStreamReadAtWriteAt()
+{
+    using namespace EA::IO;
+    using namespace TestFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "ReadAtWriteAt.txt");
+
+    FileStream fileStream(path8);
+    char       buffer[16];
+
+    EAIOTEST_VERIFY(fileStream.ReadAt(0, buffer, 1) == kSizeTypeError);
+    EAIOTEST_VERIFY(!fileStream.WriteAt(0, "x", 1));
+
+    if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        EAIOTEST_VERIFY(fileStream.Write("0123456789", 10));
+        EAIOTEST_VERIFY(fileStream.SetPosition(3));
+
+        EAIOTEST_VERIFY(fileStream.WriteAt(5, "ab", 2));
+        EAIOTEST_VERIFY(fileStream.ReadAt(0, buffer, sizeof(buffer)) == 10);
+        EAIOTEST_VERIFY(memcmp(buffer, "01234ab789", 10) == 0);
+        EAIOTEST_VERIFY(fileStream.ReadAt(10, buffer, sizeof(buffer)) == 0);
+        EAIOTEST_VERIFY(fileStream.GetPosition() == 3);
+
+        // A WriteAt past the end extends the file, including a cached size.
+        fileStream.setOption(FileStream::kOptionCacheSize, 1);
+        EAIOTEST_VERIFY(fileStream.getSize() == 10);
+        EAIOTEST_VERIFY(fileStream.WriteAt(12, "cd", 2));
+        EAIOTEST_VERIFY(fileStream.getSize() == 14);
+        EAIOTEST_VERIFY(fileStream.ReadAt(10, buffer, sizeof(buffer)) == 4);
+        EAIOTEST_VERIFY((buffer[0] == 0) && (buffer[1] == 0) && (memcmp(buffer + 2, "cd", 2) == 0));
+        EAIOTEST_VERIFY(fileStream.GetPosition() == 3);
+
+        // The next Read and Write continue from the position.
+        EAIOTEST_VERIFY(fileStream.Read(buffer, 2) == 2);
+        EAIOTEST_VERIFY(memcmp(buffer, "34", 2) == 0);
+
+        { // A StreamChild reads its span without moving the parent's position.
+            StreamChild streamChild(&fileStream, 4, 4);
+
+            EAIOTEST_VERIFY(fileStream.SetPosition(9));
+            EAIOTEST_VERIFY(streamChild.Read(buffer, 3) == 3);
+            EAIOTEST_VERIFY(memcmp(buffer, "4ab", 3) == 0);
+            EAIOTEST_VERIFY(streamChild.Read(buffer, sizeof(buffer)) == 1);
+            EAIOTEST_VERIFY(buffer[0] == '7');
+            EAIOTEST_VERIFY(streamChild.Read(buffer, sizeof(buffer)) == 0);
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 9);
+        }
+
+        EAIOTEST_VERIFY(fileStream.close());
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamUsageHints
+//
+// Usage hints and Prefetch are only advice to the kernel, so whatever they are,
+// reads must return the file's data. kUsageHintDontNeed releases pages behind 
+// the reader, which must also work when the reader seeks back over them.
+//
+static int TestFileStreamUsageHints()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "UsageHints.bin");
+
+    const size_type kBlockSize  = 65536;
+    const size_type kBlockCount = 40;   // Enough to cross the page release granularity.
+
+    static uint8_t block[kBlockSize];
+    static uint8_t buffer[kBlockSize];
+
+    FileStream fileStream(path8);
+
+    EAIOTEST_VERIFY(!fileStream.Prefetch(0, 0));
+
+    if(fileStream.open(kAccessFlagWrite, kCDCreateAlways))
+    {
+        for(size_type i = 0; i < kBlockCount; i++)
+        {
+            memset(block, (int)i, (size_t)kBlockSize);
+            EAIOTEST_VERIFY(fileStream.Write(block, kBlockSize));
+        }
+
+        EAIOTEST_VERIFY(fileStream.close());
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    const int hintArray[] = 
+    {
+        FileStream::kUsageHintNone,
+        FileStream::kUsageHintSequential,
+        FileStream::kUsageHintRandom,
+        FileStream::kUsageHintSequential | FileStream::kUsageHintWillNeed,
+        FileStream::kUsageHintSequential | FileStream::kUsageHintDontNeed,
+        FileStream::kUsageHintNoReuse
+    };
+
+    for(size_t h = 0; h < (sizeof(hintArray) / sizeof(hintArray[0])); h++)
+    {
+        if(fileStream.open(kAccessFlagRead, kCDOpenExisting, FileStream::kShareRead, hintArray[h]))
+        {
+            EAIOTEST_VERIFY(fileStream.Prefetch(0, 0));
+            EAIOTEST_VERIFY(fileStream.Prefetch(kBlockSize * 3, kBlockSize));
+
+            for(size_type i = 0; i < kBlockCount; i++)
+            {
+                if(i == (kBlockCount / 2)) // Seek back over pages which kUsageHintDontNeed may have released.
+                {
+                    EAIOTEST_VERIFY(fileStream.SetPosition((off_type)(kBlockSize * 2)));
+                    EAIOTEST_VERIFY(fileStream.Read(buffer, kBlockSize) == kBlockSize);
+                    EAIOTEST_VERIFY((buffer[0] == 2) && (buffer[kBlockSize - 1] == 2));
+                    EAIOTEST_VERIFY(fileStream.SetPosition((off_type)(kBlockSize * i)));
+                }
+
+                memset(block, (int)i, (size_t)kBlockSize);
+                EAIOTEST_VERIFY(fileStream.Read(buffer, kBlockSize) == kBlockSize);
+                EAIOTEST_VERIFY(memcmp(buffer, block, (size_t)kBlockSize) == 0);
+            }
+
+            EAIOTEST_VERIFY(fileStream.Read(buffer, kBlockSize) == 0);
+            EAIOTEST_VERIFY(fileStream.close());
+        }
+        else
+            EAIOTEST_VERIFY(!"Couldn't open the test file.");
+    }
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamCachedState
+//
+// The position is always cached, and the size is cached with kOptionCacheSize.
+// Both must track Write, SetPosition and SetSize, with the size cache on or off.
+//
+static int TestFileStreamCachedState()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "CachedState.txt");
+
+    for(int bCacheSize = 0; bCacheSize < 2; bCacheSize++)
+    {
+        FileStream fileStream(path8);
+        char       buffer[16];
+
+        if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+        {
+            fileStream.setOption(FileStream::kOptionCacheSize, bCacheSize);
+
+            EAIOTEST_VERIFY(fileStream.getSize() == 0);
+            EAIOTEST_VERIFY(fileStream.Write("0123456789", 10));
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 10);
+            EAIOTEST_VERIFY(fileStream.getSize() == 10);
+            EAIOTEST_VERIFY(fileStream.GetAvailable() == 0);
+
+            EAIOTEST_VERIFY(fileStream.SetPosition(-4, kPositionTypeCurrent));
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 6);
+            EAIOTEST_VERIFY(fileStream.GetPosition(kPositionTypeEnd) == -4);
+            EAIOTEST_VERIFY(fileStream.GetAvailable() == 4);
+
+            // An overwrite within the file doesn't change the size.
+            EAIOTEST_VERIFY(fileStream.Write("ab", 2));
+            EAIOTEST_VERIFY(fileStream.getSize() == 10);
+
+            // A write beyond the end extends the size past the gap.
+            EAIOTEST_VERIFY(fileStream.SetPosition(2, kPositionTypeEnd));
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 12);
+            EAIOTEST_VERIFY(fileStream.GetAvailable() == 0);
+            EAIOTEST_VERIFY(fileStream.Write("cd", 2));
+            EAIOTEST_VERIFY(fileStream.getSize() == 14);
+
+            // SetSize in both directions; the position stays where it was.
+            EAIOTEST_VERIFY(fileStream.SetSize(5));
+            EAIOTEST_VERIFY(fileStream.getSize() == 5);
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 14);
+            EAIOTEST_VERIFY(fileStream.GetAvailable() == 0);
+            EAIOTEST_VERIFY(fileStream.SetSize(20));
+            EAIOTEST_VERIFY(fileStream.getSize() == 20);
+            EAIOTEST_VERIFY(fileStream.GetAvailable() == 6);
+
+            // Reads advance the position by what was read.
+            EAIOTEST_VERIFY(fileStream.SetPosition(3));
+            EAIOTEST_VERIFY(fileStream.Read(buffer, 2) == 2);
+            EAIOTEST_VERIFY(memcmp(buffer, "34", 2) == 0);
+            EAIOTEST_VERIFY(fileStream.SetPosition(18));
+            EAIOTEST_VERIFY(fileStream.Read(buffer, sizeof(buffer)) == 2);
+            EAIOTEST_VERIFY(fileStream.GetPosition() == 20);
+
+            // Without the size cache, a size change by another stream is seen at once.
+            // With it, the size is refreshed when the option is set again.
+            {
+                FileStream otherStream(path8);
+                EAIOTEST_VERIFY(otherStream.open(kAccessFlagWrite, kCDOpenExisting));
+                EAIOTEST_VERIFY(otherStream.SetSize(8));
+            }
+
+            EAIOTEST_VERIFY(fileStream.getSize() == (bCacheSize ? 20u : 8u));
+            fileStream.setOption(FileStream::kOptionCacheSize, bCacheSize);
+            EAIOTEST_VERIFY(fileStream.getSize() == 8);
+
+            EAIOTEST_VERIFY(fileStream.close());
+            EAIOTEST_VERIFY(fileStream.getSize() == kSizeTypeError);
+            EAIOTEST_VERIFY(fileStream.GetPosition() == -1);
+        }
+        else
+            EAIOTEST_VERIFY(!"Couldn't create the test file.");
+    }
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamFlushPolicy
+//
+// Each flush policy succeeds on a healthy file and leaves the data visible. 
+// The policy may be set before open and is retained across close and open.
+//
+static int TestFileStreamFlushPolicy()
+{
+    using namespace EA::IO;
+    using namespace TestFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "FlushPolicy.txt");
+
+    const int policyArray[] = 
+    {
+        FileStream::kFlushPolicyNone,
+        FileStream::kFlushPolicyWriteBehind,
+        FileStream::kFlushPolicyDataSync,
+        FileStream::kFlushPolicySync
+    };
+
+    for(size_t p = 0; p < (sizeof(policyArray) / sizeof(policyArray[0])); p++)
+    {
+        FileStream fileStream(path8);
+        fileStream.setOption(FileStream::kOptionFlushPolicy, policyArray[p]);
+
+        for(int nOpenCount = 0; nOpenCount < 2; nOpenCount++)
+        {
+            if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+            {
+                EAIOTEST_VERIFY(fileStream.Flush()); // Nothing written yet.
+                EAIOTEST_VERIFY(fileStream.Write("flushed", 7));
+                EAIOTEST_VERIFY(fileStream.Flush());
+                EAIOTEST_VERIFY(FileEquals(path8, "flushed"));
+                EAIOTEST_VERIFY(fileStream.SetSize(5));
+                EAIOTEST_VERIFY(fileStream.Flush());
+                EAIOTEST_VERIFY(FileEquals(path8, "flush"));
+                EAIOTEST_VERIFY(fileStream.close());
+            }
+            else
+                EAIOTEST_VERIFY(!"Couldn't create the test file.");
+        }
+    }
+
+    #if EAIO_REPLACE_ATOMIC_ENABLED
+    { // A successful flush of a replacement doesn't prevent Commit.
+        FileStream fileStream(path8);
+        fileStream.setOption(FileStream::kOptionFlushPolicy, FileStream::kFlushPolicyDataSync);
+
+        EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDReplaceAtomic));
+        EAIOTEST_VERIFY(fileStream.Write("replaced", 8));
+        EAIOTEST_VERIFY(fileStream.Flush());
+        EAIOTEST_VERIFY(FileEquals(path8, "flush"));
+        EAIOTEST_VERIFY(fileStream.Commit());
+        EAIOTEST_VERIFY(FileEquals(path8, "replaced"));
+    }
+    #endif
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamExtents
+//
+// Preallocate, PunchHole and FindData depend on file system support, so this 
+// checks what each guarantees whether or not it is supported: Preallocate without
+// bKeepSize always grows the file, a punched hole reads as zeros, and the data 
+// ranges are ordered, lie within the file and cover all nonzero bytes.
+//
+static int TestFileStreamExtents()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "Extents.bin");
+
+    const size_type kBlockSize  = 65536;
+    const size_type kBlockCount = 8;
+    const size_type kFileSize   = kBlockSize * kBlockCount;
+
+    static uint8_t block[kBlockSize];
+    static uint8_t buffer[kBlockSize];
+
+    FileStream fileStream(path8);
+    size_type  nBegin, nEnd;
+
+    EAIOTEST_VERIFY(!fileStream.Preallocate(0, kBlockSize));
+    EAIOTEST_VERIFY(!fileStream.PunchHole(0, kBlockSize));
+    EAIOTEST_VERIFY(!fileStream.FindData(0, nBegin, nEnd));
+
+    if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        memset(block, 0x5a, (size_t)kBlockSize);
+
+        for(size_type i = 0; i < kBlockCount; i++)
+            EAIOTEST_VERIFY(fileStream.Write(block, kBlockSize));
+
+        // Preallocation which keeps the size may be unsupported, but mustn't change the size.
+        fileStream.Preallocate(kFileSize, kBlockSize, true);
+        EAIOTEST_VERIFY(fileStream.getSize() == kFileSize);
+
+        // Preallocation which extends the file always works, and the new bytes read as zeros.
+        EAIOTEST_VERIFY(fileStream.Preallocate(kFileSize, kBlockSize, false));
+        EAIOTEST_VERIFY(fileStream.getSize() == (kFileSize + kBlockSize));
+        EAIOTEST_VERIFY(fileStream.ReadAt(kFileSize, buffer, kBlockSize) == kBlockSize);
+        EAIOTEST_VERIFY((buffer[0] == 0) && (buffer[kBlockSize - 1] == 0));
+        EAIOTEST_VERIFY(fileStream.SetSize(kFileSize));
+
+        // So does growing with kOptionPreallocate.
+        fileStream.setOption(FileStream::kOptionPreallocate, 1);
+        EAIOTEST_VERIFY(fileStream.SetSize(kFileSize + kBlockSize));
+        EAIOTEST_VERIFY(fileStream.getSize() == (kFileSize + kBlockSize));
+        EAIOTEST_VERIFY(fileStream.ReadAt(kFileSize, buffer, kBlockSize) == kBlockSize);
+        EAIOTEST_VERIFY((buffer[0] == 0) && (buffer[kBlockSize - 1] == 0));
+        EAIOTEST_VERIFY(fileStream.SetSize(kFileSize));
+        fileStream.setOption(FileStream::kOptionPreallocate, 0);
+
+        // A punched hole reads as zeros and leaves the size alone.
+        const bool bPunched = fileStream.PunchHole(kBlockSize * 2, kBlockSize * 2);
+
+        EAIOTEST_VERIFY(fileStream.getSize() == kFileSize);
+        EAIOTEST_VERIFY(fileStream.ReadAt(kBlockSize * 3, buffer, kBlockSize) == kBlockSize);
+        EAIOTEST_VERIFY(!bPunched || ((buffer[0] == 0) && (buffer[kBlockSize - 1] == 0)));
+        EAIOTEST_VERIFY(bPunched || (buffer[0] == 0x5a));
+
+        // The data ranges are ordered and within the file, and every block of 
+        // nonzero data lies within one of them.
+        const off_type nPosition = 1234;
+        size_type      nCovered  = 0;      // Bit i is set if block i is within a data range.
+
+        EAIOTEST_VERIFY(fileStream.SetPosition(nPosition));
+
+        for(size_type nFind = 0; fileStream.FindData(nFind, nBegin, nEnd); nFind = nEnd)
+        {
+            EAIOTEST_VERIFY((nBegin >= nFind) && (nBegin < nEnd) && (nEnd <= kFileSize));
+
+            if((nBegin < nFind) || (nBegin >= nEnd) || (nEnd > kFileSize))
+                break;
+
+            for(size_type i = 0; i < kBlockCount; i++)
+            {
+                if((nBegin <= (kBlockSize * i)) && (nEnd >= (kBlockSize * (i + 1))))
+                    nCovered |= ((size_type)1 << i);
+            }
+        }
+
+        for(size_type i = 0; i < kBlockCount; i++)
+        {
+            if(!bPunched || (i < 2) || (i >= 4))
+                EAIOTEST_VERIFY((nCovered & ((size_type)1 << i)) != 0);
+        }
+
+        EAIOTEST_VERIFY(!fileStream.FindData(kFileSize, nBegin, nEnd));
+        EAIOTEST_VERIFY(fileStream.GetPosition() == nPosition);
+        EAIOTEST_VERIFY(fileStream.Read(buffer, 2) == 2);
+        EAIOTEST_VERIFY(buffer[0] == 0x5a);
+
+        EAIOTEST_VERIFY(fileStream.close());
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamVectorIO
+//
+// FileStream, MemoryStream and FixedMemoryStream override ReadV and WriteV. 
+// They must behave as the IStream defaults do, which StreamChild and other 
+// streams use.
+//
+static int TestFileStreamVectorIO()
+{
+    using namespace EA::IO;
+    using namespace TestFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "VectorIO.bin");
+
+    { // FileStream uses readv and writev.
+        FileStream fileStream(path8);
+
+        if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+        {
+            nErrorCount += VerifyVectorIO(&fileStream);
+            EAIOTEST_VERIFY(fileStream.close());
+        }
+        else
+            EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+        // ReadV through the IStream default, via StreamChild.
+        if(fileStream.open(kAccessFlagRead))
+        {
+            StreamChild streamChild(&fileStream, 100, 250);
+            uint8_t     buffer[300];
+            IOVector    ioVectorArray[2] = { { buffer, 200 }, { buffer + 200, 100 } };
+            uint8_t     expected[250];
+
+            EAIOTEST_VERIFY(fileStream.ReadAt(100, expected, 250) == 250);
+            EAIOTEST_VERIFY(streamChild.ReadV(ioVectorArray, 2) == 250);
+            EAIOTEST_VERIFY(memcmp(buffer, expected, 250) == 0);
+            EAIOTEST_VERIFY(fileStream.close());
+        }
+        else
+            EAIOTEST_VERIFY(!"Couldn't open the test file.");
+
+        remove(path8);
+    }
+
+    { // A MemoryStream which grows.
+        MemoryStream memoryStream;
+        memoryStream.AddRef();
+        memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+        nErrorCount += VerifyVectorIO(&memoryStream);
+    }
+
+    { // A FixedMemoryStream with exactly enough room. A write which doesn't fit fails.
+        static uint8_t fixedBuffer[kVectorIOSize];
+        FixedMemoryStream fixedMemoryStream(fixedBuffer, kVectorIOSize);
+        fixedMemoryStream.AddRef();
+        fixedMemoryStream.SetSize(0);
+        nErrorCount += VerifyVectorIO(&fixedMemoryStream);
+
+        const ConstIOVector ioVectorArray[2] = { { "abc", 3 }, { "def", 3 } };
+        EAIOTEST_VERIFY(fixedMemoryStream.SetPosition((off_type)(kVectorIOSize - 4)));
+        EAIOTEST_VERIFY(!fixedMemoryStream.WriteV(ioVectorArray, 2));
+        EAIOTEST_VERIFY(memcmp(fixedBuffer + kVectorIOSize - 4, "abcd", 4) == 0);
+    }
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStreamFileCopy
+//
+// Tests File::copy: the reported byte count, the replication of the source's
+// permissions and times, and the refusal to overwrite when asked not to.
+//
+static int TestFileStreamFileCopy()
+{
+    using namespace EA::IO;
+    using namespace TestFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t pathSource8[kMaxPathLength];
+    char8_t pathDestination8[kMaxPathLength];
+    char8_t pathMissing8[kMaxPathLength];
+
+    MakeTestPath(pathSource8,      kMaxPathLength, "FileCopySource.bin");
+    MakeTestPath(pathDestination8, kMaxPathLength, "FileCopyDestination.bin");
+    MakeTestPath(pathMissing8,     kMaxPathLength, "FileCopyMissing.bin");
+
+    File::remove(pathDestination8);
+
+    // The source is larger than any single read/write buffer the copy might use.
+    const size_type kCopySize = 70000;
+    static uint8_t  data[kCopySize];
+    static uint8_t  buffer[kCopySize];
+
+    for(size_type i = 0; i < kCopySize; i++)
+        data[i] = (uint8_t)((i * 13) + (i >> 10));
+
+    {
+        FileStream fileStream(pathSource8);
+
+        EAIOTEST_VERIFY(fileStream.open(kAccessFlagWrite, kCDCreateAlways));
+        EAIOTEST_VERIFY(fileStream.Write(data, kCopySize));
+        EAIOTEST_VERIFY(fileStream.close());
+    }
+
+    #if defined(EA_PLATFORM_LINUX)
+        const struct timespec sourceTimes[2] = { { 1000000000, 0 }, { 1100000000, 0 } };
+
+        EAIOTEST_VERIFY(chmod(pathSource8, 0640) == 0);
+        EAIOTEST_VERIFY(utimensat(AT_FDCWD, pathSource8, sourceTimes, 0) == 0);
+    #endif
+
+    { // A copy to a new file reports the number of bytes copied.
+        size_type nCopied = 0;
+
+        EAIOTEST_VERIFY(File::copy(pathSource8, pathDestination8, false, &nCopied));
+        EAIOTEST_VERIFY(nCopied == kCopySize);
+        EAIOTEST_VERIFY(File::getSize(pathDestination8) == kCopySize);
+
+        FileStream fileStream(pathDestination8);
+
+        memset(buffer, 0, sizeof(buffer));
+        EAIOTEST_VERIFY(fileStream.open(kAccessFlagRead));
+        EAIOTEST_VERIFY(fileStream.Read(buffer, kCopySize) == kCopySize);
+        EAIOTEST_VERIFY(memcmp(buffer, data, (size_t)kCopySize) == 0);
+    }
+
+    #if defined(EA_PLATFORM_LINUX)
+    { // The permissions and modification time of the source are replicated.
+        struct stat statDestination;
+
+        EAIOTEST_VERIFY(stat(pathDestination8, &statDestination) == 0);
+        EAIOTEST_VERIFY((statDestination.st_mode & 07777) == 0640);
+        EAIOTEST_VERIFY(statDestination.st_mtim.tv_sec == sourceTimes[1].tv_sec);
+        EAIOTEST_VERIFY(statDestination.st_mtim.tv_nsec == sourceTimes[1].tv_nsec);
+    }
+    #endif
+
+    { // An existing destination is left alone unless bOverwriteIfPresent is true.
+        size_type nCopied = 0;
+
+        EAIOTEST_VERIFY(WriteFile(pathDestination8, "existing"));
+        EAIOTEST_VERIFY(!File::copy(pathSource8, pathDestination8, false, &nCopied));
+        EAIOTEST_VERIFY(nCopied == kSizeTypeError);
+        EAIOTEST_VERIFY(FileEquals(pathDestination8, "existing"));
+
+        nCopied = 0;
+        EAIOTEST_VERIFY(File::copy(pathSource8, pathDestination8, true, &nCopied));
+        EAIOTEST_VERIFY(nCopied == kCopySize);
+        EAIOTEST_VERIFY(File::getSize(pathDestination8) == kCopySize);
+    }
+
+    { // A missing source fails and doesn't create the destination.
+        size_type nCopied = 0;
+
+        EAIOTEST_VERIFY(File::remove(pathDestination8));
+        EAIOTEST_VERIFY(!File::copy(pathMissing8, pathDestination8, true, &nCopied));
+        EAIOTEST_VERIFY(nCopied == kSizeTypeError);
+        EAIOTEST_VERIFY(!File::exists(pathDestination8));
+    }
+
+    File::remove(pathSource8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestFileStream
+//
+int TestFileStream()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestFileStreamReplaceAtomic();
+    nErrorCount += TestFileStreamReadAtWriteAt();
+    nErrorCount += TestFileStreamUsageHints();
+    nErrorCount += TestFileStreamCachedState();
+    nErrorCount += TestFileStreamFlushPolicy();
+    nErrorCount += TestFileStreamExtents();
+    nErrorCount += TestFileStreamVectorIO();
+    nErrorCount += TestFileStreamFileCopy();
+
+    return nErrorCount;
+}
@@ -0,0 +1,199 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/////////////////////////////////////////////////////////////////////////////
+// TestMappedFileStream.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAMappedFileStream.h>
+#include <eaio/EAFileStream.h>
+#include <string.h>
+#include <stdio.h>
+
+
+#if EAIO_MAPPED_FILE_STREAM_ENABLED
+
+namespace TestMappedFileStreamLocal
+{
+    // Creates the file at pPath8 with the given contents.
+    bool WriteFile(const char8_t* pPath8, const void* pData, EA::IO::size_type nSize)
+    {
+        EA::IO::FileStream fileStream(pPath8);
+
+        if(fileStream.open(EA::IO::kAccessFlagWrite, EA::IO::kCDCreateAlways))
+        {
+            const bool bResult = fileStream.Write(pData, nSize);
+            return fileStream.close() && bResult;
+        }
+
+        return false;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestMappedFileStreamRead
+//
+static int TestMappedFileStreamRead()
+{
+    using namespace EA::IO;
+    using namespace TestMappedFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "MappedFileStreamRead.txt");
+
+    EAIOTEST_VERIFY(WriteFile(path8, "0123456789", 10));
+
+    MappedFileStream stream(path8);
+    stream.AddRef();
+
+    // Only reading existing files is supported.
+    EAIOTEST_VERIFY(!stream.open(kAccessFlagReadWrite));
+    EAIOTEST_VERIFY(!stream.open(kAccessFlagRead, kCDCreateAlways));
+
+    if(stream.open())
+    {
+        char buffer[16];
+
+        EAIOTEST_VERIFY(stream.getSize() == 10);
+        EAIOTEST_VERIFY(stream.GetAvailable() == 10);
+
+        const char* const pData = (const char*)stream.GetData();
+        EAIOTEST_VERIFY(pData && (memcmp(pData, "0123456789", 10) == 0));
+
+        EAIOTEST_VERIFY(stream.Read(buffer, 4) == 4);
+        EAIOTEST_VERIFY(memcmp(buffer, "0123", 4) == 0);
+        EAIOTEST_VERIFY(stream.GetPosition() == 4);
+        EAIOTEST_VERIFY(stream.GetAvailable() == 6);
+
+        EAIOTEST_VERIFY(stream.SetPosition(-3, kPositionTypeEnd));
+        EAIOTEST_VERIFY(stream.GetPosition() == 7);
+        EAIOTEST_VERIFY(stream.SetPosition(-2, kPositionTypeCurrent));
+        EAIOTEST_VERIFY(stream.GetPosition() == 5);
+
+        // A read past the end is truncated, and at the end reads nothing.
+        EAIOTEST_VERIFY(stream.Read(buffer, sizeof(buffer)) == 5);
+        EAIOTEST_VERIFY(memcmp(buffer, "56789", 5) == 0);
+        EAIOTEST_VERIFY(stream.GetAvailable() == 0);
+        EAIOTEST_VERIFY(stream.Read(buffer, sizeof(buffer)) == 0);
+
+        // Out-of-bounds positions fail and are clamped.
+        EAIOTEST_VERIFY(!stream.SetPosition(11));
+        EAIOTEST_VERIFY(stream.GetPosition() == 10);
+        EAIOTEST_VERIFY(!stream.SetPosition(-1));
+        EAIOTEST_VERIFY(stream.GetPosition() == 0);
+
+        // ReadAt leaves the position alone.
+        EAIOTEST_VERIFY(stream.ReadAt(8, buffer, sizeof(buffer)) == 2);
+        EAIOTEST_VERIFY(memcmp(buffer, "89", 2) == 0);
+        EAIOTEST_VERIFY(stream.GetPosition() == 0);
+
+        // The stream is read-only.
+        EAIOTEST_VERIFY(!stream.Write("x", 1));
+        EAIOTEST_VERIFY(!stream.SetSize(4));
+        EAIOTEST_VERIFY(stream.getSize() == 10);
+
+        EAIOTEST_VERIFY(stream.close());
+        EAIOTEST_VERIFY(stream.GetData() == NULL);
+        EAIOTEST_VERIFY(stream.Read(buffer, 1) == kSizeTypeError);
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't open the test file.");
+
+    remove(path8);
+
+    // A missing file can't be opened.
+    EAIOTEST_VERIFY(!stream.open());
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestMappedFileStreamEmpty
+//
+// An empty file can't be mapped, so it opens with no mapping.
+//
+static int TestMappedFileStreamEmpty()
+{
+    using namespace EA::IO;
+    using namespace TestMappedFileStreamLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "MappedFileStreamEmpty.txt");
+
+    EAIOTEST_VERIFY(WriteFile(path8, "", 0));
+
+    MappedFileStream stream(path8);
+    stream.AddRef();
+
+    if(stream.open())
+    {
+        char buffer[4];
+
+        EAIOTEST_VERIFY(stream.getSize() == 0);
+        EAIOTEST_VERIFY(stream.GetAvailable() == 0);
+        EAIOTEST_VERIFY(stream.GetData() == NULL);
+        EAIOTEST_VERIFY(stream.Read(buffer, sizeof(buffer)) == 0);
+        EAIOTEST_VERIFY(stream.ReadAt(0, buffer, sizeof(buffer)) == 0);
+        EAIOTEST_VERIFY(stream.SetPosition(0, kPositionTypeEnd));
+        EAIOTEST_VERIFY(stream.close());
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't open the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+#endif // EAIO_MAPPED_FILE_STREAM_ENABLED
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestMappedFileStream
+//
+int TestMappedFileStream()
+{
+    int nErrorCount = 0;
+
+    #if EAIO_MAPPED_FILE_STREAM_ENABLED
+        nErrorCount += TestMappedFileStreamRead();
+        nErrorCount += TestMappedFileStreamEmpty();
+    #endif
+
+    return nErrorCount;
+}
@@ -0,0 +1,209 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/////////////////////////////////////////////////////////////////////////////
+// TestSharedBlockCache.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EASharedBlockCache.h>
+#include <eaio/EAStreamBlockCache.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAFileStream.h>
+#include <string.h>
+#include <stdio.h>
+
+
+namespace TestSharedBlockCacheLocal
+{
+    bool WriteFile(const char8_t* pPath8, const char* pText)
+    {
+        EA::IO::FileStream fileStream(pPath8);
+
+        return fileStream.open(EA::IO::kAccessFlagWrite, EA::IO::kCDCreateAlways) && 
+               fileStream.Write(pText, strlen(pText)) && 
+               fileStream.close();
+    }
+
+    // Reads the first nSize bytes of the file through the shared cache, with the id made when opening it.
+    bool ReadFile(EA::IO::SharedBlockCache* pCache, const char8_t* pPath8, char* pBuffer, EA::IO::size_type nSize)
+    {
+        using namespace EA::IO;
+
+        FileStream fileStream(pPath8);
+        bool       bResult = false;
+
+        fileStream.AddRef();
+
+        if(fileStream.open(kAccessFlagRead))
+        {
+            StreamBlockCache blockCache(&fileStream, 0, 0);
+            blockCache.AddRef();
+            blockCache.SetSharedCache(pCache, SharedBlockCache::MakeStreamId(pPath8));
+
+            bResult = (blockCache.Read(pBuffer, nSize) == nSize);
+
+            blockCache.setStream(NULL);
+        }
+
+        return bResult;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSharedBlockCacheStreams
+//
+// Streams with different ids don't share blocks, and streams with the same id do.
+//
+static int TestSharedBlockCacheStreams()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    const size_t kDataSize = 1000;
+    static char  dataArray1[kDataSize];
+    static char  dataArray2[kDataSize];
+    char         buffer[kDataSize];
+
+    for(size_t i = 0; i < kDataSize; i++)
+    {
+        dataArray1[i] = (char)i;
+        dataArray2[i] = (char)~i;
+    }
+
+    SharedBlockCache sharedCache(64 * SharedBlockCache::kStripeCount * 4, 64);
+    EAIOTEST_VERIFY(sharedCache.GetMemoryBudget() == (64 * SharedBlockCache::kStripeCount * 4));
+
+    MemoryStream memoryStream1(dataArray1, kDataSize, true, false);
+    MemoryStream memoryStream2(dataArray2, kDataSize, true, false);
+    memoryStream1.AddRef();
+    memoryStream2.AddRef();
+
+    StreamBlockCache blockCache1(&memoryStream1, 0, 0);
+    StreamBlockCache blockCache2(&memoryStream2, 0, 0);
+    blockCache1.AddRef();
+    blockCache2.AddRef();
+    blockCache1.SetSharedCache(&sharedCache, 1);
+    blockCache2.SetSharedCache(&sharedCache, 2);
+
+    for(int i = 0; i < 2; i++)
+    {
+        EAIOTEST_VERIFY(blockCache1.SetPosition(100));
+        EAIOTEST_VERIFY(blockCache1.Read(buffer, 500) == 500);
+        EAIOTEST_VERIFY(memcmp(buffer, dataArray1 + 100, 500) == 0);
+
+        EAIOTEST_VERIFY(blockCache2.SetPosition(100));
+        EAIOTEST_VERIFY(blockCache2.Read(buffer, 500) == 500);
+        EAIOTEST_VERIFY(memcmp(buffer, dataArray2 + 100, 500) == 0);
+    }
+
+    SharedBlockCache::Stats stats;
+    sharedCache.GetStats(stats);
+    EAIOTEST_VERIFY(stats.mnHitCount > 0);
+    EAIOTEST_VERIFY(stats.mnBlockCount == (SharedBlockCache::kStripeCount * 4));
+
+    // Reading the other stream's data with the same id gets the shared blocks.
+    blockCache2.SetSharedCache(&sharedCache, 1);
+    EAIOTEST_VERIFY(blockCache2.SetPosition(128));
+    EAIOTEST_VERIFY(blockCache2.Read(buffer, 64) == 64);
+    EAIOTEST_VERIFY(memcmp(buffer, dataArray1 + 128, 64) == 0);
+
+    blockCache1.setStream(NULL);
+    blockCache2.setStream(NULL);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSharedBlockCacheReplace
+//
+// A file which is replaced gets a new id, so the blocks of its old contents 
+// aren't returned for it, even if the replacement has the same size.
+//
+static int TestSharedBlockCacheReplace()
+{
+    using namespace EA::IO;
+    using namespace TestSharedBlockCacheLocal;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    char8_t pathTemp8[kMaxPathLength];
+    char    buffer[8];
+
+    MakeTestPath(path8,     kMaxPathLength, "SharedBlockCache.txt");
+    MakeTestPath(pathTemp8, kMaxPathLength, "SharedBlockCache.tmp");
+
+    SharedBlockCache sharedCache(64 * SharedBlockCache::kStripeCount * 4, 64);
+
+    EAIOTEST_VERIFY(WriteFile(path8, "abcdefgh"));
+    EAIOTEST_VERIFY(SharedBlockCache::MakeStreamId(path8) == SharedBlockCache::MakeStreamId(path8));
+    EAIOTEST_VERIFY(ReadFile(&sharedCache, path8, buffer, 8));
+    EAIOTEST_VERIFY(memcmp(buffer, "abcdefgh", 8) == 0);
+
+    const SharedStreamId streamIdOld = SharedBlockCache::MakeStreamId(path8);
+
+    EAIOTEST_VERIFY(WriteFile(pathTemp8, "ABCDEFGH"));
+    EAIOTEST_VERIFY(rename(pathTemp8, path8) == 0);
+
+    #if defined(EA_PLATFORM_UNIX)
+        EAIOTEST_VERIFY(SharedBlockCache::MakeStreamId(path8) != streamIdOld);
+    #endif
+
+    EAIOTEST_VERIFY(ReadFile(&sharedCache, path8, buffer, 8));
+    EAIOTEST_VERIFY(memcmp(buffer, "ABCDEFGH", 8) == 0);
+
+    // A file rewritten in place with a different size also gets a new id.
+    EAIOTEST_VERIFY(WriteFile(path8, "123456789"));
+    EAIOTEST_VERIFY(ReadFile(&sharedCache, path8, buffer, 8));
+    EAIOTEST_VERIFY(memcmp(buffer, "12345678", 8) == 0);
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSharedBlockCache
+//
+int TestSharedBlockCache()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestSharedBlockCacheStreams();
+    nErrorCount += TestSharedBlockCacheReplace();
+
+    return nErrorCount;
+}
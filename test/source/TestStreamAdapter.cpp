@@ -0,0 +1,674 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapter.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAStreamAdapter.h>
+#include <eaio/EABufferAdapter.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAStreamBuffer.h>
+#include <eaio/EAStreamFixedMemory.h>
+#include <eaio/EAFileStream.h>
+#include <string.h>
+#include <stdio.h>
+
+
+namespace TestStreamAdapterLocal
+{
+    // Reads from pData through each of the paths the variable-length integer reads 
+    // take: directly from memory, from a StreamBuffer's read buffer, and byte-wise.
+    enum ReadPath
+    {
+        kReadPathMemory,
+        kReadPathStreamBuffer,
+        kReadPathStream,
+        kReadPathCount
+    };
+
+    struct TestStream
+    {
+        EA::IO::MemoryStream mMemoryStream;
+        EA::IO::StreamBuffer mStreamBuffer;
+
+        TestStream(const void* pData, EA::IO::size_type nSize, int readPath)
+          : mMemoryStream((void*)pData, nSize, true, false), 
+            mStreamBuffer((readPath == kReadPathStreamBuffer) ? 64 : 0, 0, NULL)
+        {
+            mMemoryStream.AddRef();
+            mStreamBuffer.AddRef();
+
+            if(readPath != kReadPathMemory)
+                mStreamBuffer.setStream(&mMemoryStream);
+        }
+
+       ~TestStream()
+        {
+            mStreamBuffer.setStream(NULL);
+        }
+
+        EA::IO::IStream* GetStream(int readPath)
+        {
+            if(readPath == kReadPathMemory)
+                return &mMemoryStream;
+            return &mStreamBuffer;
+        }
+    };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterVarInt
+//
+static int TestStreamAdapterVarInt()
+{
+    using namespace EA::IO;
+    using namespace TestStreamAdapterLocal;
+
+    int nErrorCount = 0;
+
+    const uint64_t valueArray[] = { 0, 1, 127, 128, 300, 16383, 16384, UINT64_C(0xffffffff), UINT64_C(0x100000000), 
+                                    UINT64_C(0x00ffffffffffffff), UINT64_C(0x0100000000000000), UINT64_C(0xffffffffffffffff) };
+    const size_t   kValueCount  = sizeof(valueArray) / sizeof(valueArray[0]);
+
+    for(int readPath = 0; readPath < kReadPathCount; readPath++)
+    {
+        MemoryStream memoryStream;
+        memoryStream.AddRef();
+        memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+
+        for(size_t i = 0; i < kValueCount; i++)
+        {
+            EAIOTEST_VERIFY(WriteVarUint64(&memoryStream, valueArray[i]));
+            EAIOTEST_VERIFY(WriteVarInt64(&memoryStream, (int64_t)valueArray[i]));
+            EAIOTEST_VERIFY(WritePrefixVarUint64(&memoryStream, valueArray[i]));
+            EAIOTEST_VERIFY(WritePrefixVarInt64(&memoryStream, -(int64_t)valueArray[i]));
+        }
+
+        TestStream testStream(memoryStream.GetData(), memoryStream.getSize(), readPath);
+        IStream*   pIS = testStream.GetStream(readPath);
+
+        for(size_t i = 0; i < kValueCount; i++)
+        {
+            uint64_t nUint64 = 0;
+            int64_t  nInt64  = 0;
+
+            EAIOTEST_VERIFY(ReadVarUint64(pIS, nUint64) && (nUint64 == valueArray[i]));
+            EAIOTEST_VERIFY(ReadVarInt64(pIS, nInt64) && (nInt64 == (int64_t)valueArray[i]));
+            EAIOTEST_VERIFY(ReadPrefixVarUint64(pIS, nUint64) && (nUint64 == valueArray[i]));
+            EAIOTEST_VERIFY(ReadPrefixVarInt64(pIS, nInt64) && (nInt64 == -(int64_t)valueArray[i]));
+        }
+
+        EAIOTEST_VERIFY(pIS->GetAvailable() == 0);
+    }
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterVarIntInvalid
+//
+// Encodings which aren't the shortest for their value, and values which don't
+// fit the destination, are rejected and leave the destination unchanged.
+//
+static int TestStreamAdapterVarIntInvalid()
+{
+    using namespace EA::IO;
+    using namespace TestStreamAdapterLocal;
+
+    int nErrorCount = 0;
+
+    const uint8_t overlongArray[]       = { 0x80, 0x00 };                         // 0 in two bytes.
+    const uint8_t overlongLongArray[]   = { 0xff, 0x80, 0x00 };                   // 127 in three bytes.
+    const uint8_t tooLargeArray[]       = { 0x80, 0x80, 0x80, 0x80, 0x10 };       // 2^32.
+    const uint8_t prefixOverlongArray[] = { 0x02, 0x00 };                         // 0 in two bytes.
+    const uint8_t prefixNineArray[]     = { 0x00, 1, 0, 0, 0, 0, 0, 0, 0 };       // 1 in nine bytes.
+    const uint8_t canonicalArray[]      = { 0x80, 0x01 };                         // 128.
+
+    for(int readPath = 0; readPath < kReadPathCount; readPath++)
+    {
+        uint32_t nUint32 = 7;
+        int32_t  nInt32  = 7;
+        uint64_t nUint64 = 7;
+
+        {
+            TestStream testStream(overlongArray, sizeof(overlongArray), readPath);
+            EAIOTEST_VERIFY(!ReadVarUint32(testStream.GetStream(readPath), nUint32) && (nUint32 == 7));
+        }
+        {
+            TestStream testStream(overlongLongArray, sizeof(overlongLongArray), readPath);
+            EAIOTEST_VERIFY(!ReadVarUint64(testStream.GetStream(readPath), nUint64) && (nUint64 == 7));
+        }
+        {
+            TestStream testStream(tooLargeArray, sizeof(tooLargeArray), readPath);
+            EAIOTEST_VERIFY(!ReadVarUint32(testStream.GetStream(readPath), nUint32) && (nUint32 == 7));
+        }
+        {
+            TestStream testStream(tooLargeArray, sizeof(tooLargeArray), readPath);
+            EAIOTEST_VERIFY(!ReadVarInt32(testStream.GetStream(readPath), nInt32) && (nInt32 == 7));
+        }
+        {
+            TestStream testStream(tooLargeArray, sizeof(tooLargeArray), readPath);
+            EAIOTEST_VERIFY(ReadVarUint64(testStream.GetStream(readPath), nUint64) && (nUint64 == UINT64_C(0x100000000)));
+        }
+        {
+            TestStream testStream(prefixOverlongArray, sizeof(prefixOverlongArray), readPath);
+            nUint64 = 7;
+            EAIOTEST_VERIFY(!ReadPrefixVarUint64(testStream.GetStream(readPath), nUint64) && (nUint64 == 7));
+        }
+        {
+            TestStream testStream(prefixNineArray, sizeof(prefixNineArray), readPath);
+            EAIOTEST_VERIFY(!ReadPrefixVarUint64(testStream.GetStream(readPath), nUint64) && (nUint64 == 7));
+        }
+        {
+            TestStream testStream(canonicalArray, sizeof(canonicalArray), readPath);
+            EAIOTEST_VERIFY(ReadVarUint32(testStream.GetStream(readPath), nUint32) && (nUint32 == 128));
+        }
+    }
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterReadReservation
+//
+static int TestStreamAdapterReadReservation()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    static char dataArray1[100];
+    static char dataArray2[1000];
+
+    MemoryStream memoryStream1(dataArray1, sizeof(dataArray1), true, false);
+    MemoryStream memoryStream2(dataArray2, sizeof(dataArray2), true, false);
+    memoryStream1.AddRef();
+    memoryStream2.AddRef();
+
+    { // Arrays are deducted from the reservation and from enclosing ones.
+        StreamAdapter adapter(&memoryStream1, kEndianLittle);
+
+        {
+            StreamAdapter::ReadReservation reservation(adapter, 60);
+            EAIOTEST_VERIFY(reservation.IsValid());
+            EAIOTEST_VERIFY(adapter.VerifyArraySize(10, 4));
+
+            {
+                StreamAdapter::ReadReservation reservationInner(adapter, 30);
+                EAIOTEST_VERIFY(reservationInner.IsValid());
+                EAIOTEST_VERIFY(adapter.VerifyArraySize(4, 4));
+            }
+
+            EAIOTEST_VERIFY(adapter.VerifyArraySize(4, 1));
+            EAIOTEST_VERIFY(adapter.IsValid());
+            EAIOTEST_VERIFY(!adapter.VerifyArraySize(1, 1)); // 40 + 16 + 4 bytes of 60 are used.
+            EAIOTEST_VERIFY(!adapter.IsValid());
+        }
+
+        adapter.SetValid(true);
+        EAIOTEST_VERIFY(adapter.VerifyArraySize(100, 1)); // Checked against the stream again.
+        EAIOTEST_VERIFY(!adapter.VerifyArraySize(101, 1));
+    }
+
+    { // A reservation for more than is available fails.
+        StreamAdapter adapter(&memoryStream1, kEndianLittle);
+        StreamAdapter::ReadReservation reservation(adapter, 101);
+
+        EAIOTEST_VERIFY(!reservation.IsValid());
+        EAIOTEST_VERIFY(!adapter.IsValid());
+    }
+
+    { // setStream ends the active reservations, whose destruction then has no effect.
+        StreamAdapter adapter(&memoryStream1, kEndianLittle);
+
+        {
+            StreamAdapter::ReadReservation reservation(adapter, 10);
+
+            {
+                StreamAdapter::ReadReservation reservationInner(adapter, 5);
+
+                adapter.setStream(&memoryStream2);
+                EAIOTEST_VERIFY(adapter.VerifyArraySize(500, 1));
+
+                StreamAdapter::ReadReservation reservationNew(adapter, 800);
+                EAIOTEST_VERIFY(reservationNew.IsValid());
+                EAIOTEST_VERIFY(adapter.VerifyArraySize(700, 1));
+            }
+
+            EAIOTEST_VERIFY(adapter.VerifyArraySize(1000, 1)); // Not limited by the ended reservations of the first stream.
+        }
+
+        EAIOTEST_VERIFY(adapter.VerifyArraySize(1000, 1));
+        EAIOTEST_VERIFY(adapter.IsValid());
+    }
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterCopyStream
+//
+// copyStream takes a different path for a memory source, a memory destination,
+// a pair of FileStreams and everything else. Each must copy from the source 
+// position to the destination position and leave both positions after the copy.
+//
+static int TestStreamAdapterCopyStream()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    const size_type kDataSize = 300000; // Larger than the stack buffer and the heap buffer.
+
+    static uint8_t data[kDataSize];
+    static uint8_t buffer[kDataSize];
+
+    for(size_type i = 0; i < kDataSize; i++)
+        data[i] = (uint8_t)((i * 13) + (i >> 9));
+
+    char8_t sourcePath8[kMaxPathLength];
+    char8_t destPath8[kMaxPathLength];
+    MakeTestPath(sourcePath8, kMaxPathLength, "CopyStreamSource.bin");
+    MakeTestPath(destPath8,   kMaxPathLength, "CopyStreamDest.bin");
+
+    FileStream sourceFile(sourcePath8);
+    FileStream destFile(destPath8);
+    sourceFile.AddRef();
+    destFile.AddRef();
+
+    if(sourceFile.open(kAccessFlagReadWrite, kCDCreateAlways) && destFile.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        EAIOTEST_VERIFY(sourceFile.Write(data, kDataSize));
+
+        { // A memory source is written from directly, and limited to what's available.
+            FixedMemoryStream source(data, kDataSize);
+            source.AddRef();
+
+            EAIOTEST_VERIFY(source.SetPosition(100));
+            EAIOTEST_VERIFY(destFile.SetPosition(10));
+            EAIOTEST_VERIFY(copyStream(&source, &destFile, 1000) == 1000);
+            EAIOTEST_VERIFY(source.GetPosition() == 1100);
+            EAIOTEST_VERIFY(destFile.GetPosition() == 1010);
+            EAIOTEST_VERIFY(copyStream(&source, &destFile) == (kDataSize - 1100));
+            EAIOTEST_VERIFY(source.GetAvailable() == 0);
+            EAIOTEST_VERIFY(destFile.ReadAt(10, buffer, kDataSize) == (kDataSize - 100));
+            EAIOTEST_VERIFY(memcmp(buffer, data + 100, (size_t)(kDataSize - 100)) == 0);
+        }
+
+        { // A memory destination is grown once and read into. If the source ends early,  
+          // the destination shrinks back to what was copied, but not below its prior size.
+            MemoryStream dest;
+            dest.AddRef();
+            dest.setOption(MemoryStream::kOptionResizeEnabled, 1);
+            EAIOTEST_VERIFY(dest.Write("0123456789", 10));
+            EAIOTEST_VERIFY(dest.SetPosition(5));
+
+            EAIOTEST_VERIFY(sourceFile.SetPosition((off_type)(kDataSize - 1000)));
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &dest, 3000) == 1000);
+            EAIOTEST_VERIFY(dest.getSize() == 1005);
+            EAIOTEST_VERIFY(dest.GetPosition() == 1005);
+            EAIOTEST_VERIFY(memcmp(dest.GetData(), "01234", 5) == 0);
+            EAIOTEST_VERIFY(memcmp((uint8_t*)dest.GetData() + 5, data + kDataSize - 1000, 1000) == 0);
+            EAIOTEST_VERIFY(sourceFile.GetPosition() == (off_type)kDataSize);
+
+            EAIOTEST_VERIFY(dest.SetSize(2000));
+            EAIOTEST_VERIFY(dest.SetPosition(5));
+            EAIOTEST_VERIFY(sourceFile.SetPosition((off_type)(kDataSize - 1000)));
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &dest, 3000) == 1000);
+            EAIOTEST_VERIFY(dest.getSize() == 2000);
+            EAIOTEST_VERIFY(dest.GetPosition() == 1005);
+
+            // The whole source, from its start.
+            EAIOTEST_VERIFY(dest.SetPosition(0));
+            EAIOTEST_VERIFY(sourceFile.SetPosition(0));
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &dest) == kDataSize);
+            EAIOTEST_VERIFY(dest.getSize() == kDataSize);
+            EAIOTEST_VERIFY(memcmp(dest.GetData(), data, (size_t)kDataSize) == 0);
+        }
+
+        { // FileStream to FileStream is copied by the kernel where possible.
+            EAIOTEST_VERIFY(destFile.SetSize(0));
+            EAIOTEST_VERIFY(destFile.SetPosition(7));
+            EAIOTEST_VERIFY(sourceFile.SetPosition(1000));
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &destFile, 5000) == 5000);
+            EAIOTEST_VERIFY(sourceFile.GetPosition() == 6000);
+            EAIOTEST_VERIFY(destFile.GetPosition() == 5007);
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &destFile) == (kDataSize - 6000));
+            EAIOTEST_VERIFY(sourceFile.GetPosition() == (off_type)kDataSize);
+            EAIOTEST_VERIFY(destFile.GetPosition() == (off_type)(kDataSize - 1000 + 7));
+            EAIOTEST_VERIFY(destFile.getSize() == (kDataSize - 1000 + 7));
+            EAIOTEST_VERIFY(destFile.ReadAt(7, buffer, kDataSize) == (kDataSize - 1000));
+            EAIOTEST_VERIFY(memcmp(buffer, data + 1000, (size_t)(kDataSize - 1000)) == 0);
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &destFile) == 0); // At the end of the source.
+        }
+
+        { // Other streams are copied through a buffer.
+            StreamBuffer dest(0, 4096, &destFile);
+            dest.AddRef();
+
+            EAIOTEST_VERIFY(destFile.SetSize(0));
+            EAIOTEST_VERIFY(dest.SetPosition(0));
+            EAIOTEST_VERIFY(sourceFile.SetPosition(3));
+            EAIOTEST_VERIFY(copyStream(&sourceFile, &dest) == (kDataSize - 3));
+            EAIOTEST_VERIFY(dest.Flush());
+            EAIOTEST_VERIFY(destFile.ReadAt(0, buffer, kDataSize) == (kDataSize - 3));
+            EAIOTEST_VERIFY(memcmp(buffer, data + 3, (size_t)(kDataSize - 3)) == 0);
+            dest.setStream(NULL);
+        }
+
+        EAIOTEST_VERIFY(sourceFile.close());
+        EAIOTEST_VERIFY(destFile.close());
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test files.");
+
+    remove(sourcePath8);
+    remove(destPath8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterSwizzleArrays
+//
+// The array reads and writes which convert endian-ness, at each SwizzleLevel the
+// processor supports, for every count up to a few vectors' worth.
+//
+namespace TestStreamAdapterLocal
+{
+    const EA::IO::Endian kEndianOther = (EA::IO::kEndianLocal == EA::IO::kEndianBig) ? EA::IO::kEndianLittle : EA::IO::kEndianBig;
+
+    template <typename T>
+    int VerifySwizzledArrays(bool (*pRead)(EA::IO::IStream*, T*, EA::IO::size_type, EA::IO::Endian), 
+                             bool (*pWrite)(EA::IO::IStream*, const T*, EA::IO::size_type, EA::IO::Endian))
+    {
+        using namespace EA::IO;
+
+        int nErrorCount = 0;
+
+        const size_type kCountMax = 65;
+
+        uint8_t data[(kCountMax * sizeof(T)) + 1];   // The stream data, which is unaligned.
+        T       expected[kCountMax];                 // The data converted one element at a time.
+        T       actual[kCountMax + 1];
+
+        for(size_type i = 0; i < sizeof(data); i++)
+            data[i] = (uint8_t)((i * 37) + 11);
+
+        for(size_type i = 0; i < kCountMax; i++)
+        {
+            uint8_t element[sizeof(T)];
+
+            for(size_t b = 0; b < sizeof(T); b++)
+                element[b] = data[1 + (i * sizeof(T)) + (sizeof(T) - 1 - b)];
+            memcpy(&expected[i], element, sizeof(T));
+        }
+
+        for(size_type count = 0; count <= kCountMax; count++)
+        {
+            const size_type nSize = (count * sizeof(T));
+
+            for(int readPath = 0; readPath < kReadPathCount; readPath++)
+            {
+                TestStream testStream(data + 1, nSize, readPath);
+                IStream*   pIS = testStream.GetStream(readPath);
+
+                memset(actual, 0, sizeof(actual));
+                EAIOTEST_VERIFY(pRead(pIS, actual, count, kEndianOther));
+                EAIOTEST_VERIFY(memcmp(actual, expected, (size_t)nSize) == 0);
+                EAIOTEST_VERIFY(pIS->GetAvailable() == 0);
+                EAIOTEST_VERIFY(!pRead(pIS, actual, 1, kEndianOther));
+            }
+
+            for(int writePath = 0; writePath < 2; writePath++) // Directly to a MemoryStream, and through a StreamBuffer.
+            {
+                MemoryStream memoryStream;
+                memoryStream.AddRef();
+                memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+
+                StreamBuffer streamBuffer(0, 64, &memoryStream);
+                streamBuffer.AddRef();
+
+                IStream* const pOS = writePath ? static_cast<IStream*>(&streamBuffer) : static_cast<IStream*>(&memoryStream);
+
+                EAIOTEST_VERIFY(pWrite(pOS, expected, count, kEndianOther));
+                EAIOTEST_VERIFY(pOS->Flush());
+                EAIOTEST_VERIFY(memoryStream.getSize() == nSize);
+                EAIOTEST_VERIFY((nSize == 0) || (memcmp(memoryStream.GetData(), data + 1, (size_t)nSize) == 0));
+
+                streamBuffer.setStream(NULL);
+            }
+        }
+
+        return nErrorCount;
+    }
+}
+
+
+static int TestStreamAdapterSwizzleArrays()
+{
+    using namespace EA::IO;
+    using namespace TestStreamAdapterLocal;
+
+    int nErrorCount = 0;
+
+    for(int nLevel = kSwizzleLevelScalar; nLevel <= kSwizzleLevelAVX2; nLevel++)
+    {
+        if(SetSwizzleLevel(nLevel) == nLevel) // If the processor supports this level...
+        {
+            nErrorCount += VerifySwizzledArrays<uint16_t>(ReadUint16, WriteUint16);
+            nErrorCount += VerifySwizzledArrays<uint32_t>(ReadUint32, WriteUint32);
+            nErrorCount += VerifySwizzledArrays<uint64_t>(ReadUint64, WriteUint64);
+            nErrorCount += VerifySwizzledArrays<float>   (ReadFloat,  WriteFloat);
+            nErrorCount += VerifySwizzledArrays<double>  (ReadDouble, WriteDouble);
+        }
+    }
+
+    EAIOTEST_VERIFY(SetSwizzleLevel(kSwizzleLevelScalar) == kSwizzleLevelScalar);
+    SetSwizzleLevel(kSwizzleLevelAVX2);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapterBufferAdapter
+//
+// BufferReader and BufferWriter: byte order, agreement with the stream functions,
+// and bounds checking.
+//
+static int TestStreamAdapterBufferAdapter()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    const uint8_t kBigEndianData[20] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0x3f, 0xc0, 0x00, 0x00, 0x01 };
+
+    { // Big-endian writes, compared with the expected bytes.
+        uint8_t buffer[24];
+        memset(buffer, 0xcc, sizeof(buffer));
+
+        BufferWriter<kEndianBig> writer(buffer, sizeof(buffer));
+
+        writer.WriteUint8(0x12);
+        writer.WriteUint16(0x3456);
+        writer.WriteUint32(0x789abcde);
+        writer.WriteUint64(UINT64_C(0x0123456789abcdef));
+        writer.WriteFloat(1.5f);
+        writer.WriteBool8(true);
+
+        EAIOTEST_VERIFY(writer.IsValid());
+        EAIOTEST_VERIFY(writer.GetPosition() == 20);
+        EAIOTEST_VERIFY(writer.GetAvailable() == 4);
+        EAIOTEST_VERIFY(memcmp(buffer, kBigEndianData, sizeof(kBigEndianData)) == 0);
+
+        // A write which doesn't fit writes nothing and invalidates the writer, after 
+        // which even writes which would fit do nothing.
+        writer.WriteDouble(2.0);
+        EAIOTEST_VERIFY(!writer.IsValid());
+        EAIOTEST_VERIFY(writer.GetPosition() == 20);
+        writer.WriteUint8(0x55);
+        EAIOTEST_VERIFY(writer.GetPosition() == 20);
+        EAIOTEST_VERIFY((buffer[20] == 0xcc) && (buffer[23] == 0xcc));
+
+        // SetPosition beyond the end fails without affecting validity.
+        writer.SetBuffer(buffer, sizeof(buffer));
+        EAIOTEST_VERIFY(writer.IsValid());
+        EAIOTEST_VERIFY(!writer.SetPosition(25));
+        EAIOTEST_VERIFY(writer.IsValid());
+        EAIOTEST_VERIFY(writer.SetPosition(24));
+        EAIOTEST_VERIFY(writer.GetAvailable() == 0);
+
+        // An array write is checked as a whole.
+        const uint16_t array16[3] = { 1, 2, 3 };
+
+        EAIOTEST_VERIFY(writer.SetPosition(19));
+        writer.WriteUint16(array16, 3);
+        EAIOTEST_VERIFY(!writer.IsValid());
+        EAIOTEST_VERIFY(memcmp(buffer, kBigEndianData, sizeof(kBigEndianData)) == 0);
+        EAIOTEST_VERIFY(buffer[20] == 0xcc);
+    }
+
+    { // Little-endian writes match the stream functions.
+        uint8_t buffer[24];
+        const double arrayDouble[2] = { 1.0, -3.25 };
+
+        BufferWriter<kEndianLittle> writer(buffer, sizeof(buffer));
+
+        writer.WriteInt16(-2);
+        writer.WriteUint32(0x789abcde);
+        writer.WriteDouble(arrayDouble, 2);
+        EAIOTEST_VERIFY(writer.IsValid() && (writer.GetPosition() == 22));
+
+        MemoryStream memoryStream;
+        memoryStream.AddRef();
+        memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+
+        EAIOTEST_VERIFY(WriteInt16(&memoryStream, -2, kEndianLittle));
+        EAIOTEST_VERIFY(WriteUint32(&memoryStream, 0x789abcde, kEndianLittle));
+        EAIOTEST_VERIFY(WriteDouble(&memoryStream, arrayDouble, 2, kEndianLittle));
+        EAIOTEST_VERIFY(memoryStream.getSize() == 22);
+        EAIOTEST_VERIFY(memcmp(buffer, memoryStream.GetData(), 22) == 0);
+        EAIOTEST_VERIFY((buffer[0] == 0xfe) && (buffer[1] == 0xff) && (buffer[2] == 0xde) && (buffer[5] == 0x78));
+    }
+
+    { // Big-endian reads, checked and unchecked.
+        BufferReader<kEndianBig> reader(kBigEndianData, sizeof(kBigEndianData));
+
+        uint8_t  n8  = 0;
+        uint16_t n16 = 0;
+        uint32_t n32 = 0;
+        uint64_t n64 = 0;
+        float    f   = 0;
+        bool     b   = false;
+
+        reader.ReadUint8(n8);
+        reader.ReadUint16(n16);
+        reader.ReadUint32(n32);
+        EAIOTEST_VERIFY((n8 == 0x12) && (n16 == 0x3456) && (n32 == 0x789abcde));
+
+        EAIOTEST_VERIFY(reader.Require(sizeof(uint64_t) + sizeof(float) + 1));
+        n64 = reader.GetUint64();
+        f   = reader.GetFloat();
+        b   = reader.GetBool8();
+        EAIOTEST_VERIFY((n64 == UINT64_C(0x0123456789abcdef)) && (f == 1.5f) && b);
+        EAIOTEST_VERIFY(reader.IsValid() && (reader.GetAvailable() == 0));
+
+        // A read past the end leaves the value alone and invalidates the reader.
+        reader.ReadUint32(n32);
+        EAIOTEST_VERIFY(!reader.IsValid() && (n32 == 0x789abcde));
+
+        // After which even reads which would fit do nothing.
+        EAIOTEST_VERIFY(reader.SetPosition(0));
+        reader.ReadUint8(n8);
+        EAIOTEST_VERIFY(!reader && (reader.GetPosition() == 0));
+
+        // Little-endian reads of the same data.
+        BufferReader<kEndianLittle> readerLittle(kBigEndianData, sizeof(kBigEndianData));
+
+        readerLittle.Skip(1);
+        readerLittle.ReadUint16(n16);
+        readerLittle.ReadUint32(n32);
+        EAIOTEST_VERIFY(readerLittle.IsValid() && (n16 == 0x5634) && (n32 == 0xdebc9a78));
+    }
+
+    { // Array reads are checked as a whole, including against overflow of the size.
+        uint16_t array16[10];
+        memset(array16, 0, sizeof(array16));
+
+        BufferReader<kEndianBig> reader(kBigEndianData, sizeof(kBigEndianData));
+
+        reader.ReadUint16(array16, 10);
+        EAIOTEST_VERIFY(reader.IsValid() && (array16[0] == 0x1234) && (array16[9] == 0x0001));
+
+        reader.SetBuffer(kBigEndianData, sizeof(kBigEndianData));
+        memset(array16, 0, sizeof(array16));
+        reader.ReadUint16(array16, 11);
+        EAIOTEST_VERIFY(!reader.IsValid() && (array16[0] == 0) && (reader.GetPosition() == 0));
+
+        reader.SetBuffer(kBigEndianData, sizeof(kBigEndianData));
+        reader.ReadUint16(array16, ((size_type)-1 / 2) + 1); // The byte size wraps to zero.
+        EAIOTEST_VERIFY(!reader.IsValid() && (reader.GetPosition() == 0));
+
+        // Skip past the end invalidates the reader.
+        reader.SetBuffer(kBigEndianData, sizeof(kBigEndianData));
+        reader.Skip(21);
+        EAIOTEST_VERIFY(!reader.IsValid() && (reader.GetPosition() == 0));
+    }
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamAdapter
+//
+int TestStreamAdapter()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestStreamAdapterVarInt();
+    nErrorCount += TestStreamAdapterVarIntInvalid();
+    nErrorCount += TestStreamAdapterReadReservation();
+    nErrorCount += TestStreamAdapterCopyStream();
+    nErrorCount += TestStreamAdapterSwizzleArrays();
+    nErrorCount += TestStreamAdapterBufferAdapter();
+
+    return nErrorCount;
+}
@@ -0,0 +1,174 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestStreamBlockCache.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAStreamBlockCache.h>
+#include <eaio/EAStreamMemory.h>
+#include <eaio/EAFileStream.h>
+#include <string.h>
+#include <stdio.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBlockCacheRandom
+//
+// Compares reads and writes at random positions against a copy of the data.
+//
+static int TestStreamBlockCacheRandom()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    const size_t   kDataSize = 5000;
+    static uint8_t dataArray[kDataSize];
+    static uint8_t readArray[kDataSize];
+    uint32_t       nState = 1;
+
+    for(size_t i = 0; i < kDataSize; i++)
+        dataArray[i] = (uint8_t)i;
+
+    MemoryStream memoryStream;
+    memoryStream.AddRef();
+    memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+    memoryStream.Write(dataArray, kDataSize);
+
+    StreamBlockCache blockCache(&memoryStream, 64, 8);
+    blockCache.AddRef();
+
+    for(int i = 0; i < 2000; i++)
+    {
+        nState = (nState * 1103515245) + 12345;
+
+        const size_type nPosition = (nState >> 8) % kDataSize;
+        const size_type nSize     = (nState >> 20) % 300;
+
+        EAIOTEST_VERIFY(blockCache.SetPosition((off_type)nPosition));
+
+        if((i % 10) == 0) // Every tenth access is a write within the data.
+        {
+            if((nPosition + nSize) <= kDataSize)
+            {
+                for(size_type j = 0; j < nSize; j++)
+                    dataArray[nPosition + j] = (uint8_t)(nState + j);
+
+                EAIOTEST_VERIFY(blockCache.Write(dataArray + nPosition, nSize));
+            }
+        }
+        else
+        {
+            const size_type nExpectedSize = ((nPosition + nSize) > kDataSize) ? (kDataSize - nPosition) : nSize;
+
+            EAIOTEST_VERIFY(blockCache.Read(readArray, nSize) == nExpectedSize);
+            EAIOTEST_VERIFY(memcmp(readArray, dataArray + nPosition, (size_t)nExpectedSize) == 0);
+            EAIOTEST_VERIFY(blockCache.GetPosition() == (off_type)(nPosition + nExpectedSize));
+        }
+    }
+
+    StreamBlockCache::Stats stats;
+    blockCache.GetStats(stats);
+    EAIOTEST_VERIFY(stats.mnHitCount > 0);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBlockCacheExtend
+//
+// Reads at the end of the stream cache short blocks, which must not survive
+// a write which extends the stream. This reads the last block of a 10-byte 
+// file, reads past its end, writes 4 bytes at position 16 (leaving a hole), 
+// and then reads positions 8 through 20, which must return all 12 bytes.
+//
+static int TestStreamBlockCacheExtend()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "StreamBlockCacheExtend.bin");
+
+    FileStream fileStream(path8);
+    fileStream.AddRef();
+
+    if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        EAIOTEST_VERIFY(fileStream.Write("0123456789", 10));
+
+        StreamBlockCache blockCache(&fileStream, 4, 8);
+        blockCache.AddRef();
+
+        char buffer[16];
+
+        EAIOTEST_VERIFY(blockCache.SetPosition(8));
+        EAIOTEST_VERIFY(blockCache.Read(buffer, 4) == 2);
+        EAIOTEST_VERIFY(blockCache.Read(buffer, 4) == 0);
+        EAIOTEST_VERIFY(blockCache.SetPosition(12));
+        EAIOTEST_VERIFY(blockCache.Read(buffer, 4) == 0);
+
+        EAIOTEST_VERIFY(blockCache.SetPosition(16));
+        EAIOTEST_VERIFY(blockCache.Write("abcd", 4));
+
+        EAIOTEST_VERIFY(blockCache.SetPosition(8));
+        EAIOTEST_VERIFY(blockCache.Read(buffer, 12) == 12);
+        EAIOTEST_VERIFY(memcmp(buffer, "89\0\0\0\0\0\0abcd", 12) == 0);
+
+        blockCache.setStream(NULL);
+        fileStream.close();
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBlockCache
+//
+int TestStreamBlockCache()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestStreamBlockCacheRandom();
+    nErrorCount += TestStreamBlockCacheExtend();
+
+    return nErrorCount;
+}
@@ -0,0 +1,267 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/////////////////////////////////////////////////////////////////////////////
+// TestStreamBuffer.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAStreamBuffer.h>
+#include <eaio/EAFileStream.h>
+#include <eaio/EAStreamMemory.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(EA_PLATFORM_UNIX)
+    #include <unistd.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBufferUnbuffered
+//
+// With read buffering disabled, a read which reaches the end of the stream 
+// must advance the position by the number of bytes actually read.
+//
+static int TestStreamBufferUnbuffered()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "StreamBufferUnbuffered.txt");
+
+    FileStream fileStream(path8);
+    fileStream.AddRef();
+
+    if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        EAIOTEST_VERIFY(fileStream.Write("0123456789", 10));
+
+        StreamBuffer streamBuffer(0, 0, &fileStream);
+        streamBuffer.AddRef();
+
+        char buffer[16];
+
+        EAIOTEST_VERIFY(streamBuffer.SetPosition(6));
+        EAIOTEST_VERIFY(streamBuffer.Read(buffer, 8) == 4);
+        EAIOTEST_VERIFY(memcmp(buffer, "6789", 4) == 0);
+        EAIOTEST_VERIFY(streamBuffer.GetPosition() == 10);
+        EAIOTEST_VERIFY(streamBuffer.GetAvailable() == 0);
+
+        // A write now goes at the end, rather than beyond it.
+        EAIOTEST_VERIFY(streamBuffer.Write("ab", 2));
+        EAIOTEST_VERIFY(streamBuffer.Flush());
+        EAIOTEST_VERIFY(fileStream.getSize() == 12);
+
+        streamBuffer.setStream(NULL);
+        fileStream.close();
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBufferBackgroundOptions
+//
+// Disabling one of read-ahead and write-behind while the other stays enabled 
+// must leave the enabled one working, and queued writes must reach the file.
+//
+static int TestStreamBufferBackgroundOptions()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    char8_t path8[kMaxPathLength];
+    MakeTestPath(path8, kMaxPathLength, "StreamBufferBackgroundOptions.txt");
+
+    FileStream fileStream(path8);
+    fileStream.AddRef();
+
+    if(fileStream.open(kAccessFlagReadWrite, kCDCreateAlways))
+    {
+        const size_type kBlockSize  = 4096;
+        const size_type kBlockCount = 8;
+
+        char block[kBlockSize];
+        char buffer[kBlockSize];
+
+        StreamBuffer streamBuffer(kBlockSize, kBlockSize, &fileStream);
+        streamBuffer.AddRef();
+
+        streamBuffer.setOption(StreamBuffer::kOptionReadAhead, StreamBuffer::kReadAheadAlways);
+        streamBuffer.setOption(StreamBuffer::kOptionWriteBehind, 4);
+
+        for(size_type i = 0; i < kBlockCount; i++)
+        {
+            if(i == (kBlockCount / 2))
+                streamBuffer.setOption(StreamBuffer::kOptionReadAhead, StreamBuffer::kReadAheadNone);
+
+            memset(block, (int)('a' + i), (size_t)kBlockSize);
+            EAIOTEST_VERIFY(streamBuffer.Write(block, kBlockSize));
+        }
+
+        EAIOTEST_VERIFY(streamBuffer.Flush());
+        EAIOTEST_VERIFY(fileStream.getSize() == (kBlockSize * kBlockCount));
+
+        streamBuffer.setOption(StreamBuffer::kOptionReadAhead, StreamBuffer::kReadAheadAlways);
+        EAIOTEST_VERIFY(streamBuffer.SetPosition(0));
+
+        for(size_type i = 0; i < kBlockCount; i++)
+        {
+            if(i == (kBlockCount / 2))
+                streamBuffer.setOption(StreamBuffer::kOptionWriteBehind, 0);
+
+            memset(block, (int)('a' + i), (size_t)kBlockSize);
+            EAIOTEST_VERIFY(streamBuffer.Read(buffer, kBlockSize) == kBlockSize);
+            EAIOTEST_VERIFY(memcmp(buffer, block, (size_t)kBlockSize) == 0);
+        }
+
+        streamBuffer.setStream(NULL);
+        fileStream.close();
+    }
+    else
+        EAIOTEST_VERIFY(!"Couldn't create the test file.");
+
+    remove(path8);
+
+    return nErrorCount;
+}
+
+
+#if EAIO_THREAD_SAFETY_ENABLED && defined(EA_PLATFORM_UNIX)
+
+namespace TestStreamBufferLocal
+{
+    // A MemoryStream whose reads after the first one wait until the gate is opened, 
+    // or until a timeout. This lets us hold a read-ahead in progress.
+    class GatedStream : public EA::IO::MemoryStream
+    {
+    public:
+        GatedStream(void* pData, EA::IO::size_type nSize)
+          : EA::IO::MemoryStream(pData, nSize, true, false), mnReadCount(0), mbGateOpen(false), mbTimedOut(false) { }
+
+        EA::IO::size_type Read(void* pData, EA::IO::size_type nSize)
+        {
+            if(__atomic_fetch_add(&mnReadCount, 1, __ATOMIC_SEQ_CST) > 0)
+            {
+                int i;
+
+                for(i = 0; (i < 500) && !__atomic_load_n(&mbGateOpen, __ATOMIC_SEQ_CST); i++)
+                    usleep(10000);
+
+                if(i == 500)
+                    __atomic_store_n(&mbTimedOut, true, __ATOMIC_SEQ_CST);
+            }
+
+            return EA::IO::MemoryStream::Read(pData, nSize);
+        }
+
+        void OpenGate() { __atomic_store_n(&mbGateOpen, true, __ATOMIC_SEQ_CST); }
+        bool TimedOut() { return __atomic_load_n(&mbTimedOut, __ATOMIC_SEQ_CST); }
+
+    protected:
+        int  mnReadCount;
+        bool mbGateOpen;
+        bool mbTimedOut;
+    };
+}
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBufferSizeDuringReadAhead
+//
+// getSize and GetAvailable must not wait for a read-ahead in progress, 
+// even though the size isn't cached.
+//
+static int TestStreamBufferSizeDuringReadAhead()
+{
+    int nErrorCount = 0;
+
+    #if EAIO_THREAD_SAFETY_ENABLED && defined(EA_PLATFORM_UNIX)
+        using namespace EA::IO;
+        using namespace TestStreamBufferLocal;
+
+        const size_type kBlockSize = 4096;
+        static char     data[kBlockSize * 4];
+        char            buffer[kBlockSize];
+
+        for(size_type i = 0; i < sizeof(data); i++)
+            data[i] = (char)(i * 7);
+
+        GatedStream gatedStream(data, sizeof(data));
+        gatedStream.AddRef();
+
+        StreamBuffer streamBuffer(kBlockSize, 0, &gatedStream);
+        streamBuffer.AddRef();
+        streamBuffer.setOption(StreamBuffer::kOptionReadAhead, StreamBuffer::kReadAheadAlways);
+
+        // The first read fills the read buffer and starts the read-ahead, which is held at the gate.
+        EAIOTEST_VERIFY(streamBuffer.Read(buffer, 100) == 100);
+        EAIOTEST_VERIFY(streamBuffer.getSize() == sizeof(data));
+        EAIOTEST_VERIFY(streamBuffer.GetAvailable() == (sizeof(data) - 100));
+        EAIOTEST_VERIFY(!gatedStream.TimedOut());
+
+        gatedStream.OpenGate();
+
+        EAIOTEST_VERIFY(streamBuffer.SetPosition(kBlockSize + 5));
+        EAIOTEST_VERIFY(streamBuffer.Read(buffer, 10) == 10);
+        EAIOTEST_VERIFY(memcmp(buffer, data + kBlockSize + 5, 10) == 0);
+
+        streamBuffer.setStream(NULL);
+    #endif
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamBuffer
+//
+int TestStreamBuffer()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestStreamBufferUnbuffered();
+    nErrorCount += TestStreamBufferBackgroundOptions();
+    nErrorCount += TestStreamBufferSizeDuringReadAhead();
+
+    return nErrorCount;
+}
@@ -0,0 +1,130 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/////////////////////////////////////////////////////////////////////////////
+// TestStreamChecksum.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAStreamChecksum.h>
+#include <eaio/EAStreamMemory.h>
+#include <string.h>
+
+
+namespace TestStreamChecksumLocal
+{
+    // Computed during static initialization, possibly before that of the library.
+    const uint32_t gnStaticInitCRC32C = EA::IO::ComputeCRC32C("123456789", 9);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamChecksum
+//
+int TestStreamChecksum()
+{
+    using namespace EA::IO;
+
+    int nErrorCount = 0;
+
+    // Published check values.
+    EAIOTEST_VERIFY(ComputeCRC32C("123456789", 9) == 0xe3069283);
+    EAIOTEST_VERIFY(ComputeCRC32C("", 0) == 0);
+    EAIOTEST_VERIFY(TestStreamChecksumLocal::gnStaticInitCRC32C == 0xe3069283);
+    EAIOTEST_VERIFY(ComputeXXHash64("", 0) == UINT64_C(0xEF46DB3751D8E999));
+    EAIOTEST_VERIFY(ComputeXXHash64("a", 1) == UINT64_C(0xD24EC4F1A98C6E5B));
+    EAIOTEST_VERIFY(ComputeXXHash64("abc", 3) == UINT64_C(0x44BC2CF5AD770999));
+
+    static uint8_t dataArray[100000];
+    static uint8_t readArray[100000];
+    uint32_t       nState = 1;
+
+    for(size_t i = 0; i < sizeof(dataArray); i++)
+    {
+        nState = (nState * 1103515245) + 12345;
+        dataArray[i] = (uint8_t)(nState >> 16);
+    }
+
+    // Incremental computation must match one-shot computation at every split point
+    // and alignment, as the implementations process aligned 8 and 32 byte chunks.
+    for(size_t n = 0; n < 300; n++)
+    {
+        const uint8_t* const pData = dataArray + (n % 7);
+
+        const uint32_t nCRC = ComputeCRC32C(pData + (n / 2), n - (n / 2), ComputeCRC32C(pData, n / 2));
+        EAIOTEST_VERIFY(nCRC == ComputeCRC32C(pData, n));
+
+        XXHash64 hash(3);
+        hash.Update(pData, n / 3);
+        hash.Update(pData + (n / 3), n - (n / 3));
+        EAIOTEST_VERIFY(hash.GetValue() == ComputeXXHash64(pData, n, 3));
+    }
+
+    MemoryStream memoryStream;
+    memoryStream.AddRef();
+    memoryStream.setOption(MemoryStream::kOptionResizeEnabled, 1);
+
+    {
+        StreamChecksum checksum(&memoryStream, StreamChecksum::kChecksumCRC32C | StreamChecksum::kChecksumXXHash64, 7);
+
+        for(size_t nPosition = 0, nSize = 0; nPosition < sizeof(dataArray); nPosition += nSize)
+        {
+            nSize = ((nPosition % 97) + 1) * 13;
+            if(nSize > (sizeof(dataArray) - nPosition))
+                nSize = (sizeof(dataArray) - nPosition);
+            EAIOTEST_VERIFY(checksum.Write(dataArray + nPosition, nSize));
+        }
+
+        EAIOTEST_VERIFY(checksum.GetCRC32C()       == ComputeCRC32C(dataArray, sizeof(dataArray)));
+        EAIOTEST_VERIFY(checksum.GetXXHash64()     == ComputeXXHash64(dataArray, sizeof(dataArray), 7));
+        EAIOTEST_VERIFY(checksum.GetChecksumSize() == sizeof(dataArray));
+
+        checksum.SetPosition(0);
+        checksum.Reset();
+
+        size_type nPosition = 0;
+
+        for(size_type nReadSize; (nReadSize = checksum.Read(readArray + nPosition, 4999)) != 0; nPosition += nReadSize)
+        {
+            EAIOTEST_VERIFY(nReadSize != kSizeTypeError);
+            if(nReadSize == kSizeTypeError)
+                break;
+        }
+
+        EAIOTEST_VERIFY(nPosition == sizeof(dataArray));
+        EAIOTEST_VERIFY(memcmp(dataArray, readArray, sizeof(dataArray)) == 0);
+        EAIOTEST_VERIFY(checksum.GetCRC32C()   == ComputeCRC32C(dataArray, sizeof(dataArray)));
+        EAIOTEST_VERIFY(checksum.GetXXHash64() == ComputeXXHash64(dataArray, sizeof(dataArray), 7));
+    }
+
+    return nErrorCount;
+}
@@ -0,0 +1,220 @@
+/*
+copyright (C) 2009-2010 Electronic Arts, Inc.  All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+1.  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+2.  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+3.  Neither the name of Electronic Arts, Inc. ("EA") nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY ELECTRONIC ARTS AND ITS CONTRIBUTORS "AS IS" AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS OR ITS CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/////////////////////////////////////////////////////////////////////////////
+// TestStreamSerializer.cpp
+//
+// copyright (c) 2007, Electronic Arts Inc. All rights reserved.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+
+#include "EAIOTest.h"
+#include <eaio/EAStreamSerializer.h>
+#include <eaio/EAStreamMemory.h>
+#include <string>
+#include <string.h>
+
+
+namespace TestStreamSerializerLocal
+{
+    const EA::IO::size_type kLargeCount = 200;
+
+    // Serialized as 801 bytes, which is larger than the serializer's buffer. 
+    // mName isn't serialized, and must survive reads intact.
+    struct LargeStruct
+    {
+        std::string mName;
+        uint32_t    mValueArray[kLargeCount];
+        bool        mbFlag;
+    };
+
+    // The character types are serialized as numbers of their size.
+    struct CharStruct
+    {
+        char     mChar;
+        wchar_t  mWChar;
+        #if defined(EA_CHAR16_NATIVE) && EA_CHAR16_NATIVE
+            char16_t mChar16;
+        #endif
+        #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+            char32_t mChar32Array[2];
+        #endif
+    };
+}
+
+EAIO_SERIALIZE_BEGIN(TestStreamSerializerLocal::LargeStruct)
+    EAIO_SERIALIZE_FIELD(mValueArray)
+    EAIO_SERIALIZE_FIELD(mbFlag)
+EAIO_SERIALIZE_END()
+
+EAIO_SERIALIZE_BEGIN(TestStreamSerializerLocal::CharStruct)
+    EAIO_SERIALIZE_FIELD(mChar)
+    EAIO_SERIALIZE_FIELD(mWChar)
+    #if defined(EA_CHAR16_NATIVE) && EA_CHAR16_NATIVE
+        EAIO_SERIALIZE_FIELD(mChar16)
+    #endif
+    #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+        EAIO_SERIALIZE_FIELD(mChar32Array)
+    #endif
+EAIO_SERIALIZE_END()
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamSerializerLarge
+//
+// Structs whose serialized size exceeds the internal buffer are read and 
+// written through the buffer in pieces.
+//
+static int TestStreamSerializerLarge()
+{
+    using namespace EA::IO;
+    using namespace TestStreamSerializerLocal;
+
+    int nErrorCount = 0;
+
+    LargeStruct source[2];
+
+    for(size_type i = 0; i < 2; i++)
+    {
+        for(size_type j = 0; j < kLargeCount; j++)
+            source[i].mValueArray[j] = (uint32_t)((i * 0x10000) + j);
+        source[i].mbFlag = (i == 1);
+        source[i].mName  = "source";
+    }
+
+    EAIOTEST_VERIFY(GetSerializedSize(source[0]) == ((kLargeCount * 4) + 1));
+
+    const size_type kDataSize = 2 * ((kLargeCount * 4) + 1);
+    uint8_t data[kDataSize];
+
+    MemoryStream stream(data, kDataSize, true, false);
+    stream.AddRef();
+
+    EAIOTEST_VERIFY(WriteStruct(&stream, source, 2, kEndianBig));
+    EAIOTEST_VERIFY(stream.GetPosition() == kDataSize);
+
+    const uint8_t* pData = data;
+    EAIOTEST_VERIFY((pData[0] == 0) && (pData[1] == 0) && (pData[2] == 0) && (pData[3] == 0));
+    EAIOTEST_VERIFY((pData[4] == 0) && (pData[5] == 0) && (pData[6] == 0) && (pData[7] == 1));
+    EAIOTEST_VERIFY(pData[kLargeCount * 4] == 0);
+    EAIOTEST_VERIFY((pData[(kLargeCount * 4) + 2] == 1) && (pData[(kLargeCount * 8) + 1] == 1));
+
+    LargeStruct dest[2];
+    dest[0].mName = "dest0";
+    dest[1].mName = "dest1";
+
+    EAIOTEST_VERIFY(stream.SetPosition(0));
+    EAIOTEST_VERIFY(ReadStruct(&stream, dest, 2, kEndianBig));
+    EAIOTEST_VERIFY(memcmp(dest[0].mValueArray, source[0].mValueArray, sizeof(source[0].mValueArray)) == 0);
+    EAIOTEST_VERIFY(memcmp(dest[1].mValueArray, source[1].mValueArray, sizeof(source[1].mValueArray)) == 0);
+    EAIOTEST_VERIFY(!dest[0].mbFlag && dest[1].mbFlag);
+    EAIOTEST_VERIFY((dest[0].mName == "dest0") && (dest[1].mName == "dest1"));
+
+    // A read which runs out of data fails.
+    EAIOTEST_VERIFY(stream.SetPosition(1));
+    EAIOTEST_VERIFY(!ReadStruct(&stream, dest, 2, kEndianBig));
+    EAIOTEST_VERIFY((dest[0].mName == "dest0") && (dest[1].mName == "dest1"));
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamSerializerChars
+//
+static int TestStreamSerializerChars()
+{
+    using namespace EA::IO;
+    using namespace TestStreamSerializerLocal;
+
+    int nErrorCount = 0;
+
+    CharStruct source;
+    memset(&source, 0, sizeof(source));
+
+    size_type nExpectedSize = 1 + sizeof(wchar_t);
+
+    source.mChar  = 'a';
+    source.mWChar = (wchar_t)0x2603;
+    #if defined(EA_CHAR16_NATIVE) && EA_CHAR16_NATIVE
+        source.mChar16 = (char16_t)0x00e9;
+        nExpectedSize += 2;
+    #endif
+    #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+        source.mChar32Array[0] = (char32_t)0x0001f600;
+        source.mChar32Array[1] = (char32_t)0x00000041;
+        nExpectedSize += 8;
+    #endif
+
+    EAIOTEST_VERIFY(GetSerializedSize(source) == nExpectedSize);
+
+    uint8_t data[32];
+    memset(data, 0, sizeof(data));
+
+    MemoryStream stream(data, sizeof(data), true, false);
+    stream.AddRef();
+
+    EAIOTEST_VERIFY(WriteStruct(&stream, source, kEndianBig));
+    EAIOTEST_VERIFY(stream.GetPosition() == (off_type)nExpectedSize);
+    EAIOTEST_VERIFY(data[0] == 'a');
+    EAIOTEST_VERIFY((data[sizeof(wchar_t) - 1] == 0x26) && (data[sizeof(wchar_t)] == 0x03));
+
+    #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+        const uint8_t* const pChar32 = data + nExpectedSize - 8;
+        EAIOTEST_VERIFY((pChar32[0] == 0x00) && (pChar32[1] == 0x01) && (pChar32[2] == 0xf6) && (pChar32[3] == 0x00) && (pChar32[7] == 0x41));
+    #endif
+
+    CharStruct dest;
+    memset(&dest, 0, sizeof(dest));
+
+    EAIOTEST_VERIFY(stream.SetPosition(0));
+    EAIOTEST_VERIFY(ReadStruct(&stream, dest, kEndianBig));
+    EAIOTEST_VERIFY((dest.mChar == source.mChar) && (dest.mWChar == source.mWChar));
+    #if defined(EA_CHAR16_NATIVE) && EA_CHAR16_NATIVE
+        EAIOTEST_VERIFY(dest.mChar16 == source.mChar16);
+    #endif
+    #if defined(EA_CHAR32_NATIVE) && EA_CHAR32_NATIVE
+        EAIOTEST_VERIFY((dest.mChar32Array[0] == source.mChar32Array[0]) && (dest.mChar32Array[1] == source.mChar32Array[1]));
+    #endif
+
+    return nErrorCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStreamSerializer
+//
+int TestStreamSerializer()
+{
+    int nErrorCount = 0;
+
+    nErrorCount += TestStreamSerializerLarge();
+    nErrorCount += TestStreamSerializerChars();
+
+    return nErrorCount;
+}